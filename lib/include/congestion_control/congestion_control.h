@@ -0,0 +1,61 @@
+#ifndef CONGESTION_CONTROL_H
+#define CONGESTION_CONTROL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Congestion control modules: Send FSM detects ACKs, losses and timeouts; The module decides what they do to the window.
+ * A module owns socket's `cwnd` and `ssthresh`; Send FSM only reads them through cc_cwnd().
+ * Fast recovery's window inflation (RFC 6582) is kept by send FSM on top of it, so modules never see duplicate ACKs.
+ * Shipped modules: "reno" (RFC 5681), "cubic" (RFC 9438) and "bbr" (model based; Bottleneck bandwidth and min RTT).
+ */
+
+#define CC_NAME_MAX_LENGTH 16 /* Including terminating '\0'. */
+
+/* What a cumulative ACK tells; Built by send FSM for every ACK that acknowledges new data. */
+typedef struct
+{
+        size_t acked_bytes;
+        size_t acked_segments;
+        size_t bytes_in_flight;     /* After the ACK. */
+        time_t rtt_usec;            /* 0 if there is no valid sample (Karn's rule). */
+        time_t now_usec;            /* Monotonic. */
+        uint64_t delivered;         /* Bytes acknowledged over the connection, including this ACK; Set by cc_on_ack(). */
+        uint64_t delivered_at_send; /* cc_delivered(), when the newest acknowledged segment was sent; Only valid with an RTT sample. */
+        _Bool in_recovery;          /* Send FSM is in fast recovery; Window must not grow. */
+} cc_ack_sample_t;
+
+/* A module; Registered in congestion_control.c. */
+struct congestion_control_ops
+{
+        const char *name;
+        size_t state_size; /* Bytes of module's per connection state; Zeroed before init(). */
+        void (*init)(microtcp_sock_t *_socket, void *_state);
+        void (*on_ack)(microtcp_sock_t *_socket, void *_state, const cc_ack_sample_t *_sample);
+        void (*on_loss)(microtcp_sock_t *_socket, void *_state, size_t _bytes_in_flight);    /* Fast retransmit; Once per recovery. */
+        void (*on_timeout)(microtcp_sock_t *_socket, void *_state, size_t _bytes_in_flight); /* Retransmission timer expired. */
+        uint64_t (*pacing_rate)(const microtcp_sock_t *_socket, const void *_state);         /* Bytes per second; 0 leaves sending unpaced. */
+        size_t (*cwnd)(const microtcp_sock_t *_socket, const void *_state);
+};
+
+/**
+ * @returns module registered as `_name`, or NULL if there is none.
+ */
+const congestion_control_ops_t *cc_find(const char *_name);
+
+congestion_control_t *cc_create(const congestion_control_ops_t *_ops, microtcp_sock_t *_socket);
+status_t cc_destroy(congestion_control_t **_cc_address);
+
+const congestion_control_ops_t *cc_ops(const congestion_control_t *_cc);
+uint64_t cc_delivered(const congestion_control_t *_cc); /* Bytes acknowledged over the connection; Delivery rate samples need it. */
+void cc_on_ack(congestion_control_t *_cc, microtcp_sock_t *_socket, const cc_ack_sample_t *_sample);
+void cc_on_loss(congestion_control_t *_cc, microtcp_sock_t *_socket, size_t _bytes_in_flight);
+void cc_on_timeout(congestion_control_t *_cc, microtcp_sock_t *_socket, size_t _bytes_in_flight);
+uint64_t cc_pacing_rate(const congestion_control_t *_cc, const microtcp_sock_t *_socket);
+size_t cc_cwnd(const congestion_control_t *_cc, const microtcp_sock_t *_socket);
+
+#endif /* CONGESTION_CONTROL_H */
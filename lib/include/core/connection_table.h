@@ -0,0 +1,39 @@
+#ifndef CORE_CONNECTION_TABLE_H
+#define CORE_CONNECTION_TABLE_H
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include "core/datagram_batch.h"
+#include "status.h"
+
+/**
+ * @brief Connection control block of a listener's connection (see core/listener.h); Keyed by peer's address and port.
+ * Entries are owned by their connections; Table only chains them.
+ */
+typedef struct connection_entry
+{
+        struct sockaddr_in peer;
+        datagram_batch_t *inbox;                 /* Datagrams demultiplexed to this connection, waiting to be received. */
+        _Bool attached;                          /* Entry is in the table. */
+        const struct time_wait_entry *time_wait; /* Connection lingers in TIME_WAIT (see core/time_wait_table.h); Inbox is freed. */
+        struct connection_entry *next;
+} connection_entry_t;
+
+/**
+ * @brief Hash table of connection entries; Separate chaining, power of 2 buckets, doubled whenever entries outnumber them.
+ */
+typedef struct connection_table connection_table_t;
+
+connection_table_t *ct_create(size_t _initial_buckets);
+status_t ct_destroy(connection_table_t **_ct_address);
+
+/* @returns FAILURE if an entry of the same peer is already in the table. */
+status_t ct_insert(connection_table_t *_ct, connection_entry_t *_entry);
+void ct_remove(connection_table_t *_ct, connection_entry_t *_entry);
+connection_entry_t *ct_find(const connection_table_t *_ct, const struct sockaddr_in *_peer);
+size_t ct_size(const connection_table_t *_ct);
+
+connection_entry_t *ce_create(void);
+status_t ce_destroy(connection_entry_t **_ce_address);
+
+#endif /* CORE_CONNECTION_TABLE_H */
@@ -0,0 +1,68 @@
+#ifndef CORE_DATAGRAM_BATCH_H
+#define CORE_DATAGRAM_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include "status.h"
+
+/* Number of datagrams moved by a single sendmmsg() or recvmmsg(). */
+#define DATAGRAM_BATCH_CAPACITY 64
+
+/* UDP offload mode: Send rounds are packed into GSO super-datagrams, and GRO may coalesce received segments
+ * into datagrams of up to 64 KBytes, so fewer (but larger) receive slots are used. */
+#define UDP_OFFLOAD_SEND_BATCH_CAPACITY 256
+#define UDP_OFFLOAD_RECEIVE_BATCH_CAPACITY 8
+#define UDP_OFFLOAD_RECEIVE_SLOT_SIZE 65536
+
+struct mmsghdr;
+struct iovec;
+
+/**
+ * @brief Vector of datagram slots, handed as a whole to sendmmsg() or recvmmsg().
+ * Each slot owns a `slot_size` bytestream and the address it was received from (or is destined to).
+ * A slot's datagram is gathered from `slot_iovecs` consecutive iovecs; The first one always points to slot's bytestream.
+ * Sending:   `count` slots are queued, waiting to be flushed; `cursor` is unused.
+ *            Slots only hold segment headers, the rest of their iovecs point to payloads left in user's buffer.
+ *            In UDP offload mode, `coalesced_messages` group consecutive slots into GSO super-datagrams.
+ * Receiving: `count` slots were filled by the last recvmmsg(); `cursor` is the next slot to hand out.
+ *            A GRO coalesced slot is handed out in `slot_stride` sized pieces, `slot_offset` marks the next one.
+ */
+typedef struct datagram_batch
+{
+        size_t capacity;
+        size_t slot_size;
+        size_t slot_iovecs;
+        size_t count;
+        size_t cursor;
+        size_t slot_offset;
+        size_t slot_stride;
+        struct mmsghdr *messages;
+        struct mmsghdr *coalesced_messages;
+        struct iovec *iovecs;
+        struct sockaddr *addresses;
+        uint8_t *controls;
+        uint8_t *bytestreams;
+} datagram_batch_t;
+
+/* Ancillary data space of each slot; Enough for a UDP_SEGMENT or a UDP_GRO control message. */
+#define DATAGRAM_BATCH_CONTROL_SIZE 32
+
+datagram_batch_t *db_create(size_t _capacity, size_t _slot_size, size_t _slot_iovecs);
+status_t db_destroy(datagram_batch_t **_db_address);
+
+/**
+ * @brief Restores every slot's length fields (iovec, address), so the batch can be passed to recvmmsg().
+ * Only batches of single iovec slots can be used for reception.
+ */
+void db_prepare_reception(datagram_batch_t *_db);
+void db_flush(datagram_batch_t *_db);
+
+uint8_t *db_slot_bytestream(const datagram_batch_t *_db, size_t _slot);
+uint8_t *db_slot_control(const datagram_batch_t *_db, size_t _slot);
+struct iovec *db_slot_iovecs(const datagram_batch_t *_db, size_t _slot);
+size_t db_slot_length(const datagram_batch_t *_db, size_t _slot);
+_Bool db_is_full(const datagram_batch_t *_db);
+size_t db_pending_slots(const datagram_batch_t *_db);
+
+#endif /* CORE_DATAGRAM_BATCH_H */
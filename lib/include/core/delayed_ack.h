@@ -0,0 +1,44 @@
+#ifndef CORE_DELAYED_ACK_H
+#define CORE_DELAYED_ACK_H
+
+#include <time.h>
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Delayed ACKs (RFC 1122, RFC 5681 4.2): In-order data is ACKed every get_microtcp_delayed_ack_segments() full
+ * segments, or once get_microtcp_delayed_ack_timeout() passed since the first unACKed one; Whichever comes first.
+ * Out-of-order segments, segments filling a gap, rejected ones, short ones (peer ran out of data, and probably waits)
+ * and segments that nearly close our window are ACKed at once; Peer's fast retransmit counts on those duplicate ACKs.
+ * Any segment carrying an ACK (piggybacked ones too) covers the pending one, once it is sent.
+ * Sockets own no timer; Receiving paths bound their waits with delayed_ack_delay_usec(), and flush the ACK once due.
+ */
+
+void delayed_ack_reset(microtcp_sock_t *_socket);
+
+/* Called by the send path, once a segment carrying an ACK left; It covers the pending ACK, if it acknowledged every byte received. */
+void delayed_ack_on_ack_sent(microtcp_sock_t *_socket, const microtcp_header_t *_header);
+
+/**
+ * @brief Called once RRB took (or rejected) the data segment in `segment_receive_buffer`; ACKs it now, or leaves the ACK pending.
+ * @param _previous_ack_number socket's `ack_number`, before the segment.
+ * @returns FAILURE only if the ACK could not be sent (fatally).
+ */
+status_t delayed_ack_on_data(microtcp_sock_t *_socket, uint32_t _previous_ack_number);
+
+/* Application freed receive space: ACKs now (window update), if our window grew well past what we last advertised. */
+status_t delayed_ack_on_window_update(microtcp_sock_t *_socket);
+
+/* Sends the pending ACK, if any. */
+status_t delayed_ack_flush(microtcp_sock_t *_socket);
+
+/* Sends the pending ACK, if it is due. */
+status_t delayed_ack_expire(microtcp_sock_t *_socket);
+
+/* @returns μsec until the pending ACK is due; 0 if it already is, -1 if no ACK is pending. */
+time_t delayed_ack_delay_usec(const microtcp_sock_t *_socket);
+
+/* Blocking receptions, once the socket is drained: Waits until a datagram arrives, or the pending ACK is due (and sends it). */
+status_t delayed_ack_wait(microtcp_sock_t *_socket);
+
+#endif /* CORE_DELAYED_ACK_H */
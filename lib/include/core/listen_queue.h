@@ -0,0 +1,48 @@
+#ifndef CORE_LISTEN_QUEUE_H
+#define CORE_LISTEN_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <time.h>
+#include "core/connection_table.h"
+#include "status.h"
+
+/**
+ * @brief A listener's connection, before microtcp_accept_connection() takes it: Half-open while its SYN|ACK awaits
+ * peer's ACK, established (with an entry in listener's connection table, so peer's data is kept) once it arrives.
+ */
+typedef struct pending_connection
+{
+        struct sockaddr peer;
+        uint32_t seq_number;          /* Our ISN; SYN|ACK carries it. */
+        uint32_t ack_number;          /* Peer's ISN + 1. */
+        size_t peer_win_size;
+        size_t synack_retries;        /* Retransmissions left. */
+        time_t synack_rto_usec;       /* Backed off on each retransmission. */
+        time_t synack_deadline_usec;  /* Monotonic; When SYN|ACK is retransmitted. */
+        time_t established_time_usec; /* Monotonic; Accept takes the oldest established first. */
+        connection_entry_t *entry;    /* NULL while half-open. */
+} pending_connection_t;
+
+/**
+ * @brief Listener's backlog: Half-open and established connections alike count against its capacity.
+ * Unordered; Removal moves the last connection in place of the removed one.
+ */
+typedef struct listen_queue listen_queue_t;
+
+listen_queue_t *lq_create(size_t _backlog);
+status_t lq_destroy(listen_queue_t **_lq_address);
+
+/* @returns the new (zeroed) connection of `_peer`; NULL if the backlog is full. */
+pending_connection_t *lq_add(listen_queue_t *_lq, const struct sockaddr *_peer);
+void lq_remove(listen_queue_t *_lq, pending_connection_t *_connection);
+pending_connection_t *lq_find(listen_queue_t *_lq, const struct sockaddr *_peer);
+pending_connection_t *lq_get(listen_queue_t *_lq, size_t _index);
+pending_connection_t *lq_oldest_established(listen_queue_t *_lq);
+size_t lq_size(const listen_queue_t *_lq);
+
+/* @returns the earliest SYN|ACK retransmission deadline; -1 if no connection is half-open. */
+time_t lq_next_synack_deadline(listen_queue_t *_lq);
+
+#endif /* CORE_LISTEN_QUEUE_H */
@@ -0,0 +1,89 @@
+#ifndef CORE_LISTENER_H
+#define CORE_LISTENER_H
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include "core/connection_table.h"
+#include "core/listen_queue.h"
+#include "core/time_wait_table.h"
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Listener mode (see MICROTCP_SO_LISTENER): Connections accepted by microtcp_accept_connection() share listening
+ * socket's UDP descriptor. Datagrams are demultiplexed by peer's address and port, through a connection table
+ * (see core/connection_table.h), into each connection's inbox; Datagrams of unknown peers (SYNs) go to the unmatched inbox,
+ * where accepting connections look for them.
+ * No thread of its own: Whichever connection waits for datagrams pumps the descriptor (one at a time) and routes
+ * everyone's; Others wait on listener's condition variable. Connections may thus be driven by different threads.
+ * Listener is reference counted; Listening socket and each of its connections hold a reference.
+ */
+typedef struct listener listener_t;
+
+listener_t *listener_create(int _sd);
+
+listener_t *listener_retain(listener_t *_listener);
+
+/**
+ * @brief Drops a reference, and NULLIFIES caller's pointer.
+ * @returns true if it was listener's last reference; Caller then owns (and closes) the descriptor.
+ */
+_Bool listener_release(listener_t **_listener_address);
+
+/* @returns the number of connections (and accepting sockets) holding a reference; Listening socket's one is not counted. */
+size_t listener_connections(listener_t *_listener);
+
+/**
+ * @brief Listener's backlog (see core/listen_queue.h) is worked by one accepting socket at a time; The others wait here.
+ * Handshakes progress whenever an accept runs, connections it completes are queued for the next ones.
+ */
+listen_queue_t *listener_lock_listen_queue(listener_t *_listener);
+void listener_unlock_listen_queue(listener_t *_listener);
+
+/**
+ * @brief Accepting socket completed a handshake: Enters connection's entry (its `peer` set) into the table, so peer's
+ * datagrams are routed to it. Datagrams left in socket's `receive_batch` are routed again, peer's included.
+ * @returns FAILURE if entry's peer already has a connection.
+ */
+status_t listener_attach(microtcp_sock_t *_socket, connection_entry_t *_entry);
+
+/* Removes socket's connection entry from the table (if it is in), and drops the datagrams left in its inbox. */
+void listener_detach(microtcp_sock_t *_socket);
+
+/**
+ * @brief Socket's connection enters TIME_WAIT asynchronously (see core/time_wait_table.h): Its entry stays in the table,
+ * inbox freed, and peer's datagrams are answered by `_time_wait_entry`. Socket gives the entry up.
+ * @returns the entry, for listener_forget() once TIME_WAIT is over; NULL if socket's entry is not in the table.
+ */
+connection_entry_t *listener_linger(microtcp_sock_t *_socket, const time_wait_entry_t *_time_wait_entry);
+void listener_forget(listener_t *_listener, connection_entry_t **_entry_address);
+
+/**
+ * @brief Datagrams routed to the socket wait in its inbox (another one's pumping may have drained the shared descriptor);
+ * Or, for listening sockets, an accept would make progress: An established connection waits in the listen queue, or a
+ * SYN (or handshake's ACK) in the unmatched inbox. Descriptor's own readability is not looked at; See listener_route().
+ */
+_Bool listener_is_readable(microtcp_sock_t *_socket);
+
+/**
+ * @brief Routes the datagrams waiting on listener's descriptor, without waiting for more; Unless a waiter pumps it already.
+ * Lets a poller see what arrived for a listening socket, which no reception of its own pumps.
+ * @returns FAILURE if reception failed.
+ */
+status_t listener_route(listener_t *_listener);
+
+/**
+ * @brief An eventfd, readable once a pumping waiter routed datagrams (maybe into pollers' connections' inboxes, past
+ * their epoll wait); Created by the first call, signaled from then on. Listener owns it; Readers drain it.
+ * @returns -1 if it could not be created.
+ */
+int listener_routed_fd(listener_t *_listener);
+
+/**
+ * @brief Refills socket's (drained) `receive_batch` with the datagrams routed to it; Waits up to `_timeout_usec` for them.
+ * @returns the number of datagrams received, or RECV_SEGMENT_TIMEOUT/RECV_SEGMENT_FATAL_ERROR.
+ */
+ssize_t listener_receive(microtcp_sock_t *_socket, time_t _timeout_usec);
+
+#endif /* CORE_LISTENER_H */
@@ -0,0 +1,27 @@
+#ifndef CORE_PACING_H
+#define CORE_PACING_H
+
+#include <stddef.h>
+#include <time.h>
+#include "microtcp.h"
+
+/**
+ * @brief Packet pacing (see MICROTCP_SO_PACING): A token bucket, refilled at the pacing rate, spreads a round's segments
+ * over the RTT, instead of bursting them into peer's (and switches') buffers. Rate is congestion control module's,
+ * if it sets one (see cc_pacing_rate()), otherwise cwnd / SRTT, scaled up to stay ahead of window's growth.
+ * Bucket holds a millisecond of the rate, and lets bytes out in quanta (a couple of segments, or 100μsec of the rate);
+ * Sends may take it into debt, which later refills repay.
+ * No pacing happens before the first RTT sample.
+ */
+
+/* Next connection starts with a full bucket. */
+void pacing_reset(microtcp_sock_t *_socket);
+
+/* @returns bytes that may leave now; 0 until a quantum of them has built up, SIZE_MAX if the socket is not paced. */
+size_t pacing_allowance(microtcp_sock_t *_socket);
+void pacing_consume(microtcp_sock_t *_socket, size_t _bytes);
+
+/* @returns μsec until allowance turns non-zero; 0 if it already is. */
+time_t pacing_delay_usec(const microtcp_sock_t *_socket);
+
+#endif /* CORE_PACING_H */
@@ -0,0 +1,33 @@
+#ifndef CORE_POLLER_H
+#define CORE_POLLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Behind microtcp_poll(): An epoll instance watches registered sockets' UDP descriptors; Each descriptor once,
+ * as listener's connections share theirs. Readiness is microTCP's, not UDP's: A readable descriptor may hold nothing but
+ * ACKs, so each wait first drives its sockets (reception, ACK processing, timers), then reports what they are ready for.
+ * Only sockets in the ready list are visited: Those of descriptors epoll reported, those whose timers expired, and those
+ * application sent or received on (see poller_touch()). Ready ones stay queued; Sockets past `_max_events` go first.
+ * Connections' timers (retransmission, pacing, delayed ACK) are armed in a timer wheel (see core/timer_wheel.h), at
+ * their deadlines; Its earliest expiry bounds the epoll wait.
+ */
+microtcp_poller_t *poller_create(void);
+status_t poller_destroy(microtcp_poller_t **_poller_address);
+
+status_t poller_add(microtcp_poller_t *_poller, microtcp_sock_t *_socket, uint32_t _events, void *_user_data);
+status_t poller_remove(microtcp_poller_t *_poller, microtcp_sock_t *_socket);
+
+/* Application acted on a registered socket (e.g. its buffered send put segments in flight); Next wait visits it. */
+void poller_touch(microtcp_sock_t *_socket);
+
+/* @returns the number of ready sockets, MICROTCP_POLL_TIMEOUT or MICROTCP_POLL_FAILURE. */
+int poller_wait(microtcp_poller_t *_poller, microtcp_poll_event_t *_events, size_t _max_events, int _timeout_msec);
+
+int poller_fd(const microtcp_poller_t *_poller);
+int poller_timeout_msec(const microtcp_poller_t *_poller);
+
+#endif /* CORE_POLLER_H */
@@ -0,0 +1,37 @@
+#ifndef CORE_PROTOCOL_ENGINE_H
+#define CORE_PROTOCOL_ENGINE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Engine thread mode (see MICROTCP_SO_ENGINE_THREAD): A thread per connection owns the UDP socket, ACK generation,
+ * retransmission timers and reassembly; So ACKs keep flowing, even while the application is not inside microtcp_recv().
+ * Application and engine share only two lock-free SPSC rings (and an eventfd each, for wakeups):
+ * socket's `send_ring` (application -> engine) and engine's `delivery_ring` (engine -> application).
+ * While the engine runs, socket's protocol state (state, seq/ack numbers, buffers...) belongs to it;
+ * pe_stop() hands the connection back to the application thread. Engine holds a lock while it works on the socket
+ * (never while it waits), only so others can read a consistent snapshot.
+ */
+typedef struct protocol_engine protocol_engine_t;
+
+protocol_engine_t *pe_create(microtcp_sock_t *_socket);
+status_t pe_destroy(protocol_engine_t **_pe_address);
+
+status_t pe_start(protocol_engine_t *_pe);
+
+/**
+ * @brief Joins engine's thread; Safe to call on a stopped engine (or one that stopped itself).
+ */
+void pe_stop(protocol_engine_t *_pe);
+
+/* Application's side of microtcp_send() and microtcp_recv(); Same return values and flags. */
+ssize_t pe_send(protocol_engine_t *_pe, const void *_buffer, size_t _length, int _flags);
+ssize_t pe_recv(protocol_engine_t *_pe, void *_buffer, size_t _length, int _flags);
+
+/* Application's side of microtcp_get_info(); Snapshot is taken between engine's passes, under its lock. */
+void pe_get_info(protocol_engine_t *_pe, microtcp_info_t *_info);
+
+#endif /* CORE_PROTOCOL_ENGINE_H */
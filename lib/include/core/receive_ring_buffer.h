@@ -10,7 +10,14 @@
 typedef struct receive_ring_buffer receive_ring_buffer_t;
 typedef struct microtcp_segment microtcp_segment_t;
 
-receive_ring_buffer_t *rrb_create(size_t _rrb_size, uint32_t _current_seq_number);
+/* Contiguous bytes of sequence space. */
+typedef struct
+{
+        uint32_t seq_number; /* Of its first byte. */
+        uint32_t length;
+} rrb_block_t;
+
+receive_ring_buffer_t *rrb_create(size_t _rrb_size, uint32_t _current_seq_number, _Bool _double_mapped);
 status_t rrb_destroy(receive_ring_buffer_t **_rrb_address);
 
 /**
@@ -19,8 +26,23 @@ status_t rrb_destroy(receive_ring_buffer_t **_rrb_address);
 uint32_t rrb_append(receive_ring_buffer_t *_rrb, const microtcp_segment_t *_segment);
 uint32_t rrb_pop(receive_ring_buffer_t *_rrb, void *_buffer, uint32_t _buffer_size);
 
+/**
+ * @brief Zero-copy reading: rrb_readable_region() points to the consumable bytes, and sets `_length` to how many of them
+ * are contiguous (all of them, if RRB is double mapped). Once read, they are released with rrb_consume().
+ */
+const uint8_t *rrb_readable_region(const receive_ring_buffer_t *_rrb, uint32_t *_length);
+void rrb_consume(receive_ring_buffer_t *_rrb, uint32_t _bytes);
+_Bool rrb_is_double_mapped(const receive_ring_buffer_t *_rrb);
+
 uint32_t rrb_size(const receive_ring_buffer_t *_rrb);
 uint32_t rrb_consumable_bytes(const receive_ring_buffer_t *_rrb);
 uint32_t rrb_last_consumed_seq_number(const receive_ring_buffer_t *_rrb);
+uint32_t rrb_out_of_order_bytes(const receive_ring_buffer_t *_rrb); /* Bytes received past a gap. */
+
+/**
+ * @brief Fills `_blocks` with the blocks received out-of-order (past a gap), in sequence number order; Lowest ones first.
+ * @returns Number of blocks found, up to `_max_blocks`.
+ */
+size_t rrb_out_of_order_blocks(const receive_ring_buffer_t *_rrb, rrb_block_t *_blocks, size_t _max_blocks);
 
 #endif /* CORE_RECEIVE_RING_BUFFER_H */
@@ -9,7 +9,7 @@ void release_and_reset_connection_resources(microtcp_sock_t *_socket, microtcp_s
 /**
  * @brief Allocates buffers required for MicroTCP's handshake.
  *
- * Allocates `bytestream_build_buffer` and `bytestream_receive_buffer`.
+ * Allocates `header_build_buffer` and `receive_batch`.
  * Cleans up on failure to prevent memory leaks.
  *
  * @param _socket Pointer to the `microtcp_sock_t` socket.
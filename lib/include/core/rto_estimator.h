@@ -0,0 +1,20 @@
+#ifndef CORE_RTO_ESTIMATOR_H
+#define CORE_RTO_ESTIMATOR_H
+
+#include <time.h>
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Retransmission timeout of RFC 6298: SRTT and RTTVAR are smoothed from RTT samples, RTO = SRTT + max(G, 4 * RTTVAR),
+ * clamped within [get_microtcp_min_rto(), get_microtcp_max_rto()]; Each timeout doubles RTO, until the next sample.
+ * Samples must obey Karn's rule: Retransmitted segments are never timed, as their ACK is ambiguous.
+ * RTO is mirrored in socket's SO_RCVTIMEO, so blocking receptions time out with it.
+ */
+
+/* Back to the initial RTO (`get_microtcp_ack_timeout()`); No RTT is known. */
+status_t rto_reset(microtcp_sock_t *_socket);
+void rto_sample(microtcp_sock_t *_socket, time_t _rtt_usec);
+void rto_backoff(microtcp_sock_t *_socket);
+
+#endif /* CORE_RTO_ESTIMATOR_H */
@@ -0,0 +1,29 @@
+#ifndef CORE_SACK_H
+#define CORE_SACK_H
+
+#include <stddef.h>
+#include "microtcp.h"
+#include "core/receive_ring_buffer.h"
+
+/**
+ * @brief Selective acknowledgements (see MICROTCP_SO_SACK): ACKs report up to SACK_MAX_BLOCKS blocks, that receiver holds past a gap;
+ * Sender then retransmits only the holes between them. Blocks ride in header's `future_use` words, one per word:
+ * Offset of block's first byte from header's `ack_number` (upper 16 bits) and block's length (lower 16 bits); 0 for no block.
+ * 16 bits fit any window of the non-optimized header; The optimized header has no spare words, so there is no SACK in OPTIMIZED_MODE.
+ */
+#define SACK_MAX_BLOCKS 3 /* One per `future_use` word. */
+#ifdef OPTIMIZED_MODE
+#define SACK_SUPPORTED 0
+#else
+#define SACK_SUPPORTED 1
+#endif /* OPTIMIZED_MODE */
+
+/* Writes the lowest out-of-order blocks of `_rrb` into `_header`; Its `ack_number` must be set. */
+void sack_encode(microtcp_header_t *_header, const receive_ring_buffer_t *_rrb);
+
+/**
+ * @returns Number of blocks carried by `_header` (written to `_blocks`, which must fit SACK_MAX_BLOCKS).
+ */
+size_t sack_decode(const microtcp_header_t *_header, rrb_block_t *_blocks);
+
+#endif /* CORE_SACK_H */
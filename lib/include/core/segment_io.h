@@ -16,6 +16,7 @@
 #define RECV_SEGMENT_SYN_EXPECTED (-5)
 #define RECV_SEGMENT_FINACK_UNEXPECTED (-6)
 #define RECV_SEGMENT_CARRIES_DATA (-7)
+#define RECV_SEGMENT_ACK_RECEIVED (-8) /* A pure ACK, where a data segment was expected. */
 #define RECV_SEGMENT_EXCEPTION_THRESHOLD RECV_SEGMENT_TIMEOUT
 
 /* HANDSHAKE CONTROL */
@@ -31,9 +32,29 @@ ssize_t receive_synack_control_segment(microtcp_sock_t *_socket, struct sockaddr
 ssize_t receive_ack_control_segment(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, uint32_t _required_ack_number);
 ssize_t receive_finack_control_segment(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, uint32_t _required_ack_number);
 
+/**
+ * @brief Listener's backlog and SYN cookies: Receives any intact segment (SYNs, ACKs of SYN|ACKs, RSTs...) into
+ * `segment_receive_buffer`; Blocking waits up to socket's RTO. Caller matches it against its handshakes.
+ */
+ssize_t receive_handshake_segment(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, _Bool _block);
+
 /* DATA */
 size_t send_data_segment(microtcp_sock_t *_socket, const void *_buffer, size_t _segment_size, uint32_t _seq_number);
 ssize_t receive_data_segment(microtcp_sock_t *_socket, _Bool _block);
 ssize_t receive_data_ack_segment(microtcp_sock_t *_socket, _Bool _block);
 
+/* BATCHED DATA */
+/**
+ * @brief Queues a data segment into socket's `send_batch`, instead of sending it immediately.
+ * If the batch is full, it is flushed first.
+ * @returns the size of the queued segment (header + payload) or SEND_SEGMENT_FATAL_ERROR.
+ */
+ssize_t queue_data_segment(microtcp_sock_t *_socket, const void *_buffer, size_t _segment_size, uint32_t _seq_number);
+
+/**
+ * @brief Sends every queued data segment, with as few sendmmsg() calls as possible.
+ * @returns the number of bytes sent or SEND_SEGMENT_FATAL_ERROR.
+ */
+ssize_t flush_data_segments(microtcp_sock_t *_socket);
+
 #endif /* CORE_CONTROL_SEGMENTS_IO_H */
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
 #include "microtcp.h"
 
 struct microtcp_segment
@@ -11,6 +12,9 @@ struct microtcp_segment
         uint8_t *raw_payload_bytes;
 };
 
+/* A serialized segment is scattered in two pieces: header and payload. */
+#define MICROTCP_SEGMENT_IOVECS 2
+
 typedef struct
 {
         uint8_t *raw_bytes;
@@ -18,8 +22,16 @@ typedef struct
 } microtcp_payload_t;
 
 microtcp_segment_t *construct_microtcp_segment(microtcp_sock_t *_socket, uint32_t _seq_number, uint16_t _control, microtcp_payload_t _payload);
-void *serialize_microtcp_segment(microtcp_sock_t *_socket, microtcp_segment_t *_segment);
+size_t serialize_microtcp_segment(microtcp_segment_t *_segment, void *_header_buffer, struct iovec *_iovecs);
 _Bool is_valid_microtcp_bytestream(void *_bytestream_buffer, ssize_t _bytestream_buffer_length);
+
+/**
+ * @brief Split checksum validation, for payloads that are checksummed elsewhere (e.g. while copied, see rrb_append()).
+ * begin_microtcp_checksum() returns the running CRC32 over `_header` (its checksum field zeroed); Payload is fed on top of it,
+ * and end_microtcp_checksum() tells if the final CRC32 matches the one carried in `_header`.
+ */
+uint32_t begin_microtcp_checksum(const microtcp_header_t *_header);
+_Bool end_microtcp_checksum(const microtcp_header_t *_header, uint32_t _running_crc);
 void extract_microtcp_segment(microtcp_segment_t **_segment_buffer, void *_bytestream_buffer, size_t _bytestream_buffer_length);
 
 #endif /* CORE_SEGMENT_PROCESSING_H */
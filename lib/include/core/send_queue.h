@@ -3,28 +3,37 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #include "microtcp_defines.h"
 #include "status.h"
 
-typedef struct send_queue_node send_queue_node_t;
-struct send_queue_node
+/* Descriptor of an unacknowledged segment; Payload stays in user's buffer. */
+typedef struct send_queue_node
 {
         const void *buffer;
         uint32_t segment_size;
         uint32_t seq_number;
-        send_queue_node_t *next;
-};
+        _Bool retransmitted;           /* Karn's rule: ACK of a retransmitted segment is no RTT sample. */
+        _Bool sacked;                  /* Peer reported holding it; Never retransmitted (see sq_mark_sacked()). */
+        time_t transmission_time_usec; /* Monotonic; Of its first transmission. */
+        uint64_t delivered_at_send;    /* Bytes acknowledged over the connection, by then (see cc_delivered()). */
+} send_queue_node_t;
 
 typedef struct send_queue send_queue_t;
 
-send_queue_t *sq_create(void);
+send_queue_t *sq_create(size_t _max_window_size);
 status_t sq_destroy(send_queue_t **_sq);
 void sq_enqueue(send_queue_t *_sq, uint32_t _seq_number, uint32_t _segment_size, const void *_buffer);
-size_t sq_dequeue(send_queue_t *_sq, uint32_t _ack_number);
+size_t sq_dequeue(send_queue_t *_sq, uint32_t _ack_number, send_queue_node_t *_last_acked_node);
 void sq_flush(send_queue_t *_sq);
+size_t sq_capacity(send_queue_t *_sq);
 size_t sq_stored_segments(send_queue_t *_sq);
 size_t sq_stored_bytes(send_queue_t *_sq);
 _Bool sq_is_empty(send_queue_t *_sq);
+_Bool sq_is_full(send_queue_t *_sq);
 send_queue_node_t *sq_front(send_queue_t *_sq);
+send_queue_node_t *sq_get(send_queue_t *_sq, size_t _index);
+size_t sq_find_index(send_queue_t *_sq, uint32_t _seq_number);
+size_t sq_mark_sacked(send_queue_t *_sq, uint32_t _seq_number, uint32_t _length);
 
 #endif /* CORE_SEND_QUEUE_H */
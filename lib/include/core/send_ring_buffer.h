@@ -0,0 +1,47 @@
+#ifndef CORE_SEND_RING_BUFFER_H
+#define CORE_SEND_RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "status.h"
+
+/**
+ * @brief Socket owned copy of data handed to microtcp_send(), in buffered send mode.
+ * Bytes are stored in sequence number order; The oldest one is the first unacknowledged byte.
+ * Lock-free for a single producer (srb_push(), srb_reserve(), srb_commit()) and a single consumer (srb_peek(), srb_pop(), srb_release()),
+ * running on different threads; Engine thread mode also uses one, to deliver received bytes to the application.
+ */
+typedef struct send_ring_buffer send_ring_buffer_t;
+
+send_ring_buffer_t *srb_create(size_t _srb_size);
+status_t srb_destroy(send_ring_buffer_t **_srb_address);
+
+/**
+ * @returns Number of bytes copied in the Send-Ring-Buffer (limited by its free space).
+ */
+size_t srb_push(send_ring_buffer_t *_srb, const void *_buffer, size_t _length);
+
+/**
+ * @brief Points to the stored byte `_offset` bytes after the oldest one, and sets `_contiguous` to how many stored bytes
+ * follow it without wrapping around.
+ */
+const uint8_t *srb_peek(const send_ring_buffer_t *_srb, size_t _offset, size_t *_contiguous);
+void srb_release(send_ring_buffer_t *_srb, size_t _bytes);
+
+/**
+ * @returns Number of bytes copied out of the Send-Ring-Buffer (and released).
+ */
+size_t srb_pop(send_ring_buffer_t *_srb, void *_buffer, size_t _length);
+
+/**
+ * @brief Points to the first free byte, and sets `_contiguous` to how many free bytes follow it without wrapping around.
+ * Producer fills them in place, then makes them visible with srb_commit().
+ */
+uint8_t *srb_reserve(send_ring_buffer_t *_srb, size_t *_contiguous);
+void srb_commit(send_ring_buffer_t *_srb, size_t _bytes);
+
+size_t srb_size(const send_ring_buffer_t *_srb);
+size_t srb_stored_bytes(const send_ring_buffer_t *_srb);
+size_t srb_free_space(const send_ring_buffer_t *_srb);
+
+#endif /* CORE_SEND_RING_BUFFER_H */
@@ -0,0 +1,10 @@
+#ifndef CORE_SOCKET_OPTIONS_H
+#define CORE_SOCKET_OPTIONS_H
+
+#include <sys/socket.h>
+#include "microtcp.h"
+
+int set_microtcp_socket_option(microtcp_sock_t *_socket, microtcp_sockopt_t _option, const void *_value, socklen_t _value_len);
+int get_microtcp_socket_option(microtcp_sock_t *_socket, microtcp_sockopt_t _option, void *_value, socklen_t *_value_len);
+
+#endif /* CORE_SOCKET_OPTIONS_H */
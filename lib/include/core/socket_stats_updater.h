@@ -1,11 +1,55 @@
 #ifndef CORE_SOCKET_STATS_UPDATER_H
 #define CORE_SOCKET_STATS_UPDATER_H
 
+#include <stdatomic.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "core/stats_export.h"
 #include "microtcp.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
 
 void update_socket_sent_counters(microtcp_sock_t *_socket, size_t _bytes_sent);
 void update_socket_received_counters(microtcp_sock_t *_socket, size_t _bytes_received);
 void update_socket_lost_counters(microtcp_sock_t *_socket, size_t _bytes_lost);
 
+/* Fills a snapshot of socket's connection (see microtcp_get_info()); Caller owns the connection (see pe_get_info()). */
+void get_socket_info(const microtcp_sock_t *_socket, microtcp_info_t *_info);
+
+/* Hot path updaters; Inlined, each costs a few instructions (and a clock read, where time is accounted). */
+
+/* Log-scale bucket of a sample (see MICROTCP_HISTOGRAM_BUCKETS); Its bit length. */
+static __always_inline size_t get_histogram_bucket(const time_t _usec)
+{
+        if (_usec <= 0)
+                return 0;
+        return MIN((size_t)(64 - __builtin_clzll((unsigned long long)_usec)), (size_t)MICROTCP_HISTOGRAM_BUCKETS - 1);
+}
+
+static __always_inline void update_socket_rtt_histogram(microtcp_sock_t *const _socket, const time_t _rtt_usec)
+{
+        _socket->stats.rtt_histogram[get_histogram_bucket(_rtt_usec)]++;
+}
+
+/* Application's thread only; A relaxed load and store, no locked instruction. */
+static __always_inline void update_socket_send_latency_histogram(microtcp_sock_t *const _socket, const time_t _latency_usec)
+{
+        _Atomic uint64_t *const bucket = &_socket->application_stats.send_latency_histogram[get_histogram_bucket(_latency_usec)];
+        atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Charges the time since `_entered_usec` to send FSM's `_substate`.
+ * @returns now; When the next substate is entered, so each transition costs a single clock read.
+ */
+static __always_inline time_t update_socket_send_fsm_time(microtcp_sock_t *const _socket, const microtcp_send_fsm_substate_t _substate,
+                                                          const time_t _entered_usec)
+{
+        const time_t now_usec = get_monotonic_time_usec();
+        _socket->stats.send_fsm_usec[_substate] += now_usec - _entered_usec;
+        stats_export_publish_if_due(_socket, now_usec);
+        return now_usec;
+}
+
 #endif /* CORE_SOCKET_STATS_UPDATER_H */
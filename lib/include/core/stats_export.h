@@ -0,0 +1,117 @@
+#ifndef CORE_STATS_EXPORT_H
+#define CORE_STATS_EXPORT_H
+
+#include <netinet/in.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Statistics exporter (see microtcp_stats_export_start()): Publishes process-wide totals, and a snapshot of each
+ * connection (see microtcp_info_t), to a shared memory segment; Monitors (e.g. `microtcp_stat`) map it read-only.
+ * Each connection owns a slot and publishes into it itself, at most every STATS_EXPORT_INTERVAL_USEC, wherever its thread
+ * reads the clock anyway: Send FSM's transitions, receivers' waits for datagrams, microtcp_send() and microtcp_recv() returns,
+ * reception timeouts, poller passes, engine's loop.
+ * No locks and no logging on that path; While exporting is off, a NULL check is all it costs.
+ * Writers never wait for readers: Header's totals and each slot are seqlocks. Readers retry while a write is in progress
+ * (odd sequence), or if the sequence moved while they copied.
+ */
+
+#define STATS_EXPORT_SHM_NAME_PREFIX "/microtcp_stats." /* Followed by exporting process's pid. */
+#define STATS_EXPORT_ENVIRONMENT_VARIABLE "MICROTCP_STATS_EXPORT" /* If set, exporter starts along with the process. */
+#define STATS_EXPORT_MAGIC 0x7063546du /* "mTcp" */
+#define STATS_EXPORT_VERSION 1
+#define STATS_EXPORT_SLOTS 1024
+#define STATS_EXPORT_INTERVAL_USEC 100000
+
+typedef struct
+{
+        uint64_t connections_opened;
+        uint64_t connections_closed;
+        uint64_t connections_unexported; /* Opened while every slot was taken. */
+
+        /* Closed connections' sums; Live connections' counters are in their slots. */
+        uint64_t packets_sent;
+        uint64_t packets_lost;
+        uint64_t packets_received;
+        uint64_t bytes_sent;
+        uint64_t bytes_lost;
+        uint64_t bytes_received;
+        uint64_t timeouts;
+        uint64_t timeout_retransmits;
+        uint64_t fast_retransmits;
+        uint64_t duplicate_acks;
+} stats_export_totals_t;
+
+struct stats_export_slot
+{
+        _Atomic uint32_t sequence; /* Seqlock of the fields below; Odd while its connection writes them. */
+        _Bool in_use;
+        struct sockaddr_in local_address;
+        struct sockaddr_in peer_address;
+        time_t published_usec; /* Monotonic. */
+        microtcp_info_t info;
+};
+typedef struct stats_export_slot stats_export_slot_t;
+
+/* Shared memory segment's layout. */
+typedef struct
+{
+        uint32_t magic;
+        uint32_t version;
+        pid_t pid;
+        uint32_t slot_count;
+        _Atomic uint32_t sequence; /* Seqlock of `totals`. */
+        stats_export_totals_t totals;
+        stats_export_slot_t slots[STATS_EXPORT_SLOTS];
+} stats_export_t;
+
+/* Maps a fresh segment, named after the process; Idempotent. */
+status_t stats_export_start(void);
+
+/* Connection got established; It is exported, if exporter runs and a slot is free. */
+void stats_export_acquire_slot(microtcp_sock_t *_socket);
+
+/* Connection is over; Its last snapshot is published, and its counters are added to the totals. */
+void stats_export_release_slot(microtcp_sock_t *_socket);
+
+void stats_export_publish(microtcp_sock_t *_socket, time_t _now_usec);
+
+static __always_inline void stats_export_publish_if_due(microtcp_sock_t *const _socket, const time_t _now_usec)
+{
+        if (_socket->stats_export_slot != NULL && _now_usec >= _socket->stats_export_due_usec)
+                stats_export_publish(_socket, _now_usec);
+}
+
+/* Seqlock; A single writer at a time (slot's connection, or totals' updater holding exporter's lock). */
+static inline void stats_export_write_begin(_Atomic uint32_t *const _sequence)
+{
+        atomic_store_explicit(_sequence, atomic_load_explicit(_sequence, memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release); /* Odd sequence is visible before any field changes. */
+}
+
+static inline void stats_export_write_end(_Atomic uint32_t *const _sequence)
+{
+        atomic_store_explicit(_sequence, atomic_load_explicit(_sequence, memory_order_relaxed) + 1, memory_order_release);
+}
+
+/* @returns the sequence to hand to stats_export_read_retry(); Waits out a write in progress. */
+static inline uint32_t stats_export_read_begin(const _Atomic uint32_t *const _sequence)
+{
+        uint32_t sequence;
+        while ((sequence = atomic_load_explicit(_sequence, memory_order_acquire)) & 1)
+                ;
+        return sequence;
+}
+
+/* @returns true if fields were written meanwhile; The copy is torn, read them again. */
+static inline _Bool stats_export_read_retry(const _Atomic uint32_t *const _sequence, const uint32_t _begin_sequence)
+{
+        atomic_thread_fence(memory_order_acquire); /* Copied fields are read before the sequence is checked again. */
+        return atomic_load_explicit(_sequence, memory_order_relaxed) != _begin_sequence;
+}
+
+#endif /* CORE_STATS_EXPORT_H */
@@ -0,0 +1,27 @@
+#ifndef CORE_SYN_COOKIE_H
+#define CORE_SYN_COOKIE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include "status.h"
+
+/**
+ * @brief SYN cookies (see MICROTCP_SO_SYN_COOKIES): Server's ISN encodes the handshake, so nothing is kept for a peer
+ * until its ACK returns the cookie. Top 8 bits carry a coarse monotonic counter (one tick per SYN_COOKIE_TICK_SEC),
+ * lower 24 bits a SipHash-2-4 of peer's address, port, ISN and that counter, keyed with a per process random secret.
+ */
+#define SYN_COOKIE_TICK_SEC 64 /* A cookie is valid for 1 to 2 ticks. */
+
+/* Generates the secret key, once per process (on first use, not at load time); FAILURE if no randomness could be had. */
+status_t syn_cookie_initialize(void);
+
+uint32_t syn_cookie_generate(const struct sockaddr *_peer, uint32_t _peer_isn);
+
+/* @returns true if `_cookie` (ACK's ack number - 1) was generated for `_peer` and its ISN, during the current or previous tick. */
+_Bool syn_cookie_validate(const struct sockaddr *_peer, uint32_t _peer_isn, uint32_t _cookie);
+
+/* Cookies' keyed hash; `_words` are the message's little-endian 64-bit words (a message of `_words_count` * 8 bytes). */
+uint64_t syn_cookie_siphash_2_4(const uint64_t _key[2], const uint64_t *_words, size_t _words_count);
+
+#endif /* CORE_SYN_COOKIE_H */
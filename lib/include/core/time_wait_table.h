@@ -0,0 +1,31 @@
+#ifndef CORE_TIME_WAIT_TABLE_H
+#define CORE_TIME_WAIT_TABLE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "microtcp.h"
+#include "status.h"
+
+/**
+ * @brief Asynchronous TIME_WAIT (see MICROTCP_SO_ASYNC_TIME_WAIT): Active shutdown hands its connection over once the
+ * FIN exchange is done, and returns. For each lingering connection, the table keeps only peer's address and the final
+ * sequence numbers. It re-ACKs peer's retransmitted FIN|ACKs (when our last ACK got lost), and forgets the connection
+ * after get_shutdown_time_wait_period(). Other segments, RSTs included (RFC 1337), are ignored.
+ * Process-wide; Its thread starts with the first hand-over. Expiries run on a timer wheel (see core/timer_wheel.h).
+ * Listener's connections only: Connection's entry stays in listener's table (its inbox freed), so the listener keeps
+ * routing peer's datagrams to it; They are answered by time_wait_answer_datagram(), whenever some waiter pumps the
+ * descriptor. Table's thread watches lingering connections' descriptors, and pumps them itself if no waiter does.
+ * A plain socket owns its UDP port; Lingering in the background would keep it bound, so setsockopt() rejects the option.
+ */
+typedef struct time_wait_entry time_wait_entry_t;
+
+/* Called by active shutdown of listener's connections, in their TIME_WAIT; Resources socket still holds are released as usual afterwards. */
+status_t time_wait_table_add(microtcp_sock_t *_socket);
+
+/* Answers a datagram peer sent to a connection lingering in TIME_WAIT; Through `_sd`, the descriptor it arrived at. */
+void time_wait_answer_datagram(const time_wait_entry_t *_entry, int _sd, void *_bytestream, ssize_t _bytestream_length);
+
+/* @returns the number of connections lingering in TIME_WAIT. */
+size_t time_wait_table_size(void);
+
+#endif /* CORE_TIME_WAIT_TABLE_H */
@@ -0,0 +1,65 @@
+#ifndef CORE_TIMER_WHEEL_H
+#define CORE_TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "status.h"
+
+/**
+ * @brief A timer, embedded in whatever it times (a connection's retransmission, delayed ACK, or TIME_WAIT timer...).
+ * Owned by its embedder; The wheel only links it. Fields are the wheel's; Set `owner` through tw_timer_init().
+ */
+typedef struct wheel_timer
+{
+        time_t expiry_usec;    /* Monotonic. */
+        uint64_t expiry_tick;  /* Rounded up; Timers never expire early. */
+        void *owner;           /* Embedder's; Tells expired timer's handler whose timer it is. */
+        uint8_t level;         /* Wheel level (or expired list) timer is linked in. */
+        uint8_t slot;
+        struct wheel_timer *next;
+        struct wheel_timer **previous_next; /* NULL while disarmed. */
+} wheel_timer_t;
+
+/**
+ * @brief Hierarchical timing wheel (Varghese & Lauck): TIMER_WHEEL_LEVELS wheels of 64 slots, each slot of a level
+ * spanning a whole turn of the level below. Arming and canceling are O(1); Timers cascade down (at most once per level)
+ * as their expiry nears, and expire from the lowest level's slots, which are one TIMER_WHEEL_TICK_USEC wide.
+ * Per level, a bitmap of occupied slots lets the wheel skip empty ticks, so idle time costs nothing.
+ * Timers further out than the wheels reach are parked in the top level's farthest slot, and re-armed once they get there.
+ * Not thread-safe; Wheel is driven by whoever owns it (e.g. a poller, or TIME_WAIT table's thread).
+ */
+typedef struct timer_wheel timer_wheel_t;
+
+#define TIMER_WHEEL_TICK_USEC 100
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_NO_EXPIRY (-1)
+
+timer_wheel_t *tw_create(void);
+status_t tw_destroy(timer_wheel_t **_tw_address);
+
+void tw_timer_init(wheel_timer_t *_timer, void *_owner);
+
+/* Arms timer to expire at `_expiry_usec` (monotonic); Re-arms it, if it is armed already. Past expiries expire at once. */
+void tw_arm(timer_wheel_t *_tw, wheel_timer_t *_timer, time_t _expiry_usec);
+
+/* Disarms timer; Harmless if it is not armed. */
+void tw_cancel(timer_wheel_t *_tw, wheel_timer_t *_timer);
+
+static inline _Bool tw_is_armed(const wheel_timer_t *const _timer)
+{
+        return _timer->previous_next != NULL;
+}
+
+/* Advances the wheel to `_now_usec`. @returns the next expired timer (now disarmed), NULL once there is none. */
+wheel_timer_t *tw_pop_expired(timer_wheel_t *_tw, time_t _now_usec);
+
+/**
+ * @returns when the earliest timer expires, rounded up to a tick (earlier, if that timer has yet to cascade);
+ * TIMER_WHEEL_NO_EXPIRY if no timer is armed. Waiting until then and popping the expired timers never misses one.
+ */
+time_t tw_next_expiry_usec(const timer_wheel_t *_tw);
+
+size_t tw_armed_timers(const timer_wheel_t *_tw);
+
+#endif /* CORE_TIMER_WHEEL_H */
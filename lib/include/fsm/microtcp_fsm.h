@@ -2,6 +2,7 @@
 #define FSM_MICROTCP_FSM_H
 
 #include "microtcp.h"
+#include "status.h"
 
 int microtcp_connect_fsm(microtcp_sock_t *_socket, const struct sockaddr *_address, socklen_t _address_len);
 int microtcp_accept_fsm(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len);
@@ -9,4 +10,12 @@ ssize_t microtcp_send_fsm(microtcp_sock_t *_socket, const void *_buffer, size_t
 int microtcp_shutdown_active_fsm(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len);
 int microtcp_shutdown_passive_fsm(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len);
 
+/* Buffered send mode (see MICROTCP_SO_SEND_BUFFER). */
+send_fsm_context_t *create_send_fsm_context(void);
+ssize_t microtcp_send_buffered_fsm(microtcp_sock_t *_socket, const void *_buffer, size_t _length, int _flags);
+status_t microtcp_send_fsm_progress(microtcp_sock_t *_socket, _Bool _block);
+status_t microtcp_send_fsm_process_ack(microtcp_sock_t *_socket);
+time_t microtcp_send_fsm_pacing_delay_usec(const microtcp_sock_t *_socket);
+time_t microtcp_send_fsm_retransmission_delay_usec(const microtcp_sock_t *_socket);
+
 #endif /* FSM_MICROTCP_FSM_H */
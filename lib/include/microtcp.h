@@ -9,6 +9,7 @@
 #error GNU extensions required!
 #endif /* __GNUC__ */
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -20,6 +21,17 @@
 
 typedef struct microtcp_segment microtcp_segment_t;
 typedef struct send_queue send_queue_t;
+typedef struct send_ring_buffer send_ring_buffer_t;
+typedef struct send_fsm_context send_fsm_context_t;
+typedef struct protocol_engine protocol_engine_t;
+typedef struct datagram_batch datagram_batch_t;
+typedef struct congestion_control congestion_control_t;
+typedef struct congestion_control_ops congestion_control_ops_t;
+typedef struct listener listener_t;
+typedef struct connection_entry connection_entry_t;
+typedef struct poller microtcp_poller_t;
+typedef struct poller_registration poller_registration_t;
+typedef struct stats_export_slot stats_export_slot_t;
 
 /**
  * microTCP header structure
@@ -95,6 +107,70 @@ typedef enum
         CLOSING_BY_HOST = 1 << 6,
 } microtcp_state_t;
 
+/**
+ * Per socket options of the extended API; See microtcp_setsockopt().
+ */
+typedef enum
+{
+        MICROTCP_SO_UDP_OFFLOAD, /* int; Non-zero sends data rounds as UDP GSO super-datagrams, and receives with UDP GRO. (Default: 0) */
+        MICROTCP_SO_SEND_BUFFER, /* int; Size of an owned send buffer (power of 2), enabling buffered send; 0 disables it. (Default: 0) */
+        MICROTCP_SO_ENGINE_THREAD, /* int; Non-zero runs the connection on its own protocol engine thread; Implies buffered send. Connect and plain accept only; Listeners reject it. (Default: 0) */
+        MICROTCP_SO_CONGESTION_CONTROL, /* char[]; Congestion control module's name: "reno", "cubic" or "bbr". (Default: get_microtcp_congestion_control()) */
+        MICROTCP_SO_SACK, /* int; Non-zero reports out-of-order blocks in ACKs, and retransmits only what peer reports missing. Not in OPTIMIZED_MODE. (Default: 0) */
+        MICROTCP_SO_PACING, /* int; Non-zero spreads each send round over the RTT (token bucket), instead of bursting it. (Default: 0) */
+        MICROTCP_SO_LISTENER, /* int; Non-zero makes the socket a listener: microtcp_accept_connection() returns connections sharing its UDP socket. (Default: 0) */
+        MICROTCP_SO_SYN_COOKIES, /* int; Non-zero answers SYNs statelessly (see core/syn_cookie.h); Nothing is kept for a peer until its ACK returns. Enabling fails if no secret key can be generated. (Default: 0) */
+        MICROTCP_SO_ASYNC_TIME_WAIT, /* int; Non-zero makes active shutdown return after the FIN exchange; TIME_WAIT lingers in the background (see core/time_wait_table.h). Listener mode only (enable MICROTCP_SO_LISTENER first); Plain sockets reject it, as their port would stay bound. (Default: 0) */
+} microtcp_sockopt_t;
+
+/**
+ * Readiness events of microtcp_poll(); A bitmask, alike microtcp_state_t.
+ */
+typedef enum
+{
+        MICROTCP_POLLIN = 1 << 0,  /* microtcp_recv() returns data without blocking. On a LISTEN socket: A handshake's segment waits for accept. */
+        MICROTCP_POLLOUT = 1 << 1, /* microtcp_send() takes data; In buffered send mode, without blocking on a full send buffer. */
+        MICROTCP_POLLERR = 1 << 2, /* Connection broke (RST, stalled peer, host failure). Always reported. */
+        MICROTCP_POLLHUP = 1 << 3, /* Peer closed its side (FIN|ACK); Data it sent before, is still readable. Always reported. */
+} microtcp_poll_events_t;
+
+#define MICROTCP_HISTOGRAM_BUCKETS 32 /* Log-scale: Bucket 0 counts samples of 0μsec, bucket `i` those within [2^(i-1), 2^i) μsec; The last one, all longer. */
+
+/**
+ * Send FSM's substates, whose time is accounted in `microtcp_connection_stats_t`.
+ */
+typedef enum
+{
+        MICROTCP_SEND_FSM_DATA_ROUND,       /* Transmitting a round's segments. */
+        MICROTCP_SEND_FSM_ACK_ROUND,        /* Waiting for (and processing) round's ACKs; Paced transmissions included. */
+        MICROTCP_SEND_FSM_RETRANSMISSIONS,  /* Retransmitting, after a timeout. */
+        MICROTCP_SEND_FSM_PEER_WINDOW_ZERO, /* Probing peer's closed window. */
+        MICROTCP_SEND_FSM_SUBSTATES,
+} microtcp_send_fsm_substate_t;
+
+/**
+ * Connection's event counters and histograms; Kept in the socket, updated on the hot path (see core/socket_stats_updater.h).
+ */
+typedef struct
+{
+        uint64_t timeouts;            /* Retransmission timer expirations. */
+        uint64_t timeout_retransmits; /* Segments retransmitted after a timeout. */
+        uint64_t fast_retransmits;    /* Segments retransmitted in fast recovery (3 duplicate ACKs, partial ACKs, SACK holes). */
+        uint64_t duplicate_acks;
+        time_t send_fsm_usec[MICROTCP_SEND_FSM_SUBSTATES];             /* Time spent in each send FSM substate. */
+        uint64_t rtt_histogram[MICROTCP_HISTOGRAM_BUCKETS];          /* RTT samples; Retransmitted segments are not timed (Karn's rule). */
+        uint64_t send_latency_histogram[MICROTCP_HISTOGRAM_BUCKETS]; /* microtcp_send() calls, from entry to return. */
+} microtcp_connection_stats_t;
+
+/**
+ * Counters of the application's thread; In engine thread mode, `microtcp_connection_stats_t` is engine's.
+ * Single writer; Other threads (engine publishing statistics) read them relaxed.
+ */
+typedef struct
+{
+        _Atomic uint64_t send_latency_histogram[MICROTCP_HISTOGRAM_BUCKETS]; /* Reported in `microtcp_connection_stats_t`. */
+} microtcp_application_stats_t;
+
 /**
  * This is the microTCP socket structure. It holds all the necessary
  * information of each microTCP socket.
@@ -110,8 +186,25 @@ typedef struct
 
         receive_ring_buffer_t *bytestream_rrb; /* a.k.a `recvbuf`, used to store and reassmble bytes of incoming packets. */
 
+        /* Owned by congestion control module; Send FSM reads the window through cc_cwnd(). */
         size_t cwnd;
         size_t ssthresh;
+        congestion_control_t *congestion_control; /* Module and its per connection state; Allocated after the handshake. */
+
+        /* Retransmission timeout (RFC 6298), estimated from ACK timing (see core/rto_estimator.h).
+         * Blocking receptions wait for it too; Socket's SO_RCVTIMEO always holds `rto_usec`. */
+        time_t srtt_usec;   /* Smoothed RTT; 0 until the first sample. */
+        time_t rttvar_usec; /* RTT variation. */
+        time_t rto_usec;
+
+        /* Pacing token bucket (see core/pacing.h). */
+        int64_t pacing_tokens;     /* Bytes; Negative while in debt. */
+        time_t pacing_refill_usec; /* Monotonic; Of the last refill, 0 before the first one. */
+
+        /* Delayed ACKs (see core/delayed_ack.h). */
+        uint32_t unacked_segments;  /* Full, in-order data segments received since our last ACK. */
+        time_t ack_deadline_usec;   /* Monotonic; When the pending ACK is due, 0 if none is pending. */
+        size_t advertised_win_size; /* Window our last ACK advertised. */
 
         uint32_t seq_number;       /* Keep the state of the sequence number. */
         uint32_t ack_number;       /* Keep the state of the ack number. */
@@ -121,6 +214,10 @@ typedef struct
         uint64_t bytes_sent;       /* Bytes that were sent from socket. */
         uint64_t bytes_lost;       /* Bytes that were sent from socket, but (probably) lost. */
         uint64_t bytes_received;   /* Bytes that were received from socket. */
+        microtcp_connection_stats_t stats;
+        microtcp_application_stats_t application_stats;
+        stats_export_slot_t *stats_export_slot; /* Shared memory slot, while exporter runs (see core/stats_export.h); NULL otherwise. */
+        time_t stats_export_due_usec;           /* Monotonic; Next publication into the slot. */
 
         /* Instead of allocating buffers all the time, constructing and receiving
          * MicroTCP segments, we allocate 3 buffers that do all immediate receiving
@@ -131,21 +228,77 @@ typedef struct
          * receiving and sending data, which hinder transmissions speeds.
          */
         microtcp_segment_t *segment_build_buffer;
-        void *bytestream_build_buffer;
+        void *header_build_buffer; /* Serialized header slot; Payload is gathered straight from user's buffer by sendmsg(). */
         send_queue_t *send_queue;
+        datagram_batch_t *send_batch; /* Data segments of a send round, flushed with a single sendmmsg(). */
+
+        /* Buffered send mode (see MICROTCP_SO_SEND_BUFFER): microtcp_send() copies data into `send_ring` and returns,
+         * transmissions and ACK processing progress in later send/recv/shutdown calls. */
+        send_ring_buffer_t *send_ring;
+        send_fsm_context_t *send_context; /* Send FSM's state, kept between calls. */
+
+        /* Engine thread mode (see MICROTCP_SO_ENGINE_THREAD): While engine runs, it owns every other connection field;
+         * microtcp_send() and microtcp_recv() only exchange bytes with it. Socket must not be moved while connected. */
+        protocol_engine_t *engine;
 
         /* During data transfering only receiver thread has access. (deprecated IDEA) */
         microtcp_segment_t *segment_receive_buffer;
-        void *bytestream_receive_buffer;
+        datagram_batch_t *receive_batch; /* Datagrams drained with a single recvmmsg(), handed out one by one. */
         struct sockaddr *peer_address;
         _Bool data_reception_with_finack;
 
+        /* Per socket options (see microtcp_setsockopt()). */
+        _Bool udp_offload;
+        size_t send_buffer_size;
+        _Bool engine_thread;
+        const congestion_control_ops_t *congestion_control_ops; /* NULL: Module set by set_microtcp_congestion_control(). */
+        _Bool sack;
+        _Bool pacing;
+        _Bool syn_cookies;
+        _Bool async_time_wait;
+
+        /* Listener mode (see MICROTCP_SO_LISTENER and core/listener.h): Listening socket and its connections share `sd`,
+         * receiving through the listener. Only connections have an entry in listener's connection table. */
+        listener_t *listener;
+        connection_entry_t *connection_entry;
+
+        poller_registration_t *poller_registration; /* See microtcp_poller_add(); Application's sends and receptions queue it. */
+
 #ifdef LOG_TRAFFIC_MODE
         FILE *inbound_traffic_log;
         FILE *outbound_traffic_log;
 #endif /* LOG_TRAFFIC_MODE */
 } microtcp_sock_t;
 
+/* A snapshot of a connection (see microtcp_get_info()); In the spirit of Linux's TCP_INFO. */
+typedef struct
+{
+        microtcp_state_t state;
+        time_t srtt_usec; /* 0 until the first RTT sample. */
+        time_t rttvar_usec;
+        time_t rto_usec;
+        size_t cwnd;               /* Congestion control module's window. */
+        size_t ssthresh;
+        size_t peer_win_size;      /* Last window peer advertised. */
+        size_t bytes_in_flight;    /* Sent, not acknowledged yet. */
+        size_t out_of_order_bytes; /* Received past a gap; Held in the receive buffer, until the gap fills. */
+        uint64_t packets_sent;
+        uint64_t packets_lost;
+        uint64_t packets_received;
+        uint64_t bytes_sent;
+        uint64_t bytes_lost;
+        uint64_t bytes_received;
+        microtcp_connection_stats_t stats;
+} microtcp_info_t;
+
+/* A socket microtcp_poll() found ready. */
+typedef struct
+{
+        microtcp_sock_t *socket;
+        uint32_t events; /* `microtcp_poll_events_t` bits. */
+        void *user_data; /* As registered with microtcp_poller_add(). */
+} microtcp_poll_event_t;
+
 microtcp_sock_t microtcp_socket(int _domain, int _type, int _protocol);
 
 int microtcp_bind(microtcp_sock_t *_socket, const struct sockaddr *_address, socklen_t _address_len);
@@ -168,8 +321,21 @@ int microtcp_connect(microtcp_sock_t *socket, const struct sockaddr *address, so
  */
 int microtcp_accept(microtcp_sock_t *socket, struct sockaddr *address, socklen_t address_len);
 
+/**
+ * @brief Part of the extended API(). Blocks waiting for a new connection on a listening socket (see MICROTCP_SO_LISTENER).
+ * Returned connection shares listener's UDP socket (and port), inheriting its per socket options; It is closed on its own,
+ * with microtcp_close(), while the listener keeps accepting.
+ * @param _address pointer to store the address information of the connected peer; Must outlive the connection.
+ * @return the new connection; Its state is INVALID on failure.
+ */
+microtcp_sock_t microtcp_accept_connection(microtcp_sock_t *_listener, struct sockaddr *_address, socklen_t _address_len);
+
 int microtcp_shutdown(microtcp_sock_t *socket, int how);
 
+/**
+ * @brief In buffered send mode, returns as soon as data is copied in socket's send buffer, blocking only while it is full.
+ * With MSG_DONTWAIT it never blocks; If no byte fit, returns -1 and sets errno to EAGAIN.
+ */
 ssize_t microtcp_send(microtcp_sock_t *socket, const void *buffer, size_t length, int flags);
 
 ssize_t microtcp_recv(microtcp_sock_t *socket, void *buffer, size_t length, int flags);
@@ -177,6 +343,62 @@ ssize_t microtcp_recv(microtcp_sock_t *socket, void *buffer, size_t length, int
 /* Part of the extended API(). */
 ssize_t microtcp_recv_timed(microtcp_sock_t *_socket, void *_buffer, size_t _length, struct timeval _max_idle_time);
 
+/**
+ * @brief Sets a per socket option (see `microtcp_sockopt_t`), in the fashion of POSIX's setsockopt().
+ * @note Options that shape connection's buffers must be set before microtcp_connect() or microtcp_accept().
+ * @return 0 on success, -1 on failure.
+ */
+int microtcp_setsockopt(microtcp_sock_t *_socket, microtcp_sockopt_t _option, const void *_value, socklen_t _value_len);
+
+/**
+ * @brief Reads a per socket option (see `microtcp_sockopt_t`), in the fashion of POSIX's getsockopt().
+ * @return 0 on success, -1 on failure.
+ */
+int microtcp_getsockopt(microtcp_sock_t *_socket, microtcp_sockopt_t _option, void *_value, socklen_t *_value_len);
+
+/**
+ * @brief Part of the extended API(). Fills `_info` with a snapshot of socket's connection; Cheap enough to call at will.
+ * Engine thread sockets are read while their engine runs; Fields of a snapshot may then be a few updates apart.
+ * @return 0 on success, -1 on failure.
+ */
+int microtcp_get_info(const microtcp_sock_t *_socket, microtcp_info_t *_info);
+
+/**
+ * @brief Part of the extended API(). Starts exporting statistics to shared memory (see core/stats_export.h), where
+ * `microtcp_stat` watches them live; Connections established from then on are exported. Setting MICROTCP_STATS_EXPORT
+ * in the environment starts it along with the process instead.
+ * @return 0 on success (or if it runs already), -1 on failure.
+ */
+int microtcp_stats_export_start(void);
+
 void microtcp_close(microtcp_sock_t *socket);
 
+/**
+ * @brief Part of the extended API(). Waits on many sockets from a single thread (see core/poller.h), over an epoll of
+ * their UDP descriptors. While waiting, it drives registered connections as microtcp_recv() would: Data is reassembled
+ * (and ACKed), buffered sends' ACKs are processed, and retransmission, pacing and delayed ACK timers are honored.
+ * Sockets must stay in place while registered, and be removed before microtcp_close(). Engine thread sockets are refused.
+ */
+microtcp_poller_t *microtcp_poller_create(void);
+void microtcp_poller_destroy(microtcp_poller_t **_poller_address);
+
+/* @return 0 on success, -1 on failure (e.g. socket is already registered). */
+int microtcp_poller_add(microtcp_poller_t *_poller, microtcp_sock_t *_socket, uint32_t _events, void *_user_data);
+int microtcp_poller_remove(microtcp_poller_t *_poller, microtcp_sock_t *_socket);
+
+/**
+ * @brief Level-triggered: Reports (up to `_max_events`) ready sockets; Waits up to `_timeout_msec` (-1 waits indefinitely).
+ * @return the number of ready sockets, 0 on timeout, -1 on failure.
+ */
+int microtcp_poll(microtcp_poller_t *_poller, microtcp_poll_event_t *_events, size_t _max_events, int _timeout_msec);
+
+/**
+ * @brief For outer event loops: Poller's epoll descriptor turns readable along with a registered UDP descriptor.
+ * Timers are not on it; Outer loops bound their waits with microtcp_poller_timeout(), then call microtcp_poll() with 0.
+ */
+int microtcp_poller_fd(const microtcp_poller_t *_poller);
+
+/* @return milliseconds until poller's next timer; 0 if a socket is ready already, -1 if no timer runs. */
+int microtcp_poller_timeout(const microtcp_poller_t *_poller);
+
 #endif /* LIB_MICROTCP_H_ */
@@ -51,6 +51,14 @@ static inline _Bool socket_requires_peer_address(const microtcp_sock_t *const _s
                         LOG_ERROR_RETURN((_failure_return_value), "Invalid MicroTCP socket descriptor; (sd = %d).", (_socket)->sd);    \
         } while (0)
 
+/* Engine thread mode: Engine's thread owns socket's state; Calls handing over to it only check the socket itself first. */
+#define RETURN_ERROR_IF_MICROTCP_SOCKET_NULL(_failure_return_value, _socket)                                 \
+        do                                                                                                    \
+        {                                                                                                     \
+                if ((_socket) == NULL)                                                                        \
+                        LOG_ERROR_RETURN((_failure_return_value), "%s() got a NULL socket.", __func__);       \
+        } while (0)
+
 /* Directly used in: microtcp_bind() & microtcp_connect() */
 #define RETURN_ERROR_IF_SOCKADDR_INVALID(_failure_return_value, _address) \
         do                                                                \
@@ -27,6 +27,8 @@
 #define RNG_DESTRUCTOR_PRIOTITY RNG_CONSTRUCTOR_PRIORITY
 #define SOCKET_MANAGER_CONSTRUCTOR_PRIORITY 1003
 #define SOCKET_MANAGER_DESTRUCTOR_PRIORITY SOCKET_MANAGER_CONSTRUCTOR_PRIORITY
+#define STATS_EXPORT_CONSTRUCTOR_PRIORITY 1005
+#define STATS_EXPORT_DESTRUCTOR_PRIORITY STATS_EXPORT_CONSTRUCTOR_PRIORITY
 
 /* POSIX's socket() function returns a file descriptor in successful calls. */
 #define POSIX_SOCKET_FAILURE_VALUE -1
@@ -54,6 +56,26 @@
 #define MICROTCP_RECV_TIMEOUT 0
 #define MICROTCP_RECV_FAILURE -1
 
+/* microtcp_setsockopt() & microtcp_getsockopt() possible return values. */
+#define MICROTCP_SOCKOPT_SUCCESS 0
+#define MICROTCP_SOCKOPT_FAILURE -1
+
+/* microtcp_poll() possible return values. */
+#define MICROTCP_POLL_TIMEOUT 0
+#define MICROTCP_POLL_FAILURE -1
+
+/* microtcp_poller_add() & microtcp_poller_remove() possible return values. */
+#define MICROTCP_POLLER_SUCCESS 0
+#define MICROTCP_POLLER_FAILURE -1
+
+/* microtcp_get_info() possible return values. */
+#define MICROTCP_GET_INFO_SUCCESS 0
+#define MICROTCP_GET_INFO_FAILURE -1
+
+/* microtcp_stats_export_start() possible return values. */
+#define MICROTCP_STATS_EXPORT_SUCCESS 0
+#define MICROTCP_STATS_EXPORT_FAILURE -1
+
 /* POSIX's bind() possible return values. */
 #define POSIX_BIND_SUCCESS 0
 #define POSIX_BIND_FAILURE -1
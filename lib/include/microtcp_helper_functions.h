@@ -37,6 +37,7 @@ time_t timeval_to_usec(struct timeval _timeval);
 struct timeval usec_to_timeval(time_t _us);
 time_t elapsed_time_usec(struct timeval _start_time);
 struct timeval get_current_timeval(void);
+time_t get_monotonic_time_usec(void); /* Immune to wall-clock adjustments; For measuring intervals (e.g. RTT samples). */
 size_t get_transferred_bytes_per_sec(struct timeval _start_time, size_t _transferred_bytes);
 
 #endif /* MICROTCP_HELPER_FUNCTIONS_H */
@@ -9,6 +9,8 @@
 
 #define IS_POWER_OF_2(_num) ((_num) > 0 && ((_num) & ((_num) - 1)) == 0)
 
+#define ARRAY_SIZE(_array) (sizeof(_array) / sizeof((_array)[0]))
+
 #define COMMON_CASE(x) __builtin_expect((_Bool)(x), 1)
 #define RARE_CASE(x) __builtin_expect((_Bool)(x), 0)
 
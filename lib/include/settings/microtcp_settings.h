@@ -6,12 +6,33 @@
 struct timeval;
 
 /* MicroTCP socket configurators. */
-struct timeval get_microtcp_ack_timeout(void);
+struct timeval get_microtcp_ack_timeout(void); /* Initial retransmission timeout, until RTT is measured. */
 void set_microtcp_ack_timeout(struct timeval _tv);
 
+/* Adaptive retransmission timeout is clamped within [min, max]; Exponential backoff stops at max. */
+struct timeval get_microtcp_min_rto(void);
+void set_microtcp_min_rto(struct timeval _tv);
+struct timeval get_microtcp_max_rto(void);
+void set_microtcp_max_rto(struct timeval _tv);
+
 size_t get_microtcp_bytestream_rrb_size(void);
 void set_microtcp_bytestream_rrb_size(size_t _length);
 
+/* Double mapped RRB: Its pages are mapped twice back-to-back, so no copy in or out of it ever splits on wrap-around. */
+_Bool get_microtcp_bytestream_rrb_double_mapped(void);
+void set_microtcp_bytestream_rrb_double_mapped(_Bool _double_mapped);
+
+/* Congestion control module of new connections ("reno", "cubic" or "bbr"); Per socket, see MICROTCP_SO_CONGESTION_CONTROL. */
+const char *get_microtcp_congestion_control(void);
+void set_microtcp_congestion_control(const char *_name);
+
+/* Delayed ACKs: In-order data is ACKed every `segments` full segments, or `timeout` after the first unACKed one;
+ * A single segment (or a zero timeout) ACKs every segment. */
+struct timeval get_microtcp_delayed_ack_timeout(void);
+void set_microtcp_delayed_ack_timeout(struct timeval _tv);
+size_t get_microtcp_delayed_ack_segments(void);
+void set_microtcp_delayed_ack_segments(size_t _segments_count);
+
 void set_microtcp_stall_time_limit(struct timeval _time_limit);
 struct timeval get_microtcp_stall_time_limit(void);
 
@@ -22,6 +43,9 @@ void set_connect_rst_retries(size_t _retries_count);
 /* Accept()'s FSM configurators. */
 size_t get_accept_synack_retries(void);
 void set_accept_synack_retries(size_t _retries_count);
+/* Listener mode: Handshakes in progress, plus completed connections not yet accepted; Read when the listener is enabled. */
+size_t get_accept_backlog(void);
+void set_accept_backlog(size_t _backlog);
 
 /* Shutdown()'s FSM configurators. */
 size_t get_shutdown_finack_retries(void);
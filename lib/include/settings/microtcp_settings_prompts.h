@@ -2,9 +2,16 @@
 #define MICROTCP_SETTINGS_PROMPTS_H
 
 void prompt_set_rrb_size(void);
+void prompt_set_microtcp_rrb_double_mapped(void);
 void prompt_set_microtcp_ack_timeout(void);
+void prompt_set_microtcp_min_rto(void);
+void prompt_set_microtcp_max_rto(void);
+void prompt_set_microtcp_congestion_control(void);
+void prompt_set_microtcp_delayed_ack_timeout(void);
+void prompt_set_microtcp_delayed_ack_segments(void);
 void prompt_set_connect_retries(void);
 void prompt_set_accept_retries(void);
+void prompt_set_accept_backlog(void);
 void prompt_set_shutdown_retries(void);
 void prompt_set_shutdown_time_wait_period(void);
 
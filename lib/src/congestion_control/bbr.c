@@ -0,0 +1,276 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "congestion_control/congestion_control.h"
+#include "congestion_control_modules.h"
+#include "microtcp.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+
+/**
+ * @brief BBR (v1 model): Instead of reacting to loss, it keeps estimates of bottleneck bandwidth (windowed max of delivery rate)
+ * and of path's propagation delay (windowed min of RTT); Sending rate follows bandwidth, and bytes in flight stay near their product (BDP),
+ * so bottleneck's queue stays short. Modes:
+ * STARTUP  grows sending rate by 2/ln(2) per round, until bandwidth stops growing;
+ * DRAIN    empties the queue STARTUP built;
+ * PROBE_BW cycles pacing gain (1.25, 0.75, then 1 for 6 RTTs), probing for more bandwidth and draining what the probe queued;
+ * PROBE_RTT drops to 4 segments in flight for 200 msec, whenever min RTT was not refreshed for 10 seconds.
+ */
+
+#define BBR_HIGH_GAIN 2.885 /* 2/ln(2); Doubles delivery rate every round, as slow start does. */
+#define BBR_DRAIN_GAIN (1.0 / BBR_HIGH_GAIN)
+#define BBR_CWND_GAIN 2.0
+#define BBR_GAIN_CYCLE_LENGTH 8
+#define BBR_PROBE_GAIN_INDEX 0
+#define BBR_DRAIN_PROBE_GAIN_INDEX 1
+#define BBR_BW_FILTER_ROUNDS 10
+#define BBR_MIN_RTT_FILTER_USEC (10 * USEC_PER_SEC)
+#define BBR_PROBE_RTT_DURATION_USEC (200 * USEC_PER_MSEC)
+#define BBR_MIN_CWND (4 * MICROTCP_MSS)
+#define BBR_CWND_QUANTA (3 * MICROTCP_MSS) /* Headroom above cwnd_gain * BDP, for delayed and stretched ACKs. */
+#define BBR_FULL_BW_GROWTH 1.25             /* STARTUP ends, once bandwidth grew less than this */
+#define BBR_FULL_BW_ROUNDS 3                /* ... for that many rounds in a row. */
+#define USEC_PER_SEC 1000000
+#define USEC_PER_MSEC 1000
+
+static const double pacing_gain_cycle[BBR_GAIN_CYCLE_LENGTH] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+typedef enum
+{
+        BBR_STARTUP,
+        BBR_DRAIN,
+        BBR_PROBE_BW,
+        BBR_PROBE_RTT
+} bbr_mode_t;
+
+typedef struct
+{
+        bbr_mode_t mode;
+        double pacing_gain;
+        double cwnd_gain;
+
+        /* Rounds: A round ends when a segment sent after its start is acknowledged. */
+        uint64_t round_count;
+        uint64_t next_round_delivered;
+        _Bool round_start;
+
+        uint64_t bw_filter[BBR_BW_FILTER_ROUNDS]; /* Bytes per second; Max delivery rate of each of the last rounds. */
+        time_t min_rtt_usec;                      /* 0 until the first sample. */
+        time_t min_rtt_stamp_usec;
+
+        uint64_t full_bw; /* STARTUP's bandwidth plateau detection. */
+        uint8_t full_bw_count;
+        _Bool filled_pipe;
+
+        uint8_t cycle_index; /* PROBE_BW's position in `pacing_gain_cycle`. */
+        time_t cycle_stamp_usec;
+
+        time_t probe_rtt_done_usec; /* 0 until bytes in flight drain to BBR_MIN_CWND. */
+        size_t prior_cwnd;          /* Restored after PROBE_RTT. */
+} bbr_state_t;
+
+static uint64_t max_bw(const bbr_state_t *const _bbr)
+{
+        uint64_t bw = 0;
+        for (size_t i = 0; i < BBR_BW_FILTER_ROUNDS; i++)
+                bw = MAX(bw, _bbr->bw_filter[i]);
+        return bw;
+}
+
+/* @returns 0 if there is no model yet. */
+static size_t bdp(const bbr_state_t *const _bbr, const double _gain)
+{
+        return (size_t)(_gain * (double)max_bw(_bbr) * (double)_bbr->min_rtt_usec / USEC_PER_SEC);
+}
+
+static void enter_startup(bbr_state_t *const _bbr)
+{
+        _bbr->mode = BBR_STARTUP;
+        _bbr->pacing_gain = BBR_HIGH_GAIN;
+        _bbr->cwnd_gain = BBR_HIGH_GAIN;
+}
+
+static void enter_probe_bw(bbr_state_t *const _bbr, const time_t _now_usec)
+{
+        _bbr->mode = BBR_PROBE_BW;
+        _bbr->cwnd_gain = BBR_CWND_GAIN;
+        /* Any phase but the draining one; Round count stands in for a random pick. */
+        _bbr->cycle_index = BBR_DRAIN_PROBE_GAIN_INDEX + 1 + _bbr->round_count % (BBR_GAIN_CYCLE_LENGTH - 1);
+        _bbr->cycle_index %= BBR_GAIN_CYCLE_LENGTH;
+        _bbr->pacing_gain = pacing_gain_cycle[_bbr->cycle_index];
+        _bbr->cycle_stamp_usec = _now_usec;
+}
+
+static void enter_probe_rtt(microtcp_sock_t *const _socket, bbr_state_t *const _bbr)
+{
+        _bbr->mode = BBR_PROBE_RTT;
+        _bbr->pacing_gain = 1;
+        _bbr->cwnd_gain = 1;
+        _bbr->prior_cwnd = _socket->cwnd;
+        _bbr->probe_rtt_done_usec = 0;
+}
+
+static void update_round(bbr_state_t *const _bbr, const cc_ack_sample_t *const _sample)
+{
+        _bbr->round_start = false;
+        if (_sample->rtt_usec == 0 || _sample->delivered_at_send < _bbr->next_round_delivered)
+                return;
+        _bbr->next_round_delivered = _sample->delivered;
+        _bbr->round_count++;
+        _bbr->round_start = true;
+        _bbr->bw_filter[_bbr->round_count % BBR_BW_FILTER_ROUNDS] = 0; /* Oldest round leaves the window. */
+}
+
+static void update_model(microtcp_sock_t *const _socket, bbr_state_t *const _bbr, const cc_ack_sample_t *const _sample)
+{
+        update_round(_bbr, _sample);
+        if (_sample->rtt_usec == 0)
+                return;
+
+        uint64_t *const bw_slot = &_bbr->bw_filter[_bbr->round_count % BBR_BW_FILTER_ROUNDS];
+        const uint64_t delivery_rate = (_sample->delivered - _sample->delivered_at_send) * USEC_PER_SEC / (uint64_t)_sample->rtt_usec;
+        *bw_slot = MAX(*bw_slot, delivery_rate);
+
+        const _Bool min_rtt_expired = _bbr->min_rtt_usec != 0 && _sample->now_usec - _bbr->min_rtt_stamp_usec > BBR_MIN_RTT_FILTER_USEC;
+        if (_bbr->min_rtt_usec == 0 || _sample->rtt_usec <= _bbr->min_rtt_usec || min_rtt_expired)
+        {
+                _bbr->min_rtt_usec = _sample->rtt_usec;
+                _bbr->min_rtt_stamp_usec = _sample->now_usec;
+        }
+        if (min_rtt_expired && _bbr->mode != BBR_PROBE_RTT)
+                enter_probe_rtt(_socket, _bbr);
+}
+
+static void check_full_pipe(bbr_state_t *const _bbr)
+{
+        if (_bbr->filled_pipe || !_bbr->round_start)
+                return;
+        const uint64_t bw = max_bw(_bbr);
+        if ((double)bw >= BBR_FULL_BW_GROWTH * (double)_bbr->full_bw)
+        {
+                _bbr->full_bw = bw;
+                _bbr->full_bw_count = 0;
+                return;
+        }
+        if (++_bbr->full_bw_count >= BBR_FULL_BW_ROUNDS)
+                _bbr->filled_pipe = true;
+}
+
+static void update_mode(microtcp_sock_t *const _socket, bbr_state_t *const _bbr, const cc_ack_sample_t *const _sample)
+{
+        check_full_pipe(_bbr);
+        switch (_bbr->mode)
+        {
+        case BBR_STARTUP:
+                if (!_bbr->filled_pipe)
+                        break;
+                _bbr->mode = BBR_DRAIN;
+                _bbr->pacing_gain = BBR_DRAIN_GAIN;
+                _bbr->cwnd_gain = BBR_HIGH_GAIN;
+                /* fall through */
+        case BBR_DRAIN:
+                if (_sample->bytes_in_flight <= bdp(_bbr, 1))
+                        enter_probe_bw(_bbr, _sample->now_usec);
+                break;
+        case BBR_PROBE_BW:
+        {
+                const _Bool phase_elapsed = _sample->now_usec - _bbr->cycle_stamp_usec > _bbr->min_rtt_usec;
+                const _Bool drained = _bbr->cycle_index == BBR_DRAIN_PROBE_GAIN_INDEX && _sample->bytes_in_flight <= bdp(_bbr, 1);
+                if (!phase_elapsed && !drained)
+                        break;
+                _bbr->cycle_index = (_bbr->cycle_index + 1) % BBR_GAIN_CYCLE_LENGTH;
+                _bbr->pacing_gain = pacing_gain_cycle[_bbr->cycle_index];
+                _bbr->cycle_stamp_usec = _sample->now_usec;
+                break;
+        }
+        case BBR_PROBE_RTT:
+                if (_bbr->probe_rtt_done_usec == 0 && _sample->bytes_in_flight <= BBR_MIN_CWND)
+                        _bbr->probe_rtt_done_usec = _sample->now_usec + BBR_PROBE_RTT_DURATION_USEC;
+                else if (_bbr->probe_rtt_done_usec != 0 && _sample->now_usec > _bbr->probe_rtt_done_usec)
+                {
+                        _bbr->min_rtt_stamp_usec = _sample->now_usec;
+                        _socket->cwnd = MAX(_socket->cwnd, _bbr->prior_cwnd);
+                        if (_bbr->filled_pipe)
+                                enter_probe_bw(_bbr, _sample->now_usec);
+                        else
+                                enter_startup(_bbr);
+                }
+                break;
+        }
+}
+
+static void update_cwnd(microtcp_sock_t *const _socket, const bbr_state_t *const _bbr, const cc_ack_sample_t *const _sample)
+{
+        if (_bbr->mode == BBR_PROBE_RTT)
+        {
+                _socket->cwnd = MIN(_socket->cwnd, BBR_MIN_CWND);
+                return;
+        }
+        if (_sample->in_recovery) /* Send FSM's window inflation lets out as much as leaves the network. */
+                return;
+        const size_t target_cwnd = bdp(_bbr, _bbr->cwnd_gain) + BBR_CWND_QUANTA;
+        if (_bbr->filled_pipe)
+                _socket->cwnd = MIN(_socket->cwnd + _sample->acked_bytes, target_cwnd);
+        else if (_socket->cwnd < target_cwnd || _bbr->min_rtt_usec == 0 || _sample->delivered < CC_INITIAL_CWND)
+                _socket->cwnd += _sample->acked_bytes;
+        _socket->cwnd = MAX(_socket->cwnd, BBR_MIN_CWND);
+}
+
+static void bbr_init(microtcp_sock_t *const _socket, void *const _state)
+{
+        bbr_state_t *const bbr = _state;
+        _socket->cwnd = CC_INITIAL_CWND;
+        _socket->ssthresh = CC_INITIAL_SSTHRESH; /* Unused; Kept for socket's statistics. */
+        enter_startup(bbr);
+}
+
+static void bbr_on_ack(microtcp_sock_t *const _socket, void *const _state, const cc_ack_sample_t *const _sample)
+{
+        bbr_state_t *const bbr = _state;
+        update_model(_socket, bbr, _sample);
+        update_mode(_socket, bbr, _sample);
+        update_cwnd(_socket, bbr, _sample);
+}
+
+/* Loss is no congestion signal to the model; Window only stops growing, until recovery ends. */
+static void bbr_on_loss(microtcp_sock_t *const _socket, void *const _state, const size_t _bytes_in_flight)
+{
+        (void)_state;
+        _socket->cwnd = MAX(MIN(_socket->cwnd, _bytes_in_flight), BBR_MIN_CWND);
+}
+
+/* Whatever was in flight is presumed lost; Window restarts low, and regrows by every delivered byte, up to the model's target. */
+static void bbr_on_timeout(microtcp_sock_t *const _socket, void *const _state, const size_t _bytes_in_flight)
+{
+        (void)_state;
+        (void)_bytes_in_flight;
+        _socket->cwnd = BBR_MIN_CWND;
+}
+
+static uint64_t bbr_pacing_rate(const microtcp_sock_t *const _socket, const void *const _state)
+{
+        const bbr_state_t *const bbr = _state;
+        const uint64_t bw = max_bw(bbr);
+        if (bw != 0)
+                return (uint64_t)(bbr->pacing_gain * (double)bw);
+        if (_socket->srtt_usec == 0) /* No model, nor RTT; Initial window goes out unpaced. */
+                return 0;
+        return (uint64_t)(BBR_HIGH_GAIN * (double)_socket->cwnd * USEC_PER_SEC / (double)_socket->srtt_usec);
+}
+
+static size_t bbr_cwnd(const microtcp_sock_t *const _socket, const void *const _state)
+{
+        (void)_state;
+        return _socket->cwnd;
+}
+
+const congestion_control_ops_t bbr_congestion_control_ops = {
+    .name = "bbr",
+    .state_size = sizeof(bbr_state_t),
+    .init = bbr_init,
+    .on_ack = bbr_on_ack,
+    .on_loss = bbr_on_loss,
+    .on_timeout = bbr_on_timeout,
+    .pacing_rate = bbr_pacing_rate,
+    .cwnd = bbr_cwnd,
+};
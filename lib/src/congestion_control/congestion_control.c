@@ -0,0 +1,105 @@
+#include "congestion_control/congestion_control.h"
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "allocator/allocator_macros.h"
+#include "congestion_control_modules.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "smart_assert.h"
+#include "status.h"
+
+static const congestion_control_ops_t *const registered_modules[] = {
+    &reno_congestion_control_ops,
+    &cubic_congestion_control_ops,
+    &bbr_congestion_control_ops,
+};
+
+/* `congestion_control_t` is defined in equivilant header_file. */
+/* Module's state follows, in the same allocation. */
+struct congestion_control
+{
+        const congestion_control_ops_t *ops;
+        uint64_t delivered;
+        alignas(max_align_t) uint8_t state[];
+};
+
+const congestion_control_ops_t *cc_find(const char *const _name)
+{
+        if (_name == NULL)
+                return NULL;
+        for (size_t i = 0; i < sizeof(registered_modules) / sizeof(*registered_modules); i++)
+                if (strcmp(registered_modules[i]->name, _name) == 0)
+                        return registered_modules[i];
+        return NULL;
+}
+
+congestion_control_t *cc_create(const congestion_control_ops_t *const _ops, microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_ops != NULL, _socket != NULL);
+        congestion_control_t *cc = CALLOC_LOG(cc, sizeof(congestion_control_t) + _ops->state_size);
+        if (cc == NULL)
+                return NULL;
+        cc->ops = _ops;
+        _ops->init(_socket, cc->state);
+        LOG_INFO_RETURN(cc, "Congestion control module `%s` initialized.", _ops->name);
+}
+
+/* We request a double pointer, in order to NULLIFY user's congestion control pointer. */
+status_t cc_destroy(congestion_control_t **const _cc_address)
+{
+        SMART_ASSERT(_cc_address != NULL);
+
+#define CC (*_cc_address)
+        if (CC == NULL)
+                return SUCCESS;
+        FREE_NULLIFY_LOG(CC);
+        return SUCCESS;
+#undef CC
+}
+
+const congestion_control_ops_t *cc_ops(const congestion_control_t *const _cc)
+{
+        DEBUG_SMART_ASSERT(_cc != NULL);
+        return _cc->ops;
+}
+
+uint64_t cc_delivered(const congestion_control_t *const _cc)
+{
+        DEBUG_SMART_ASSERT(_cc != NULL);
+        return _cc->delivered;
+}
+
+void cc_on_ack(congestion_control_t *const _cc, microtcp_sock_t *const _socket, const cc_ack_sample_t *const _sample)
+{
+        DEBUG_SMART_ASSERT(_cc != NULL, _socket != NULL, _sample != NULL);
+        _cc->delivered += _sample->acked_bytes;
+        cc_ack_sample_t sample = *_sample;
+        sample.delivered = _cc->delivered;
+        _cc->ops->on_ack(_socket, _cc->state, &sample);
+}
+
+void cc_on_loss(congestion_control_t *const _cc, microtcp_sock_t *const _socket, const size_t _bytes_in_flight)
+{
+        DEBUG_SMART_ASSERT(_cc != NULL, _socket != NULL);
+        _cc->ops->on_loss(_socket, _cc->state, _bytes_in_flight);
+}
+
+void cc_on_timeout(congestion_control_t *const _cc, microtcp_sock_t *const _socket, const size_t _bytes_in_flight)
+{
+        DEBUG_SMART_ASSERT(_cc != NULL, _socket != NULL);
+        _cc->ops->on_timeout(_socket, _cc->state, _bytes_in_flight);
+}
+
+uint64_t cc_pacing_rate(const congestion_control_t *const _cc, const microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_cc != NULL, _socket != NULL);
+        return _cc->ops->pacing_rate(_socket, _cc->state);
+}
+
+size_t cc_cwnd(const congestion_control_t *const _cc, const microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_cc != NULL, _socket != NULL);
+        return _cc->ops->cwnd(_socket, _cc->state);
+}
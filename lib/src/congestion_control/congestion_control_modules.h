@@ -0,0 +1,19 @@
+#ifndef CONGESTION_CONTROL_MODULES_H
+#define CONGESTION_CONTROL_MODULES_H
+
+#include <stdint.h>
+#include "congestion_control/congestion_control.h"
+#include "microtcp.h"
+
+extern const congestion_control_ops_t reno_congestion_control_ops;
+extern const congestion_control_ops_t cubic_congestion_control_ops;
+extern const congestion_control_ops_t bbr_congestion_control_ops;
+
+/* Every module starts a connection from the same window. */
+#define CC_INITIAL_CWND MICROTCP_INIT_CWND
+#define CC_INITIAL_SSTHRESH SIZE_MAX /* RFC 5681: Arbitrarily high; Slow start lasts until the first loss (or peer's window). */
+
+/* RFC 5681: Window never drops below 2 segments, after a loss. */
+#define CC_MIN_SSTHRESH (2 * MICROTCP_MSS)
+
+#endif /* CONGESTION_CONTROL_MODULES_H */
@@ -0,0 +1,128 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "congestion_control/congestion_control.h"
+#include "congestion_control_modules.h"
+#include "microtcp.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+
+/**
+ * @brief CUBIC (RFC 9438): After a loss, window follows W(t) = C * (t - K)^3 + W_max; It climbs fast while far from W_max,
+ * flattens around it, then probes past it. Growth depends on time since the loss, not on RTT; Long fat pipes refill in seconds.
+ * Window sizes below are in segments.
+ */
+
+#define CUBIC_C 0.4    /* Scaling constant; Segments per second^3. */
+#define CUBIC_BETA 0.7 /* Multiplicative decrease. */
+#define CUBIC_RENO_ALPHA (3.0 * (1.0 - CUBIC_BETA) / (1.0 + CUBIC_BETA)) /* Reno-friendly additive increase, at CUBIC's beta. */
+#define CUBIC_MAX_GROWTH_RATIO 1.5 /* Target window is at most this much the current one; Bounds growth per RTT. */
+#define USEC_PER_SEC_DOUBLE 1e6
+
+typedef struct
+{
+        double w_max;            /* Window right before the last reduction. */
+        double k_sec;            /* Time W(t) takes to climb back to `w_max`. */
+        double origin_point;     /* W(K). */
+        double w_est;            /* Window Reno would have by now; CUBIC never grows slower. */
+        time_t epoch_start_usec; /* 0: No epoch; Next ACK in congestion avoidance starts one. */
+} cubic_state_t;
+
+static void cubic_init(microtcp_sock_t *const _socket, void *const _state)
+{
+        (void)_state; /* Zeroed; No epoch, no W_max. */
+        _socket->cwnd = CC_INITIAL_CWND;
+        _socket->ssthresh = CC_INITIAL_SSTHRESH;
+}
+
+static void start_epoch(cubic_state_t *const _cubic, const double _cwnd_segments, const time_t _now_usec)
+{
+        _cubic->epoch_start_usec = _now_usec;
+        if (_cwnd_segments < _cubic->w_max)
+        {
+                _cubic->k_sec = cbrt((_cubic->w_max - _cwnd_segments) / CUBIC_C);
+                _cubic->origin_point = _cubic->w_max;
+        }
+        else
+        {
+                _cubic->k_sec = 0;
+                _cubic->origin_point = _cwnd_segments;
+        }
+        _cubic->w_est = _cwnd_segments;
+}
+
+static void cubic_on_ack(microtcp_sock_t *const _socket, void *const _state, const cc_ack_sample_t *const _sample)
+{
+        cubic_state_t *const cubic = _state;
+        if (_sample->in_recovery)
+                return;
+        if (_socket->cwnd < _socket->ssthresh) /* Slow start. */
+        {
+                _socket->cwnd += _sample->acked_segments * MICROTCP_MSS;
+                return;
+        }
+
+        const double cwnd_segments = (double)_socket->cwnd / MICROTCP_MSS;
+        if (cubic->epoch_start_usec == 0)
+                start_epoch(cubic, cwnd_segments, _sample->now_usec);
+
+        /* Target is where W(t) will be an RTT from now. */
+        const double t_sec = (double)(_sample->now_usec - cubic->epoch_start_usec + _socket->srtt_usec) / USEC_PER_SEC_DOUBLE;
+        double target = cubic->origin_point + CUBIC_C * pow(t_sec - cubic->k_sec, 3);
+        cubic->w_est += CUBIC_RENO_ALPHA * (double)_sample->acked_segments / cwnd_segments;
+        target = MIN(MAX(target, cubic->w_est), CUBIC_MAX_GROWTH_RATIO * cwnd_segments);
+
+        if (target > cwnd_segments)
+                _socket->cwnd += (size_t)((target - cwnd_segments) / cwnd_segments * (double)(_sample->acked_segments * MICROTCP_MSS));
+        else /* Plateau around W_max; Creep up, a segment every 100 RTTs. */
+                _socket->cwnd += MAX((size_t)((double)(_sample->acked_segments * MICROTCP_MSS) / (100.0 * cwnd_segments)), 1);
+}
+
+/* Reduction starts from bytes in flight, when they are fewer; `cwnd` may have grown far past what peer's window let out. */
+static size_t reduce_window(microtcp_sock_t *const _socket, cubic_state_t *const _cubic, const size_t _bytes_in_flight)
+{
+        const double window_segments = (double)MIN(_socket->cwnd, MAX(_bytes_in_flight, MICROTCP_MSS)) / MICROTCP_MSS;
+        _cubic->epoch_start_usec = 0;
+        if (window_segments < _cubic->w_max) /* Fast convergence: Still below the last W_max; Leave room to newer flows. */
+                _cubic->w_max = window_segments * (1.0 + CUBIC_BETA) / 2.0;
+        else
+                _cubic->w_max = window_segments;
+        return MAX((size_t)(window_segments * CUBIC_BETA * MICROTCP_MSS), CC_MIN_SSTHRESH);
+}
+
+static void cubic_on_loss(microtcp_sock_t *const _socket, void *const _state, const size_t _bytes_in_flight)
+{
+        _socket->ssthresh = reduce_window(_socket, _state, _bytes_in_flight);
+        _socket->cwnd = _socket->ssthresh;
+}
+
+static void cubic_on_timeout(microtcp_sock_t *const _socket, void *const _state, const size_t _bytes_in_flight)
+{
+        _socket->ssthresh = reduce_window(_socket, _state, _bytes_in_flight);
+        _socket->cwnd = MICROTCP_MSS;
+}
+
+static uint64_t cubic_pacing_rate(const microtcp_sock_t *const _socket, const void *const _state)
+{
+        (void)_socket;
+        (void)_state;
+        return 0;
+}
+
+static size_t cubic_cwnd(const microtcp_sock_t *const _socket, const void *const _state)
+{
+        (void)_state;
+        return _socket->cwnd;
+}
+
+const congestion_control_ops_t cubic_congestion_control_ops = {
+    .name = "cubic",
+    .state_size = sizeof(cubic_state_t),
+    .init = cubic_init,
+    .on_ack = cubic_on_ack,
+    .on_loss = cubic_on_loss,
+    .on_timeout = cubic_on_timeout,
+    .pacing_rate = cubic_pacing_rate,
+    .cwnd = cubic_cwnd,
+};
@@ -0,0 +1,69 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "congestion_control/congestion_control.h"
+#include "congestion_control_modules.h"
+#include "microtcp.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+
+/* Reno (RFC 5681): Slow start up to `ssthresh`, then a segment per RTT; Window is halved on loss. No private state. */
+
+static void reno_init(microtcp_sock_t *const _socket, void *const _state)
+{
+        (void)_state;
+        _socket->cwnd = CC_INITIAL_CWND;
+        _socket->ssthresh = CC_INITIAL_SSTHRESH;
+}
+
+static void reno_on_ack(microtcp_sock_t *const _socket, void *const _state, const cc_ack_sample_t *const _sample)
+{
+        (void)_state;
+        if (_sample->in_recovery)
+                return;
+        if (_socket->cwnd < _socket->ssthresh) /* Slow start. */
+        {
+                _socket->cwnd += _sample->acked_segments * MICROTCP_MSS;
+                return;
+        }
+        for (size_t i = 0; i < _sample->acked_segments; i++) /* Congestion avoidance. */
+                _socket->cwnd += MAX((MICROTCP_MSS * MICROTCP_MSS) / _socket->cwnd, 1); /* If CWND > MSS^2, increament by 1 byte (tahoe). */
+}
+
+/* Halved from bytes in flight; `cwnd` may have grown far past what peer's window let out. */
+static void reno_on_loss(microtcp_sock_t *const _socket, void *const _state, const size_t _bytes_in_flight)
+{
+        (void)_state;
+        _socket->ssthresh = MAX(_bytes_in_flight / 2, CC_MIN_SSTHRESH);
+        _socket->cwnd = _socket->ssthresh;
+}
+
+static void reno_on_timeout(microtcp_sock_t *const _socket, void *const _state, const size_t _bytes_in_flight)
+{
+        (void)_state;
+        _socket->ssthresh = MAX(_bytes_in_flight / 2, CC_MIN_SSTHRESH);
+        _socket->cwnd = MICROTCP_MSS;
+}
+
+static uint64_t reno_pacing_rate(const microtcp_sock_t *const _socket, const void *const _state)
+{
+        (void)_socket;
+        (void)_state;
+        return 0;
+}
+
+static size_t reno_cwnd(const microtcp_sock_t *const _socket, const void *const _state)
+{
+        (void)_state;
+        return _socket->cwnd;
+}
+
+const congestion_control_ops_t reno_congestion_control_ops = {
+    .name = "reno",
+    .state_size = 0,
+    .init = reno_init,
+    .on_ack = reno_on_ack,
+    .on_loss = reno_on_loss,
+    .on_timeout = reno_on_timeout,
+    .pacing_rate = reno_pacing_rate,
+    .cwnd = reno_cwnd,
+};
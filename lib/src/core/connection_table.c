@@ -0,0 +1,164 @@
+#include "core/connection_table.h"
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "allocator/allocator_macros.h"
+#include "core/datagram_batch.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+#include "status.h"
+
+#define FIBONACCI_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL /* 2^64 / golden ratio; Spreads consecutive addresses and ports apart. */
+
+struct connection_table
+{
+        connection_entry_t **buckets;
+        size_t bucket_bits; /* Buckets are 2^bucket_bits. */
+        size_t size;
+};
+
+static size_t get_bucket(const struct sockaddr_in *_peer, size_t _bucket_bits);
+static _Bool is_same_peer(const struct sockaddr_in *_a, const struct sockaddr_in *_b);
+static void grow(connection_table_t *_ct);
+
+connection_table_t *ct_create(const size_t _initial_buckets)
+{
+        SMART_ASSERT(IS_POWER_OF_2(_initial_buckets));
+        connection_table_t *ct = CALLOC_LOG(ct, sizeof(connection_table_t));
+        if (ct == NULL)
+                return NULL;
+        ct->buckets = CALLOC_LOG(ct->buckets, _initial_buckets * sizeof(connection_entry_t *));
+        if (ct->buckets == NULL)
+        {
+                FREE_NULLIFY_LOG(ct);
+                return NULL;
+        }
+        while (((size_t)1 << ct->bucket_bits) < _initial_buckets)
+                ct->bucket_bits++;
+        return ct;
+}
+
+/* We request a double pointer, in order to NULLIFY user's table pointer. */
+status_t ct_destroy(connection_table_t **const _ct_address)
+{
+        SMART_ASSERT(_ct_address != NULL);
+
+#define CT (*_ct_address)
+        if (CT == NULL)
+                return SUCCESS;
+        if (CT->size != 0)
+                LOG_WARNING("Connection table destroyed with %zu connections still in it.", CT->size);
+        FREE_NULLIFY_LOG(CT->buckets);
+        FREE_NULLIFY_LOG(CT);
+        return SUCCESS;
+#undef CT
+}
+
+status_t ct_insert(connection_table_t *const _ct, connection_entry_t *const _entry)
+{
+        DEBUG_SMART_ASSERT(_ct != NULL, _entry != NULL, !_entry->attached);
+        if (ct_find(_ct, &_entry->peer) != NULL)
+                return FAILURE;
+        if (_ct->size >= ((size_t)1 << _ct->bucket_bits))
+                grow(_ct);
+        const size_t bucket = get_bucket(&_entry->peer, _ct->bucket_bits);
+        _entry->next = _ct->buckets[bucket];
+        _ct->buckets[bucket] = _entry;
+        _entry->attached = true;
+        _ct->size++;
+        return SUCCESS;
+}
+
+void ct_remove(connection_table_t *const _ct, connection_entry_t *const _entry)
+{
+        DEBUG_SMART_ASSERT(_ct != NULL, _entry != NULL);
+        if (!_entry->attached)
+                return;
+        connection_entry_t **link = &_ct->buckets[get_bucket(&_entry->peer, _ct->bucket_bits)];
+        while (*link != _entry)
+        {
+                DEBUG_SMART_ASSERT(*link != NULL); /* Attached entries are always found. */
+                link = &(*link)->next;
+        }
+        *link = _entry->next;
+        _entry->next = NULL;
+        _entry->attached = false;
+        _ct->size--;
+}
+
+connection_entry_t *ct_find(const connection_table_t *const _ct, const struct sockaddr_in *const _peer)
+{
+        DEBUG_SMART_ASSERT(_ct != NULL, _peer != NULL);
+        connection_entry_t *entry = _ct->buckets[get_bucket(_peer, _ct->bucket_bits)];
+        while (entry != NULL && !is_same_peer(&entry->peer, _peer))
+                entry = entry->next;
+        return entry;
+}
+
+size_t ct_size(const connection_table_t *const _ct)
+{
+        DEBUG_SMART_ASSERT(_ct != NULL);
+        return _ct->size;
+}
+
+connection_entry_t *ce_create(void)
+{
+        connection_entry_t *ce = CALLOC_LOG(ce, sizeof(connection_entry_t));
+        if (ce == NULL)
+                return NULL;
+        if ((ce->inbox = db_create(DATAGRAM_BATCH_CAPACITY, MICROTCP_MTU, 1)) == NULL)
+                FREE_NULLIFY_LOG(ce);
+        return ce;
+}
+
+/* We request a double pointer, in order to NULLIFY user's entry pointer. Entry must be out of its table. */
+status_t ce_destroy(connection_entry_t **const _ce_address)
+{
+        SMART_ASSERT(_ce_address != NULL);
+
+#define CE (*_ce_address)
+        if (CE == NULL)
+                return SUCCESS;
+        SMART_ASSERT(!CE->attached);
+        db_destroy(&CE->inbox);
+        FREE_NULLIFY_LOG(CE);
+        return SUCCESS;
+#undef CE
+}
+
+static size_t get_bucket(const struct sockaddr_in *const _peer, const size_t _bucket_bits)
+{
+        const uint64_t key = ((uint64_t)_peer->sin_addr.s_addr << 16) | _peer->sin_port;
+        return _bucket_bits == 0 ? 0 : (size_t)((key * FIBONACCI_HASH_MULTIPLIER) >> (64 - _bucket_bits));
+}
+
+static _Bool is_same_peer(const struct sockaddr_in *const _a, const struct sockaddr_in *const _b)
+{
+        return _a->sin_addr.s_addr == _b->sin_addr.s_addr && _a->sin_port == _b->sin_port;
+}
+
+/* Rehashes into twice the buckets; If that allocation fails, chains just grow longer. */
+static void grow(connection_table_t *const _ct)
+{
+        const size_t old_bucket_count = (size_t)1 << _ct->bucket_bits;
+        connection_entry_t **new_buckets = CALLOC_LOG(new_buckets, 2 * old_bucket_count * sizeof(connection_entry_t *));
+        if (new_buckets == NULL)
+                return;
+        for (size_t i = 0; i < old_bucket_count; i++)
+        {
+                connection_entry_t *entry = _ct->buckets[i];
+                while (entry != NULL)
+                {
+                        connection_entry_t *const next = entry->next;
+                        const size_t bucket = get_bucket(&entry->peer, _ct->bucket_bits + 1);
+                        entry->next = new_buckets[bucket];
+                        new_buckets[bucket] = entry;
+                        entry = next;
+                }
+        }
+        FREE_NULLIFY_LOG(_ct->buckets);
+        _ct->buckets = new_buckets;
+        _ct->bucket_bits++;
+}
@@ -0,0 +1,132 @@
+#include "core/datagram_batch.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "allocator/allocator_macros.h"
+#include "logging/microtcp_logger.h"
+#include "smart_assert.h"
+#include "status.h"
+
+datagram_batch_t *db_create(const size_t _capacity, const size_t _slot_size, const size_t _slot_iovecs)
+{
+        SMART_ASSERT(_capacity > 0, _slot_size > 0, _slot_iovecs > 0);
+        datagram_batch_t *db = CALLOC_LOG(db, sizeof(datagram_batch_t));
+        if (db == NULL)
+                return NULL;
+
+        db->capacity = _capacity;
+        db->slot_size = _slot_size;
+        db->slot_iovecs = _slot_iovecs;
+        db->messages = CALLOC_LOG(db->messages, _capacity * sizeof(struct mmsghdr));
+        db->coalesced_messages = CALLOC_LOG(db->coalesced_messages, _capacity * sizeof(struct mmsghdr));
+        db->iovecs = CALLOC_LOG(db->iovecs, _capacity * _slot_iovecs * sizeof(struct iovec));
+        db->addresses = CALLOC_LOG(db->addresses, _capacity * sizeof(struct sockaddr));
+        db->controls = CALLOC_LOG(db->controls, _capacity * DATAGRAM_BATCH_CONTROL_SIZE);
+        db->bytestreams = MALLOC_LOG(db->bytestreams, _capacity * _slot_size);
+        if (db->messages == NULL || db->coalesced_messages == NULL || db->iovecs == NULL ||
+            db->addresses == NULL || db->controls == NULL || db->bytestreams == NULL)
+        {
+                db_destroy(&db);
+                return NULL;
+        }
+
+        /* Slots are wired once, only their lengths change while the batch is in use. */
+        for (size_t i = 0; i < _capacity; i++)
+        {
+                db->iovecs[i * _slot_iovecs].iov_base = db->bytestreams + i * _slot_size;
+                db->messages[i].msg_hdr.msg_name = &db->addresses[i];
+                db->messages[i].msg_hdr.msg_iov = &db->iovecs[i * _slot_iovecs];
+                db->messages[i].msg_hdr.msg_iovlen = _slot_iovecs;
+        }
+        db_flush(db);
+        return db;
+}
+
+/* We request a double pointer, in order to NULLIFY user's batch pointer. */
+status_t db_destroy(datagram_batch_t **const _db_address)
+{
+        SMART_ASSERT(_db_address != NULL);
+
+#define DB (*_db_address)
+        if (DB == NULL)
+                return SUCCESS;
+        if (DB->messages != NULL)
+                FREE_NULLIFY_LOG(DB->messages);
+        if (DB->coalesced_messages != NULL)
+                FREE_NULLIFY_LOG(DB->coalesced_messages);
+        if (DB->iovecs != NULL)
+                FREE_NULLIFY_LOG(DB->iovecs);
+        if (DB->addresses != NULL)
+                FREE_NULLIFY_LOG(DB->addresses);
+        if (DB->controls != NULL)
+                FREE_NULLIFY_LOG(DB->controls);
+        if (DB->bytestreams != NULL)
+                FREE_NULLIFY_LOG(DB->bytestreams);
+        FREE_NULLIFY_LOG(DB);
+        return SUCCESS;
+#undef DB
+}
+
+void db_prepare_reception(datagram_batch_t *const _db)
+{
+        DEBUG_SMART_ASSERT(_db != NULL, _db->slot_iovecs == 1);
+        for (size_t i = 0; i < _db->capacity; i++)
+        {
+                _db->iovecs[i].iov_len = _db->slot_size;
+                _db->messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr);
+                _db->messages[i].msg_hdr.msg_control = db_slot_control(_db, i);
+                _db->messages[i].msg_hdr.msg_controllen = DATAGRAM_BATCH_CONTROL_SIZE;
+                _db->messages[i].msg_hdr.msg_flags = 0;
+                _db->messages[i].msg_len = 0;
+        }
+}
+
+void db_flush(datagram_batch_t *const _db)
+{
+        DEBUG_SMART_ASSERT(_db != NULL);
+        _db->count = 0;
+        _db->cursor = 0;
+        _db->slot_offset = 0;
+        _db->slot_stride = 0;
+}
+
+uint8_t *db_slot_bytestream(const datagram_batch_t *const _db, const size_t _slot)
+{
+        DEBUG_SMART_ASSERT(_db != NULL, _slot < _db->capacity);
+        return _db->bytestreams + _slot * _db->slot_size;
+}
+
+uint8_t *db_slot_control(const datagram_batch_t *const _db, const size_t _slot)
+{
+        DEBUG_SMART_ASSERT(_db != NULL, _slot < _db->capacity);
+        return _db->controls + _slot * DATAGRAM_BATCH_CONTROL_SIZE;
+}
+
+struct iovec *db_slot_iovecs(const datagram_batch_t *const _db, const size_t _slot)
+{
+        DEBUG_SMART_ASSERT(_db != NULL, _slot < _db->capacity);
+        return _db->iovecs + _slot * _db->slot_iovecs;
+}
+
+/* @returns the length of slot's datagram, gathered from all of its iovecs. */
+size_t db_slot_length(const datagram_batch_t *const _db, const size_t _slot)
+{
+        const struct iovec *const iovecs = db_slot_iovecs(_db, _slot);
+        size_t length = 0;
+        for (size_t i = 0; i < _db->slot_iovecs; i++)
+                length += iovecs[i].iov_len;
+        return length;
+}
+
+_Bool db_is_full(const datagram_batch_t *const _db)
+{
+        DEBUG_SMART_ASSERT(_db != NULL);
+        return _db->count == _db->capacity;
+}
+
+size_t db_pending_slots(const datagram_batch_t *const _db)
+{
+        DEBUG_SMART_ASSERT(_db != NULL, _db->cursor <= _db->count);
+        return _db->count - _db->cursor;
+}
@@ -0,0 +1,128 @@
+#include "core/delayed_ack.h"
+#include <poll.h>
+#include <stdint.h>
+#include <time.h>
+#include "core/listener.h"
+#include "core/receive_ring_buffer.h"
+#include "core/segment_io.h"
+#include "core/segment_processing.h"
+#include "core/stats_export.h"
+#include "microtcp.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "settings/microtcp_settings.h"
+#include "smart_assert.h"
+#include "status.h"
+
+#define DELAYED_ACK_MIN_WINDOW (2 * MICROTCP_MSS)   /* Below it, peer is about to stall on our window; Tell it at once. */
+#define WINDOW_UPDATE_MIN_GROWTH (2 * MICROTCP_MSS) /* RFC 1122 4.2.3.3: Window updates are worth a segment, once they reach 2 MSS... */
+#define WINDOW_UPDATE_GROWTH_FACTOR 2               /* ...and (Linux's __tcp_cleanup_rbuf()) the window at least doubled. */
+#define USEC_PER_SEC 1000000
+#define NSEC_PER_USEC 1000
+
+static status_t send_ack(microtcp_sock_t *_socket);
+static _Bool is_ack_delaying_enabled(void);
+
+void delayed_ack_reset(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL);
+        _socket->unacked_segments = 0; /* Nothing pending; Window is the one we start with. */
+        _socket->ack_deadline_usec = 0;
+        _socket->advertised_win_size = _socket->curr_win_size;
+}
+
+void delayed_ack_on_ack_sent(microtcp_sock_t *const _socket, const microtcp_header_t *const _header)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _header != NULL);
+        if (RARE_CASE(_header->ack_number != _socket->ack_number)) /* Built before the latest segments arrived. */
+                return;
+        _socket->unacked_segments = 0;
+        _socket->ack_deadline_usec = 0;
+        _socket->advertised_win_size = _header->window;
+}
+
+status_t delayed_ack_on_data(microtcp_sock_t *const _socket, const uint32_t _previous_ack_number)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->segment_receive_buffer != NULL, _socket->bytestream_rrb != NULL);
+        const microtcp_header_t *const header = &_socket->segment_receive_buffer->header;
+        const _Bool in_order = header->seq_number == _previous_ack_number &&
+                               _socket->ack_number - _previous_ack_number == header->data_len && /* Neither rejected, nor trimmed, nor filling a gap. */
+                               rrb_out_of_order_bytes(_socket->bytestream_rrb) == 0;
+        if (!in_order || header->data_len < MICROTCP_MSS || _socket->curr_win_size < DELAYED_ACK_MIN_WINDOW || !is_ack_delaying_enabled())
+                return send_ack(_socket);
+        if (++_socket->unacked_segments >= get_microtcp_delayed_ack_segments())
+                return send_ack(_socket);
+        if (_socket->ack_deadline_usec == 0) /* First unACKed segment starts the timer. */
+                _socket->ack_deadline_usec = get_monotonic_time_usec() + timeval_to_usec(get_microtcp_delayed_ack_timeout());
+        return SUCCESS;
+}
+
+status_t delayed_ack_on_window_update(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        const size_t advertised_window = _socket->advertised_win_size;
+        if (_socket->curr_win_size >= advertised_window + WINDOW_UPDATE_MIN_GROWTH &&
+            _socket->curr_win_size >= WINDOW_UPDATE_GROWTH_FACTOR * advertised_window)
+                return send_ack(_socket);
+        return SUCCESS;
+}
+
+status_t delayed_ack_flush(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        if (COMMON_CASE(_socket->ack_deadline_usec == 0))
+                return SUCCESS;
+        return send_ack(_socket);
+}
+
+status_t delayed_ack_expire(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        if (delayed_ack_delay_usec(_socket) != 0)
+                return SUCCESS;
+        return send_ack(_socket);
+}
+
+time_t delayed_ack_delay_usec(const microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        if (COMMON_CASE(_socket->ack_deadline_usec == 0))
+                return -1;
+        return MAX(_socket->ack_deadline_usec - get_monotonic_time_usec(), 0);
+}
+
+status_t delayed_ack_wait(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        if (_socket->stats_export_slot != NULL) /* Socket is drained, receiver is about to block; Blocking receptions return rarely. */
+                stats_export_publish_if_due(_socket, get_monotonic_time_usec());
+        const time_t delay_usec = delayed_ack_delay_usec(_socket);
+        if (delay_usec > 0 && _socket->listener != NULL)
+        {
+                const ssize_t receive_ret_val = listener_receive(_socket, delay_usec);
+                if (receive_ret_val != RECV_SEGMENT_TIMEOUT)
+                        return receive_ret_val == RECV_SEGMENT_FATAL_ERROR ? FAILURE : SUCCESS;
+        }
+        else if (delay_usec > 0)
+        {
+                struct pollfd socket_fd = {.fd = _socket->sd, .events = POLLIN};
+                const struct timespec timeout = {.tv_sec = delay_usec / USEC_PER_SEC, .tv_nsec = (delay_usec % USEC_PER_SEC) * NSEC_PER_USEC};
+                if (ppoll(&socket_fd, 1, &timeout, NULL) != 0) /* A datagram (or a signal); Caller receives before ACKing. */
+                        return SUCCESS;
+        }
+        return delayed_ack_flush(_socket);
+}
+
+/* Send path resets the pending state, once the ACK left (see delayed_ack_on_ack_sent()). */
+static status_t send_ack(microtcp_sock_t *const _socket)
+{
+        if (RARE_CASE(send_ack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address)) == SEND_SEGMENT_FATAL_ERROR))
+                return FAILURE;
+        return SUCCESS;
+}
+
+static _Bool is_ack_delaying_enabled(void)
+{
+        return get_microtcp_delayed_ack_segments() > 1 && timeval_to_usec(get_microtcp_delayed_ack_timeout()) > 0;
+}
@@ -0,0 +1,118 @@
+#include "core/listen_queue.h"
+#include <netinet/in.h>
+#include <stddef.h>
+#include <string.h>
+#include "allocator/allocator_macros.h"
+#include "logging/microtcp_logger.h"
+#include "smart_assert.h"
+#include "status.h"
+
+struct listen_queue
+{
+        pending_connection_t *connections;
+        size_t capacity;
+        size_t size;
+};
+
+static _Bool is_same_peer(const struct sockaddr *_a, const struct sockaddr *_b);
+
+listen_queue_t *lq_create(const size_t _backlog)
+{
+        SMART_ASSERT(_backlog > 0);
+        listen_queue_t *lq = CALLOC_LOG(lq, sizeof(listen_queue_t));
+        if (lq == NULL)
+                return NULL;
+        lq->connections = CALLOC_LOG(lq->connections, _backlog * sizeof(pending_connection_t));
+        if (lq->connections == NULL)
+        {
+                FREE_NULLIFY_LOG(lq);
+                return NULL;
+        }
+        lq->capacity = _backlog;
+        return lq;
+}
+
+/* We request a double pointer, in order to NULLIFY user's queue pointer. Established connections' entries are caller's to free. */
+status_t lq_destroy(listen_queue_t **const _lq_address)
+{
+        SMART_ASSERT(_lq_address != NULL);
+
+#define LQ (*_lq_address)
+        if (LQ == NULL)
+                return SUCCESS;
+        FREE_NULLIFY_LOG(LQ->connections);
+        FREE_NULLIFY_LOG(LQ);
+        return SUCCESS;
+#undef LQ
+}
+
+pending_connection_t *lq_add(listen_queue_t *const _lq, const struct sockaddr *const _peer)
+{
+        DEBUG_SMART_ASSERT(_lq != NULL, _peer != NULL, lq_find(_lq, _peer) == NULL);
+        if (_lq->size == _lq->capacity)
+                return NULL;
+        pending_connection_t *const connection = &_lq->connections[_lq->size++];
+        *connection = (pending_connection_t){0};
+        memcpy(&connection->peer, _peer, sizeof(connection->peer));
+        return connection;
+}
+
+void lq_remove(listen_queue_t *const _lq, pending_connection_t *const _connection)
+{
+        DEBUG_SMART_ASSERT(_lq != NULL, _connection >= _lq->connections, _connection < _lq->connections + _lq->size);
+        *_connection = _lq->connections[--_lq->size];
+}
+
+pending_connection_t *lq_find(listen_queue_t *const _lq, const struct sockaddr *const _peer)
+{
+        DEBUG_SMART_ASSERT(_lq != NULL, _peer != NULL);
+        for (size_t i = 0; i < _lq->size; i++)
+                if (is_same_peer(&_lq->connections[i].peer, _peer))
+                        return &_lq->connections[i];
+        return NULL;
+}
+
+pending_connection_t *lq_get(listen_queue_t *const _lq, const size_t _index)
+{
+        DEBUG_SMART_ASSERT(_lq != NULL, _index < _lq->size);
+        return &_lq->connections[_index];
+}
+
+pending_connection_t *lq_oldest_established(listen_queue_t *const _lq)
+{
+        DEBUG_SMART_ASSERT(_lq != NULL);
+        pending_connection_t *oldest = NULL;
+        for (size_t i = 0; i < _lq->size; i++)
+        {
+                pending_connection_t *const connection = &_lq->connections[i];
+                if (connection->entry != NULL && (oldest == NULL || connection->established_time_usec < oldest->established_time_usec))
+                        oldest = connection;
+        }
+        return oldest;
+}
+
+size_t lq_size(const listen_queue_t *const _lq)
+{
+        DEBUG_SMART_ASSERT(_lq != NULL);
+        return _lq->size;
+}
+
+time_t lq_next_synack_deadline(listen_queue_t *const _lq)
+{
+        DEBUG_SMART_ASSERT(_lq != NULL);
+        time_t next_deadline_usec = -1;
+        for (size_t i = 0; i < _lq->size; i++)
+        {
+                const pending_connection_t *const connection = &_lq->connections[i];
+                if (connection->entry == NULL && (next_deadline_usec == -1 || connection->synack_deadline_usec < next_deadline_usec))
+                        next_deadline_usec = connection->synack_deadline_usec;
+        }
+        return next_deadline_usec;
+}
+
+static _Bool is_same_peer(const struct sockaddr *const _a, const struct sockaddr *const _b)
+{
+        const struct sockaddr_in *const a = (const struct sockaddr_in *)_a;
+        const struct sockaddr_in *const b = (const struct sockaddr_in *)_b;
+        return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
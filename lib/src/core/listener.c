@@ -0,0 +1,414 @@
+#include "core/listener.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "allocator/allocator_macros.h"
+#include "core/connection_table.h"
+#include "core/datagram_batch.h"
+#include "core/listen_queue.h"
+#include "core/segment_io.h"
+#include "core/syn_cookie.h"
+#include "core/time_wait_table.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "settings/microtcp_settings.h"
+#include "smart_assert.h"
+#include "status.h"
+
+#define CONNECTION_TABLE_INITIAL_BUCKETS 64
+#define RECVMMSG_ERROR (-1)
+#define USEC_PER_SEC 1000000
+#define NSEC_PER_USEC 1000
+#define NO_ROUTED_EVENTFD (-1)
+
+struct listener
+{
+        int sd;
+        connection_table_t *table;
+        datagram_batch_t *unmatched_inbox; /* Datagrams of peers without a connection; Handed to accepting sockets. */
+        datagram_batch_t *pump_batch;      /* Filled by pumping recvmmsg(), then routed to inboxes. */
+        listen_queue_t *listen_queue;      /* Guarded by `accept_lock`; Held through a whole accept (see listener_lock_listen_queue()). */
+        pthread_mutex_t accept_lock;
+        pthread_mutex_t lock;              /* Guards everything else below `sd`, and every connection entry. */
+        pthread_cond_t routed;             /* Broadcast after each routing, and whenever pumping stops. */
+        _Bool pumping;                     /* A waiter is pumping the descriptor (outside the lock). */
+        int routed_eventfd;                /* Signaled after each routing, once a poller asked for it (see listener_routed_fd()). */
+        size_t references;
+};
+
+static status_t pump(listener_t *_listener, time_t _deadline_usec);
+static _Bool holds_handshake_segment(listener_t *_listener, const microtcp_sock_t *_socket);
+static void route_datagram(listener_t *_listener, const datagram_batch_t *_source, size_t _slot);
+static datagram_batch_t **get_inbox(listener_t *_listener, microtcp_sock_t *_socket);
+static struct timespec usec_to_timespec(time_t _usec);
+
+listener_t *listener_create(const int _sd)
+{
+        listener_t *listener = CALLOC_LOG(listener, sizeof(listener_t));
+        if (listener == NULL)
+                return NULL;
+        listener->sd = _sd;
+        listener->routed_eventfd = NO_ROUTED_EVENTFD;
+        listener->references = 1;
+        pthread_condattr_t routed_attributes;
+        _Bool accept_lock_initialized = false, lock_initialized = false, routed_initialized = false;
+        if ((listener->table = ct_create(CONNECTION_TABLE_INITIAL_BUCKETS)) == NULL ||
+            (listener->listen_queue = lq_create(get_accept_backlog())) == NULL ||
+            (listener->unmatched_inbox = db_create(DATAGRAM_BATCH_CAPACITY, MICROTCP_MTU, 1)) == NULL ||
+            (listener->pump_batch = db_create(DATAGRAM_BATCH_CAPACITY, MICROTCP_MTU, 1)) == NULL)
+                goto failure_cleanup;
+        if (!(accept_lock_initialized = (pthread_mutex_init(&listener->accept_lock, NULL) == 0)))
+                goto failure_cleanup;
+        if (!(lock_initialized = (pthread_mutex_init(&listener->lock, NULL) == 0)))
+                goto failure_cleanup;
+        if (pthread_condattr_init(&routed_attributes) != 0)
+                goto failure_cleanup;
+        pthread_condattr_setclock(&routed_attributes, CLOCK_MONOTONIC); /* Deadlines come from get_monotonic_time_usec(). */
+        routed_initialized = (pthread_cond_init(&listener->routed, &routed_attributes) == 0);
+        pthread_condattr_destroy(&routed_attributes);
+        if (!routed_initialized)
+                goto failure_cleanup;
+        LOG_INFO_RETURN(listener, "Listener created. (sd = %d)", _sd);
+
+failure_cleanup:
+        if (accept_lock_initialized)
+                pthread_mutex_destroy(&listener->accept_lock);
+        if (lock_initialized)
+                pthread_mutex_destroy(&listener->lock);
+        lq_destroy(&listener->listen_queue);
+        db_destroy(&listener->pump_batch);
+        db_destroy(&listener->unmatched_inbox);
+        ct_destroy(&listener->table);
+        FREE_NULLIFY_LOG(listener);
+        LOG_ERROR_RETURN(NULL, "Failed to create listener.");
+}
+
+listener_t *listener_retain(listener_t *const _listener)
+{
+        SMART_ASSERT(_listener != NULL);
+        pthread_mutex_lock(&_listener->lock);
+        _listener->references++;
+        pthread_mutex_unlock(&_listener->lock);
+        return _listener;
+}
+
+/* We request a double pointer, in order to NULLIFY user's listener pointer. */
+_Bool listener_release(listener_t **const _listener_address)
+{
+        SMART_ASSERT(_listener_address != NULL);
+
+#define LISTENER (*_listener_address)
+        if (LISTENER == NULL)
+                return false;
+        pthread_mutex_lock(&LISTENER->lock);
+        const size_t references = --LISTENER->references;
+        pthread_mutex_unlock(&LISTENER->lock);
+        if (references > 0)
+        {
+                LISTENER = NULL;
+                return false;
+        }
+        for (size_t i = 0; i < lq_size(LISTENER->listen_queue); i++) /* Established, but never accepted. */
+        {
+                pending_connection_t *const connection = lq_get(LISTENER->listen_queue, i);
+                if (connection->entry == NULL)
+                        continue;
+                ct_remove(LISTENER->table, connection->entry);
+                ce_destroy(&connection->entry);
+        }
+        lq_destroy(&LISTENER->listen_queue);
+        if (LISTENER->routed_eventfd != NO_ROUTED_EVENTFD)
+                close(LISTENER->routed_eventfd);
+        pthread_cond_destroy(&LISTENER->routed);
+        pthread_mutex_destroy(&LISTENER->accept_lock);
+        pthread_mutex_destroy(&LISTENER->lock);
+        db_destroy(&LISTENER->pump_batch);
+        db_destroy(&LISTENER->unmatched_inbox);
+        ct_destroy(&LISTENER->table);
+        FREE_NULLIFY_LOG(LISTENER);
+        return true;
+#undef LISTENER
+}
+
+size_t listener_connections(listener_t *const _listener)
+{
+        SMART_ASSERT(_listener != NULL);
+        pthread_mutex_lock(&_listener->lock);
+        const size_t connections = _listener->references - 1;
+        pthread_mutex_unlock(&_listener->lock);
+        return connections;
+}
+
+listen_queue_t *listener_lock_listen_queue(listener_t *const _listener)
+{
+        SMART_ASSERT(_listener != NULL);
+        pthread_mutex_lock(&_listener->accept_lock);
+        return _listener->listen_queue;
+}
+
+void listener_unlock_listen_queue(listener_t *const _listener)
+{
+        SMART_ASSERT(_listener != NULL);
+        pthread_mutex_unlock(&_listener->accept_lock);
+}
+
+status_t listener_attach(microtcp_sock_t *const _socket, connection_entry_t *const _entry)
+{
+        SMART_ASSERT(_socket != NULL, _socket->listener != NULL, _entry != NULL);
+        listener_t *const listener = _socket->listener;
+        datagram_batch_t *const batch = _socket->receive_batch;
+        pthread_mutex_lock(&listener->lock);
+        if (ct_insert(listener->table, _entry) == FAILURE)
+        {
+                pthread_mutex_unlock(&listener->lock);
+                LOG_WARNING_RETURN(FAILURE, "Peer already has a connection on this listener.");
+        }
+        /* Unmatched datagrams were taken as a whole; Whatever is left goes where it belongs now (new peer's, to its inbox). */
+        for (size_t slot = batch->cursor; slot < batch->count; slot++)
+                route_datagram(listener, batch, slot);
+        batch->cursor = batch->count;
+        pthread_cond_broadcast(&listener->routed); /* Unmatched inbox may have been refilled. */
+        pthread_mutex_unlock(&listener->lock);
+        return SUCCESS;
+}
+
+void listener_detach(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL, _socket->listener != NULL);
+        if (_socket->connection_entry == NULL)
+                return;
+        pthread_mutex_lock(&_socket->listener->lock);
+        ct_remove(_socket->listener->table, _socket->connection_entry);
+        db_flush(_socket->connection_entry->inbox);
+        pthread_mutex_unlock(&_socket->listener->lock);
+}
+
+connection_entry_t *listener_linger(microtcp_sock_t *const _socket, const time_wait_entry_t *const _time_wait_entry)
+{
+        SMART_ASSERT(_socket != NULL, _socket->listener != NULL, _time_wait_entry != NULL);
+        connection_entry_t *const entry = _socket->connection_entry;
+        if (entry == NULL || !entry->attached)
+                return NULL;
+        pthread_mutex_lock(&_socket->listener->lock);
+        entry->time_wait = _time_wait_entry;
+        db_destroy(&entry->inbox);
+        pthread_mutex_unlock(&_socket->listener->lock);
+        _socket->connection_entry = NULL;
+        return entry;
+}
+
+void listener_forget(listener_t *const _listener, connection_entry_t **const _entry_address)
+{
+        SMART_ASSERT(_listener != NULL, _entry_address != NULL);
+        pthread_mutex_lock(&_listener->lock);
+        ct_remove(_listener->table, *_entry_address);
+        pthread_mutex_unlock(&_listener->lock);
+        ce_destroy(_entry_address);
+}
+
+_Bool listener_is_readable(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->listener != NULL);
+        listener_t *const listener = _socket->listener;
+        if (_socket->connection_entry != NULL)
+        {
+                pthread_mutex_lock(&listener->lock);
+                const _Bool readable = (*get_inbox(listener, _socket))->count > 0;
+                pthread_mutex_unlock(&listener->lock);
+                return readable;
+        }
+        if (pthread_mutex_trylock(&listener->accept_lock) != 0)
+                return false; /* A held listen queue is being worked by an accept; It takes what is there. */
+        pthread_mutex_lock(&listener->lock);
+        const _Bool readable = lq_oldest_established(listener->listen_queue) != NULL || holds_handshake_segment(listener, _socket);
+        pthread_mutex_unlock(&listener->lock);
+        pthread_mutex_unlock(&listener->accept_lock);
+        return readable;
+}
+
+status_t listener_route(listener_t *const _listener)
+{
+        SMART_ASSERT(_listener != NULL);
+        pthread_mutex_lock(&_listener->lock);
+        if (_listener->pumping)
+        {
+                pthread_mutex_unlock(&_listener->lock);
+                return SUCCESS;
+        }
+        _listener->pumping = true;
+        pthread_mutex_unlock(&_listener->lock);
+        const status_t pump_ret_val = pump(_listener, get_monotonic_time_usec()); /* Deadline is now; Drains, without waiting. */
+        pthread_mutex_lock(&_listener->lock);
+        _listener->pumping = false;
+        pthread_cond_broadcast(&_listener->routed);
+        pthread_mutex_unlock(&_listener->lock);
+        return pump_ret_val;
+}
+
+int listener_routed_fd(listener_t *const _listener)
+{
+        SMART_ASSERT(_listener != NULL);
+        pthread_mutex_lock(&_listener->lock);
+        if (_listener->routed_eventfd == NO_ROUTED_EVENTFD &&
+            (_listener->routed_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == NO_ROUTED_EVENTFD)
+                LOG_ERROR("Listener's routing eventfd could not be created; errno(%d):%s.", errno, strerror(errno));
+        const int routed_eventfd = _listener->routed_eventfd;
+        pthread_mutex_unlock(&_listener->lock);
+        return routed_eventfd;
+}
+
+ssize_t listener_receive(microtcp_sock_t *const _socket, const time_t _timeout_usec)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->listener != NULL, db_pending_slots(_socket->receive_batch) == 0);
+        listener_t *const listener = _socket->listener;
+        const time_t deadline_usec = get_monotonic_time_usec() + _timeout_usec;
+        _Bool pumped_once = false;
+
+        pthread_mutex_lock(&listener->lock);
+        datagram_batch_t **const inbox = get_inbox(listener, _socket); /* Stable while locked; Attach/detach are socket's own calls. */
+        while ((*inbox)->count == 0)
+        {
+                const time_t remaining_usec = deadline_usec - get_monotonic_time_usec();
+                if (pumped_once && remaining_usec <= 0)
+                        break;
+                if (!listener->pumping)
+                {
+                        listener->pumping = true;
+                        pthread_mutex_unlock(&listener->lock);
+                        const status_t pump_ret_val = pump(listener, deadline_usec);
+                        pthread_mutex_lock(&listener->lock);
+                        listener->pumping = false;
+                        pthread_cond_broadcast(&listener->routed); /* Routed datagrams, or pumping is up for grabs. */
+                        pumped_once = true;
+                        if (RARE_CASE(pump_ret_val == FAILURE))
+                        {
+                                pthread_mutex_unlock(&listener->lock);
+                                return RECV_SEGMENT_FATAL_ERROR;
+                        }
+                        continue;
+                }
+                if (remaining_usec <= 0) /* Someone else pumps; A non-blocking reception has nothing to wait for. */
+                        break;
+                const struct timespec deadline = usec_to_timespec(deadline_usec);
+                pthread_cond_timedwait(&listener->routed, &listener->lock, &deadline);
+        }
+        if ((*inbox)->count == 0)
+        {
+                pthread_mutex_unlock(&listener->lock);
+                return RECV_SEGMENT_TIMEOUT;
+        }
+        /* Inbox and receive batch are alike; Swapping them hands datagrams over without copying. */
+        datagram_batch_t *const received = *inbox;
+        db_flush(_socket->receive_batch);
+        *inbox = _socket->receive_batch;
+        _socket->receive_batch = received;
+        pthread_mutex_unlock(&listener->lock);
+        return received->count;
+}
+
+/**
+ * @brief Called unlocked, by the one pumping waiter: Waits (up to `_deadline_usec`) for the descriptor to turn readable,
+ * drains it, and routes what it got (locked). A signal, or stray readiness, ends the wait early; Callers loop anyway.
+ */
+static status_t pump(listener_t *const _listener, const time_t _deadline_usec)
+{
+        datagram_batch_t *const batch = _listener->pump_batch;
+        const time_t wait_usec = MAX(_deadline_usec - get_monotonic_time_usec(), 0);
+        if (wait_usec > 0)
+        {
+                struct pollfd listener_fd = {.fd = _listener->sd, .events = POLLIN};
+                const struct timespec timeout = {.tv_sec = wait_usec / USEC_PER_SEC, .tv_nsec = (wait_usec % USEC_PER_SEC) * NSEC_PER_USEC};
+                if (ppoll(&listener_fd, 1, &timeout, NULL) <= 0)
+                        return SUCCESS;
+        }
+        db_flush(batch);
+        db_prepare_reception(batch);
+        const int recvmmsg_ret_val = recvmmsg(_listener->sd, batch->messages, batch->capacity, MSG_DONTWAIT | MSG_TRUNC, NULL);
+        if (recvmmsg_ret_val == RECVMMSG_ERROR && (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR))
+                return SUCCESS;
+        if (RARE_CASE(recvmmsg_ret_val == RECVMMSG_ERROR))
+                LOG_ERROR_RETURN(FAILURE, "Listener's reception failed; recvmmsg() set errno(%d):%s.", errno, strerror(errno));
+        batch->count = recvmmsg_ret_val;
+        pthread_mutex_lock(&_listener->lock);
+        for (size_t slot = 0; slot < batch->count; slot++)
+                route_datagram(_listener, batch, slot);
+        const int routed_eventfd = _listener->routed_eventfd;
+        pthread_mutex_unlock(&_listener->lock);
+        const uint64_t routing = 1;
+        if (routed_eventfd != NO_ROUTED_EVENTFD && write(routed_eventfd, &routing, sizeof(routing)) == -1 && errno != EAGAIN)
+                LOG_WARNING("Listener's routing went unsignaled; write() on eventfd set errno(%d):%s.", errno, strerror(errno));
+        return SUCCESS;
+}
+
+/* Called locked; Copies a datagram into its peer's inbox (or the unmatched one). Full inboxes drop it, as a full socket buffer would. */
+static void route_datagram(listener_t *const _listener, const datagram_batch_t *const _source, const size_t _slot)
+{
+        const struct sockaddr_in *const peer = (const struct sockaddr_in *)&_source->addresses[_slot];
+        const connection_entry_t *const entry = ct_find(_listener->table, peer);
+        if (entry != NULL && entry->time_wait != NULL)
+        {
+                time_wait_answer_datagram(entry->time_wait, _listener->sd, db_slot_bytestream(_source, _slot), _source->messages[_slot].msg_len);
+                return;
+        }
+        datagram_batch_t *const inbox = entry != NULL ? entry->inbox : _listener->unmatched_inbox;
+        const size_t datagram_length = _source->messages[_slot].msg_len;
+        if (RARE_CASE(db_is_full(inbox) || datagram_length > inbox->slot_size))
+        {
+                LOG_WARNING("Listener dropped a datagram of %zu bytes; %s.", datagram_length, db_is_full(inbox) ? "Its inbox is full" : "It is oversized");
+                return;
+        }
+        const size_t slot = inbox->count++;
+        memcpy(db_slot_bytestream(inbox, slot), db_slot_bytestream(_source, _slot), datagram_length);
+        memcpy(&inbox->addresses[slot], &_source->addresses[_slot], sizeof(struct sockaddr));
+        inbox->messages[slot].msg_len = datagram_length;
+        inbox->messages[slot].msg_hdr.msg_namelen = sizeof(struct sockaddr);
+        inbox->messages[slot].msg_hdr.msg_controllen = 0;
+        inbox->messages[slot].msg_hdr.msg_flags = 0;
+}
+
+/**
+ * Called with both locks held; Unmatched datagrams an accept acts upon: SYNs, and ACKs completing a handshake (of a
+ * half-open connection, or of a SYN cookie). Strays (e.g. late segments of a closed connection) are no reason to accept.
+ */
+static _Bool holds_handshake_segment(listener_t *const _listener, const microtcp_sock_t *const _socket)
+{
+        const datagram_batch_t *const inbox = _listener->unmatched_inbox;
+        for (size_t slot = 0; slot < inbox->count; slot++)
+        {
+                if (inbox->messages[slot].msg_len < MICROTCP_HEADER_SIZE)
+                        continue;
+                const microtcp_header_t *const header = (const microtcp_header_t *)db_slot_bytestream(inbox, slot);
+                if (header->control == SYN_BIT)
+                        return true;
+                if (!(header->control & ACK_BIT) || (header->control & (SYN_BIT | FIN_BIT | RST_BIT)))
+                        continue;
+                const struct sockaddr *const peer = &inbox->addresses[slot];
+                const pending_connection_t *const connection = lq_find(_listener->listen_queue, peer);
+                if (connection != NULL ? connection->entry == NULL
+                                       : _socket->syn_cookies && syn_cookie_validate(peer, header->seq_number - SYN_SEQ_NUMBER_INCREMENT,
+                                                                                     header->ack_number - SYN_SEQ_NUMBER_INCREMENT))
+                        return true;
+        }
+        return false;
+}
+
+/* Called locked; Sockets with a connection entry in the table receive from it, the rest (accepting ones) from the unmatched inbox. */
+static datagram_batch_t **get_inbox(listener_t *const _listener, microtcp_sock_t *const _socket)
+{
+        connection_entry_t *const entry = _socket->connection_entry;
+        return entry != NULL && entry->attached ? &entry->inbox : &_listener->unmatched_inbox;
+}
+
+static struct timespec usec_to_timespec(const time_t _usec)
+{
+        return (struct timespec){.tv_sec = _usec / USEC_PER_SEC, .tv_nsec = (_usec % USEC_PER_SEC) * NSEC_PER_USEC};
+}
@@ -6,10 +6,14 @@
 #include "logging/microtcp_logger.h"
 #include "microtcp_helper_macros.h"
 #include "smart_assert.h"
+#include "core/delayed_ack.h"
 #include "core/misc.h"
 #include "core/microtcp_recv_impl.h"
 #include "core/segment_processing.h"
 #include "core/segment_io.h"
+#include "core/protocol_engine.h"
+#include "core/send_ring_buffer.h"
+#include "core/stats_export.h"
 #include <threads.h>
 #include <limits.h>
 #include "microtcp_helper_functions.h"
@@ -34,23 +38,48 @@ static __always_inline ssize_t handle_rst_reception(microtcp_sock_t *const _sock
         LOG_ERROR_RETURN(MICROTCP_RECV_FAILURE, "Peer sent an RST. Socket enters %s state", get_microtcp_state_to_string(_socket->state));
 }
 
+/* Buffered send mode: Send FSM broke the connection (FIN|ACK, RST, or failure), while microtcp_recv() was progressing it. */
+static __always_inline ssize_t handle_send_fsm_failure(microtcp_sock_t *const _socket, const size_t _bytes_received)
+{
+        if (_socket->state == CLOSING_BY_PEER && _bytes_received > 0)
+        {
+                _socket->state = ESTABLISHED; /* Like handle_finack_reception(): Data goes first, next call reports the FIN|ACK. */
+                _socket->data_reception_with_finack = true;
+        }
+        DEBUG_SMART_ASSERT(_bytes_received < SSIZE_MAX);
+        return _bytes_received > 0 ? (ssize_t)_bytes_received : MICROTCP_RECV_FAILURE;
+}
+
 /* _flags are validated by the caller. microtcp_recv() */
 ssize_t microtcp_recv_impl(microtcp_sock_t *const _socket, uint8_t *const _buffer, const size_t _length, const int _flags)
 {
+        if (_socket->engine != NULL) /* microtcp_recv_timed() lands here too. */
+                return pe_recv(_socket->engine, _buffer, _length, _flags);
         receive_ring_buffer_t *const bytestream_rrb = _socket->bytestream_rrb; /* Create local pointer to avoid dereferencing. */
         const size_t cached_rrb_size = rrb_size(bytestream_rrb);
         const _Bool block = !(_flags & MSG_DONTWAIT);
 
         if (_socket->data_reception_with_finack == true) /* Received finack on previous called, but there was data available. */
         {
+                const size_t leftover_bytes = rrb_pop(bytestream_rrb, _buffer, _length); /* microtcp_poll() may leave data in RRB. */
+                _socket->curr_win_size = cached_rrb_size - rrb_consumable_bytes(bytestream_rrb);
+                if (leftover_bytes > 0)
+                        return (ssize_t)leftover_bytes;
                 _socket->state = CLOSING_BY_PEER;
                 return MICROTCP_RECV_FAILURE;
         }
 
         size_t bytes_received = rrb_pop(bytestream_rrb, _buffer, _length); /* Pop any leftover bytes in RRB. */
+        if (bytes_received > 0)
+        {
+                _socket->curr_win_size = cached_rrb_size - rrb_consumable_bytes(bytestream_rrb);
+                if (delayed_ack_on_window_update(_socket) == FAILURE)
+                        return MICROTCP_RECV_FAILURE;
+        }
         while (bytes_received != _length)
         {
-                ssize_t receive_data_ret_val = receive_data_segment(_socket, block);
+                /* While an ACK is pending, the socket is drained first; Then we wait no longer than the ACK may. */
+                ssize_t receive_data_ret_val = receive_data_segment(_socket, block && delayed_ack_delay_usec(_socket) < 0);
                 switch (receive_data_ret_val)
                 {
                 case RECV_SEGMENT_ERROR:
@@ -59,36 +88,62 @@ ssize_t microtcp_recv_impl(microtcp_sock_t *const _socket, uint8_t *const _buffe
                         return MICROTCP_RECV_FAILURE;
                 case RECV_SEGMENT_FINACK_UNEXPECTED:
                         if (_socket->segment_receive_buffer->header.seq_number == _socket->ack_number)
+                        {
+                                if (delayed_ack_flush(_socket) == FAILURE) /* Data's ACK goes first; Shutdown ACKs the FIN|ACK. */
+                                        return MICROTCP_RECV_FAILURE;
                                 return handle_finack_reception(_socket, bytes_received);
+                        }
                         LOG_WARNING("Protocol lost sychronization, received FIN|ACK, with mismatched `seq_number`; Could also be out-of-order (ignored)");
                         break;
                 case RECV_SEGMENT_RST_RECEIVED:
                         return handle_rst_reception(_socket);
+                case RECV_SEGMENT_ACK_RECEIVED:
+                        if (_socket->send_ring != NULL && microtcp_send_fsm_process_ack(_socket) == FAILURE)
+                                return handle_send_fsm_failure(_socket, bytes_received);
+                        break;
                 case RECV_SEGMENT_WINACK_RECEIVED:
                         if (send_ack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address)) == SEND_SEGMENT_FATAL_ERROR)
                                 return MICROTCP_RECV_FAILURE;
                         break;
                 case RECV_SEGMENT_TIMEOUT:
+                        if (_socket->stats_export_slot != NULL) /* Idle; Clock read costs nothing here. */
+                                stats_export_publish_if_due(_socket, get_monotonic_time_usec());
+                        /* Buffered sends' retransmission timers are checked here too, while no segment arrives. */
+                        if (_socket->send_ring != NULL && microtcp_send_fsm_progress(_socket, false) == FAILURE)
+                                return handle_send_fsm_failure(_socket, bytes_received);
+                        if (block && delayed_ack_delay_usec(_socket) >= 0) /* Socket got drained, it did not idle. */
+                        {
+                                if (delayed_ack_wait(_socket) == FAILURE)
+                                        return MICROTCP_RECV_FAILURE;
+                                break;
+                        }
                         bytes_received += rrb_pop(bytestream_rrb, _buffer + bytes_received, _length - bytes_received); /* Pop any remaining bytes.*/
                         if (_flags & MSG_WAITALL)
                                 break;
 
+                        if (delayed_ack_flush(_socket) == FAILURE)
+                                return MICROTCP_RECV_FAILURE;
                         DEBUG_SMART_ASSERT(bytes_received < SSIZE_MAX);
                         return (ssize_t)bytes_received;
                 default:
                 {
+                        const uint32_t previous_ack_number = _socket->ack_number;
                         uint32_t appended_bytes = rrb_append(bytestream_rrb, _socket->segment_receive_buffer);
-                        if (RARE_CASE(appended_bytes == 0))
-                                break;
-
-                        _socket->ack_number = rrb_last_consumed_seq_number(bytestream_rrb) + rrb_consumable_bytes(bytestream_rrb) + 1;
-                        bytes_received += rrb_pop(bytestream_rrb, _buffer + bytes_received, _length - bytes_received);
-                        _socket->curr_win_size = cached_rrb_size - rrb_consumable_bytes(bytestream_rrb);
-                        send_ack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address)); /* If curr_win_size == 0, we still send ACK. */
+                        if (COMMON_CASE(appended_bytes > 0))
+                        {
+                                _socket->ack_number = rrb_last_consumed_seq_number(bytestream_rrb) + rrb_consumable_bytes(bytestream_rrb) + 1;
+                                bytes_received += rrb_pop(bytestream_rrb, _buffer + bytes_received, _length - bytes_received);
+                                _socket->curr_win_size = cached_rrb_size - rrb_consumable_bytes(bytestream_rrb);
+                        }
+                        /* If curr_win_size == 0, we still send ACK. Rejected segments too; A (spurious) retransmission means peer missed our ACK. */
+                        if (delayed_ack_on_data(_socket, previous_ack_number) == FAILURE)
+                                return MICROTCP_RECV_FAILURE;
                         break;
                 }
                 }
         }
+        if (delayed_ack_flush(_socket) == FAILURE) /* No timer fires once we return; Data would sit unACKed until the next call. */
+                return MICROTCP_RECV_FAILURE;
         DEBUG_SMART_ASSERT(bytes_received < SSIZE_MAX);
         return (ssize_t)bytes_received;
 }
@@ -108,7 +163,7 @@ ssize_t microtcp_recv_timed_impl(microtcp_sock_t *const _socket, uint8_t *const
                             STRINGIFY(microtcp_recv), microtcp_recv_timeout_usec,
                             STRINGIFY(microtcp_recv));
 
-        time_t current_idle_time_usec = 0;
+        struct timeval idle_start_time = get_current_timeval(); /* Timeouts of microtcp_recv() follow RTO, so idle time is measured. */
         size_t bytes_received = 0;
         while (bytes_received != _length)
         {
@@ -117,15 +172,14 @@ ssize_t microtcp_recv_timed_impl(microtcp_sock_t *const _socket, uint8_t *const
                         return (ssize_t)(bytes_received > 0 ? bytes_received : MICROTCP_RECV_FAILURE);
                 if (RARE_CASE(recv_ret_val == MICROTCP_RECV_TIMEOUT))
                 {
-                        current_idle_time_usec += microtcp_recv_timeout_usec;
-                        if (current_idle_time_usec >= max_idle_time_usec) /* Max time reached (or exceeded). */
+                        if (elapsed_time_usec(idle_start_time) >= max_idle_time_usec) /* Max time reached (or exceeded). */
                                 LOG_WARNING_RETURN(bytes_received, "%s() `_max_idle_time` timer exhausted; `bytes_received = %zd`",
                                                    __func__, bytes_received);
                         continue;
                 }
                 DEBUG_SMART_ASSERT(recv_ret_val > 0);
                 bytes_received += recv_ret_val;
-                current_idle_time_usec = 0; /* Reset idle time counter. */
+                idle_start_time = get_current_timeval(); /* Reset idle time counter. */
         }
         DEBUG_SMART_ASSERT(bytes_received <= _length); /* We should never received more bytes than asked... (Just a final silly check). */
         return (ssize_t)bytes_received;
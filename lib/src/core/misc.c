@@ -7,6 +7,8 @@
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
+#include "core/connection_table.h"
+#include "core/listener.h"
 #include "core/resource_allocation.h"
 #include "core/send_queue.h"
 #include "logging/microtcp_logger.h"
@@ -81,6 +83,15 @@ microtcp_sock_t initialize_microtcp_socket(void)
             .bytestream_rrb = NULL,                              /* Receive-Ring-Buffer gets allocated in 3-way handshake. */
             .cwnd = MICROTCP_INIT_CWND,
             .ssthresh = get_microtcp_bytestream_rrb_size(),
+            .congestion_control = NULL,
+            .srtt_usec = 0,
+            .rttvar_usec = 0,
+            .rto_usec = timeval_to_usec(get_microtcp_ack_timeout()), /* microtcp_socket() sets SO_RCVTIMEO to it. */
+            .pacing_tokens = 0,
+            .pacing_refill_usec = 0,
+            .unacked_segments = 0,
+            .ack_deadline_usec = 0,
+            .advertised_win_size = get_microtcp_bytestream_rrb_size(),
             .seq_number = 0, /* Default value, waiting 3 way. */
             .ack_number = 0, /* Default value */
             .packets_sent = 0,
@@ -89,16 +100,35 @@ microtcp_sock_t initialize_microtcp_socket(void)
             .bytes_sent = 0,
             .bytes_received = 0,
             .bytes_lost = 0,
+            .stats = {0},
+            .application_stats = {{0}},
+            .stats_export_slot = NULL,
+            .stats_export_due_usec = 0,
             .segment_build_buffer = NULL,
-            .bytestream_build_buffer = NULL,
+            .header_build_buffer = NULL,
             .send_queue = NULL,
-            .bytestream_receive_buffer = NULL,
+            .send_batch = NULL,
+            .send_ring = NULL,
+            .send_context = NULL,
+            .engine = NULL,
+            .receive_batch = NULL,
             .peer_address = NULL,
 #ifdef LOG_TRAFFIC_MODE
             .inbound_traffic_log = fopen("inbound_traffic.log", "w"),
             .outbound_traffic_log = fopen("outbound_traffic.log", "w"),
 #endif /* LOG_TRAFFIC_MODE */
-            .data_reception_with_finack = false};
+            .data_reception_with_finack = false,
+            .udp_offload = false,
+            .send_buffer_size = 0,
+            .engine_thread = false,
+            .congestion_control_ops = NULL,
+            .sack = false,
+            .pacing = false,
+            .syn_cookies = false,
+            .async_time_wait = false,
+            .listener = NULL,
+            .connection_entry = NULL,
+            .poller_registration = NULL};
         return new_socket;
 }
 
@@ -113,7 +143,14 @@ void cleanup_microtcp_socket(microtcp_sock_t *const _socket)
                 graceful_operation = false;
         }
 
-        if (_socket->sd != POSIX_SOCKET_FAILURE_VALUE)
+        if (_socket->listener != NULL) /* Descriptor is shared; Last one out closes it. */
+        {
+                listener_detach(_socket);
+                ce_destroy(&_socket->connection_entry);
+                if (listener_release(&_socket->listener) && _socket->sd != POSIX_SOCKET_FAILURE_VALUE)
+                        close(_socket->sd);
+        }
+        else if (_socket->sd != POSIX_SOCKET_FAILURE_VALUE)
                 close(_socket->sd);
         _socket->sd = POSIX_SOCKET_FAILURE_VALUE;
         _socket->state = INVALID;
@@ -0,0 +1,101 @@
+#include "core/pacing.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "congestion_control/congestion_control.h"
+#include "microtcp.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+
+/* Linux's gains (tcp_update_pacing_rate()): Slow start doubles the window every RTT, congestion avoidance barely grows it. */
+#define SLOW_START_PACING_GAIN_PERCENT 200
+#define CONGESTION_AVOIDANCE_PACING_GAIN_PERCENT 120
+
+#define PACING_BURST_USEC 1000        /* Engine's poll() is no finer; Shorter gaps would stretch into one anyway. */
+#define PACING_QUANTUM_USEC 100       /* Bytes are let out in chunks of at least this much of the rate; Each costs a sleep and a sendmmsg(). */
+#define PACING_MIN_QUANTUM_SEGMENTS 2 /* Linux fq's quantum. */
+#define USEC_PER_SEC 1000000
+#define PERCENT 100
+
+static uint64_t get_pacing_rate(const microtcp_sock_t *_socket);
+static int64_t get_bucket_depth(uint64_t _pacing_rate);
+static int64_t get_quantum(uint64_t _pacing_rate);
+
+void pacing_reset(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL);
+        _socket->pacing_tokens = 0;
+        _socket->pacing_refill_usec = 0;
+}
+
+size_t pacing_allowance(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        if (!_socket->pacing)
+                return SIZE_MAX;
+        const uint64_t pacing_rate = get_pacing_rate(_socket);
+        if (pacing_rate == 0)
+                return SIZE_MAX;
+
+        const time_t now_usec = get_monotonic_time_usec();
+        const int64_t bucket_depth = get_bucket_depth(pacing_rate);
+        if (RARE_CASE(_socket->pacing_refill_usec == 0)) /* First paced round. */
+                _socket->pacing_tokens = bucket_depth;
+        else
+        {
+                const uint64_t elapsed_usec = (uint64_t)MAX(now_usec - _socket->pacing_refill_usec, 0);
+                const uint64_t refill = MIN(elapsed_usec * pacing_rate / USEC_PER_SEC, (uint64_t)bucket_depth); /* Long idle periods must not overflow. */
+                _socket->pacing_tokens = MIN(_socket->pacing_tokens + (int64_t)refill, bucket_depth);
+        }
+        _socket->pacing_refill_usec = now_usec;
+        return _socket->pacing_tokens >= get_quantum(pacing_rate) ? (size_t)_socket->pacing_tokens : 0;
+}
+
+void pacing_consume(microtcp_sock_t *const _socket, const size_t _bytes)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        if (_socket->pacing && _socket->pacing_refill_usec != 0)
+                _socket->pacing_tokens -= (int64_t)_bytes;
+}
+
+time_t pacing_delay_usec(const microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        if (!_socket->pacing || _socket->pacing_refill_usec == 0)
+                return 0;
+        const uint64_t pacing_rate = get_pacing_rate(_socket);
+        if (pacing_rate == 0 || _socket->pacing_tokens >= get_quantum(pacing_rate))
+                return 0;
+        const uint64_t missing_tokens = (uint64_t)(get_quantum(pacing_rate) - _socket->pacing_tokens);
+        const time_t repay_time_usec = (time_t)((missing_tokens * USEC_PER_SEC + pacing_rate - 1) / pacing_rate);
+        const time_t elapsed_usec = get_monotonic_time_usec() - _socket->pacing_refill_usec;
+        return elapsed_usec >= repay_time_usec ? 0 : repay_time_usec - elapsed_usec;
+}
+
+/* @returns bytes per second; 0 if unknown. */
+static uint64_t get_pacing_rate(const microtcp_sock_t *const _socket)
+{
+        if (_socket->congestion_control == NULL)
+                return 0;
+        const uint64_t module_pacing_rate = cc_pacing_rate(_socket->congestion_control, _socket);
+        if (module_pacing_rate != 0)
+                return module_pacing_rate;
+        if (_socket->srtt_usec == 0)
+                return 0;
+        const uint64_t gain_percent = _socket->cwnd < _socket->ssthresh ? SLOW_START_PACING_GAIN_PERCENT : CONGESTION_AVOIDANCE_PACING_GAIN_PERCENT;
+        const uint64_t cwnd = cc_cwnd(_socket->congestion_control, _socket);
+        return cwnd * gain_percent * (USEC_PER_SEC / PERCENT) / (uint64_t)_socket->srtt_usec;
+}
+
+static int64_t get_bucket_depth(const uint64_t _pacing_rate)
+{
+        return MAX((int64_t)(_pacing_rate / (USEC_PER_SEC / PACING_BURST_USEC)), get_quantum(_pacing_rate));
+}
+
+static int64_t get_quantum(const uint64_t _pacing_rate)
+{
+        const uint64_t quantum_bytes = _pacing_rate / (USEC_PER_SEC / PACING_QUANTUM_USEC);
+        return (int64_t)MAX(quantum_bytes, (uint64_t)(PACING_MIN_QUANTUM_SEGMENTS * MICROTCP_MSS));
+}
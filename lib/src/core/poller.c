@@ -0,0 +1,611 @@
+#include "core/poller.h"
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "allocator/allocator_macros.h"
+#include "core/datagram_batch.h"
+#include "core/delayed_ack.h"
+#include "core/listener.h"
+#include "core/receive_ring_buffer.h"
+#include "core/segment_io.h"
+#include "core/segment_processing.h"
+#include "core/send_ring_buffer.h"
+#include "core/stats_export.h"
+#include "core/timer_wheel.h"
+#include "fsm/microtcp_fsm.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+#include "status.h"
+
+#define EPOLL_EVENTS_CAPACITY 64
+#define EPOLL_FAILURE (-1)
+#define EPOLL_INFINITE_TIMEOUT (-1)
+#define NO_DEADLINE (-1)
+#define NO_TIMER (-1)
+#define USEC_PER_MSEC 1000
+#define NO_ROUTED_FD (-1)
+#define ALWAYS_REPORTED_EVENTS (MICROTCP_POLLERR | MICROTCP_POLLHUP)
+
+typedef struct poller_registration registration_t;
+
+/**
+ * A UDP descriptor in the epoll instance; Registrations of listener's connections share it. Listener's routing eventfd
+ * (see listener_routed_fd()) is watched along, as other threads' pumping may route datagrams past our epoll wait.
+ */
+typedef struct watched_descriptor
+{
+        int sd;
+        int routed_fd;                  /* NO_ROUTED_FD for plain sockets. */
+        registration_t *registrations;  /* Queued together, whenever descriptor (or its routed_fd) turns readable. */
+        _Bool readable;                 /* Reported by the latest epoll_wait(). */
+        struct watched_descriptor *next;
+} watched_descriptor_t;
+
+struct poller_registration
+{
+        microtcp_sock_t *socket;
+        uint32_t events;
+        void *user_data;
+        microtcp_poller_t *poller;
+        watched_descriptor_t *descriptor;
+        wheel_timer_t retransmission_timer; /* At buffered send's retransmission (or window probe) deadline. */
+        wheel_timer_t pacing_timer;
+        wheel_timer_t delayed_ack_timer;
+        _Bool timer_expired; /* Connection is driven on the next pass. */
+        _Bool broken;        /* Driving the connection failed, with its state left ESTABLISHED (e.g. stalled peer). */
+        _Bool queued;        /* In poller's ready list. */
+        registration_t *next_sharing; /* Next registration of the same descriptor. */
+        registration_t *next_ready;
+};
+
+struct poller
+{
+        int epoll_fd;
+        registration_t *ready_head; /* Only registrations in the ready list are visited by a pass. */
+        registration_t *ready_tail;
+        watched_descriptor_t *descriptors;
+        timer_wheel_t *timers; /* Registrations' timers. */
+        struct epoll_event epoll_events[EPOLL_EVENTS_CAPACITY];
+};
+
+static watched_descriptor_t *watch_descriptor(microtcp_poller_t *_poller, const microtcp_sock_t *_socket);
+static void unwatch_descriptor(microtcp_poller_t *_poller, watched_descriptor_t *_descriptor);
+static void queue_registration(microtcp_poller_t *_poller, registration_t *_registration);
+static void unqueue_registration(microtcp_poller_t *_poller, registration_t *_registration);
+static void queue_readable_descriptor(microtcp_poller_t *_poller, watched_descriptor_t *_descriptor);
+static size_t collect_ready_sockets(microtcp_poller_t *_poller, microtcp_poll_event_t *_events, size_t _max_events);
+static uint32_t get_ready_events(registration_t *_registration);
+static void expire_timers(microtcp_poller_t *_poller, time_t _now_usec);
+static void arm_timers(microtcp_poller_t *_poller, registration_t *_registration, time_t _now_usec);
+static void cancel_timers(microtcp_poller_t *_poller, registration_t *_registration);
+static time_t get_next_timer_usec(const microtcp_poller_t *_poller, time_t _now_usec);
+static int usec_to_timeout_msec(time_t _usec);
+
+microtcp_poller_t *poller_create(void)
+{
+        microtcp_poller_t *poller = CALLOC_LOG(poller, sizeof(microtcp_poller_t));
+        if (poller == NULL)
+                return NULL;
+        poller->timers = tw_create();
+        if (poller->timers == NULL)
+        {
+                FREE_NULLIFY_LOG(poller);
+                return NULL;
+        }
+        poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (poller->epoll_fd == EPOLL_FAILURE)
+        {
+                LOG_ERROR("Poller creation failed; epoll_create1() set errno(%d):%s.", errno, strerror(errno));
+                tw_destroy(&poller->timers);
+                FREE_NULLIFY_LOG(poller);
+                return NULL;
+        }
+        return poller;
+}
+
+/* We request a double pointer, in order to NULLIFY user's poller pointer. Registered sockets are left as they are. */
+status_t poller_destroy(microtcp_poller_t **const _poller_address)
+{
+        SMART_ASSERT(_poller_address != NULL);
+
+#define POLLER (*_poller_address)
+        if (POLLER == NULL)
+                return SUCCESS;
+        tw_destroy(&POLLER->timers); /* Disarms registrations' timers first. */
+        while (POLLER->descriptors != NULL)
+        {
+                watched_descriptor_t *descriptor = POLLER->descriptors;
+                POLLER->descriptors = descriptor->next;
+                while (descriptor->registrations != NULL)
+                {
+                        registration_t *registration = descriptor->registrations;
+                        descriptor->registrations = registration->next_sharing;
+                        registration->socket->poller_registration = NULL;
+                        FREE_NULLIFY_LOG(registration);
+                }
+                FREE_NULLIFY_LOG(descriptor);
+        }
+        close(POLLER->epoll_fd);
+        FREE_NULLIFY_LOG(POLLER);
+        return SUCCESS;
+#undef POLLER
+}
+
+status_t poller_add(microtcp_poller_t *const _poller, microtcp_sock_t *const _socket, const uint32_t _events, void *const _user_data)
+{
+        DEBUG_SMART_ASSERT(_poller != NULL, _socket != NULL);
+        if (_socket->poller_registration != NULL)
+                LOG_ERROR_RETURN(FAILURE, "Socket is already registered in a poller.");
+        if (_socket->engine_thread)
+                LOG_ERROR_RETURN(FAILURE, "Engine thread sockets are driven by their own thread; Poller can't drive them.");
+        watched_descriptor_t *const descriptor = watch_descriptor(_poller, _socket);
+        if (descriptor == NULL)
+                return FAILURE;
+        registration_t *registration = CALLOC_LOG(registration, sizeof(registration_t));
+        if (registration == NULL)
+        {
+                unwatch_descriptor(_poller, descriptor);
+                return FAILURE;
+        }
+        registration->socket = _socket;
+        registration->events = _events;
+        registration->user_data = _user_data;
+        registration->poller = _poller;
+        registration->descriptor = descriptor;
+        tw_timer_init(&registration->retransmission_timer, registration);
+        tw_timer_init(&registration->pacing_timer, registration);
+        tw_timer_init(&registration->delayed_ack_timer, registration);
+        registration->next_sharing = descriptor->registrations;
+        descriptor->registrations = registration;
+        _socket->poller_registration = registration;
+        queue_registration(_poller, registration); /* It may be ready already. */
+        return SUCCESS;
+}
+
+status_t poller_remove(microtcp_poller_t *const _poller, microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_poller != NULL, _socket != NULL);
+        registration_t *registration = _socket->poller_registration;
+        if (registration == NULL || registration->poller != _poller)
+                LOG_ERROR_RETURN(FAILURE, "Socket is not registered in the poller.");
+        registration_t **link = &registration->descriptor->registrations;
+        while (*link != registration)
+                link = &(*link)->next_sharing;
+        *link = registration->next_sharing;
+        unqueue_registration(_poller, registration);
+        cancel_timers(_poller, registration);
+        unwatch_descriptor(_poller, registration->descriptor);
+        _socket->poller_registration = NULL;
+        FREE_NULLIFY_LOG(registration);
+        return SUCCESS;
+}
+
+void poller_touch(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->poller_registration != NULL);
+        registration_t *const registration = _socket->poller_registration;
+        queue_registration(registration->poller, registration);
+}
+
+int poller_wait(microtcp_poller_t *const _poller, microtcp_poll_event_t *const _events, const size_t _max_events, const int _timeout_msec)
+{
+        DEBUG_SMART_ASSERT(_poller != NULL, _events != NULL, _max_events > 0);
+        const time_t deadline_usec = _timeout_msec < 0 ? NO_DEADLINE : get_monotonic_time_usec() + (time_t)_timeout_msec * USEC_PER_MSEC;
+        int wait_msec = 0; /* Sockets may be ready already; Descriptors are only polled at first. */
+        while (true)
+        {
+                const int ready_descriptors = epoll_wait(_poller->epoll_fd, _poller->epoll_events, EPOLL_EVENTS_CAPACITY, wait_msec);
+                if (RARE_CASE(ready_descriptors == EPOLL_FAILURE && errno != EINTR))
+                        LOG_ERROR_RETURN(MICROTCP_POLL_FAILURE, "Poller's wait failed; epoll_wait() set errno(%d):%s.", errno, strerror(errno));
+                for (int i = 0; i < ready_descriptors; i++)
+                        queue_readable_descriptor(_poller, _poller->epoll_events[i].data.ptr);
+
+                const size_t ready_sockets = collect_ready_sockets(_poller, _events, MIN(_max_events, (size_t)INT_MAX));
+                for (int i = 0; i < ready_descriptors; i++) /* Level-triggered; Undrained ones are reported again. */
+                        ((watched_descriptor_t *)_poller->epoll_events[i].data.ptr)->readable = false;
+                if (ready_sockets > 0)
+                        return (int)ready_sockets;
+
+                const time_t now_usec = get_monotonic_time_usec();
+                if (deadline_usec != NO_DEADLINE && now_usec >= deadline_usec)
+                        return MICROTCP_POLL_TIMEOUT;
+                time_t wait_usec = get_next_timer_usec(_poller, now_usec);
+                if (deadline_usec != NO_DEADLINE)
+                        wait_usec = wait_usec == NO_TIMER ? deadline_usec - now_usec : MIN(wait_usec, deadline_usec - now_usec);
+                wait_msec = wait_usec == NO_TIMER ? EPOLL_INFINITE_TIMEOUT : usec_to_timeout_msec(wait_usec);
+        }
+}
+
+int poller_fd(const microtcp_poller_t *const _poller)
+{
+        DEBUG_SMART_ASSERT(_poller != NULL);
+        return _poller->epoll_fd;
+}
+
+int poller_timeout_msec(const microtcp_poller_t *const _poller)
+{
+        DEBUG_SMART_ASSERT(_poller != NULL);
+        if (_poller->ready_head != NULL) /* Maybe ready; microtcp_poll() tells. */
+                return 0;
+        const time_t next_timer_usec = get_next_timer_usec(_poller, get_monotonic_time_usec());
+        return next_timer_usec == NO_TIMER ? EPOLL_INFINITE_TIMEOUT : usec_to_timeout_msec(next_timer_usec);
+}
+
+/* ------------------------------------------ DRIVING CONNECTIONS ------------------------------------------ */
+/* Peer closed; Data left in RRB goes to microtcp_recv() first, as when FIN|ACK follows data within a single call. */
+static status_t handle_finack_reception(microtcp_sock_t *const _socket)
+{
+        if (delayed_ack_flush(_socket) == FAILURE)
+                return FAILURE;
+        _socket->ack_number += FIN_SEQ_NUMBER_INCREMENT;
+        if (rrb_consumable_bytes(_socket->bytestream_rrb) > 0)
+                _socket->data_reception_with_finack = true;
+        else
+                _socket->state = CLOSING_BY_PEER;
+        return SUCCESS;
+}
+
+/* Segments RRB rejects are ACKed too (at once); A retransmitted one means peer missed our last ACK. */
+static status_t store_received_data(microtcp_sock_t *const _socket)
+{
+        receive_ring_buffer_t *const bytestream_rrb = _socket->bytestream_rrb;
+        const uint32_t previous_ack_number = _socket->ack_number;
+        if (COMMON_CASE(rrb_append(bytestream_rrb, _socket->segment_receive_buffer) > 0))
+        {
+                _socket->ack_number = rrb_last_consumed_seq_number(bytestream_rrb) + rrb_consumable_bytes(bytestream_rrb) + 1;
+                _socket->curr_win_size = rrb_size(bytestream_rrb) - rrb_consumable_bytes(bytestream_rrb);
+        }
+        return delayed_ack_on_data(_socket, previous_ack_number);
+}
+
+/**
+ * @brief Handles every segment already waiting for the socket; Same handling as microtcp_recv() (and protocol engine's).
+ * @returns FAILURE if the connection broke (socket's state tells how).
+ */
+static status_t receive_pending_segments(microtcp_sock_t *const _socket)
+{
+        while (_socket->state == ESTABLISHED && !_socket->data_reception_with_finack)
+        {
+                switch (receive_data_segment(_socket, false))
+                {
+                case RECV_SEGMENT_TIMEOUT:
+                        return SUCCESS; /* Socket drained. */
+                case RECV_SEGMENT_ERROR:
+                        break; /* Faulty segment, ignore it. */
+                case RECV_SEGMENT_FATAL_ERROR:
+                        LOG_ERROR_RETURN(FAILURE, "Poller failed receiving segments.");
+                case RECV_SEGMENT_FINACK_UNEXPECTED:
+                        if (_socket->segment_receive_buffer->header.seq_number == _socket->ack_number)
+                                return handle_finack_reception(_socket);
+                        LOG_WARNING("Protocol lost sychronization, received FIN|ACK, with mismatched `seq_number`; Could also be out-of-order (ignored)");
+                        break;
+                case RECV_SEGMENT_RST_RECEIVED:
+                        _socket->state = RESET;
+                        LOG_ERROR_RETURN(FAILURE, "Peer sent an RST. Socket enters %s state", get_microtcp_state_to_string(_socket->state));
+                case RECV_SEGMENT_ACK_RECEIVED:
+                        if (_socket->send_ring != NULL && microtcp_send_fsm_process_ack(_socket) == FAILURE)
+                                return FAILURE;
+                        break;
+                case RECV_SEGMENT_WINACK_RECEIVED:
+                        if (send_ack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address)) == SEND_SEGMENT_FATAL_ERROR)
+                                return FAILURE;
+                        break;
+                default:
+                        if (store_received_data(_socket) == FAILURE)
+                                return FAILURE;
+                        break;
+                }
+        }
+        return SUCCESS;
+}
+
+static __always_inline _Bool is_driven(const registration_t *const _registration)
+{
+        const microtcp_sock_t *const socket = _registration->socket;
+        return socket->state == ESTABLISHED && !socket->data_reception_with_finack && socket->engine == NULL && !_registration->broken;
+}
+
+static __always_inline _Bool has_pending_segments(registration_t *const _registration)
+{
+        microtcp_sock_t *const socket = _registration->socket;
+        return _registration->descriptor->readable ||
+               (socket->receive_batch != NULL && db_pending_slots(socket->receive_batch) > 0) ||
+               (socket->listener != NULL && listener_is_readable(socket));
+}
+
+static __always_inline _Bool has_bytes_to_send(const microtcp_sock_t *const _socket)
+{
+        return _socket->send_ring != NULL && srb_stored_bytes(_socket->send_ring) > 0;
+}
+
+/* Connection broke while driven; Like microtcp_recv(), data that arrived before peer's FIN|ACK is still handed out. */
+static void handle_drive_failure(registration_t *const _registration)
+{
+        microtcp_sock_t *const socket = _registration->socket;
+        if (socket->state == CLOSING_BY_PEER && rrb_consumable_bytes(socket->bytestream_rrb) > 0)
+        {
+                socket->state = ESTABLISHED;
+                socket->data_reception_with_finack = true;
+        }
+        else if (socket->state == ESTABLISHED)
+        {
+                _registration->broken = true;
+        }
+}
+
+/* epoll_wait() is no finer than a millisecond; Shorter ACK delays end once the connection is drained. */
+static __always_inline status_t expire_delayed_ack(microtcp_sock_t *const _socket)
+{
+        if (delayed_ack_delay_usec(_socket) < USEC_PER_MSEC)
+                return delayed_ack_flush(_socket);
+        return SUCCESS;
+}
+
+/* Connections are driven once segments wait for them, or one of their timers expired. */
+static void drive_connection(registration_t *const _registration)
+{
+        const _Bool timer_expired = _registration->timer_expired;
+        _registration->timer_expired = false;
+        if (!is_driven(_registration))
+                return;
+        microtcp_sock_t *const socket = _registration->socket;
+        status_t drive_ret_val = SUCCESS;
+        if (has_pending_segments(_registration))
+                drive_ret_val = receive_pending_segments(socket);
+        else if (!timer_expired)
+                return;
+        if (drive_ret_val == SUCCESS && is_driven(_registration) && timer_expired && has_bytes_to_send(socket))
+                drive_ret_val = microtcp_send_fsm_progress(socket, false);
+        if (drive_ret_val == SUCCESS && is_driven(_registration))
+                drive_ret_val = expire_delayed_ack(socket);
+        if (drive_ret_val == FAILURE)
+                handle_drive_failure(_registration);
+}
+
+/* Listening sockets don't receive on their own; Their descriptor is pumped here, so SYNs (and connections' datagrams) get routed. */
+static void route_listener_datagrams(registration_t *const _registration)
+{
+        microtcp_sock_t *const socket = _registration->socket;
+        if (socket->state != LISTEN || socket->listener == NULL || !_registration->descriptor->readable || _registration->broken)
+                return;
+        if (listener_route(socket->listener) == FAILURE)
+                _registration->broken = true;
+}
+
+/* ------------------------------------------ READINESS ------------------------------------------ */
+static uint32_t get_ready_events(registration_t *const _registration)
+{
+        microtcp_sock_t *const socket = _registration->socket;
+        uint32_t events = _registration->broken ? MICROTCP_POLLERR : 0;
+        switch (socket->state)
+        {
+        case ESTABLISHED:
+                if (socket->data_reception_with_finack)
+                        events |= MICROTCP_POLLIN | MICROTCP_POLLHUP;
+                else if (rrb_consumable_bytes(socket->bytestream_rrb) > 0)
+                        events |= MICROTCP_POLLIN;
+                if (socket->send_ring == NULL || srb_free_space(socket->send_ring) > 0)
+                        events |= MICROTCP_POLLOUT;
+                break;
+        case CLOSING_BY_PEER:
+                events |= MICROTCP_POLLHUP;
+                break;
+        case LISTEN: /* Listener's descriptor is shared; Its readability may be any connection's datagrams. */
+                if (socket->listener != NULL ? listener_is_readable(socket) : _registration->descriptor->readable)
+                        events |= MICROTCP_POLLIN;
+                break;
+        case RESET:
+        case INVALID:
+                events |= MICROTCP_POLLERR;
+                break;
+        default:
+                break;
+        }
+        return events & (_registration->events | ALWAYS_REPORTED_EVENTS);
+}
+
+/**
+ * Visits the ready list only: Registrations of readable descriptors, with expired timers, or that application acted on.
+ * Ready ones stay queued (level-triggered); Those past `_max_events` ahead of reported ones, so they are not starved.
+ */
+static size_t collect_ready_sockets(microtcp_poller_t *const _poller, microtcp_poll_event_t *const _events, const size_t _max_events)
+{
+        const time_t now_usec = get_monotonic_time_usec();
+        expire_timers(_poller, now_usec);
+        registration_t *registration = _poller->ready_head;
+        _poller->ready_head = _poller->ready_tail = NULL;
+        registration_t *reported_head = NULL, *reported_tail = NULL;
+        size_t ready_sockets = 0;
+        while (registration != NULL)
+        {
+                registration_t *const next = registration->next_ready;
+                registration->next_ready = NULL;
+                registration->queued = false;
+                route_listener_datagrams(registration);
+                drive_connection(registration); /* Whether or not it gets an event slot; Timers don't wait for one. */
+                arm_timers(_poller, registration, now_usec); /* Application's calls since the last pass may have started some. */
+                stats_export_publish_if_due(registration->socket, now_usec);
+                const uint32_t ready_events = get_ready_events(registration);
+                if (ready_events != 0 && ready_sockets < _max_events)
+                {
+                        _events[ready_sockets++] = (microtcp_poll_event_t){.socket = registration->socket,
+                                                                           .events = ready_events,
+                                                                           .user_data = registration->user_data};
+                        if (reported_tail != NULL)
+                                reported_tail->next_ready = registration;
+                        else
+                                reported_head = registration;
+                        reported_tail = registration;
+                }
+                else if (ready_events != 0)
+                {
+                        queue_registration(_poller, registration);
+                }
+                registration = next;
+        }
+        while (reported_head != NULL)
+        {
+                registration_t *const reported = reported_head;
+                reported_head = reported->next_ready;
+                reported->next_ready = NULL;
+                queue_registration(_poller, reported);
+        }
+        return ready_sockets;
+}
+
+/* ------------------------------------------ TIMERS ------------------------------------------ */
+static void expire_timers(microtcp_poller_t *const _poller, const time_t _now_usec)
+{
+        wheel_timer_t *timer;
+        while ((timer = tw_pop_expired(_poller->timers, _now_usec)) != NULL)
+        {
+                registration_t *const registration = timer->owner;
+                registration->timer_expired = true;
+                queue_registration(_poller, registration);
+        }
+}
+
+/* Armed timers keep their expiry; Those that expired (or expire early) are armed again once their connection is driven. */
+static __always_inline void arm_timer(microtcp_poller_t *const _poller, wheel_timer_t *const _timer, const time_t _delay_usec, const time_t _now_usec)
+{
+        if (_delay_usec < 0)
+                tw_cancel(_poller->timers, _timer);
+        else if (!tw_is_armed(_timer))
+                tw_arm(_poller->timers, _timer, _now_usec + _delay_usec);
+}
+
+static void arm_timers(microtcp_poller_t *const _poller, registration_t *const _registration, const time_t _now_usec)
+{
+        microtcp_sock_t *const socket = _registration->socket;
+        if (!is_driven(_registration))
+        {
+                cancel_timers(_poller, _registration);
+                return;
+        }
+        arm_timer(_poller, &_registration->delayed_ack_timer, delayed_ack_delay_usec(socket), _now_usec);
+        if (!has_bytes_to_send(socket))
+        {
+                tw_cancel(_poller->timers, &_registration->retransmission_timer);
+                tw_cancel(_poller->timers, &_registration->pacing_timer);
+                return;
+        }
+        /* Deadline moves with each transmission and ACK; Re-armed (in O(1)) on every visit, so it never fires early. */
+        const time_t retransmission_delay_usec = microtcp_send_fsm_retransmission_delay_usec(socket);
+        if (retransmission_delay_usec < 0)
+                tw_cancel(_poller->timers, &_registration->retransmission_timer);
+        else
+                tw_arm(_poller->timers, &_registration->retransmission_timer, _now_usec + retransmission_delay_usec);
+        arm_timer(_poller, &_registration->pacing_timer, microtcp_send_fsm_pacing_delay_usec(socket), _now_usec);
+}
+
+static void cancel_timers(microtcp_poller_t *const _poller, registration_t *const _registration)
+{
+        tw_cancel(_poller->timers, &_registration->retransmission_timer);
+        tw_cancel(_poller->timers, &_registration->pacing_timer);
+        tw_cancel(_poller->timers, &_registration->delayed_ack_timer);
+}
+
+/* @returns μsec until registrations' earliest timer (delayed ACK, pacing, retransmission check) expires; NO_TIMER if none is armed. */
+static time_t get_next_timer_usec(const microtcp_poller_t *const _poller, const time_t _now_usec)
+{
+        const time_t next_expiry_usec = tw_next_expiry_usec(_poller->timers);
+        return next_expiry_usec == TIMER_WHEEL_NO_EXPIRY ? NO_TIMER : MAX(next_expiry_usec - _now_usec, 0);
+}
+
+/* epoll_wait() is no finer than a millisecond; Rounded up, so timers are due once it returns. */
+static int usec_to_timeout_msec(const time_t _usec)
+{
+        return (int)MIN((_usec + USEC_PER_MSEC - 1) / USEC_PER_MSEC, (time_t)INT_MAX);
+}
+
+/* ------------------------------------------ REGISTRATIONS ------------------------------------------ */
+static watched_descriptor_t *watch_descriptor(microtcp_poller_t *const _poller, const microtcp_sock_t *const _socket)
+{
+        for (watched_descriptor_t *descriptor = _poller->descriptors; descriptor != NULL; descriptor = descriptor->next)
+                if (descriptor->sd == _socket->sd)
+                        return descriptor;
+        watched_descriptor_t *descriptor = CALLOC_LOG(descriptor, sizeof(watched_descriptor_t));
+        if (descriptor == NULL)
+                return NULL;
+        descriptor->sd = _socket->sd;
+        descriptor->routed_fd = _socket->listener != NULL ? listener_routed_fd(_socket->listener) : NO_ROUTED_FD;
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = descriptor};
+        if (epoll_ctl(_poller->epoll_fd, EPOLL_CTL_ADD, descriptor->sd, &event) == EPOLL_FAILURE)
+        {
+                LOG_ERROR("Poller failed watching descriptor %d; epoll_ctl() set errno(%d):%s.", descriptor->sd, errno, strerror(errno));
+                FREE_NULLIFY_LOG(descriptor);
+                return NULL;
+        }
+        if (descriptor->routed_fd != NO_ROUTED_FD && epoll_ctl(_poller->epoll_fd, EPOLL_CTL_ADD, descriptor->routed_fd, &event) == EPOLL_FAILURE)
+        {
+                LOG_ERROR("Poller failed watching listener's routing; epoll_ctl() set errno(%d):%s.", errno, strerror(errno));
+                epoll_ctl(_poller->epoll_fd, EPOLL_CTL_DEL, descriptor->sd, NULL);
+                FREE_NULLIFY_LOG(descriptor);
+                return NULL;
+        }
+        descriptor->next = _poller->descriptors;
+        _poller->descriptors = descriptor;
+        return descriptor;
+}
+
+/* Called once the registration is off descriptor's list; The last one takes the descriptor along. */
+static void unwatch_descriptor(microtcp_poller_t *const _poller, watched_descriptor_t *_descriptor)
+{
+        if (_descriptor->registrations != NULL)
+                return;
+        epoll_ctl(_poller->epoll_fd, EPOLL_CTL_DEL, _descriptor->sd, NULL); /* Fails harmlessly, if descriptor got closed already. */
+        if (_descriptor->routed_fd != NO_ROUTED_FD)
+                epoll_ctl(_poller->epoll_fd, EPOLL_CTL_DEL, _descriptor->routed_fd, NULL);
+        watched_descriptor_t **link = &_poller->descriptors;
+        while (*link != _descriptor)
+                link = &(*link)->next;
+        *link = _descriptor->next;
+        FREE_NULLIFY_LOG(_descriptor);
+}
+
+static void queue_registration(microtcp_poller_t *const _poller, registration_t *const _registration)
+{
+        if (_registration->queued)
+                return;
+        _registration->queued = true;
+        _registration->next_ready = NULL;
+        if (_poller->ready_tail != NULL)
+                _poller->ready_tail->next_ready = _registration;
+        else
+                _poller->ready_head = _registration;
+        _poller->ready_tail = _registration;
+}
+
+static void unqueue_registration(microtcp_poller_t *const _poller, registration_t *const _registration)
+{
+        if (!_registration->queued)
+                return;
+        registration_t *previous = NULL;
+        for (registration_t *queued = _poller->ready_head; queued != _registration; queued = queued->next_ready)
+                previous = queued;
+        if (previous != NULL)
+                previous->next_ready = _registration->next_ready;
+        else
+                _poller->ready_head = _registration->next_ready;
+        if (_poller->ready_tail == _registration)
+                _poller->ready_tail = previous;
+        _registration->queued = false;
+        _registration->next_ready = NULL;
+}
+
+/* Any of descriptor's registrations may have gotten datagrams; A routing eventfd is drained along. */
+static void queue_readable_descriptor(microtcp_poller_t *const _poller, watched_descriptor_t *const _descriptor)
+{
+        _descriptor->readable = true;
+        uint64_t routings;
+        if (_descriptor->routed_fd != NO_ROUTED_FD && read(_descriptor->routed_fd, &routings, sizeof(routings)) == -1 && errno != EAGAIN)
+                LOG_WARNING("Poller failed draining listener's routing eventfd; errno(%d):%s.", errno, strerror(errno));
+        for (registration_t *registration = _descriptor->registrations; registration != NULL; registration = registration->next_sharing)
+                queue_registration(_poller, registration);
+}
@@ -0,0 +1,423 @@
+#include "core/protocol_engine.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "allocator/allocator_macros.h"
+#include "core/datagram_batch.h"
+#include "core/delayed_ack.h"
+#include "core/receive_ring_buffer.h"
+#include "core/segment_io.h"
+#include "core/segment_processing.h"
+#include "core/send_queue.h"
+#include "core/send_ring_buffer.h"
+#include "core/socket_stats_updater.h"
+#include "core/stats_export.h"
+#include "fsm/microtcp_fsm.h"
+#include "microtcp_defines.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "settings/microtcp_settings.h"
+#include "smart_assert.h"
+#include "status.h"
+
+/* While segments are in flight, retransmission timers are checked a few times per RTO. */
+#define TIMER_CHECKS_PER_RTO 4
+#define POLL_INFINITE_TIMEOUT (-1)
+#define POLL_TIMEOUT 0
+#define EVENTFD_FAILURE (-1)
+#define USEC_PER_MSEC 1000
+
+/* `protocol_engine_t` is defined in equivilant header_file. */
+struct protocol_engine
+{
+        microtcp_sock_t *socket;
+        send_ring_buffer_t *delivery_ring; /* Reassembled bytes, waiting for microtcp_recv(). */
+        pthread_t thread;
+        pthread_mutex_t socket_lock; /* Held by engine while it works on socket; Readers of a snapshot take it. */
+        _Bool thread_started;    /* Only accessed by application's thread. */
+        int engine_eventfd;      /* Application -> engine: bytes queued, delivery space freed, or stop requested. */
+        int application_eventfd; /* Engine -> application: bytes delivered, send space freed, or engine exited. */
+        _Atomic _Bool running;   /* Cleared by engine, when the connection breaks (socket's state tells how). */
+        _Atomic _Bool stop_requested;
+        _Atomic _Bool engine_waiting; /* Each side is woken up, only after it announced it is (about to start) waiting. */
+        _Atomic _Bool application_waiting;
+};
+
+static void *run_protocol_engine(void *_pe);
+
+static void notify(const int _eventfd)
+{
+        const uint64_t event = 1;
+        if (write(_eventfd, &event, sizeof(event)) == -1)
+                LOG_WARNING("Protocol engine's wakeup failed; write() on eventfd set errno(%d):%s.", errno, strerror(errno));
+}
+
+/* Publisher's side of the wakeup handshake: Whatever was published (ring indices) is ordered before reading waiter's flag. */
+static __always_inline void wake_if_waiting(_Atomic _Bool *const _waiting, const int _eventfd)
+{
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(_waiting, memory_order_relaxed))
+                notify(_eventfd);
+}
+
+/* Waiter's side: Flag is raised before the waiter re-checks its condition; Publisher either sees the flag, or waiter sees its update. */
+static __always_inline void announce_waiting(_Atomic _Bool *const _waiting)
+{
+        atomic_store_explicit(_waiting, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+}
+
+/**
+ * @brief `_fds[0]` is waiter's own eventfd, which gets drained.
+ * @returns poll()'s return value; POLL_TIMEOUT if nothing happened.
+ */
+static int wait_for_events(struct pollfd *const _fds, const nfds_t _fds_count, const int _timeout_msec, _Atomic _Bool *const _waiting)
+{
+        const int poll_ret_val = poll(_fds, _fds_count, _timeout_msec);
+        atomic_store_explicit(_waiting, false, memory_order_relaxed);
+        uint64_t events;
+        if (poll_ret_val > 0 && (_fds[0].revents & POLLIN) && read(_fds[0].fd, &events, sizeof(events)) == -1 && errno != EAGAIN)
+                LOG_WARNING("Draining protocol engine's eventfd failed; read() set errno(%d):%s.", errno, strerror(errno));
+        return poll_ret_val;
+}
+
+static __always_inline _Bool is_engine_running(protocol_engine_t *const _pe)
+{
+        return atomic_load_explicit(&_pe->running, memory_order_acquire);
+}
+
+static __always_inline int get_ack_timeout_msec(void)
+{
+        return (int)(timeval_to_usec(get_microtcp_ack_timeout()) / USEC_PER_MSEC);
+}
+
+protocol_engine_t *pe_create(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL, _socket->send_ring != NULL, _socket->bytestream_rrb != NULL);
+        protocol_engine_t *pe = CALLOC_LOG(pe, sizeof(protocol_engine_t));
+        if (pe == NULL)
+                return NULL;
+
+        pe->socket = _socket;
+        pthread_mutex_init(&pe->socket_lock, NULL);
+        pe->engine_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        pe->application_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        pe->delivery_ring = srb_create(rrb_size(_socket->bytestream_rrb));
+        atomic_init(&pe->running, false);
+        atomic_init(&pe->stop_requested, false);
+        atomic_init(&pe->engine_waiting, false);
+        atomic_init(&pe->application_waiting, false);
+        if (pe->engine_eventfd == EVENTFD_FAILURE || pe->application_eventfd == EVENTFD_FAILURE || pe->delivery_ring == NULL)
+        {
+                LOG_ERROR("Failed to create protocol engine; errno(%d):%s.", errno, strerror(errno));
+                pe_destroy(&pe);
+                return NULL;
+        }
+        return pe;
+}
+
+/* We request a double pointer, in order to NULLIFY user's engine pointer. */
+status_t pe_destroy(protocol_engine_t **const _pe_address)
+{
+        SMART_ASSERT(_pe_address != NULL);
+
+#define PE (*_pe_address)
+        if (PE == NULL)
+                return SUCCESS;
+        pe_stop(PE);
+        if (PE->engine_eventfd != EVENTFD_FAILURE)
+                close(PE->engine_eventfd);
+        if (PE->application_eventfd != EVENTFD_FAILURE)
+                close(PE->application_eventfd);
+        srb_destroy(&PE->delivery_ring);
+        pthread_mutex_destroy(&PE->socket_lock);
+        FREE_NULLIFY_LOG(PE);
+        return SUCCESS;
+#undef PE
+}
+
+status_t pe_start(protocol_engine_t *const _pe)
+{
+        DEBUG_SMART_ASSERT(_pe != NULL, !_pe->thread_started);
+        atomic_store_explicit(&_pe->running, true, memory_order_relaxed);
+        atomic_store_explicit(&_pe->stop_requested, false, memory_order_relaxed);
+        const int pthread_create_ret_val = pthread_create(&_pe->thread, NULL, run_protocol_engine, _pe);
+        if (pthread_create_ret_val != 0)
+        {
+                atomic_store_explicit(&_pe->running, false, memory_order_relaxed);
+                LOG_ERROR_RETURN(FAILURE, "Starting protocol engine failed; pthread_create() returned (%d):%s.",
+                                 pthread_create_ret_val, strerror(pthread_create_ret_val));
+        }
+        _pe->thread_started = true;
+        LOG_INFO_RETURN(SUCCESS, "Protocol engine started. (sd = %d)", _pe->socket->sd);
+}
+
+void pe_stop(protocol_engine_t *const _pe)
+{
+        DEBUG_SMART_ASSERT(_pe != NULL);
+        if (!_pe->thread_started)
+                return;
+        atomic_store_explicit(&_pe->stop_requested, true, memory_order_release);
+        notify(_pe->engine_eventfd);
+        pthread_join(_pe->thread, NULL); /* Engine's last updates on socket are visible from here on. */
+        _pe->thread_started = false;
+        atomic_store_explicit(&_pe->running, false, memory_order_relaxed);
+        LOG_INFO("Protocol engine stopped; Socket state = %s.", get_microtcp_state_to_string(_pe->socket->state));
+}
+
+ssize_t pe_send(protocol_engine_t *const _pe, const void *const _buffer, const size_t _length, const int _flags)
+{
+        DEBUG_SMART_ASSERT(_pe != NULL, _buffer != NULL);
+        send_ring_buffer_t *const send_ring = _pe->socket->send_ring;
+        const _Bool block = !(_flags & MSG_DONTWAIT);
+        struct pollfd fds[] = {{.fd = _pe->application_eventfd, .events = POLLIN}};
+        size_t bytes_queued = 0;
+        while (is_engine_running(_pe))
+        {
+                const size_t bytes_pushed = srb_push(send_ring, (const uint8_t *)_buffer + bytes_queued, _length - bytes_queued);
+                if (bytes_pushed > 0)
+                        wake_if_waiting(&_pe->engine_waiting, _pe->engine_eventfd);
+                bytes_queued += bytes_pushed;
+                if (bytes_queued == _length || !block)
+                        break;
+
+                announce_waiting(&_pe->application_waiting); /* Send ring is full; Wait for ACKs to free some space. */
+                if (srb_free_space(send_ring) == 0 && is_engine_running(_pe))
+                        wait_for_events(fds, ARRAY_SIZE(fds), POLL_INFINITE_TIMEOUT, &_pe->application_waiting);
+                else
+                        atomic_store_explicit(&_pe->application_waiting, false, memory_order_relaxed);
+        }
+
+        if (bytes_queued > 0)
+        {
+                DEBUG_SMART_ASSERT(bytes_queued < SSIZE_MAX);
+                return (ssize_t)bytes_queued;
+        }
+        if (!is_engine_running(_pe))
+        {
+                pe_stop(_pe);
+                LOG_ERROR_RETURN(MICROTCP_SEND_FAILURE, "Protocol engine has stopped; Socket state = %s.", get_microtcp_state_to_string(_pe->socket->state));
+        }
+        errno = EAGAIN;
+        return MICROTCP_SEND_FAILURE;
+}
+
+/* Engine stopped; Application thread now owns socket, and collects any bytes engine left behind (in delivery ring, or RRB). */
+static ssize_t collect_bytes_after_engine_exit(protocol_engine_t *const _pe, uint8_t *const _buffer, size_t _bytes_received, const size_t _length)
+{
+        pe_stop(_pe);
+        _bytes_received += srb_pop(_pe->delivery_ring, _buffer + _bytes_received, _length - _bytes_received);
+        _bytes_received += rrb_pop(_pe->socket->bytestream_rrb, _buffer + _bytes_received, MIN(_length - _bytes_received, UINT32_MAX));
+        if (_bytes_received > 0)
+        {
+                DEBUG_SMART_ASSERT(_bytes_received < SSIZE_MAX);
+                return (ssize_t)_bytes_received;
+        }
+        if (_pe->socket->state == CLOSING_BY_PEER) /* Like microtcp_recv(): Peer's FIN|ACK is reported, once every byte is read. */
+                return MICROTCP_RECV_FAILURE;
+        LOG_ERROR_RETURN(MICROTCP_RECV_FAILURE, "Protocol engine has stopped; Socket state = %s.", get_microtcp_state_to_string(_pe->socket->state));
+}
+
+/* Timeout semantics follow microtcp_recv(): Without MSG_WAITALL, an ACK timeout period without new bytes ends the call. */
+ssize_t pe_recv(protocol_engine_t *const _pe, void *const _buffer, const size_t _length, const int _flags)
+{
+        DEBUG_SMART_ASSERT(_pe != NULL, _buffer != NULL);
+        uint8_t *const buffer = _buffer;
+        const _Bool block = !(_flags & MSG_DONTWAIT);
+        const int idle_timeout_msec = (_flags & MSG_WAITALL) ? POLL_INFINITE_TIMEOUT : get_ack_timeout_msec();
+        struct pollfd fds[] = {{.fd = _pe->application_eventfd, .events = POLLIN}};
+        size_t bytes_received = 0;
+        while (true)
+        {
+                const _Bool engine_running = is_engine_running(_pe); /* Checked before popping; Engine's last deliveries are not missed. */
+                const size_t bytes_popped = srb_pop(_pe->delivery_ring, buffer + bytes_received, _length - bytes_received);
+                if (bytes_popped > 0)
+                        wake_if_waiting(&_pe->engine_waiting, _pe->engine_eventfd); /* Delivery space freed; RRB can drain (and window reopen). */
+                bytes_received += bytes_popped;
+                if (bytes_received == _length)
+                        break;
+                if (!engine_running)
+                        return collect_bytes_after_engine_exit(_pe, buffer, bytes_received, _length);
+                if (!block)
+                        break;
+
+                announce_waiting(&_pe->application_waiting);
+                if (srb_stored_bytes(_pe->delivery_ring) > 0 || !is_engine_running(_pe))
+                {
+                        atomic_store_explicit(&_pe->application_waiting, false, memory_order_relaxed);
+                        continue;
+                }
+                if (wait_for_events(fds, ARRAY_SIZE(fds), idle_timeout_msec, &_pe->application_waiting) == POLL_TIMEOUT)
+                        break;
+        }
+        DEBUG_SMART_ASSERT(bytes_received < SSIZE_MAX);
+        return (ssize_t)bytes_received;
+}
+
+void pe_get_info(protocol_engine_t *const _pe, microtcp_info_t *const _info)
+{
+        DEBUG_SMART_ASSERT(_pe != NULL, _info != NULL);
+        pthread_mutex_lock(&_pe->socket_lock);
+        get_socket_info(_pe->socket, _info);
+        pthread_mutex_unlock(&_pe->socket_lock);
+}
+
+/* Moves reassembled bytes from RRB into delivery ring (as many as fit), and updates the window we advertise. */
+static void deliver_reassembled_bytes(protocol_engine_t *const _pe)
+{
+        receive_ring_buffer_t *const bytestream_rrb = _pe->socket->bytestream_rrb;
+        for (int span = 0; span < 2 && rrb_consumable_bytes(bytestream_rrb) > 0; span++) /* Free space wraps around (at most) once. */
+        {
+                size_t contiguous_space = 0;
+                uint8_t *const free_space = srb_reserve(_pe->delivery_ring, &contiguous_space);
+                if (contiguous_space == 0)
+                        break;
+                srb_commit(_pe->delivery_ring, rrb_pop(bytestream_rrb, free_space, MIN(contiguous_space, UINT32_MAX)));
+        }
+        _pe->socket->curr_win_size = rrb_size(bytestream_rrb) - rrb_consumable_bytes(bytestream_rrb);
+}
+
+/* Segments RRB rejects are ACKed too (at once); A retransmitted one means peer missed our last ACK (see store_peer_data() of send FSM). */
+static status_t store_received_data(protocol_engine_t *const _pe)
+{
+        microtcp_sock_t *const socket = _pe->socket;
+        receive_ring_buffer_t *const bytestream_rrb = socket->bytestream_rrb;
+        const uint32_t previous_ack_number = socket->ack_number;
+        if (COMMON_CASE(rrb_append(bytestream_rrb, socket->segment_receive_buffer) > 0))
+        {
+                socket->ack_number = rrb_last_consumed_seq_number(bytestream_rrb) + rrb_consumable_bytes(bytestream_rrb) + 1;
+                deliver_reassembled_bytes(_pe);
+        }
+        return delayed_ack_on_data(socket, previous_ack_number);
+}
+
+/* Engine's poll() is no finer than a millisecond; Shorter ACK delays end once the socket is drained. */
+static __always_inline status_t expire_delayed_ack(microtcp_sock_t *const _socket)
+{
+        if (delayed_ack_delay_usec(_socket) < USEC_PER_MSEC)
+                return delayed_ack_flush(_socket);
+        return SUCCESS;
+}
+
+/**
+ * @brief Handles every segment already waiting in the UDP socket; Same handling as microtcp_recv().
+ * @returns FAILURE if the connection broke (socket's state tells how).
+ */
+static status_t receive_pending_segments(protocol_engine_t *const _pe)
+{
+        microtcp_sock_t *const socket = _pe->socket;
+        while (true)
+        {
+                switch (receive_data_segment(socket, false))
+                {
+                case RECV_SEGMENT_TIMEOUT:
+                        return expire_delayed_ack(socket); /* Socket drained. */
+                case RECV_SEGMENT_ERROR:
+                        break; /* Faulty segment, ignore it. */
+                case RECV_SEGMENT_FATAL_ERROR:
+                        LOG_ERROR_RETURN(FAILURE, "Protocol engine failed receiving segments.");
+                case RECV_SEGMENT_FINACK_UNEXPECTED:
+                        if (socket->segment_receive_buffer->header.seq_number == socket->ack_number)
+                        {
+                                if (delayed_ack_flush(socket) == FAILURE)
+                                        return FAILURE;
+                                socket->ack_number += FIN_SEQ_NUMBER_INCREMENT;
+                                socket->state = CLOSING_BY_PEER;
+                                return FAILURE;
+                        }
+                        LOG_WARNING("Protocol lost sychronization, received FIN|ACK, with mismatched `seq_number`; Could also be out-of-order (ignored)");
+                        break;
+                case RECV_SEGMENT_RST_RECEIVED:
+                        socket->state = RESET;
+                        LOG_ERROR_RETURN(FAILURE, "Peer sent an RST. Socket enters %s state", get_microtcp_state_to_string(socket->state));
+                case RECV_SEGMENT_ACK_RECEIVED:
+                        if (microtcp_send_fsm_process_ack(socket) == FAILURE)
+                                return FAILURE;
+                        break;
+                case RECV_SEGMENT_WINACK_RECEIVED:
+                        if (send_ack_control_segment(socket, socket->peer_address, sizeof(*socket->peer_address)) == SEND_SEGMENT_FATAL_ERROR)
+                                return FAILURE;
+                        break;
+                default:
+                        if (store_received_data(_pe) == FAILURE)
+                                return FAILURE;
+                        break;
+                }
+        }
+}
+
+/**
+ * @brief Work that poll() would not report: A new send round, delivery space for bytes stuck in RRB (both handed over by
+ * application), datagrams send FSM left in `receive_batch` (drained from the socket along with the ACKs it was after),
+ * round's bytes that pacing lets out by now, or a delayed ACK that is due.
+ */
+static __always_inline _Bool has_pending_work(protocol_engine_t *const _pe)
+{
+        const microtcp_sock_t *const socket = _pe->socket;
+        return db_pending_slots(socket->receive_batch) > 0 ||
+               (sq_is_empty(socket->send_queue) && srb_stored_bytes(socket->send_ring) > 0) ||
+               microtcp_send_fsm_pacing_delay_usec(socket) == 0 ||
+               delayed_ack_delay_usec(socket) == 0 ||
+               (rrb_consumable_bytes(socket->bytestream_rrb) > 0 && srb_free_space(_pe->delivery_ring) > 0);
+}
+
+/* poll() rounds `_delay_usec` up to the millisecond; Negative delays (nothing is due) leave timeout as is. */
+static __always_inline int shorten_timeout(const int _timeout_msec, const time_t _delay_usec)
+{
+        if (_delay_usec <= 0)
+                return _timeout_msec;
+        const int delay_msec = (int)((_delay_usec + USEC_PER_MSEC - 1) / USEC_PER_MSEC);
+        return _timeout_msec == POLL_INFINITE_TIMEOUT ? delay_msec : MIN(_timeout_msec, delay_msec);
+}
+
+static void wait_for_engine_events(protocol_engine_t *const _pe)
+{
+        microtcp_sock_t *const socket = _pe->socket;
+        announce_waiting(&_pe->engine_waiting);
+        if (has_pending_work(_pe) || atomic_load_explicit(&_pe->stop_requested, memory_order_acquire))
+        {
+                atomic_store_explicit(&_pe->engine_waiting, false, memory_order_relaxed);
+                return;
+        }
+        struct pollfd fds[] = {{.fd = _pe->engine_eventfd, .events = POLLIN},
+                               {.fd = socket->sd, .events = POLLIN}};
+        int timeout_msec = sq_is_empty(socket->send_queue) ? POLL_INFINITE_TIMEOUT
+                                                           : MAX((int)(socket->rto_usec / USEC_PER_MSEC) / TIMER_CHECKS_PER_RTO, 1);
+        timeout_msec = shorten_timeout(timeout_msec, microtcp_send_fsm_pacing_delay_usec(socket)); /* Round's next segment is due. */
+        timeout_msec = shorten_timeout(timeout_msec, delayed_ack_delay_usec(socket));               /* Delayed ACK is due. */
+        wait_for_events(fds, ARRAY_SIZE(fds), timeout_msec, &_pe->engine_waiting);
+}
+
+static void *run_protocol_engine(void *const _pe)
+{
+        protocol_engine_t *const pe = _pe;
+        microtcp_sock_t *const socket = pe->socket;
+        _Bool connection_alive = true;
+        while (connection_alive && !atomic_load_explicit(&pe->stop_requested, memory_order_acquire))
+        {
+                wait_for_engine_events(pe);
+                pthread_mutex_lock(&pe->socket_lock);
+                connection_alive = receive_pending_segments(pe) == SUCCESS &&
+                                   (srb_stored_bytes(socket->send_ring) == 0 || microtcp_send_fsm_progress(socket, false) == SUCCESS);
+                deliver_reassembled_bytes(pe);
+                connection_alive = connection_alive && delayed_ack_on_window_update(socket) == SUCCESS;
+                wake_if_waiting(&pe->application_waiting, pe->application_eventfd);
+                if (socket->stats_export_slot != NULL) /* Clock is read only while exported. */
+                        stats_export_publish_if_due(socket, get_monotonic_time_usec());
+                pthread_mutex_unlock(&pe->socket_lock);
+        }
+        pthread_mutex_lock(&pe->socket_lock);
+        if (connection_alive && delayed_ack_flush(socket) == FAILURE) /* Application takes the connection back; Nothing would send it. */
+                LOG_ERROR("Protocol engine failed sending its delayed ACK.");
+        pthread_mutex_unlock(&pe->socket_lock);
+        atomic_store_explicit(&pe->running, false, memory_order_release);
+        wake_if_waiting(&pe->application_waiting, pe->application_eventfd);
+        return NULL;
+}
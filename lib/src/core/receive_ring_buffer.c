@@ -1,11 +1,15 @@
 #include <errno.h>
 #include <stdint.h>
 #include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <unistd.h>
 #include "allocator/allocator_macros.h"
 #include "microtcp.h"
 #include "smart_assert.h"
 #include "core/segment_processing.h"
+#include "crc32.h"
 #include "microtcp_helper_functions.h"
 #include "microtcp_helper_macros.h"
 #include "core/receive_ring_buffer.h"
@@ -15,51 +19,69 @@
 #include "microtcp_defines.h"
 #include "core/segment_processing.h"
 
-typedef struct rrb_block rrb_block_t;
-struct rrb_block
-{
-        uint32_t seq_number;
-        uint32_t size;
-        rrb_block_t *next;
-};
+#define BITMAP_WORD_BITS 64
 
 /* `receive_ring_bufffer_t` is defined in equivilant header_file. */
 struct receive_ring_buffer
 {
         uint8_t *buffer;
         uint32_t buffer_size;
+        _Bool double_mapped; /* `buffer` is followed by a second mapping of itself; Any span of up to `buffer_size` bytes is contiguous. */
         uint32_t last_consumed_seq_number;
         uint32_t consumable_bytes;
-        rrb_block_t *rrb_block_list_head;
+        uint64_t *received_bitmap; /* One bit per RRB byte; Set for bytes received out-of-order (beyond consumable bytes). */
+        uint32_t out_of_order_bytes; /* Set bits in `received_bitmap`. */
 };
 
 /* Inner helper functions. */
-static void rrb_block_list_destroy(rrb_block_t **_head_address);
+static uint8_t *map_double_mapped_buffer(size_t _rrb_size);
+static inline uint32_t contiguous_span(const receive_ring_buffer_t *_rrb, uint32_t _begin_pos, uint32_t _bytes);
 static inline _Bool is_in_bounds(uint32_t _rrb_begin_ex_bound, uint32_t _rrb_remaining_size, uint32_t _segment_seq_number);
 static inline uint32_t free_space(uint32_t _rrb_last_consumed_seq_number, uint32_t _rrb_size, uint32_t _segment_seq_number);
-static void rrb_block_list_insert(rrb_block_t **_head_address, uint32_t _seq_number, uint32_t _size);
-static uint32_t join_rrb_blocks(receive_ring_buffer_t *_rrb);
-static inline rrb_block_t *create_rrb_block(uint32_t _seq_number, uint32_t _size, rrb_block_t *_next);
-static inline void merge_with_left(rrb_block_t *_prev_left_node, rrb_block_t *_left_node, uint32_t _extend_size, rrb_block_t **_head_address);
-static inline void merge_with_right(rrb_block_t *_prev_right_node, rrb_block_t *_right_node, uint32_t _new_seq_number, uint32_t _extend_size);
-__attribute__((unused)) static inline size_t block_list_size(const rrb_block_t *_head_of_list);
-
-receive_ring_buffer_t *rrb_create(const size_t _rrb_size, const uint32_t _current_seq_number)
+static inline void bitmap_word_range(uint32_t _begin_pos, uint32_t _size, size_t *_word, uint64_t *_mask);
+static _Bool any_received_in_range(const receive_ring_buffer_t *_rrb, uint32_t _begin_pos, uint32_t _size);
+static void mark_received_range(receive_ring_buffer_t *_rrb, uint32_t _begin_pos, uint32_t _size);
+static uint32_t take_received_run(receive_ring_buffer_t *_rrb, uint32_t _begin_pos);
+static inline uint32_t bits_in_first_word(const receive_ring_buffer_t *_rrb, uint32_t _begin_pos, uint32_t _size);
+static uint32_t find_bit(const receive_ring_buffer_t *_rrb, uint32_t _begin_pos, uint32_t _size, _Bool _value);
+
+/**
+ * @param _double_mapped if set, RRB's pages are mapped twice back-to-back (see map_double_mapped_buffer()), so appends and pops
+ * never split. Falls back to a plain buffer if mapping fails, or `_rrb_size` is not a multiple of page size.
+ */
+receive_ring_buffer_t *rrb_create(const size_t _rrb_size, const uint32_t _current_seq_number, const _Bool _double_mapped)
 {
         SMART_ASSERT(_rrb_size > 0, _rrb_size <= UINT32_MAX, IS_POWER_OF_2(_rrb_size));
         receive_ring_buffer_t *rrb = MALLOC_LOG(rrb, sizeof(receive_ring_buffer_t));
         if (rrb == NULL)
                 return NULL;
 
-        rrb->buffer = MALLOC_LOG(rrb->buffer, _rrb_size);
+        /* Bitmap is calloc()ed: Its pages are only backed by memory once out-of-order segments touch them. */
+        const size_t bitmap_words = (_rrb_size + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+        rrb->received_bitmap = CALLOC_LOG(rrb->received_bitmap, bitmap_words * sizeof(uint64_t));
+        if (rrb->received_bitmap == NULL)
+        {
+                FREE_NULLIFY_LOG(rrb);
+                return NULL;
+        }
+
+        rrb->double_mapped = false;
+        if (_double_mapped)
+        {
+                rrb->buffer = map_double_mapped_buffer(_rrb_size);
+                rrb->double_mapped = rrb->buffer != NULL;
+        }
+        if (!rrb->double_mapped)
+                rrb->buffer = MALLOC_LOG(rrb->buffer, _rrb_size);
         if (rrb->buffer == NULL)
         {
+                FREE_NULLIFY_LOG(rrb->received_bitmap);
                 FREE_NULLIFY_LOG(rrb);
                 return NULL;
         }
-        rrb->rrb_block_list_head = NULL;
         rrb->buffer_size = _rrb_size;
         rrb->consumable_bytes = 0;
+        rrb->out_of_order_bytes = 0;
         rrb->last_consumed_seq_number = _current_seq_number;
         return rrb;
 }
@@ -75,17 +97,25 @@ status_t rrb_destroy(receive_ring_buffer_t **const _rrb_address)
                 return SUCCESS;
 
         /* Proceed with destruction. */
-        rrb_block_list_destroy(&RRB->rrb_block_list_head);
-        FREE_NULLIFY_LOG(RRB->buffer);
+        FREE_NULLIFY_LOG(RRB->received_bitmap);
+        if (RRB->double_mapped)
+        {
+                if (munmap(RRB->buffer, 2 * (size_t)RRB->buffer_size) == -1)
+                        LOG_ERROR("Failed to unmap RRB's double mapped buffer; munmap() set errno(%d):%s.", errno, strerror(errno));
+                RRB->buffer = NULL;
+        }
+        else
+                FREE_NULLIFY_LOG(RRB->buffer);
         FREE_NULLIFY_LOG(RRB);
         return SUCCESS;
 #undef RRB
 }
 
 /**
- * @returns Number of bytes, appended to the Receive-Ring-Buffer
- * @note Due to the checksum function we need to first process the segment in continuous buffer.
- * Thus any attempt to directly write new segment into RRB is failed (by Initial DESIGN).
+ * @returns Number of bytes, appended to the Receive-Ring-Buffer. 0 if segment is out-of-bounds, duplicate or corrupted.
+ * @note Segment arrives with its checksum unvalidated (see receive_data_segment()). Its CRC32 is calculated while its
+ * payload is copied straight into its final RRB position, in a single pass. Segment is committed only if checksum matches;
+ * Otherwise bytes written land on free (uncommitted) RRB space, which is never read.
  */
 uint32_t rrb_append(receive_ring_buffer_t *const _rrb, const microtcp_segment_t *const _segment)
 {
@@ -98,26 +128,36 @@ uint32_t rrb_append(receive_ring_buffer_t *const _rrb, const microtcp_segment_t
                                    rrb_begin_ex_bound, rrb_remaining_size, _segment->header.seq_number);
         const uint32_t available_space = free_space(_rrb->last_consumed_seq_number, _rrb->buffer_size, _segment->header.seq_number);
         const uint32_t data_len = _segment->header.data_len;
-        DEBUG_SMART_ASSERT(data_len <= available_space);                         /* SHOULD NOT receive packet, that doesnt fit.. sender should respect my receive_window */
         const uint32_t bytes_to_copy = data_len * (data_len <= available_space); /* Copy whole segment.. Or no segment at all. */
         if (bytes_to_copy == 0)
                 return 0;
+        /* Writing over stored bytes would damage them, if this segment turns out corrupted. */
+        const uint32_t begin_pos = _segment->header.seq_number % _rrb->buffer_size;
+        if (RARE_CASE(any_received_in_range(_rrb, begin_pos, bytes_to_copy)))
+                LOG_WARNING_RETURN(0, "RRB duplicate segment: {`incoming seq_number` = %u, `data_len` = %u}.", _segment->header.seq_number, data_len);
 
-        if (_rrb->last_consumed_seq_number + _rrb->consumable_bytes + 1 == _segment->header.seq_number)
-                _rrb->consumable_bytes += bytes_to_copy;
-        else
-                rrb_block_list_insert(&(_rrb->rrb_block_list_head), _segment->header.seq_number, bytes_to_copy);
+        /* Write on Right-Side of RRB, and on Left-Side (if wrap-around occurs); Checksumming on the way. */
+        const uint32_t bytes_on_right_side = contiguous_span(_rrb, begin_pos, bytes_to_copy);
+        const uint32_t bytes_on_left_size = bytes_to_copy - bytes_on_right_side;
+        uint32_t running_crc = begin_microtcp_checksum(&_segment->header);
+        running_crc = update_crc32_copy(running_crc, _rrb->buffer + begin_pos, _segment->raw_payload_bytes, bytes_on_right_side);
+        running_crc = update_crc32_copy(running_crc, _rrb->buffer, _segment->raw_payload_bytes + bytes_on_right_side, bytes_on_left_size);
+        if (RARE_CASE(!end_microtcp_checksum(&_segment->header, running_crc)))
+                LOG_WARNING_RETURN(0, "Received microtcp bytestream is corrupted.");
 
-        /* Check if you can grow consumable bytes (using block_list). */
-        _rrb->consumable_bytes += join_rrb_blocks(_rrb);
+        if (_rrb->last_consumed_seq_number + _rrb->consumable_bytes + 1 != _segment->header.seq_number)
+        {
+                mark_received_range(_rrb, begin_pos, bytes_to_copy);
+                _rrb->out_of_order_bytes += bytes_to_copy;
+                return bytes_to_copy;
+        }
+        _rrb->consumable_bytes += bytes_to_copy;
 
-        /* Write on Right-Side of RRB: */
-        const uint32_t begin_pos = _segment->header.seq_number % _rrb->buffer_size;
-        const uint32_t bytes_on_right_side = MIN(bytes_to_copy, _rrb->buffer_size - begin_pos);
-        const uint32_t bytes_on_left_size = bytes_to_copy - bytes_on_right_side;
-        memcpy(_rrb->buffer + begin_pos, _segment->raw_payload_bytes, bytes_on_right_side);
-        /* Write on Left-Side of RRB (if wrap-around occurs): */
-        memcpy(_rrb->buffer, _segment->raw_payload_bytes + bytes_on_right_side, bytes_on_left_size);
+        /* Gap filled; Out-of-order bytes that directly follow become consumable too. */
+        const uint32_t consumable_end_pos = (_rrb->last_consumed_seq_number + _rrb->consumable_bytes + 1) % _rrb->buffer_size;
+        const uint32_t joined_bytes = take_received_run(_rrb, consumable_end_pos);
+        _rrb->consumable_bytes += joined_bytes;
+        _rrb->out_of_order_bytes -= joined_bytes;
         return bytes_to_copy;
 }
 
@@ -128,15 +168,35 @@ uint32_t rrb_pop(receive_ring_buffer_t *const _rrb, void *const _buffer, const u
         if (bytes_to_copy == 0)
                 return 0;
         const uint32_t begin_pos = (_rrb->last_consumed_seq_number + 1) % _rrb->buffer_size;
-        const uint32_t bytes_on_right_side = MIN(bytes_to_copy, _rrb->buffer_size - begin_pos);
+        const uint32_t bytes_on_right_side = contiguous_span(_rrb, begin_pos, bytes_to_copy);
         const uint32_t bytes_on_left_size = bytes_to_copy - bytes_on_right_side;
         memcpy(_buffer, _rrb->buffer + begin_pos, bytes_on_right_side);
         memcpy((uint8_t *)_buffer + bytes_on_right_side, _rrb->buffer, bytes_on_left_size);
-        _rrb->consumable_bytes -= bytes_to_copy;
-        _rrb->last_consumed_seq_number += bytes_to_copy;
+        rrb_consume(_rrb, bytes_to_copy);
         return bytes_to_copy;
 }
 
+const uint8_t *rrb_readable_region(const receive_ring_buffer_t *const _rrb, uint32_t *const _length)
+{
+        DEBUG_SMART_ASSERT(_rrb != NULL, _length != NULL);
+        const uint32_t begin_pos = (_rrb->last_consumed_seq_number + 1) % _rrb->buffer_size;
+        *_length = contiguous_span(_rrb, begin_pos, _rrb->consumable_bytes);
+        return _rrb->buffer + begin_pos;
+}
+
+void rrb_consume(receive_ring_buffer_t *const _rrb, const uint32_t _bytes)
+{
+        DEBUG_SMART_ASSERT(_rrb != NULL, _bytes <= _rrb->consumable_bytes);
+        _rrb->consumable_bytes -= _bytes;
+        _rrb->last_consumed_seq_number += _bytes;
+}
+
+_Bool rrb_is_double_mapped(const receive_ring_buffer_t *const _rrb)
+{
+        DEBUG_SMART_ASSERT(_rrb != NULL);
+        return _rrb->double_mapped;
+}
+
 uint32_t rrb_size(const receive_ring_buffer_t *const _rrb)
 {
         DEBUG_SMART_ASSERT(_rrb != NULL);
@@ -154,18 +214,80 @@ uint32_t rrb_last_consumed_seq_number(const receive_ring_buffer_t *const _rrb)
         return _rrb->last_consumed_seq_number;
 }
 
-static void rrb_block_list_destroy(rrb_block_t **const _head_address)
+uint32_t rrb_out_of_order_bytes(const receive_ring_buffer_t *const _rrb)
+{
+        DEBUG_SMART_ASSERT(_rrb != NULL);
+        return _rrb->out_of_order_bytes;
+}
+
+size_t rrb_out_of_order_blocks(const receive_ring_buffer_t *const _rrb, rrb_block_t *const _blocks, const size_t _max_blocks)
+{
+        DEBUG_SMART_ASSERT(_rrb != NULL, _blocks != NULL);
+        if (COMMON_CASE(_rrb->out_of_order_bytes == 0))
+                return 0;
+        const uint32_t first_free_seq_number = _rrb->last_consumed_seq_number + _rrb->consumable_bytes + 1;
+        const uint32_t free_bytes = _rrb->buffer_size - _rrb->consumable_bytes;
+        size_t block_count = 0;
+        uint32_t offset = 0; /* From `first_free_seq_number`. */
+        while (block_count < _max_blocks && offset < free_bytes)
+        {
+                const uint32_t block_begin = offset + find_bit(_rrb, (first_free_seq_number + offset) % _rrb->buffer_size, free_bytes - offset, true);
+                if (block_begin == free_bytes)
+                        break;
+                const uint32_t block_end = block_begin + find_bit(_rrb, (first_free_seq_number + block_begin) % _rrb->buffer_size, free_bytes - block_begin, false);
+                _blocks[block_count++] = (rrb_block_t){.seq_number = first_free_seq_number + block_begin, .length = block_end - block_begin};
+                offset = block_end;
+        }
+        return block_count;
+}
+
+/**
+ * @brief Maps the pages of an anonymous memory file twice, back-to-back: [0, size) and [size, 2 * size) alias the same bytes.
+ * Thus, writing (or reading) past the end of the first mapping wraps around to the RRB's beginning, with no split memcpy().
+ * @returns pointer to the first mapping, or NULL on failure.
+ */
+static uint8_t *map_double_mapped_buffer(const size_t _rrb_size)
 {
-        DEBUG_SMART_ASSERT(_head_address != NULL); /* head pointer can be NULL, but not its address. */
+        const long page_size = sysconf(_SC_PAGESIZE);
+        if (page_size <= 0 || _rrb_size % (size_t)page_size != 0)
+                LOG_WARNING_RETURN(NULL, "RRB size (%zu bytes) is not a multiple of page size (%ld bytes); Cannot double map it.", _rrb_size, page_size);
+
+        const int memfd = memfd_create("microtcp_rrb", MFD_CLOEXEC);
+        if (memfd == -1)
+                LOG_WARNING_RETURN(NULL, "Failed to double map RRB; memfd_create() set errno(%d):%s.", errno, strerror(errno));
+        if (ftruncate(memfd, (off_t)_rrb_size) == -1)
+        {
+                LOG_WARNING("Failed to double map RRB; ftruncate() set errno(%d):%s.", errno, strerror(errno));
+                close(memfd);
+                return NULL;
+        }
 
-#define HEAD (*_head_address)
-        while (HEAD != NULL)
+        /* Reserve the whole address range first, so both mappings are guaranteed adjacent. */
+        uint8_t *const buffer = mmap(NULL, 2 * _rrb_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED)
         {
-                rrb_block_t *next = HEAD->next;
-                FREE_NULLIFY_LOG(HEAD);
-                HEAD = next;
+                LOG_WARNING("Failed to double map RRB; mmap() set errno(%d):%s.", errno, strerror(errno));
+                close(memfd);
+                return NULL;
+        }
+        if (mmap(buffer, _rrb_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd, 0) == MAP_FAILED ||
+            mmap(buffer + _rrb_size, _rrb_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd, 0) == MAP_FAILED)
+        {
+                LOG_WARNING("Failed to double map RRB; mmap() set errno(%d):%s.", errno, strerror(errno));
+                munmap(buffer, 2 * _rrb_size);
+                close(memfd);
+                return NULL;
         }
-#undef HEAD
+        close(memfd); /* Mappings keep the memory file alive. */
+        LOG_INFO_RETURN(buffer, "RRB of %zu bytes is double mapped.", _rrb_size);
+}
+
+/* @returns how many of the `_bytes` starting at `_begin_pos` can be accessed with a single memcpy(). */
+static inline uint32_t contiguous_span(const receive_ring_buffer_t *const _rrb, const uint32_t _begin_pos, const uint32_t _bytes)
+{
+        if (_rrb->double_mapped)
+                return _bytes;
+        return MIN(_bytes, _rrb->buffer_size - _begin_pos);
 }
 
 static inline _Bool is_in_bounds(uint32_t _rrb_begin_ex_bound, uint32_t _rrb_remaining_size, uint32_t _segment_seq_number)
@@ -197,144 +319,97 @@ static inline uint32_t free_space(const uint32_t _rrb_last_consumed_seq_number,
         return (_rrb_last_consumed_seq_number + _rrb_size) - _segment_seq_number + 1; /* +1 because _segment_seq_number is pointing to consumable data. */
 }
 
-/* Does not account for overlap, as it require EXTRA logic (a lot !). */
-static void rrb_block_list_insert(rrb_block_t **const _head_address, const uint32_t _seq_number, const uint32_t _size)
-{
-        SMART_ASSERT(_size > 0, _size < INT32_MAX); /* WRAP-AROUND threshold. Shouldn't worry.. size shouldn't exceeds a few kbytes */
-#define HEAD (*_head_address)
-        /* Case 0: Empty list, insert as head */
-        if (HEAD == NULL)
-        {
-                HEAD = create_rrb_block(_seq_number, _size, NULL);
-                return;
-        }
 
-        rrb_block_t *curr_node = HEAD;
-        rrb_block_t *prev_node = NULL;
-        _Bool flag = false;
-        rrb_block_t *flag_prev_node = NULL;
-        rrb_block_t *flag_curr_node = NULL;
-        while (curr_node != NULL)
-        {
-                /* Case 1: Continuation of current node. */
-                if (curr_node->seq_number + curr_node->size == _seq_number)
-                {
-                        merge_with_left(prev_node, curr_node, _size, _head_address);
-                        return;
-                }
-                /* Case 2: Merge with the current block (less than) */
-                if (_seq_number + _size == curr_node->seq_number)
-                {
-                        merge_with_right(prev_node, curr_node, _seq_number, _size);
-                        return;
-                }
-                if (flag == false && _seq_number < curr_node->seq_number)
-                {
-
-                        flag = true;
-                        flag_prev_node = prev_node;
-                        flag_curr_node = curr_node;
-                }
-                prev_node = curr_node;
-                curr_node = curr_node->next;
-        }
-        /* Case 3: Insert before the current block (less than, no merge) */
-        if (flag == true && _seq_number < flag_curr_node->seq_number)
-        {
-                rrb_block_t *new_block = create_rrb_block(_seq_number, _size, flag_curr_node);
-                if (flag_prev_node == NULL) /* Means curr_node == HEAD. */
-                        HEAD = new_block;
-                else
-                        flag_prev_node->next = new_block;
-                return;
-        }
-        prev_node->next = create_rrb_block(_seq_number, _size, NULL);
-#undef HEAD
-}
+/* Bitmap helpers: RRB positions are bit indices. Ranges are walked a word at a time, wrapping around RRB's end. */
 
-static uint32_t join_rrb_blocks(receive_ring_buffer_t *const _rrb)
+/* Sets `_word` to the word holding `_begin_pos`, and `_mask` to the bits of [_begin_pos, _begin_pos + _size) in it. */
+static inline void bitmap_word_range(const uint32_t _begin_pos, const uint32_t _size, size_t *const _word, uint64_t *const _mask)
 {
-        uint32_t growth_counter = 0;
-        rrb_block_t *prev_node = NULL;
-        rrb_block_t *curr_node = _rrb->rrb_block_list_head;
-        _Bool found_match = false;
-        do
-        {
-                found_match = false;
-                for (; curr_node != NULL; curr_node = curr_node->next)
-                {
-                        if (_rrb->last_consumed_seq_number + _rrb->consumable_bytes + 1 == curr_node->seq_number)
-                                break;
-                        prev_node = curr_node;
-                }
-                if (curr_node == NULL) /* Didn't find match. */
-                        break;
-
-                if (prev_node == NULL) /* curr_node == HEAD. */
-                        _rrb->rrb_block_list_head = curr_node->next;
-                else
-                        prev_node->next = curr_node->next;
-                growth_counter += curr_node->size;
-                FREE_NULLIFY_LOG(curr_node);
-                found_match = true;
-        } while (found_match == true);
-        return growth_counter;
+        DEBUG_SMART_ASSERT(_size > 0, _begin_pos % BITMAP_WORD_BITS + _size <= BITMAP_WORD_BITS);
+        const uint32_t first_bit = _begin_pos % BITMAP_WORD_BITS;
+        *_word = _begin_pos / BITMAP_WORD_BITS;
+        *_mask = (_size == BITMAP_WORD_BITS ? ~0ULL : ((1ULL << _size) - 1)) << first_bit;
 }
 
-static inline rrb_block_t *create_rrb_block(uint32_t _seq_number, uint32_t _size, rrb_block_t *_next)
+/* @returns how many bits of a range starting at `_begin_pos` fit in its first word (and before RRB's end). */
+static inline uint32_t bits_in_first_word(const receive_ring_buffer_t *const _rrb, const uint32_t _begin_pos, const uint32_t _size)
 {
-        rrb_block_t *new_block = MALLOC_LOG(new_block, sizeof(rrb_block_t));
-        new_block->seq_number = _seq_number;
-        new_block->size = _size;
-        new_block->next = _next;
-        return new_block;
+        return MIN(_size, MIN(BITMAP_WORD_BITS - _begin_pos % BITMAP_WORD_BITS, _rrb->buffer_size - _begin_pos));
 }
 
-static inline void merge_with_left(rrb_block_t *_prev_left_node, rrb_block_t *_left_node, uint32_t _extend_size, rrb_block_t **_head_address)
+static _Bool any_received_in_range(const receive_ring_buffer_t *const _rrb, uint32_t _begin_pos, uint32_t _size)
 {
-#define HEAD (*_head_address)
-        _left_node->size += _extend_size;
-        /* If reached another block to right, merge too. */
-        if (_left_node->next != NULL && _left_node->next->seq_number == _left_node->seq_number + _left_node->size)
+        while (_size > 0)
         {
-                _left_node->size += _left_node->next->size;
-                rrb_block_t *next_node_copy = _left_node->next;
-                _left_node->next = _left_node->next->next;
-                FREE_NULLIFY_LOG(next_node_copy);
+                size_t word;
+                uint64_t mask;
+                const uint32_t bits = bits_in_first_word(_rrb, _begin_pos, _size);
+                bitmap_word_range(_begin_pos, bits, &word, &mask);
+                if (_rrb->received_bitmap[word] & mask)
+                        return true;
+                _begin_pos = (_begin_pos + bits) % _rrb->buffer_size;
+                _size -= bits;
         }
-        else if (_left_node->seq_number + _left_node->size == HEAD->seq_number) /* Can we merge with HEAD? */
+        return false;
+}
+
+static void mark_received_range(receive_ring_buffer_t *const _rrb, uint32_t _begin_pos, uint32_t _size)
+{
+        while (_size > 0)
         {
-                HEAD->seq_number = _left_node->seq_number;
-                HEAD->size += _left_node->size;
-                FREE_NULLIFY_LOG(_left_node);
-                if (_prev_left_node != NULL)
-                        _prev_left_node->next = NULL;
+                size_t word;
+                uint64_t mask;
+                const uint32_t bits = bits_in_first_word(_rrb, _begin_pos, _size);
+                bitmap_word_range(_begin_pos, bits, &word, &mask);
+                _rrb->received_bitmap[word] |= mask;
+                _begin_pos = (_begin_pos + bits) % _rrb->buffer_size;
+                _size -= bits;
         }
-#undef HEAD
 }
 
-static inline void merge_with_right(rrb_block_t *_prev_right_node, rrb_block_t *_right_node, uint32_t _new_seq_number, uint32_t _extend_size)
+/* @returns offset of the first bit equal to `_value`, within `_size` bits from `_begin_pos`; `_size` if there is none. */
+static uint32_t find_bit(const receive_ring_buffer_t *const _rrb, const uint32_t _begin_pos, const uint32_t _size, const _Bool _value)
 {
-        _right_node->seq_number = _new_seq_number;
-        _right_node->size += _extend_size;
-
-        /* Merge `_prev_right_node` and `_right_node` if they are contiguous blocks. */
-        if (_prev_right_node != NULL && _prev_right_node->seq_number + _prev_right_node->size == _right_node->seq_number)
+        uint32_t offset = 0;
+        while (offset < _size)
         {
-                _prev_right_node->size += _right_node->size;
-                _prev_right_node->next = _right_node->next;
-                FREE_NULLIFY_LOG(_right_node);
+                const uint32_t pos = (_begin_pos + offset) % _rrb->buffer_size;
+                const uint32_t bits = bits_in_first_word(_rrb, pos, _size - offset);
+                uint64_t word = _rrb->received_bitmap[pos / BITMAP_WORD_BITS] >> (pos % BITMAP_WORD_BITS);
+                if (!_value)
+                        word = ~word;
+                if (bits < BITMAP_WORD_BITS)
+                        word &= (1ULL << bits) - 1;
+                if (word != 0)
+                        return offset + (uint32_t)__builtin_ctzll(word);
+                offset += bits;
         }
+        return _size;
 }
 
-__attribute__((unused)) static inline size_t block_list_size(const rrb_block_t *_head_of_list)
+/**
+ * @brief Counts (and clears) the run of received bits starting at `_begin_pos`; A word at a time, with ctz().
+ * @returns the length of the run, in bytes.
+ */
+static uint32_t take_received_run(receive_ring_buffer_t *const _rrb, uint32_t _begin_pos)
 {
-        DEBUG_SMART_ASSERT(_head_of_list != NULL);
-        size_t list_size = 0;
-        while (_head_of_list)
+        uint32_t run_length = 0;
+        while (true)
         {
-                list_size++;
-                _head_of_list = _head_of_list->next;
+                const size_t word = _begin_pos / BITMAP_WORD_BITS;
+                const uint32_t first_bit = _begin_pos % BITMAP_WORD_BITS;
+                const uint64_t unset_bits = ~(_rrb->received_bitmap[word] >> first_bit); /* Bits shifted in count as unset. */
+                const uint32_t bits = unset_bits == 0 ? BITMAP_WORD_BITS : (uint32_t)__builtin_ctzll(unset_bits);
+                if (bits == 0)
+                        break;
+                size_t unused_word;
+                uint64_t mask;
+                bitmap_word_range(_begin_pos, bits, &unused_word, &mask);
+                _rrb->received_bitmap[word] &= ~mask;
+                run_length += bits;
+                _begin_pos = (_begin_pos + bits) % _rrb->buffer_size;
+                if (first_bit + bits < BITMAP_WORD_BITS) /* Run ended inside this word. */
+                        break;
         }
-        return list_size;
+        return run_length;
 }
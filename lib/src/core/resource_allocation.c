@@ -2,8 +2,18 @@
 #include <stddef.h>
 #include <sys/socket.h>
 #include "allocator/allocator_macros.h"
+#include "congestion_control/congestion_control.h"
+#include "core/datagram_batch.h"
+#include "core/delayed_ack.h"
+#include "core/listener.h"
+#include "core/pacing.h"
+#include "core/protocol_engine.h"
+#include "core/rto_estimator.h"
 #include "core/segment_io.h"
 #include "core/send_queue.h"
+#include "core/send_ring_buffer.h"
+#include "core/stats_export.h"
+#include "fsm/microtcp_fsm.h"
 #include "core/misc.h"
 #include "core/segment_processing.h"
 #include "logging/microtcp_logger.h"
@@ -14,13 +24,13 @@
 
 /* Declarations of static functions implemented in this file: */
 static microtcp_segment_t *allocate_segment_build_buffer(microtcp_sock_t *_socket);
-static void *allocate_bytestream_build_buffer(microtcp_sock_t *_socket);
+static void *allocate_header_build_buffer(microtcp_sock_t *_socket);
 static microtcp_segment_t *allocate_segment_extraction_buffer(microtcp_sock_t *_socket);
-static void *allocate_bytestream_receive_buffer(microtcp_sock_t *_socket);
+static datagram_batch_t *allocate_receive_batch(microtcp_sock_t *_socket);
 static void deallocate_segment_build_buffer(microtcp_sock_t *_socket);
-static void deallocate_bytestream_build_buffer(microtcp_sock_t *_socket);
+static void deallocate_header_build_buffer(microtcp_sock_t *_socket);
 static void deallocate_segment_extraction_buffer(microtcp_sock_t *_socket);
-static void deallocate_bytestream_receive_buffer(microtcp_sock_t *_socket);
+static void deallocate_receive_batch(microtcp_sock_t *_socket);
 
 status_t allocate_pre_handshake_buffers(microtcp_sock_t *_socket)
 {
@@ -30,11 +40,11 @@ status_t allocate_pre_handshake_buffers(microtcp_sock_t *_socket)
         /* Buffers meant for making ack sending packets. */
         if (allocate_segment_build_buffer(_socket) == NULL)
                 goto failure_cleanup;
-        if (allocate_bytestream_build_buffer(_socket) == NULL)
+        if (allocate_header_build_buffer(_socket) == NULL)
                 goto failure_cleanup;
 
         /* Buffers meant for receiving and extracting segments. */
-        if (allocate_bytestream_receive_buffer(_socket) == NULL)
+        if (allocate_receive_batch(_socket) == NULL)
                 goto failure_cleanup;
         if (allocate_segment_extraction_buffer(_socket) == NULL)
                 goto failure_cleanup;
@@ -50,18 +60,38 @@ void deallocate_pre_handshake_buffers(microtcp_sock_t *_socket)
         SMART_ASSERT(_socket != NULL);
         SMART_ASSERT(_socket->state != ESTABLISHED);
         deallocate_segment_build_buffer(_socket);
-        deallocate_bytestream_build_buffer(_socket);
-        deallocate_bytestream_receive_buffer(_socket);
+        deallocate_header_build_buffer(_socket);
+        deallocate_receive_batch(_socket);
         deallocate_segment_extraction_buffer(_socket);
 }
 
 status_t allocate_post_handshake_buffers(microtcp_sock_t *_socket)
 {
         SMART_ASSERT(_socket != NULL);
-        SMART_ASSERT(_socket->state == ESTABLISHED, _socket->send_queue == NULL, _socket->bytestream_rrb == NULL);
-        _socket->send_queue = sq_create();
-        if ((_socket->bytestream_rrb = rrb_create(get_microtcp_bytestream_rrb_size(), _socket->ack_number - 1)) == NULL)
+        SMART_ASSERT(_socket->state == ESTABLISHED, _socket->send_queue == NULL, _socket->bytestream_rrb == NULL, _socket->send_batch == NULL);
+        SMART_ASSERT(_socket->congestion_control == NULL);
+        /* Peer's advertised window bounds the bytes in flight; Send-Queue is sized to hold all of them. */
+        if ((_socket->send_queue = sq_create(_socket->peer_win_size)) == NULL)
                 goto failure_cleanup;
+        const size_t send_batch_capacity = _socket->udp_offload ? UDP_OFFLOAD_SEND_BATCH_CAPACITY : DATAGRAM_BATCH_CAPACITY;
+        if ((_socket->send_batch = db_create(send_batch_capacity, MICROTCP_HEADER_SIZE, MICROTCP_SEGMENT_IOVECS)) == NULL)
+                goto failure_cleanup;
+        if ((_socket->bytestream_rrb = rrb_create(get_microtcp_bytestream_rrb_size(), _socket->ack_number - 1, get_microtcp_bytestream_rrb_double_mapped())) == NULL)
+                goto failure_cleanup;
+        const congestion_control_ops_t *const cc_module = _socket->congestion_control_ops != NULL ? _socket->congestion_control_ops
+                                                                                                 : cc_find(get_microtcp_congestion_control());
+        if ((_socket->congestion_control = cc_create(cc_module, _socket)) == NULL)
+                goto failure_cleanup;
+        if (_socket->send_buffer_size > 0) /* Buffered send mode. */
+        {
+                if ((_socket->send_ring = srb_create(_socket->send_buffer_size)) == NULL)
+                        goto failure_cleanup;
+                if ((_socket->send_context = create_send_fsm_context()) == NULL)
+                        goto failure_cleanup;
+        }
+        if (_socket->engine_thread && (_socket->engine = pe_create(_socket)) == NULL) /* Started by connect() or accept(). */
+                goto failure_cleanup;
+        stats_export_acquire_slot(_socket);
         return SUCCESS;
 
 failure_cleanup:
@@ -72,7 +102,14 @@ failure_cleanup:
 status_t deallocate_post_handshake_buffers(microtcp_sock_t *_socket)
 {
         SMART_ASSERT(_socket != NULL);
-        return sq_destroy(&_socket->send_queue) &&
+        pe_destroy(&_socket->engine); /* Engine thread goes first; It uses every other buffer. */
+        stats_export_release_slot(_socket); /* Its last snapshot reads congestion control's state. */
+        if (_socket->send_context != NULL)
+                FREE_NULLIFY_LOG(_socket->send_context);
+        return cc_destroy(&_socket->congestion_control) &&
+               sq_destroy(&_socket->send_queue) &&
+               srb_destroy(&_socket->send_ring) &&
+               db_destroy(&_socket->send_batch) &&
                rrb_destroy(&_socket->bytestream_rrb);
 }
 
@@ -80,6 +117,8 @@ void release_and_reset_connection_resources(microtcp_sock_t *_socket, microtcp_s
 {
         SMART_ASSERT(_socket != NULL, _rollback_state != ESTABLISHED);
         _Bool graceful_operation = true;
+        if (_socket->engine != NULL)
+                pe_stop(_socket->engine); /* Takes the connection back, before touching it. */
 
         /* Reset connection if established (its not this function's job to terminate gracefully).
          * We dont check if RST_BIT is actually received; Its a best effort to warn client,
@@ -87,6 +126,8 @@ void release_and_reset_connection_resources(microtcp_sock_t *_socket, microtcp_s
         if (_socket->state == ESTABLISHED)
                 send_rstack_control_segment(_socket, _socket->peer_address, sizeof(*(_socket->peer_address)));
 
+        if (_socket->listener != NULL) /* Peer's datagrams are no longer routed to us. */
+                listener_detach(_socket);
         _socket->state = _rollback_state;
         _socket->peer_address = NULL;
         _socket->data_reception_with_finack = false;
@@ -96,8 +137,10 @@ void release_and_reset_connection_resources(microtcp_sock_t *_socket, microtcp_s
                 LOG_ERROR("Deallocation of post handshake buffers failed!");
                 graceful_operation = false;
         }
-        if (set_socket_recvfrom_timeout(_socket, get_microtcp_ack_timeout()) == POSIX_SETSOCKOPT_FAILURE)
+        if (rto_reset(_socket) == FAILURE) /* Next connection measures its own RTT. */
                 LOG_ERROR("Failed resetting socket's timeout period.");
+        pacing_reset(_socket);
+        delayed_ack_reset(_socket);
         if (graceful_operation)
                 LOG_INFO("Connection's resources, successfully released and reset.");
 }
@@ -114,37 +157,41 @@ static microtcp_segment_t *allocate_segment_build_buffer(microtcp_sock_t *_socke
 }
 
 /**
- * @returns pointer to the newly allocated `bytestream_build_buffer`. If allocation fails returns `NULL`;
- * @brief There are two states where `bytestream_build_buffer` memory allocation is possible.
- * Client allocates its `bytestream_build_buffer` in connect(), socket in CLOSED state.
- * Server allocates its `bytestream_build_buffer` in accept(),  socket in LISTEN  state.
+ * @returns pointer to the newly allocated `header_build_buffer`. If allocation fails returns `NULL`;
+ * @brief There are two states where `header_build_buffer` memory allocation is possible.
+ * Client allocates its `header_build_buffer` in connect(), socket in CLOSED state.
+ * Server allocates its `header_build_buffer` in accept(),  socket in LISTEN  state.
  */
-static void *allocate_bytestream_build_buffer(microtcp_sock_t *_socket)
+static void *allocate_header_build_buffer(microtcp_sock_t *_socket)
 {
         RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(NULL, _socket, (CLOSED | LISTEN));
-        SMART_ASSERT(_socket->bytestream_build_buffer == NULL);
+        SMART_ASSERT(_socket->header_build_buffer == NULL);
 
-        _socket->bytestream_build_buffer = CALLOC_LOG(_socket->bytestream_build_buffer, MICROTCP_MTU);
-        if (_socket->bytestream_build_buffer == NULL)
-                LOG_ERROR_RETURN(_socket->bytestream_build_buffer, "Failed to allocate socket's `bytestream_build_buffer`.");
-        LOG_INFO_RETURN(_socket->bytestream_build_buffer, "Succesful allocation of `bytestream_build_buffer`.");
+        _socket->header_build_buffer = CALLOC_LOG(_socket->header_build_buffer, MICROTCP_HEADER_SIZE);
+        if (_socket->header_build_buffer == NULL)
+                LOG_ERROR_RETURN(_socket->header_build_buffer, "Failed to allocate socket's `header_build_buffer`.");
+        LOG_INFO_RETURN(_socket->header_build_buffer, "Succesful allocation of `header_build_buffer`.");
 }
 
 /**
- * @returns pointer to the newly allocated `bytestream_receive_buffer`. If allocation fails returns `NULL`;
- * @brief There are two states where `bytestream_receive_buffer` memory allocation is possible.
- * Client allocates its `bytestream_receive_buffer` in connect(), socket in CLOSED state.
- * Server allocates its `bytestream_receive_buffer` in accept(),  socket in LISTEN  state.
+ * @returns pointer to the newly allocated `receive_batch`. If allocation fails returns `NULL`;
+ * @brief There are two states where `receive_batch` memory allocation is possible.
+ * Client allocates its `receive_batch` in connect(), socket in CLOSED state.
+ * Server allocates its `receive_batch` in accept(),  socket in LISTEN  state.
  */
-static void *allocate_bytestream_receive_buffer(microtcp_sock_t *_socket)
+static datagram_batch_t *allocate_receive_batch(microtcp_sock_t *_socket)
 {
         RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(NULL, _socket, (CLOSED | LISTEN));
-        SMART_ASSERT(_socket->bytestream_receive_buffer == NULL);
-
-        _socket->bytestream_receive_buffer = CALLOC_LOG(_socket->bytestream_receive_buffer, MICROTCP_MTU);
-        if (_socket->bytestream_receive_buffer == NULL)
-                LOG_ERROR_RETURN(_socket->bytestream_receive_buffer, "Failed to allocate socket's `bytestream_receive_buffer`.");
-        LOG_INFO_RETURN(_socket->bytestream_receive_buffer, "Succesful allocation of `bytestream_receive_buffer`.");
+        SMART_ASSERT(_socket->receive_batch == NULL);
+
+        /* GRO may coalesce several segments into a single datagram; Slots must fit the largest UDP datagram. */
+        if (_socket->udp_offload)
+                _socket->receive_batch = db_create(UDP_OFFLOAD_RECEIVE_BATCH_CAPACITY, UDP_OFFLOAD_RECEIVE_SLOT_SIZE, 1);
+        else
+                _socket->receive_batch = db_create(DATAGRAM_BATCH_CAPACITY, MICROTCP_MTU, 1);
+        if (_socket->receive_batch == NULL)
+                LOG_ERROR_RETURN(_socket->receive_batch, "Failed to allocate socket's `receive_batch`.");
+        LOG_INFO_RETURN(_socket->receive_batch, "Succesful allocation of `receive_batch`.");
 }
 
 static microtcp_segment_t *allocate_segment_extraction_buffer(microtcp_sock_t *_socket)
@@ -166,20 +213,19 @@ static void deallocate_segment_build_buffer(microtcp_sock_t *_socket)
                 FREE_NULLIFY_LOG(_socket->segment_build_buffer);
 }
 
-static void deallocate_bytestream_build_buffer(microtcp_sock_t *_socket)
+static void deallocate_header_build_buffer(microtcp_sock_t *_socket)
 {
         SMART_ASSERT(_socket != NULL);
         SMART_ASSERT(_socket->state != ESTABLISHED);
-        if (_socket->bytestream_build_buffer != NULL)
-                FREE_NULLIFY_LOG(_socket->bytestream_build_buffer);
+        if (_socket->header_build_buffer != NULL)
+                FREE_NULLIFY_LOG(_socket->header_build_buffer);
 }
 
-static void deallocate_bytestream_receive_buffer(microtcp_sock_t *_socket)
+static void deallocate_receive_batch(microtcp_sock_t *_socket)
 {
         SMART_ASSERT(_socket != NULL);
         SMART_ASSERT(_socket->state != ESTABLISHED);
-        if (_socket->bytestream_receive_buffer != NULL)
-                FREE_NULLIFY_LOG(_socket->bytestream_receive_buffer);
+        db_destroy(&_socket->receive_batch);
 }
 
 static void deallocate_segment_extraction_buffer(microtcp_sock_t *_socket)
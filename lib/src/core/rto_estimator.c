@@ -0,0 +1,77 @@
+#include "core/rto_estimator.h"
+#include <time.h>
+#include "core/misc.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "settings/microtcp_settings.h"
+#include "smart_assert.h"
+#include "status.h"
+
+/* RFC 6298 gains: alpha = 1/8, beta = 1/4, K = 4. */
+#define SRTT_GAIN_SHIFT 3
+#define RTTVAR_GAIN_SHIFT 2
+#define RTTVAR_MULTIPLIER 4
+
+/* G of RFC 6298; SO_RCVTIMEO (and poll()) sleeps are no finer than a millisecond. */
+#define CLOCK_GRANULARITY_USEC 1000
+
+/* RTO moves less than 1/8 of itself are not applied; Spares a setsockopt() per ACK. */
+#define RTO_UPDATE_HYSTERESIS_SHIFT 3
+
+static status_t apply_rto(microtcp_sock_t *_socket, time_t _rto_usec);
+
+status_t rto_reset(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL);
+        _socket->srtt_usec = 0;
+        _socket->rttvar_usec = 0;
+        return apply_rto(_socket, timeval_to_usec(get_microtcp_ack_timeout()));
+}
+
+void rto_sample(microtcp_sock_t *const _socket, time_t _rtt_usec)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _rtt_usec >= 0);
+        _rtt_usec = MAX(_rtt_usec, 1); /* SRTT of 0 stands for "no sample yet". */
+        if (RARE_CASE(_socket->srtt_usec == 0))
+        {
+                _socket->srtt_usec = _rtt_usec;
+                _socket->rttvar_usec = _rtt_usec / 2;
+        }
+        else
+        {
+                const time_t deviation_usec = _socket->srtt_usec > _rtt_usec ? _socket->srtt_usec - _rtt_usec : _rtt_usec - _socket->srtt_usec;
+                _socket->rttvar_usec += (deviation_usec - _socket->rttvar_usec) / (1 << RTTVAR_GAIN_SHIFT);
+                _socket->srtt_usec += (_rtt_usec - _socket->srtt_usec) / (1 << SRTT_GAIN_SHIFT);
+        }
+
+        const time_t min_rto_usec = timeval_to_usec(get_microtcp_min_rto());
+        const time_t max_rto_usec = timeval_to_usec(get_microtcp_max_rto());
+        const time_t rto_usec = _socket->srtt_usec + MAX(CLOCK_GRANULARITY_USEC, RTTVAR_MULTIPLIER * _socket->rttvar_usec);
+        const time_t clamped_rto_usec = MIN(MAX(rto_usec, min_rto_usec), max_rto_usec);
+        const time_t rto_change_usec = clamped_rto_usec > _socket->rto_usec ? clamped_rto_usec - _socket->rto_usec
+                                                                            : _socket->rto_usec - clamped_rto_usec;
+        if (rto_change_usec > (_socket->rto_usec >> RTO_UPDATE_HYSTERESIS_SHIFT))
+                apply_rto(_socket, clamped_rto_usec);
+}
+
+/* Backoff never shrinks RTO; An initial one, configured above max, is kept. */
+void rto_backoff(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL);
+        const time_t max_rto_usec = timeval_to_usec(get_microtcp_max_rto());
+        const time_t backed_off_rto_usec = MAX(_socket->rto_usec, MIN(2 * _socket->rto_usec, max_rto_usec));
+        if (backed_off_rto_usec != _socket->rto_usec)
+                apply_rto(_socket, backed_off_rto_usec);
+}
+
+static status_t apply_rto(microtcp_sock_t *const _socket, const time_t _rto_usec)
+{
+        if (_socket->listener == NULL && /* Listener's receptions wait for `rto_usec` themselves; Descriptor's timeout is shared. */
+            set_socket_recvfrom_timeout(_socket, usec_to_timeval(_rto_usec)) == POSIX_SETSOCKOPT_FAILURE)
+                LOG_ERROR_RETURN(FAILURE, "Failed to set socket's timeout to RTO = %lld μsec.", (long long)_rto_usec);
+        _socket->rto_usec = _rto_usec;
+        return SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include "core/sack.h"
+#include <stddef.h>
+#include <stdint.h>
+#include "core/receive_ring_buffer.h"
+#include "microtcp.h"
+#include "smart_assert.h"
+
+#if SACK_SUPPORTED
+
+#define SACK_OFFSET_SHIFT 16
+#define SACK_FIELD_MASK 0xFFFFu
+
+void sack_encode(microtcp_header_t *const _header, const receive_ring_buffer_t *const _rrb)
+{
+        DEBUG_SMART_ASSERT(_header != NULL, _rrb != NULL);
+        rrb_block_t blocks[SACK_MAX_BLOCKS];
+        uint32_t words[SACK_MAX_BLOCKS] = {0};
+        const size_t block_count = rrb_out_of_order_blocks(_rrb, blocks, SACK_MAX_BLOCKS);
+        for (size_t i = 0; i < block_count; i++)
+        {
+                const uint32_t offset = blocks[i].seq_number - _header->ack_number;
+                if (offset == 0 || offset > SACK_FIELD_MASK || blocks[i].length > SACK_FIELD_MASK) /* Can't be told apart from "no block", or doesn't fit. */
+                        break;
+                words[i] = (offset << SACK_OFFSET_SHIFT) | blocks[i].length;
+        }
+        _header->future_use0 = words[0];
+        _header->future_use1 = words[1];
+        _header->future_use2 = words[2];
+}
+
+size_t sack_decode(const microtcp_header_t *const _header, rrb_block_t *const _blocks)
+{
+        DEBUG_SMART_ASSERT(_header != NULL, _blocks != NULL);
+        const uint32_t words[SACK_MAX_BLOCKS] = {_header->future_use0, _header->future_use1, _header->future_use2};
+        size_t block_count = 0;
+        for (size_t i = 0; i < SACK_MAX_BLOCKS && words[i] != 0; i++)
+        {
+                const uint32_t length = words[i] & SACK_FIELD_MASK;
+                if (length == 0)
+                        break;
+                _blocks[block_count++] = (rrb_block_t){.seq_number = _header->ack_number + (words[i] >> SACK_OFFSET_SHIFT), .length = length};
+        }
+        return block_count;
+}
+
+#else /* SACK_SUPPORTED */
+
+void sack_encode(microtcp_header_t *const _header, const receive_ring_buffer_t *const _rrb)
+{
+        (void)_header;
+        (void)_rrb;
+}
+
+size_t sack_decode(const microtcp_header_t *const _header, rrb_block_t *const _blocks)
+{
+        (void)_header;
+        (void)_blocks;
+        return 0;
+}
+
+#endif /* SACK_SUPPORTED */
@@ -1,8 +1,14 @@
 #include <errno.h>
+#include <poll.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <netinet/udp.h>
+#include "core/datagram_batch.h"
+#include "core/delayed_ack.h"
+#include "core/listener.h"
 #include "core/segment_io.h"
 #include "core/segment_processing.h"
 #include "logging/microtcp_logger.h"
@@ -20,8 +26,14 @@
 #include "microtcp_core_macros.h"
 #include "logging/microtcp_logger.h"
 
-static inline ssize_t receive_bytestream(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, int _recvfrom_flgas);
-static inline ssize_t receive_segment(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, uint16_t _required_control, _Bool _block);
+static inline ssize_t receive_bytestream(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, int _recvfrom_flgas,
+                                         _Bool _defer_checksum, void **_bytestream);
+static inline ssize_t fill_receive_batch(microtcp_sock_t *_socket, int _recvmmsg_flags);
+static inline size_t get_gro_segment_size(const struct msghdr *_message, size_t _datagram_length);
+static inline size_t coalesce_data_segments(microtcp_sock_t *_socket, size_t _first_slot);
+static inline void wait_for_send_space(const microtcp_sock_t *_socket, int _sendmmsg_errno, size_t _consecutive_errors);
+static inline ssize_t receive_segment(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, uint16_t _required_control,
+                                      _Bool _block, _Bool _defer_checksum);
 static inline ssize_t send_segment(microtcp_sock_t *_socket, const struct sockaddr *const _address, const socklen_t _address_len, microtcp_segment_t *_segment);
 static inline ssize_t send_control_segment(microtcp_sock_t *const _socket, const struct sockaddr *const _address, const socklen_t _address_len,
                                            uint16_t _control, microtcp_state_t _required_state);
@@ -31,6 +43,18 @@ static inline ssize_t send_control_segment(microtcp_sock_t *const _socket, const
 #define NO_RECVFROM_FLAGS 0
 
 #define MAX_CONSECUTIVE_SEND_MISMATCH_ERRORS 100
+#define SENDMSG_ERROR (-1)
+#define SENDMMSG_ERROR (-1)
+#define RECVMMSG_ERROR (-1)
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif /* UDP_SEGMENT */
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif /* UDP_GRO */
+#define UDP_MAX_GSO_SEGMENTS 64       /* Kernel's limit of segments in a single GSO super-datagram. */
+#define UDP_MAX_PAYLOAD_SIZE 65507    /* IPv4's limit of a UDP datagram's payload. */
 
 #define LOG_WARNING_RETURN_CONTROL_MISMATCH(_return_value, _received, _expected)                \
         LOG_WARNING_RETURN((_return_value), "Control-field: Received = `%s`; Expected = `%s`.", \
@@ -113,7 +137,7 @@ static inline ssize_t receive_control_segment(microtcp_sock_t *const _socket, st
         RETURN_ERROR_IF_SOCKADDR_INVALID(RECV_SEGMENT_FATAL_ERROR, _address);
         RETURN_ERROR_IF_SOCKET_ADDRESS_LENGTH_INVALID(RECV_SEGMENT_FATAL_ERROR, _address_len, sizeof(struct sockaddr));
 
-        ssize_t receive_segment_ret_val = receive_segment(_socket, _address, _address_len, _required_control, true);
+        ssize_t receive_segment_ret_val = receive_segment(_socket, _address, _address_len, _required_control, true, false);
         if (receive_segment_ret_val <= RECV_SEGMENT_EXCEPTION_THRESHOLD)
                 return receive_segment_ret_val;
         microtcp_segment_t *control_segment = _socket->segment_receive_buffer;
@@ -132,19 +156,38 @@ static inline ssize_t receive_control_segment(microtcp_sock_t *const _socket, st
         LOG_INFO_RETURN(receive_segment_ret_val, "%s segment received.", get_microtcp_control_to_string(_required_control));
 }
 
-/* Just receive a data segment, and pass it to the receive buffer... not your job to pass it to assembly. */
+ssize_t receive_handshake_segment(microtcp_sock_t *const _socket, struct sockaddr *const _address, const socklen_t _address_len, const _Bool _block)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(RECV_SEGMENT_FATAL_ERROR, _socket, LISTEN);
+        void *bytestream = NULL;
+        const ssize_t receive_bytestream_ret_val = receive_bytestream(_socket, _address, _address_len, _block ? 0 : MSG_DONTWAIT, false, &bytestream);
+        if (receive_bytestream_ret_val <= RECV_SEGMENT_EXCEPTION_THRESHOLD)
+                return receive_bytestream_ret_val;
+        extract_microtcp_segment(&_socket->segment_receive_buffer, bytestream, receive_bytestream_ret_val);
+#ifdef LOG_TRAFFIC_MODE
+        fprintf(_socket->inbound_traffic_log, "SQ=%u, AN=%u, SZ=%u\n", _socket->segment_receive_buffer->header.seq_number,
+                _socket->segment_receive_buffer->header.ack_number, _socket->segment_receive_buffer->header.data_len);
+#endif /* LOG_TRAFFIC_MODE */
+        return receive_bytestream_ret_val;
+}
+
+/* Just receive a data segment, and pass it to the receive buffer... not your job to pass it to assembly.
+ * Its checksum is NOT validated here; rrb_append() validates it while copying its payload. */
 ssize_t receive_data_segment(microtcp_sock_t *const _socket, const _Bool _block)
 {
 #ifdef DEBUG_MODE
         RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(RECV_SEGMENT_FATAL_ERROR, _socket, ESTABLISHED);
 #endif /* DEBUG_MODE */
-        ssize_t receive_segment_ret_val = receive_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address), DATA_SEGMENT_CONTROL_FLAGS, _block);
+        ssize_t receive_segment_ret_val = receive_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address), DATA_SEGMENT_CONTROL_FLAGS, _block, true);
         if (receive_segment_ret_val <= RECV_SEGMENT_EXCEPTION_THRESHOLD)
                 return receive_segment_ret_val;
 
         microtcp_segment_t *data_segment = _socket->segment_receive_buffer;
 
         DEBUG_SMART_ASSERT(receive_segment_ret_val >= (ssize_t)MICROTCP_HEADER_SIZE);
+        if (data_segment->header.data_len == 0) /* Would otherwise be mistaken for a timeout. */
+                LOG_INFO_RETURN(RECV_SEGMENT_ACK_RECEIVED, "%s segment received; ack_number = %u",
+                                get_microtcp_control_to_string(ACK_BIT), data_segment->header.ack_number);
 
         LOG_INFO_RETURN(data_segment->header.data_len, "data segment received; seq_number = %u, data_len = %u",
                         data_segment->header.seq_number, data_segment->header.data_len);
@@ -155,7 +198,7 @@ ssize_t receive_data_ack_segment(microtcp_sock_t *const _socket, const _Bool _bl
 #ifdef DEBUG_MODE
         RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(RECV_SEGMENT_FATAL_ERROR, _socket, ESTABLISHED);
 #endif /* DEBUG_MODE */
-        ssize_t receive_segment_ret_val = receive_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address), ACK_BIT, _block);
+        ssize_t receive_segment_ret_val = receive_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address), ACK_BIT, _block, false);
         if (receive_segment_ret_val <= RECV_SEGMENT_EXCEPTION_THRESHOLD)
                 return receive_segment_ret_val;
 
@@ -167,17 +210,29 @@ ssize_t receive_data_ack_segment(microtcp_sock_t *const _socket, const _Bool _bl
         LOG_INFO_RETURN(receive_segment_ret_val, "%s segment received.", get_microtcp_control_to_string(ACK_BIT));
 }
 
+/**
+ * @param _defer_checksum if set, a segment of `_required_control` carrying payload is handed out unvalidated;
+ * Its checksum is to be validated while its payload is copied (see rrb_append()). Any other segment is validated here.
+ */
 static inline ssize_t receive_segment(microtcp_sock_t *_socket, struct sockaddr *const _address, const socklen_t _address_len,
-                                      const uint16_t _required_control, const _Bool _block)
+                                      const uint16_t _required_control, const _Bool _block, const _Bool _defer_checksum)
 {
         const int recvfrom_flags = _block ? 0 : MSG_DONTWAIT;
-        ssize_t receive_bytestream_ret_val = receive_bytestream(_socket, _address, _address_len, recvfrom_flags);
+        void *bytestream = NULL;
+        ssize_t receive_bytestream_ret_val = receive_bytestream(_socket, _address, _address_len, recvfrom_flags, _defer_checksum, &bytestream);
         if (receive_bytestream_ret_val <= RECV_SEGMENT_EXCEPTION_THRESHOLD)
                 return receive_bytestream_ret_val;
 
-        extract_microtcp_segment(&_socket->segment_receive_buffer, _socket->bytestream_receive_buffer, receive_bytestream_ret_val);
+        extract_microtcp_segment(&_socket->segment_receive_buffer, bytestream, receive_bytestream_ret_val);
         microtcp_segment_t *segment = _socket->segment_receive_buffer;
         DEBUG_SMART_ASSERT(segment != NULL);
+        if (_defer_checksum)
+        {
+                const _Bool deferrable = segment->header.control == _required_control && segment->header.data_len > 0 &&
+                                         segment->header.data_len == receive_bytestream_ret_val - MICROTCP_HEADER_SIZE;
+                if (RARE_CASE(!deferrable) && !is_valid_microtcp_bytestream(bytestream, receive_bytestream_ret_val))
+                        LOG_WARNING_RETURN(RECV_SEGMENT_ERROR, "Received microtcp bytestream is corrupted.");
+        }
 #ifdef LOG_TRAFFIC_MODE
         fprintf(_socket->inbound_traffic_log, "SQ=%u, AN=%u, SZ=%u\n",
                 segment->header.seq_number, segment->header.ack_number, segment->header.data_len);
@@ -195,22 +250,90 @@ static inline ssize_t receive_segment(microtcp_sock_t *_socket, struct sockaddr
 }
 #undef LOG_WARNING_RETURN_CONTROL_MISMATCH
 
-static inline ssize_t receive_bytestream(microtcp_sock_t *_socket, struct sockaddr *const _address, socklen_t _address_len, int _recvfrom_flags)
+/**
+ * @brief Hands out the next datagram of socket's `receive_batch`. When every slot has been handed out,
+ * the batch is refilled with a single recvmmsg(), draining all datagrams pending in the socket.
+ * GRO coalesced datagrams are split back into their segments, one segment per call.
+ * @param _defer_checksum if set, bytestream's checksum is left for the caller to validate.
+ * @param _bytestream is set to the slot holding the datagram; It stays valid until the next reception.
+ */
+static inline ssize_t receive_bytestream(microtcp_sock_t *_socket, struct sockaddr *const _address, const socklen_t _address_len,
+                                         const int _recvfrom_flags, const _Bool _defer_checksum, void **const _bytestream)
+{
+        DEBUG_SMART_ASSERT(_socket->receive_batch != NULL, _address_len == sizeof(struct sockaddr));
+        if (db_pending_slots(_socket->receive_batch) == 0)
+        {
+                const ssize_t fill_ret_val = fill_receive_batch(_socket, _recvfrom_flags);
+                if (fill_ret_val <= RECV_SEGMENT_EXCEPTION_THRESHOLD)
+                        return fill_ret_val;
+        }
+        datagram_batch_t *const batch = _socket->receive_batch; /* Listener's sockets get a whole new batch filled. */
+
+        const size_t slot = batch->cursor;
+        const size_t datagram_length = batch->messages[slot].msg_len;
+        if (batch->slot_offset == 0)
+                batch->slot_stride = get_gro_segment_size(&batch->messages[slot].msg_hdr, datagram_length);
+        const ssize_t bytestream_length = MIN(batch->slot_stride, datagram_length - batch->slot_offset);
+        void *const bytestream_buffer = db_slot_bytestream(batch, slot) + batch->slot_offset;
+        batch->slot_offset += bytestream_length;
+        if (batch->slot_offset >= datagram_length) /* Slot exhausted, move to the next one. */
+        {
+                batch->cursor++;
+                batch->slot_offset = 0;
+        }
+
+        DEBUG_SMART_ASSERT(batch->messages[slot].msg_hdr.msg_namelen == sizeof(struct sockaddr));
+        DEBUG_SMART_ASSERT(datagram_length != RECVFROM_SHUTDOWN); /* Underlying protocol is UDP, this should be impossible. */
+        memcpy(_address, &batch->addresses[slot], _address_len);
+        if (RARE_CASE(bytestream_length < (ssize_t)MICROTCP_HEADER_SIZE || bytestream_length > (ssize_t)MICROTCP_MTU))
+                LOG_WARNING_RETURN(RECV_SEGMENT_ERROR, "Received bytestream of invalid length = %zd.", bytestream_length);
+        if (!_defer_checksum && !is_valid_microtcp_bytestream(bytestream_buffer, bytestream_length))
+                LOG_WARNING_RETURN(RECV_SEGMENT_ERROR, "Received microtcp bytestream is corrupted.");
+        update_socket_received_counters(_socket, bytestream_length);
+        *_bytestream = bytestream_buffer;
+        return bytestream_length;
+}
+
+/* @returns the size of segments GRO coalesced into this datagram; Or the datagram's length if it was not coalesced. */
+static inline size_t get_gro_segment_size(const struct msghdr *const _message, const size_t _datagram_length)
 {
-        void *const bytestream_buffer = _socket->bytestream_receive_buffer;
-        _recvfrom_flags |= MSG_TRUNC; /* Appending MSG_TRUNC flag, too catch large than MicroTCP allowed packets, and discard them. */
+        if (COMMON_CASE(_message->msg_controllen == 0) || (_message->msg_flags & MSG_TRUNC))
+                return _datagram_length;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(_message); cmsg != NULL; cmsg = CMSG_NXTHDR((struct msghdr *)_message, cmsg))
+        {
+                if (cmsg->cmsg_level != SOL_UDP || cmsg->cmsg_type != UDP_GRO)
+                        continue;
+                int gro_segment_size = 0;
+                memcpy(&gro_segment_size, CMSG_DATA(cmsg), sizeof(gro_segment_size));
+                if (gro_segment_size > 0)
+                        return MIN((size_t)gro_segment_size, _datagram_length);
+        }
+        return _datagram_length;
+}
 
-        ssize_t recvfrom_ret_val = recvfrom(_socket->sd, bytestream_buffer, MICROTCP_MTU, _recvfrom_flags, _address, &_address_len);
-        DEBUG_SMART_ASSERT(_address_len == sizeof(struct sockaddr));
-        DEBUG_SMART_ASSERT(recvfrom_ret_val != RECVFROM_SHUTDOWN); /* Underlying protocol is UDP, this should be impossible. */
-        if (recvfrom_ret_val == RECVFROM_ERROR && errno == EWOULDBLOCK)
+/**
+ * @returns the number of datagrams drained from the socket, or RECV_SEGMENT_TIMEOUT/RECV_SEGMENT_FATAL_ERROR.
+ * @note Blocking receptions wait (up to the SO_RCVTIMEO timeout) only for the first datagram; Whatever else
+ * is already queued in the socket comes along, up to the batch's capacity. Listener's sockets wait up to their RTO.
+ */
+static inline ssize_t fill_receive_batch(microtcp_sock_t *const _socket, int _recvmmsg_flags)
+{
+        datagram_batch_t *const batch = _socket->receive_batch;
+        _recvmmsg_flags |= MSG_TRUNC; /* Appending MSG_TRUNC flag, too catch large than MicroTCP allowed packets, and discard them. */
+        if (!(_recvmmsg_flags & MSG_DONTWAIT))
+                _recvmmsg_flags |= MSG_WAITFORONE;
+
+        if (_socket->listener != NULL) /* Descriptor is shared; Listener demultiplexes it. */
+                return listener_receive(_socket, (_recvmmsg_flags & MSG_DONTWAIT) ? 0 : _socket->rto_usec);
+        db_flush(batch);
+        db_prepare_reception(batch);
+        const int recvmmsg_ret_val = recvmmsg(_socket->sd, batch->messages, batch->capacity, _recvmmsg_flags, NULL);
+        if (recvmmsg_ret_val == RECVMMSG_ERROR && (errno == EWOULDBLOCK || errno == EAGAIN))
                 return RECV_SEGMENT_TIMEOUT;
-        if (RARE_CASE(recvfrom_ret_val == RECVFROM_ERROR))
-                LOG_ERROR_RETURN(RECV_SEGMENT_FATAL_ERROR, "Receiving segment failed; recvfrom() set errno(%d):%s.", recvfrom_ret_val, errno, strerror(errno));
-        if (!is_valid_microtcp_bytestream(bytestream_buffer, recvfrom_ret_val))
-                LOG_WARNING_RETURN(RECV_SEGMENT_ERROR, "Received microtcp bytestream is corrupted.");
-        update_socket_received_counters(_socket, recvfrom_ret_val);
-        return recvfrom_ret_val;
+        if (RARE_CASE(recvmmsg_ret_val == RECVMMSG_ERROR))
+                LOG_ERROR_RETURN(RECV_SEGMENT_FATAL_ERROR, "Receiving segments failed; recvmmsg() set errno(%d):%s.", errno, strerror(errno));
+        batch->count = recvmmsg_ret_val;
+        return recvmmsg_ret_val;
 }
 
 size_t send_data_segment(microtcp_sock_t *const _socket, const void *const _buffer, const size_t _segment_size, const uint32_t _seq_number)
@@ -228,6 +351,155 @@ size_t send_data_segment(microtcp_sock_t *const _socket, const void *const _buff
         return send_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address), data_segment);
 }
 
+ssize_t queue_data_segment(microtcp_sock_t *const _socket, const void *const _buffer, const size_t _segment_size, const uint32_t _seq_number)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _buffer != NULL, _segment_size > 0);
+#ifdef DEBUG_MODE
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(SEND_SEGMENT_FATAL_ERROR, _socket, ESTABLISHED);
+#endif /* DEBUG_MODE */
+        datagram_batch_t *const batch = _socket->send_batch;
+        DEBUG_SMART_ASSERT(batch != NULL);
+        if (db_is_full(batch) && flush_data_segments(_socket) == SEND_SEGMENT_FATAL_ERROR)
+                return SEND_SEGMENT_FATAL_ERROR;
+
+        const microtcp_payload_t payload = {.raw_bytes = (uint8_t *)_buffer, .size = _segment_size};
+        microtcp_segment_t *data_segment = construct_microtcp_segment(_socket, _seq_number, DATA_SEGMENT_CONTROL_FLAGS, payload);
+        DEBUG_SMART_ASSERT(data_segment != NULL); /* If socket is properly initialized, assert should never fail. */
+
+        const size_t slot = batch->count++;
+        serialize_microtcp_segment(data_segment, db_slot_bytestream(batch, slot), db_slot_iovecs(batch, slot));
+        batch->messages[slot].msg_hdr.msg_namelen = sizeof(*_socket->peer_address);
+        memcpy(&batch->addresses[slot], _socket->peer_address, sizeof(*_socket->peer_address));
+        return MICROTCP_HEADER_SIZE + _segment_size;
+}
+
+ssize_t flush_data_segments(microtcp_sock_t *const _socket)
+{
+        size_t consecutive_sendmmsg_errors = 0;
+        datagram_batch_t *const batch = _socket->send_batch;
+        DEBUG_SMART_ASSERT(batch != NULL);
+
+        ssize_t flushed_bytes = 0;
+        size_t flushed_segments = 0;
+        while (flushed_segments < batch->count)
+        {
+                const _Bool udp_offload = _socket->udp_offload;
+                struct mmsghdr *const messages = udp_offload ? batch->coalesced_messages : batch->messages + flushed_segments;
+                const size_t message_count = udp_offload ? coalesce_data_segments(_socket, flushed_segments) : batch->count - flushed_segments;
+                int sendmmsg_ret_val = sendmmsg(_socket->sd, messages, message_count, NO_SENDTO_FLAGS);
+                if (RARE_CASE(sendmmsg_ret_val == SENDMMSG_ERROR))
+                {
+                        if (udp_offload && (errno == EIO || errno == EINVAL || errno == EOPNOTSUPP || errno == ENOPROTOOPT))
+                        {
+                                LOG_WARNING("UDP GSO rejected by kernel; errno(%d):%s. Socket falls back to non-offloaded sends.", errno, strerror(errno));
+                                _socket->udp_offload = false;
+                                continue;
+                        }
+                        if (errno != EINTR && errno != ENOBUFS && errno != EAGAIN)
+                        {
+                                db_flush(batch);
+                                LOG_ERROR_RETURN(SEND_SEGMENT_FATAL_ERROR, "Sending DATA segments failed. sendmmsg() set errno(%d):%s.", errno, strerror(errno));
+                        }
+                        wait_for_send_space(_socket, errno, consecutive_sendmmsg_errors);
+                        sendmmsg_ret_val = 0;
+                }
+                for (int i = 0; i < sendmmsg_ret_val; i++)
+                {
+                        const struct msghdr *const message = &messages[i].msg_hdr;
+                        const size_t message_segments = message->msg_iovlen / batch->slot_iovecs;
+                        size_t message_length = 0;
+                        for (size_t j = 0; j < message_segments; j++)
+                                message_length += db_slot_length(batch, flushed_segments + j);
+                        if (RARE_CASE(messages[i].msg_len != message_length))
+                        {
+                                LOG_ERROR("Sending DATA segment failed; sendmmsg() sent %u bytes, microtcp_segment was %zu bytes",
+                                          messages[i].msg_len, message_length);
+                                sendmmsg_ret_val = i; /* Resend from the mismatched segment. */
+                                break;
+                        }
+                        for (size_t j = 0; j < message_segments; j++) /* Each slot is a segment (even in a GSO super-datagram). */
+                        {
+                                update_socket_sent_counters(_socket, db_slot_length(batch, flushed_segments + j));
+#ifdef LOG_TRAFFIC_MODE
+                                const microtcp_header_t *header = (const microtcp_header_t *)db_slot_bytestream(batch, flushed_segments + j);
+                                fprintf(_socket->outbound_traffic_log, "SN=%u, AN=%u, DL=%u\n",
+                                        header->seq_number, header->ack_number, header->data_len);
+#endif /* LOG_TRAFFIC_MODE */
+                        }
+                        flushed_segments += message_segments;
+                        flushed_bytes += messages[i].msg_len;
+                }
+                if (COMMON_CASE(sendmmsg_ret_val > 0))
+                        consecutive_sendmmsg_errors = 0;
+                else if (++consecutive_sendmmsg_errors > MAX_CONSECUTIVE_SEND_MISMATCH_ERRORS)
+                {
+                        db_flush(batch);
+                        LOG_ERROR_RETURN(SEND_SEGMENT_FATAL_ERROR, "Max consecutive send mismatch errors reached.");
+                }
+        }
+        if (flushed_segments > 0) /* Data segments piggyback our ACK; The last one covers any ACK we delayed. */
+                delayed_ack_on_ack_sent(_socket, (const microtcp_header_t *)db_slot_bytestream(batch, flushed_segments - 1));
+        db_flush(batch);
+        LOG_INFO_RETURN(flushed_bytes, "%zu DATA segments flushed.", flushed_segments);
+}
+
+/**
+ * @brief Socket's send buffer (EAGAIN) or device's queue (ENOBUFS) is full; Retrying at once would only spin.
+ * EAGAIN waits for POLLOUT, ENOBUFS (which POLLOUT does not track) backs off; Both for up to a delay that doubles per consecutive error, up to 16ms.
+ */
+static inline void wait_for_send_space(const microtcp_sock_t *const _socket, const int _sendmmsg_errno, const size_t _consecutive_errors)
+{
+        if (_sendmmsg_errno == EINTR)
+                return;
+        const int backoff_msec = 1 << MIN(_consecutive_errors, 4);
+        struct pollfd send_space = {.fd = _socket->sd, .events = POLLOUT};
+        poll(&send_space, _sendmmsg_errno == EAGAIN ? 1 : 0, backoff_msec);
+}
+
+/**
+ * @brief Packs queued segments (starting from `_first_slot`) into UDP GSO super-datagrams, in batch's `coalesced_messages`.
+ * A super-datagram holds consecutive segments of equal size; Only its last segment may be shorter.
+ * Kernel (or NIC) splits it back into `gso_size` datagrams, so peer receives ordinary segments.
+ * @returns the number of super-datagrams prepared.
+ */
+static inline size_t coalesce_data_segments(microtcp_sock_t *const _socket, const size_t _first_slot)
+{
+        datagram_batch_t *const batch = _socket->send_batch;
+        size_t super_datagrams = 0;
+        for (size_t first = _first_slot; first < batch->count; super_datagrams++)
+        {
+                const size_t gso_size = db_slot_length(batch, first);
+                size_t segments = 1;
+                size_t super_datagram_size = gso_size;
+                while (first + segments < batch->count &&
+                       segments < UDP_MAX_GSO_SEGMENTS &&
+                       db_slot_length(batch, first + segments - 1) == gso_size && /* Only the last segment can be shorter. */
+                       db_slot_length(batch, first + segments) <= gso_size &&
+                       super_datagram_size + db_slot_length(batch, first + segments) <= UDP_MAX_PAYLOAD_SIZE)
+                        super_datagram_size += db_slot_length(batch, first + segments++);
+
+                /* Slots' iovecs are contiguous; Kernel splits the gathered bytes by `gso_size`, regardless of iovec boundaries. */
+                struct msghdr *const message = &batch->coalesced_messages[super_datagrams].msg_hdr;
+                *message = (struct msghdr){.msg_name = _socket->peer_address,
+                                           .msg_namelen = sizeof(*_socket->peer_address),
+                                           .msg_iov = db_slot_iovecs(batch, first),
+                                           .msg_iovlen = segments * batch->slot_iovecs};
+                if (segments > 1)
+                {
+                        message->msg_control = db_slot_control(batch, super_datagrams);
+                        message->msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                        struct cmsghdr *cmsg = CMSG_FIRSTHDR(message);
+                        cmsg->cmsg_level = SOL_UDP;
+                        cmsg->cmsg_type = UDP_SEGMENT;
+                        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                        const uint16_t segment_size = gso_size;
+                        memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+                }
+                first += segments;
+        }
+        return super_datagrams;
+}
+
 static inline ssize_t send_control_segment(microtcp_sock_t *const _socket, const struct sockaddr *const _address,
                                            const socklen_t _address_len, uint16_t _control, microtcp_state_t _required_state)
 {
@@ -246,36 +518,40 @@ static inline ssize_t send_control_segment(microtcp_sock_t *const _socket, const
 
 static inline ssize_t send_segment(microtcp_sock_t *_socket, const struct sockaddr *const _address, const socklen_t _address_len, microtcp_segment_t *_segment)
 {
-        static _Thread_local size_t consecutive_sendto_errors = 0;
+        static _Thread_local size_t consecutive_sendmsg_errors = 0;
         DEBUG_SMART_ASSERT(_socket != NULL, _address != NULL, _address_len == sizeof(struct sockaddr), _segment != NULL);
 
-        /* Convert it to bytestream. */
-        void *const bytestream_buffer = serialize_microtcp_segment(_socket, _segment);
-        DEBUG_SMART_ASSERT(bytestream_buffer != NULL); /* If socket is properly initialized, assert should never fail. */
-
-        const ssize_t segment_length = sizeof(_segment->header) + _segment->header.data_len;
-        const ssize_t sendto_ret_val = sendto(_socket->sd, bytestream_buffer, segment_length, NO_SENDTO_FLAGS, _address, _address_len);
+        /* Serialize header into socket's header slot; Payload is gathered from where it lies (zero-copy). */
+        struct iovec iovecs[MICROTCP_SEGMENT_IOVECS];
+        const ssize_t segment_length = serialize_microtcp_segment(_segment, _socket->header_build_buffer, iovecs);
+        const struct msghdr message = {.msg_name = (struct sockaddr *)_address,
+                                       .msg_namelen = _address_len,
+                                       .msg_iov = iovecs,
+                                       .msg_iovlen = MICROTCP_SEGMENT_IOVECS};
+        const ssize_t sendmsg_ret_val = sendmsg(_socket->sd, &message, NO_SENDTO_FLAGS);
 
         const char *segment_type = (_segment->header.data_len > 0 ? "DATA" : get_microtcp_control_to_string(_segment->header.control));
 
         /* Log operation's outcome. */
-        if (RARE_CASE(sendto_ret_val == SENDTO_ERROR))
-                LOG_ERROR_RETURN(SEND_SEGMENT_FATAL_ERROR, "Sending %s segment failed. sendto() set errno(%d):%s.",
+        if (RARE_CASE(sendmsg_ret_val == SENDMSG_ERROR))
+                LOG_ERROR_RETURN(SEND_SEGMENT_FATAL_ERROR, "Sending %s segment failed. sendmsg() set errno(%d):%s.",
                                  segment_type, errno, strerror(errno));
-        if (RARE_CASE(sendto_ret_val != segment_length))
+        if (RARE_CASE(sendmsg_ret_val != segment_length))
         {
-                LOG_ERROR("Sending %s segment failed; sendto() sent %d bytes, microtcp_segment was %d bytes",
-                          segment_type, sendto_ret_val, segment_length);
-                consecutive_sendto_errors++;
-                if (consecutive_sendto_errors > MAX_CONSECUTIVE_SEND_MISMATCH_ERRORS)
+                LOG_ERROR("Sending %s segment failed; sendmsg() sent %zd bytes, microtcp_segment was %zd bytes",
+                          segment_type, sendmsg_ret_val, segment_length);
+                consecutive_sendmsg_errors++;
+                if (consecutive_sendmsg_errors > MAX_CONSECUTIVE_SEND_MISMATCH_ERRORS)
                         LOG_ERROR_RETURN(SEND_SEGMENT_FATAL_ERROR, "Max consecutive send mismatch errors reached.");
                 return SEND_SEGMENT_ERROR;
         }
-        consecutive_sendto_errors = 0;
-        update_socket_sent_counters(_socket, sendto_ret_val);
+        consecutive_sendmsg_errors = 0;
+        update_socket_sent_counters(_socket, sendmsg_ret_val);
+        if (_segment->header.control & ACK_BIT) /* Pure or piggybacked, it covers any ACK we delayed. */
+                delayed_ack_on_ack_sent(_socket, &_segment->header);
 #ifdef LOG_TRAFFIC_MODE
         fprintf(_socket->outbound_traffic_log, "SN=%u, AN=%u, DL=%u\n",
                 _segment->header.seq_number, _segment->header.ack_number, _segment->header.data_len);
 #endif /* LOG_TRAFFIC_MODE */
-        LOG_INFO_RETURN(sendto_ret_val, "%s segment sent.", segment_type);
+        LOG_INFO_RETURN(sendmsg_ret_val, "%s segment sent.", segment_type);
 }
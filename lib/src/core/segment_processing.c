@@ -1,5 +1,6 @@
 #include "core/segment_processing.h"
 #include <string.h>
+#include "core/sack.h"
 #include "crc32.h"
 #include "logging/microtcp_logger.h"
 #include "microtcp.h"
@@ -28,22 +29,29 @@ microtcp_segment_t *construct_microtcp_segment(microtcp_sock_t *_socket, uint32_
         new_segment->header.future_use1 = 0;
         new_segment->header.future_use2 = 0;
 #endif /* OPTIMIZED_MODE */
+        if (_socket->sack && _payload.size == 0 && (_control & ACK_BIT) && _socket->bytestream_rrb != NULL) /* Pure ACKs report the blocks past a gap. */
+                sack_encode(&new_segment->header, _socket->bytestream_rrb);
 
         new_segment->header.checksum = 0; /* CRC32 checksum is calculated after linearizing this packet. */
 
         /* Set the payload pointer. We do not do deep copy, to avoid wasting memory.
-         * MicroTCP will have to create a bitstream, where header and payload will have
-         * to be compacted together. In that case deep copying is unavoidable.
+         * Serialization does not linearize the segment either; Header and payload
+         * are handed to sendmsg() as separate iovecs (scatter-gather).
          */
         new_segment->raw_payload_bytes = _payload.raw_bytes;
 
         return new_segment;
 }
 
-void *serialize_microtcp_segment(microtcp_sock_t *const _socket, microtcp_segment_t *const _segment)
+/**
+ * @brief Serializes `_segment` without linearizing it: Header is copied into `_header_buffer` (MICROTCP_HEADER_SIZE bytes,
+ * socket's `header_build_buffer` or a send batch slot), payload is left in place (user's buffer).
+ * `_iovecs` (MICROTCP_SEGMENT_IOVECS entries) are set to point to both pieces, ready for sendmsg()/sendmmsg().
+ * @returns the length of the serialized segment (header + payload).
+ */
+size_t serialize_microtcp_segment(microtcp_segment_t *const _segment, void *const _header_buffer, struct iovec *const _iovecs)
 {
-        SMART_ASSERT(_socket != NULL, _segment != NULL);
-        SMART_ASSERT(_socket->bytestream_build_buffer);
+        SMART_ASSERT(_segment != NULL, _header_buffer != NULL, _iovecs != NULL);
 
         if (_segment->header.checksum != 0)
         {
@@ -52,21 +60,20 @@ void *serialize_microtcp_segment(microtcp_sock_t *const _socket, microtcp_segmen
         }
 
         const uint16_t payload_length = _segment->header.data_len;
+        memcpy(_header_buffer, &(_segment->header), MICROTCP_HEADER_SIZE);
 
-        const uint16_t bytestream_buffer_length = MICROTCP_HEADER_SIZE + payload_length;
-        void *bytestream_buffer = _socket->bytestream_build_buffer;
-
-        memcpy(bytestream_buffer, &(_segment->header), MICROTCP_HEADER_SIZE);
-        if (payload_length > 0) /* Its techinically Undefined Behavior if length = 0. */
-                memcpy((uint8_t *)bytestream_buffer + MICROTCP_HEADER_SIZE, _segment->raw_payload_bytes, payload_length);
-
-        /* Calculate crc32 checksum: */
-        const uint32_t checksum_result = crc32(bytestream_buffer, bytestream_buffer_length);
+        /* Calculate crc32 checksum progressively, across header and payload; Same result as over a linearized bytestream. */
+        uint32_t checksum_result = update_crc32(0xffffffff, _header_buffer, MICROTCP_HEADER_SIZE);
+        if (payload_length > 0)
+                checksum_result = update_crc32(checksum_result, _segment->raw_payload_bytes, payload_length);
+        checksum_result ^= 0xffffffff;
 
         /* Implant the CRC checksum. */
-        ((microtcp_header_t *)bytestream_buffer)->checksum = checksum_result;
+        ((microtcp_header_t *)_header_buffer)->checksum = checksum_result;
 
-        return bytestream_buffer;
+        _iovecs[0] = (struct iovec){.iov_base = _header_buffer, .iov_len = MICROTCP_HEADER_SIZE};
+        _iovecs[1] = (struct iovec){.iov_base = _segment->raw_payload_bytes, .iov_len = payload_length};
+        return MICROTCP_HEADER_SIZE + payload_length;
 }
 
 _Bool is_valid_microtcp_bytestream(void *_bytestream_buffer, const ssize_t _bytestream_length)
@@ -86,6 +93,21 @@ _Bool is_valid_microtcp_bytestream(void *_bytestream_buffer, const ssize_t _byte
         return calculated_checksum == extracted_checksum;
 }
 
+uint32_t begin_microtcp_checksum(const microtcp_header_t *const _header)
+{
+        DEBUG_SMART_ASSERT(_header != NULL);
+        microtcp_header_t zeroed_header;
+        memcpy(&zeroed_header, _header, MICROTCP_HEADER_SIZE);
+        zeroed_header.checksum = 0; /* Checksum was calculated with a zeroed checksum field. */
+        return update_crc32(0xffffffff, (const uint8_t *)&zeroed_header, MICROTCP_HEADER_SIZE);
+}
+
+_Bool end_microtcp_checksum(const microtcp_header_t *const _header, const uint32_t _running_crc)
+{
+        DEBUG_SMART_ASSERT(_header != NULL);
+        return (_running_crc ^ 0xffffffff) == _header->checksum;
+}
+
 void extract_microtcp_segment(microtcp_segment_t **_segment_buffer, void *_bytestream_buffer, size_t _bytestream_buffer_length)
 {
 
@@ -1,31 +1,49 @@
 #include <stdint.h>
 #include "core/send_queue.h"
-#include "core/segment_io.h"
 #include "allocator/allocator_macros.h"
 #include "microtcp_defines.h"
+#include "microtcp_helper_macros.h"
 #include "microtcp.h"
 #include "smart_assert.h"
-#include <pthread.h>
-#include <errno.h>
 
+/**
+ * @brief Circular array of segment descriptors, preallocated for a whole window of MSS sized segments.
+ * Slots `front` .. `front + stored_segments - 1` (modulo `capacity`) hold consecutive segments, in sequence number order.
+ */
 struct send_queue
 {
-        send_queue_node_t *front;
-        send_queue_node_t *rear;
+        send_queue_node_t *nodes;
+        size_t capacity; /* Power of 2, so slot indices wrap with a mask. */
+        size_t front;
         size_t stored_segments;
         size_t stored_bytes;
-        /* TODO Remove: Added for debugging. */
-        // FILE *send_packets_info;
 };
 
-send_queue_t *sq_create(void)
+static inline send_queue_node_t *node_at(const send_queue_t *_sq, size_t _index);
+static inline uint32_t node_ack_number(const send_queue_node_t *_node);
+static size_t find_acked_index(const send_queue_t *_sq, uint32_t _ack_number);
+
+#define ACKED_INDEX_NOT_FOUND SIZE_MAX
+
+send_queue_t *sq_create(const size_t _max_window_size)
 {
         send_queue_t *sq = MALLOC_LOG(sq, sizeof(send_queue_t));
-        sq->front = NULL;
-        sq->rear = NULL;
+        if (sq == NULL)
+                return NULL;
+
+        size_t capacity = 1;
+        while (capacity * MICROTCP_MSS < _max_window_size)
+                capacity <<= 1;
+        sq->nodes = MALLOC_LOG(sq->nodes, capacity * sizeof(send_queue_node_t));
+        if (sq->nodes == NULL)
+        {
+                FREE_NULLIFY_LOG(sq);
+                return NULL;
+        }
+        sq->capacity = capacity;
+        sq->front = 0;
         sq->stored_segments = 0;
         sq->stored_bytes = 0;
-        // sq->send_packets_info = fopen("__SENT_PACKETS__.txt","w");
         return sq;
 }
 
@@ -37,92 +55,69 @@ status_t sq_destroy(send_queue_t **const _sq_address)
         if (SQ == NULL)
                 return SUCCESS;
 
-        send_queue_node_t *curr_node = SQ->front;
-        if (SQ->front != NULL)
+        if (SQ->stored_segments != 0)
                 LOG_ERROR("For correct protocol function Send-Queue should be empty when passed to `%s`", __func__);
-        while (curr_node != NULL)
-        {
-                send_queue_node_t *next = curr_node->next;
-                FREE_NULLIFY_LOG(curr_node);
-                curr_node = next;
-        }
+        FREE_NULLIFY_LOG(SQ->nodes);
         FREE_NULLIFY_LOG(SQ);
-        // fclose(SQ->send_packets_info);
         return SUCCESS;
 #undef SQ
 }
 
 void sq_enqueue(send_queue_t *const _sq, const uint32_t _seq_number, const uint32_t _segment_size, const void *_buffer)
 {
-        DEBUG_SMART_ASSERT(_sq != NULL, _segment_size > 0, _buffer != NULL);
-        DEBUG_SMART_ASSERT((_sq->front == NULL && _sq->rear == NULL) || (_sq->front != NULL && _sq->rear != NULL));
-        send_queue_node_t *new_node = MALLOC_LOG(new_node, sizeof(send_queue_node_t));
+        DEBUG_SMART_ASSERT(_sq != NULL, _segment_size > 0, _buffer != NULL, !sq_is_full(_sq));
+        DEBUG_SMART_ASSERT(_sq->stored_segments == 0 || node_ack_number(node_at(_sq, _sq->stored_segments - 1)) == _seq_number);
+        send_queue_node_t *new_node = node_at(_sq, _sq->stored_segments);
         new_node->seq_number = _seq_number;
         new_node->segment_size = _segment_size;
         new_node->buffer = _buffer;
-        new_node->next = NULL;
-        if (_sq->front == NULL)
-
-                _sq->front = _sq->rear = new_node;
-        else
-                _sq->rear = _sq->rear->next = new_node;
-        DEBUG_SMART_ASSERT(_sq->rear != NULL && _sq->rear->next == NULL);
+        new_node->retransmitted = false;
+        new_node->sacked = false;
         _sq->stored_segments++;
         _sq->stored_bytes += _segment_size;
-        // fprintf(_sq->send_packets_info,"sn: %u, sz: %u\n", _seq_number, _segment_size);
 }
 
 /**
+ * @param _last_acked_node if not NULL, receives a copy of the newest dequeued node (e.g. for RTT sampling).
  * @returns number of dequeued nodes.
  */
-size_t sq_dequeue(send_queue_t *const _sq, const uint32_t _ack_number)
+size_t sq_dequeue(send_queue_t *const _sq, const uint32_t _ack_number, send_queue_node_t *const _last_acked_node)
 {
         DEBUG_SMART_ASSERT(_sq != NULL);
-        DEBUG_SMART_ASSERT((_sq->front == NULL && _sq->rear == NULL) || (_sq->front != NULL && _sq->rear != NULL));
         size_t dequeued_node_counter = 0;
 
-        if (_sq->front == NULL)
+        if (_sq->stored_segments == 0)
                 LOG_ERROR_RETURN(dequeued_node_counter, "Send-Queue is empty, dequeuing impossible.");
 
-        /* Find requested node */
-        send_queue_node_t *curr_node = _sq->front;
-        while (curr_node != NULL && curr_node->seq_number + curr_node->segment_size != _ack_number)
-                curr_node = curr_node->next;
+        /* Find requested node. */
+        const size_t acked_index = find_acked_index(_sq, _ack_number);
 
         /* Not FOUND! Probably ACK for old packet (already acked). Usually occur in timeouts. */
-        if (curr_node == NULL)
+        if (acked_index == ACKED_INDEX_NOT_FOUND)
                 LOG_WARNING_RETURN(dequeued_node_counter, "No match for ACK number = %u (old/duplicate ACK).", _ack_number);
 
-        /* ACK number matched. */
-        while (true)
-        {
-                uint32_t calculated_ack_number = _sq->front->seq_number + _sq->front->segment_size;
-                send_queue_node_t *old_front = _sq->front;
-                _sq->stored_segments--;
-                _sq->stored_bytes -= _sq->front->segment_size;
-                _sq->front = _sq->front->next;
-                FREE_NULLIFY_LOG(old_front);
-                dequeued_node_counter++;
-
-                if (calculated_ack_number == _ack_number)
-                        break;
-                DEBUG_SMART_ASSERT(_sq->front != NULL); /* If in this while loop, means we found the node; If assert fails something went very wrong... */
-        }
-        if (_sq->front == NULL)
-                _sq->rear = NULL;
+        /* ACK number matched; Segments are consecutive, so acked bytes are the distance between sequence numbers. */
+        dequeued_node_counter = acked_index + 1;
+        if (_last_acked_node != NULL)
+                *_last_acked_node = *node_at(_sq, acked_index);
+        _sq->stored_bytes -= _ack_number - node_at(_sq, 0)->seq_number;
+        _sq->stored_segments -= dequeued_node_counter;
+        _sq->front = (_sq->front + dequeued_node_counter) & (_sq->capacity - 1);
         return dequeued_node_counter;
 }
 
 void sq_flush(send_queue_t *const _sq)
 {
         DEBUG_SMART_ASSERT(_sq != NULL);
-        if (_sq->front == NULL)
-                return;
-        sq_dequeue(_sq, _sq->rear->seq_number + _sq->rear->segment_size);
-        DEBUG_SMART_ASSERT(_sq->front == NULL,
-                           _sq->rear == NULL,
-                           _sq->stored_bytes == 0,
-                           _sq->stored_segments == 0);
+        _sq->front = 0;
+        _sq->stored_segments = 0;
+        _sq->stored_bytes = 0;
+}
+
+size_t sq_capacity(send_queue_t *const _sq)
+{
+        DEBUG_SMART_ASSERT(_sq != NULL);
+        return _sq->capacity;
 }
 
 size_t sq_stored_segments(send_queue_t *const _sq)
@@ -140,11 +135,114 @@ size_t sq_stored_bytes(send_queue_t *const _sq)
 _Bool sq_is_empty(send_queue_t *const _sq)
 {
         DEBUG_SMART_ASSERT(_sq != NULL);
-        return _sq->front == NULL;
+        return _sq->stored_segments == 0;
+}
+
+_Bool sq_is_full(send_queue_t *const _sq)
+{
+        DEBUG_SMART_ASSERT(_sq != NULL);
+        return _sq->stored_segments == _sq->capacity;
 }
 
 send_queue_node_t *sq_front(send_queue_t *const _sq)
 {
         DEBUG_SMART_ASSERT(_sq != NULL);
-        return _sq->front;
+        return _sq->stored_segments == 0 ? NULL : node_at(_sq, 0);
+}
+
+/**
+ * @brief Segments carry at most MICROTCP_MSS bytes, so `_seq_number`'s segment is at least its distance from front, over MSS;
+ * Search starts there and moves forward.
+ * @returns index of the first stored segment not lying entirely before `_seq_number`; Stored segments' count, if none.
+ */
+size_t sq_find_index(send_queue_t *const _sq, const uint32_t _seq_number)
+{
+        DEBUG_SMART_ASSERT(_sq != NULL);
+        if (_sq->stored_segments == 0)
+                return 0;
+        const uint32_t front_seq_number = node_at(_sq, 0)->seq_number;
+        const int32_t offset = (int32_t)(_seq_number - front_seq_number);
+        if (offset <= 0)
+                return 0;
+        if ((uint32_t)offset >= _sq->stored_bytes)
+                return _sq->stored_segments;
+        size_t index = (size_t)offset / MICROTCP_MSS;
+        while ((int32_t)(node_ack_number(node_at(_sq, index)) - front_seq_number) <= offset)
+                index++;
+        return index;
+}
+
+/**
+ * @brief Marks stored segments lying entirely within [`_seq_number`, `_seq_number` + `_length`) as SACKed.
+ * @returns number of segments marked (newly or not).
+ */
+size_t sq_mark_sacked(send_queue_t *const _sq, const uint32_t _seq_number, const uint32_t _length)
+{
+        DEBUG_SMART_ASSERT(_sq != NULL);
+        const uint32_t block_end = _seq_number + _length;
+        size_t sacked_segments = 0;
+        for (size_t index = sq_find_index(_sq, _seq_number); index < _sq->stored_segments; index++)
+        {
+                send_queue_node_t *const node = node_at(_sq, index);
+                if ((int32_t)(node_ack_number(node) - block_end) > 0)
+                        break;
+                if ((int32_t)(node->seq_number - _seq_number) >= 0)
+                {
+                        node->sacked = true;
+                        sacked_segments++;
+                }
+        }
+        return sacked_segments;
+}
+
+/* @returns the `_index`-th stored node (0 is the front), or NULL past the rear. */
+send_queue_node_t *sq_get(send_queue_t *const _sq, const size_t _index)
+{
+        DEBUG_SMART_ASSERT(_sq != NULL);
+        return _index >= _sq->stored_segments ? NULL : node_at(_sq, _index);
+}
+
+static inline send_queue_node_t *node_at(const send_queue_t *const _sq, const size_t _index)
+{
+        return &_sq->nodes[(_sq->front + _index) & (_sq->capacity - 1)];
+}
+
+static inline uint32_t node_ack_number(const send_queue_node_t *const _node)
+{
+        return _node->seq_number + _node->segment_size;
+}
+
+/**
+ * @brief Maps `_ack_number` to the stored segment it acknowledges (the one ending on it).
+ * Every segment but the last of a round carries MICROTCP_MSS bytes, so the slot is computed arithmetically;
+ * Should the guess miss, a binary search over the (sorted) sequence numbers is the fallback.
+ * @returns index relative to front, or ACKED_INDEX_NOT_FOUND.
+ */
+static size_t find_acked_index(const send_queue_t *const _sq, const uint32_t _ack_number)
+{
+        /* Offsets from front's sequence number; Unsigned arithmetic takes care of wrap-around. */
+        const uint32_t acked_bytes = _ack_number - node_at(_sq, 0)->seq_number;
+        if (acked_bytes == 0 || acked_bytes > _sq->stored_bytes)
+                return ACKED_INDEX_NOT_FOUND;
+
+        const size_t guess = MIN((acked_bytes - 1) / MICROTCP_MSS, _sq->stored_segments - 1);
+        if (COMMON_CASE(node_ack_number(node_at(_sq, guess)) == _ack_number))
+                return guess;
+
+        size_t low = 0;
+        size_t high = _sq->stored_segments - 1;
+        while (low <= high)
+        {
+                const size_t middle = low + (high - low) / 2;
+                const uint32_t middle_acked_bytes = node_ack_number(node_at(_sq, middle)) - node_at(_sq, 0)->seq_number;
+                if (middle_acked_bytes == acked_bytes)
+                        return middle;
+                if (middle_acked_bytes < acked_bytes)
+                        low = middle + 1;
+                else if (middle == 0)
+                        break;
+                else
+                        high = middle - 1;
+        }
+        return ACKED_INDEX_NOT_FOUND;
 }
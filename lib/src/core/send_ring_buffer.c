@@ -0,0 +1,149 @@
+#include "core/send_ring_buffer.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "allocator/allocator_macros.h"
+#include "microtcp_defines.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+#include "status.h"
+
+/* `send_ring_buffer_t` is defined in equivilant header_file. */
+/* `head` and `tail` run freely (positions are masked on access); Each one is written only by its own side. */
+struct send_ring_buffer
+{
+        uint8_t *buffer;
+        size_t buffer_size;   /* Power of 2, so positions wrap with a mask. */
+        _Atomic size_t head;  /* Bytes released so far; Written by consumer. */
+        _Atomic size_t tail;  /* Bytes stored so far; Written by producer. */
+};
+
+/* Each side reads its own index relaxed, and the other side's with acquire; Stores are released after the bytes they publish. */
+#define LOAD_OWN(_index) atomic_load_explicit(&(_index), memory_order_relaxed)
+#define LOAD_PEER(_index) atomic_load_explicit(&(_index), memory_order_acquire)
+#define PUBLISH(_index, _value) atomic_store_explicit(&(_index), (_value), memory_order_release)
+
+send_ring_buffer_t *srb_create(const size_t _srb_size)
+{
+        SMART_ASSERT(IS_POWER_OF_2(_srb_size));
+        send_ring_buffer_t *srb = MALLOC_LOG(srb, sizeof(send_ring_buffer_t));
+        if (srb == NULL)
+                return NULL;
+
+        srb->buffer = MALLOC_LOG(srb->buffer, _srb_size);
+        if (srb->buffer == NULL)
+        {
+                FREE_NULLIFY_LOG(srb);
+                return NULL;
+        }
+        srb->buffer_size = _srb_size;
+        atomic_init(&srb->head, 0);
+        atomic_init(&srb->tail, 0);
+        return srb;
+}
+
+/* We request a double pointer, in order to NULLIFY user's SRB pointer. */
+status_t srb_destroy(send_ring_buffer_t **const _srb_address)
+{
+        SMART_ASSERT(_srb_address != NULL);
+
+#define SRB (*_srb_address)
+        if (SRB == NULL)
+                return SUCCESS;
+
+        if (srb_stored_bytes(SRB) != 0)
+                LOG_WARNING("Send-Ring-Buffer destroyed with %zu bytes never consumed.", srb_stored_bytes(SRB));
+        FREE_NULLIFY_LOG(SRB->buffer);
+        FREE_NULLIFY_LOG(SRB);
+        return SUCCESS;
+#undef SRB
+}
+
+size_t srb_push(send_ring_buffer_t *const _srb, const void *const _buffer, const size_t _length)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL, _buffer != NULL);
+        const size_t tail = LOAD_OWN(_srb->tail);
+        const size_t bytes_to_copy = MIN(_length, _srb->buffer_size - (tail - LOAD_PEER(_srb->head)));
+        if (bytes_to_copy == 0)
+                return 0;
+
+        /* Write on Right-Side of SRB, and on Left-Side (if wrap-around occurs). */
+        const size_t begin_pos = tail & (_srb->buffer_size - 1);
+        const size_t bytes_on_right_side = MIN(bytes_to_copy, _srb->buffer_size - begin_pos);
+        memcpy(_srb->buffer + begin_pos, _buffer, bytes_on_right_side);
+        memcpy(_srb->buffer, (const uint8_t *)_buffer + bytes_on_right_side, bytes_to_copy - bytes_on_right_side);
+        PUBLISH(_srb->tail, tail + bytes_to_copy);
+        return bytes_to_copy;
+}
+
+uint8_t *srb_reserve(send_ring_buffer_t *const _srb, size_t *const _contiguous)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL, _contiguous != NULL);
+        const size_t tail = LOAD_OWN(_srb->tail);
+        const size_t pos = tail & (_srb->buffer_size - 1);
+        *_contiguous = MIN(_srb->buffer_size - (tail - LOAD_PEER(_srb->head)), _srb->buffer_size - pos);
+        return _srb->buffer + pos;
+}
+
+void srb_commit(send_ring_buffer_t *const _srb, const size_t _bytes)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL, _bytes <= srb_free_space(_srb));
+        PUBLISH(_srb->tail, LOAD_OWN(_srb->tail) + _bytes);
+}
+
+const uint8_t *srb_peek(const send_ring_buffer_t *const _srb, const size_t _offset, size_t *const _contiguous)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL, _contiguous != NULL);
+        const size_t head = LOAD_OWN(_srb->head);
+        const size_t stored_bytes = LOAD_PEER(_srb->tail) - head;
+        DEBUG_SMART_ASSERT(_offset <= stored_bytes);
+        const size_t pos = (head + _offset) & (_srb->buffer_size - 1);
+        *_contiguous = MIN(stored_bytes - _offset, _srb->buffer_size - pos);
+        return _srb->buffer + pos;
+}
+
+void srb_release(send_ring_buffer_t *const _srb, const size_t _bytes)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL, _bytes <= srb_stored_bytes(_srb));
+        PUBLISH(_srb->head, LOAD_OWN(_srb->head) + _bytes);
+}
+
+size_t srb_pop(send_ring_buffer_t *const _srb, void *const _buffer, const size_t _length)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL, _buffer != NULL);
+        size_t bytes_popped = 0;
+        size_t contiguous_bytes = 0;
+        while (bytes_popped != _length)
+        {
+                const uint8_t *const bytes = srb_peek(_srb, 0, &contiguous_bytes);
+                const size_t bytes_to_copy = MIN(contiguous_bytes, _length - bytes_popped);
+                if (bytes_to_copy == 0)
+                        break;
+                memcpy((uint8_t *)_buffer + bytes_popped, bytes, bytes_to_copy);
+                srb_release(_srb, bytes_to_copy);
+                bytes_popped += bytes_to_copy;
+        }
+        return bytes_popped;
+}
+
+size_t srb_size(const send_ring_buffer_t *const _srb)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL);
+        return _srb->buffer_size;
+}
+
+/* Exact for its callers' own side; The other side may only make it grow (producer) or shrink (consumer) meanwhile. */
+size_t srb_stored_bytes(const send_ring_buffer_t *const _srb)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL);
+        const size_t head = LOAD_PEER(_srb->head); /* Loaded first; `tail` can't fall behind it. */
+        return LOAD_PEER(_srb->tail) - head;
+}
+
+size_t srb_free_space(const send_ring_buffer_t *const _srb)
+{
+        DEBUG_SMART_ASSERT(_srb != NULL);
+        return _srb->buffer_size - srb_stored_bytes(_srb);
+}
@@ -0,0 +1,270 @@
+#include "core/socket_options.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/udp.h>
+#include "congestion_control/congestion_control.h"
+#include "core/listener.h"
+#include "core/misc.h"
+#include "core/sack.h"
+#include "core/syn_cookie.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "microtcp_core_macros.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "settings/microtcp_settings.h"
+#include "smart_assert.h"
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif /* UDP_GRO */
+
+/* Options shaping connection's buffers, are only accepted before connect() or accept() allocates them. */
+#define PRE_CONNECTION_STATES (CLOSED | LISTEN)
+
+/* Engine thread mode needs a send buffer; This one is used, unless one was set already. */
+#define ENGINE_THREAD_DEFAULT_SEND_BUFFER_SIZE (4 * MICROTCP_RECVBUF_LEN)
+
+static int set_udp_offload_option(microtcp_sock_t *_socket, int _enable);
+static int set_send_buffer_option(microtcp_sock_t *_socket, int _size);
+static int set_engine_thread_option(microtcp_sock_t *_socket, int _enable);
+static int set_sack_option(microtcp_sock_t *_socket, int _enable);
+static int set_pacing_option(microtcp_sock_t *_socket, int _enable);
+static int set_listener_option(microtcp_sock_t *_socket, int _enable);
+static int set_syn_cookies_option(microtcp_sock_t *_socket, int _enable);
+static int set_async_time_wait_option(microtcp_sock_t *_socket, int _enable);
+static int set_congestion_control_option(microtcp_sock_t *_socket, const void *_name, socklen_t _name_len);
+static int get_congestion_control_option(const microtcp_sock_t *_socket, void *_name, socklen_t *_name_len);
+
+static __always_inline int read_int_option_value(const void *const _value, const socklen_t _value_len, int *const _int_value)
+{
+        if (_value == NULL || _value_len != sizeof(int))
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Option value must be an `int`; (value = %p, value_len = %u).", _value, _value_len);
+        memcpy(_int_value, _value, sizeof(int));
+        return MICROTCP_SOCKOPT_SUCCESS;
+}
+
+static __always_inline int write_int_option_value(void *const _value, socklen_t *const _value_len, const int _int_value)
+{
+        if (_value == NULL || _value_len == NULL || *_value_len < sizeof(int))
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Option value buffer must fit an `int`.");
+        memcpy(_value, &_int_value, sizeof(int));
+        *_value_len = sizeof(int);
+        return MICROTCP_SOCKOPT_SUCCESS;
+}
+
+int set_microtcp_socket_option(microtcp_sock_t *const _socket, const microtcp_sockopt_t _option, const void *const _value, const socklen_t _value_len)
+{
+        SMART_ASSERT(_socket != NULL);
+        int int_value = 0;
+        switch (_option)
+        {
+        case MICROTCP_SO_UDP_OFFLOAD:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_udp_offload_option(_socket, int_value);
+        case MICROTCP_SO_SEND_BUFFER:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_send_buffer_option(_socket, int_value);
+        case MICROTCP_SO_ENGINE_THREAD:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_engine_thread_option(_socket, int_value);
+        case MICROTCP_SO_CONGESTION_CONTROL:
+                return set_congestion_control_option(_socket, _value, _value_len);
+        case MICROTCP_SO_SACK:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_sack_option(_socket, int_value);
+        case MICROTCP_SO_PACING:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_pacing_option(_socket, int_value);
+        case MICROTCP_SO_LISTENER:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_listener_option(_socket, int_value);
+        case MICROTCP_SO_SYN_COOKIES:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_syn_cookies_option(_socket, int_value);
+        case MICROTCP_SO_ASYNC_TIME_WAIT:
+                if (read_int_option_value(_value, _value_len, &int_value) == MICROTCP_SOCKOPT_FAILURE)
+                        return MICROTCP_SOCKOPT_FAILURE;
+                return set_async_time_wait_option(_socket, int_value);
+        default:
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Unknown socket option (%d).", _option);
+        }
+}
+
+int get_microtcp_socket_option(microtcp_sock_t *const _socket, const microtcp_sockopt_t _option, void *const _value, socklen_t *const _value_len)
+{
+        SMART_ASSERT(_socket != NULL);
+        switch (_option)
+        {
+        case MICROTCP_SO_UDP_OFFLOAD:
+                return write_int_option_value(_value, _value_len, _socket->udp_offload);
+        case MICROTCP_SO_SEND_BUFFER:
+                return write_int_option_value(_value, _value_len, (int)_socket->send_buffer_size);
+        case MICROTCP_SO_ENGINE_THREAD:
+                return write_int_option_value(_value, _value_len, _socket->engine_thread);
+        case MICROTCP_SO_CONGESTION_CONTROL:
+                return get_congestion_control_option(_socket, _value, _value_len);
+        case MICROTCP_SO_SACK:
+                return write_int_option_value(_value, _value_len, _socket->sack);
+        case MICROTCP_SO_PACING:
+                return write_int_option_value(_value, _value_len, _socket->pacing);
+        case MICROTCP_SO_LISTENER:
+                return write_int_option_value(_value, _value_len, _socket->listener != NULL && _socket->connection_entry == NULL);
+        case MICROTCP_SO_SYN_COOKIES:
+                return write_int_option_value(_value, _value_len, _socket->syn_cookies);
+        case MICROTCP_SO_ASYNC_TIME_WAIT:
+                return write_int_option_value(_value, _value_len, _socket->async_time_wait);
+        default:
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Unknown socket option (%d).", _option);
+        }
+}
+
+/**
+ * @brief GSO needs no socket state; Each send round attaches its own UDP_SEGMENT control message.
+ * GRO on the other hand, has to be enabled on the underlying UDP socket.
+ */
+static int set_udp_offload_option(microtcp_sock_t *const _socket, const int _enable)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        const int gro_enable = (_enable != 0);
+        if (gro_enable && _socket->listener != NULL)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "UDP offload is unavailable in listener mode; Listener routes plain datagrams.");
+        if (setsockopt(_socket->sd, SOL_UDP, UDP_GRO, &gro_enable, sizeof(gro_enable)) == POSIX_SETSOCKOPT_FAILURE)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Setting UDP GRO on socket failed; setsockopt() set errno(%d):%s.", errno, strerror(errno));
+        _socket->udp_offload = gro_enable;
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "UDP offload (GSO/GRO) %s.", gro_enable ? "enabled" : "disabled");
+}
+
+/* Send buffer is allocated along with the rest of connection's buffers, after the handshake. */
+static int set_send_buffer_option(microtcp_sock_t *const _socket, const int _size)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        if (_size != 0 && (_size < (int)MICROTCP_MSS || !IS_POWER_OF_2(_size)))
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Send buffer size must be 0, or a power of 2 no smaller than MSS (%llu); Got %d.", MICROTCP_MSS, _size);
+        if (_size == 0 && _socket->engine_thread)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Engine thread mode requires a send buffer; Disable %s first.", STRINGIFY(MICROTCP_SO_ENGINE_THREAD));
+        _socket->send_buffer_size = _size;
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "Buffered send %s (send buffer size = %d bytes).", _size ? "enabled" : "disabled", _size);
+}
+
+/* Engine thread is started after the handshake (see pe_start()); Application talks to it through the send buffer. */
+static int set_engine_thread_option(microtcp_sock_t *const _socket, const int _enable)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        if (_enable && _socket->listener != NULL)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Engine thread mode is unavailable in listener mode; Engine polls the descriptor on its own.");
+        _socket->engine_thread = (_enable != 0);
+        if (_socket->engine_thread && _socket->send_buffer_size == 0)
+                _socket->send_buffer_size = ENGINE_THREAD_DEFAULT_SEND_BUFFER_SIZE;
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "Engine thread mode %s (send buffer size = %zu bytes).",
+                        _socket->engine_thread ? "enabled" : "disabled", _socket->send_buffer_size);
+}
+
+/* No negotiation; A peer without SACK leaves header's spare words zeroed, which decodes to no blocks. */
+static int set_sack_option(microtcp_sock_t *const _socket, const int _enable)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        if (_enable && !SACK_SUPPORTED)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "SACK is unavailable in OPTIMIZED_MODE; Its header has no spare words.");
+        _socket->sack = (_enable != 0);
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "SACK %s.", _socket->sack ? "enabled" : "disabled");
+}
+
+static int set_pacing_option(microtcp_sock_t *const _socket, const int _enable)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        _socket->pacing = (_enable != 0);
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "Pacing %s.", _socket->pacing ? "enabled" : "disabled");
+}
+
+/* Only the server side uses it; Connecting sockets accept it, and ignore it. */
+static int set_syn_cookies_option(microtcp_sock_t *const _socket, const int _enable)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        if (_enable != 0 && syn_cookie_initialize() == FAILURE)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "SYN cookies unavailable; Secret key could not be generated.");
+        _socket->syn_cookies = (_enable != 0);
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "SYN cookies %s.", _socket->syn_cookies ? "enabled" : "disabled");
+}
+
+/* Read by active shutdown, so it may still be changed on an established connection; Accepted connections inherit it.
+ * Only listener's connections linger in the background; A plain socket owns its port, which would stay bound. */
+static int set_async_time_wait_option(microtcp_sock_t *const _socket, const int _enable)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES | ESTABLISHED);
+        if (_enable && _socket->listener == NULL)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Asynchronous TIME_WAIT is for listener mode only; Enable %s first.", STRINGIFY(MICROTCP_SO_LISTENER));
+        _socket->async_time_wait = (_enable != 0);
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "Asynchronous TIME_WAIT %s.", _socket->async_time_wait ? "enabled" : "disabled");
+}
+
+/**
+ * @brief Listener takes over socket's descriptor; Connections accepted from it keep a reference, so it can only be
+ * disabled while none is left.
+ */
+static int set_listener_option(microtcp_sock_t *const _socket, const int _enable)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        if (_socket->connection_entry != NULL)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Socket is a listener's connection; It cannot become a listener itself.");
+        if (_enable && (_socket->udp_offload || _socket->engine_thread))
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Listener mode is incompatible with %s and %s; Disable them first.",
+                                 STRINGIFY(MICROTCP_SO_UDP_OFFLOAD), STRINGIFY(MICROTCP_SO_ENGINE_THREAD));
+        if (_enable && _socket->listener == NULL && (_socket->listener = listener_create(_socket->sd)) == NULL)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Failed to create socket's listener.");
+        if (!_enable && _socket->listener != NULL)
+        {
+                if (listener_connections(_socket->listener) != 0)
+                        LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Listener still has %zu connections; Close them first.",
+                                         listener_connections(_socket->listener));
+                listener_release(&_socket->listener); /* Last reference; Descriptor goes back to the socket. */
+                _socket->async_time_wait = false;
+                if (set_socket_recvfrom_timeout(_socket, usec_to_timeval(_socket->rto_usec)) == POSIX_SETSOCKOPT_FAILURE)
+                        LOG_WARNING("Failed to restore socket's timeout to RTO = %lld μsec.", (long long)_socket->rto_usec);
+        }
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "Listener mode %s.", _enable ? "enabled" : "disabled");
+}
+
+/**
+ * @brief Module's name needs no terminating '\0' (length is `_name_len`), as with Linux's TCP_CONGESTION.
+ * Module's state is allocated along with the rest of connection's buffers, after the handshake.
+ */
+static int set_congestion_control_option(microtcp_sock_t *const _socket, const void *const _name, const socklen_t _name_len)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, PRE_CONNECTION_STATES);
+        if (_name == NULL || _name_len == 0 || _name_len >= CC_NAME_MAX_LENGTH)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Congestion control name must be 1 to %d chars; (value = %p, value_len = %u).",
+                                 CC_NAME_MAX_LENGTH - 1, _name, _name_len);
+        char name[CC_NAME_MAX_LENGTH] = {0};
+        memcpy(name, _name, _name_len);
+        const congestion_control_ops_t *const ops = cc_find(name);
+        if (ops == NULL)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Unknown congestion control module `%s`.", name);
+        _socket->congestion_control_ops = ops;
+        LOG_INFO_RETURN(MICROTCP_SOCKOPT_SUCCESS, "Congestion control set to `%s`.", ops->name);
+}
+
+/* Connection's module; Before one is allocated, the module it will run. */
+static int get_congestion_control_option(const microtcp_sock_t *const _socket, void *const _name, socklen_t *const _name_len)
+{
+        const char *name = get_microtcp_congestion_control();
+        if (_socket->congestion_control != NULL)
+                name = cc_ops(_socket->congestion_control)->name;
+        else if (_socket->congestion_control_ops != NULL)
+                name = _socket->congestion_control_ops->name;
+        const size_t name_size = strlen(name) + 1;
+        if (_name == NULL || _name_len == NULL || *_name_len < name_size)
+                LOG_ERROR_RETURN(MICROTCP_SOCKOPT_FAILURE, "Option value buffer must fit congestion control's name (%zu bytes).", name_size);
+        memcpy(_name, name, name_size);
+        *_name_len = name_size;
+        return MICROTCP_SOCKOPT_SUCCESS;
+}
@@ -1,5 +1,9 @@
 #include "core/socket_stats_updater.h"
+#include <stdatomic.h>
 #include <stddef.h>
+#include "congestion_control/congestion_control.h"
+#include "core/receive_ring_buffer.h"
+#include "core/send_queue.h"
 #include "logging/microtcp_logger.h"
 #include "microtcp.h"
 #include "microtcp_helper_macros.h"
@@ -19,7 +23,6 @@ void update_socket_sent_counters(microtcp_sock_t *_socket, size_t _bytes_sent)
 
         _socket->bytes_sent += _bytes_sent;
         _socket->packets_sent++;
-        LOG_INFO("Socket's sent counters updated.");
 }
 
 void update_socket_received_counters(microtcp_sock_t *_socket, size_t _bytes_received)
@@ -36,7 +39,6 @@ void update_socket_received_counters(microtcp_sock_t *_socket, size_t _bytes_rec
 
         _socket->bytes_received += _bytes_received;
         _socket->packets_received++;
-        LOG_INFO("Socket's received counters updated.");
 }
 
 void update_socket_lost_counters(microtcp_sock_t *_socket, size_t _bytes_lost)
@@ -53,5 +55,28 @@ void update_socket_lost_counters(microtcp_sock_t *_socket, size_t _bytes_lost)
 
         _socket->bytes_lost += _bytes_lost;
         _socket->packets_lost++;
-        LOG_INFO("Socket's lost counters updated.");
+}
+
+void get_socket_info(const microtcp_sock_t *const _socket, microtcp_info_t *const _info)
+{
+        SMART_ASSERT(_socket != NULL, _info != NULL);
+        *_info = (microtcp_info_t){
+            .state = _socket->state,
+            .srtt_usec = _socket->srtt_usec,
+            .rttvar_usec = _socket->rttvar_usec,
+            .rto_usec = _socket->rto_usec,
+            .cwnd = _socket->congestion_control != NULL ? cc_cwnd(_socket->congestion_control, _socket) : _socket->cwnd,
+            .ssthresh = _socket->ssthresh,
+            .peer_win_size = _socket->peer_win_size,
+            .bytes_in_flight = _socket->send_queue != NULL ? sq_stored_bytes(_socket->send_queue) : 0,
+            .out_of_order_bytes = _socket->bytestream_rrb != NULL ? rrb_out_of_order_bytes(_socket->bytestream_rrb) : 0,
+            .packets_sent = _socket->packets_sent,
+            .packets_lost = _socket->packets_lost,
+            .packets_received = _socket->packets_received,
+            .bytes_sent = _socket->bytes_sent,
+            .bytes_lost = _socket->bytes_lost,
+            .bytes_received = _socket->bytes_received,
+            .stats = _socket->stats};
+        for (size_t i = 0; i < MICROTCP_HISTOGRAM_BUCKETS; i++)
+                _info->stats.send_latency_histogram[i] = atomic_load_explicit(&_socket->application_stats.send_latency_histogram[i], memory_order_relaxed);
 }
@@ -0,0 +1,232 @@
+#include "core/stats_export.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "allocator/allocator_macros.h"
+#include "core/socket_stats_updater.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "smart_assert.h"
+#include "status.h"
+
+#define SHM_NAME_CAPACITY 64
+#define SHM_OPEN_FAILURE (-1)
+#define MMAP_FAILURE MAP_FAILED
+
+static struct
+{
+        pthread_mutex_t lock; /* Guards everything below, and writes to `segment->totals`. */
+        _Bool started;
+        stats_export_t *segment; /* Mapped by start; A forked child maps its own, with its first connection. */
+        char shm_name[SHM_NAME_CAPACITY];
+        uint16_t free_slots[STATS_EXPORT_SLOTS]; /* Stack of free slots' indices. */
+        size_t free_slot_count;
+} exporter = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static void add_to_totals(stats_export_totals_t *_totals, const microtcp_info_t *_info);
+static void lock_exporter(void);
+static void unlock_exporter(void);
+static void fork_segment_in_child(void);
+
+/* Creates a zero filled segment named after the process, and maps it; At `_address` if not NULL. */
+static stats_export_t *map_segment(void *const _address)
+{
+        snprintf(exporter.shm_name, sizeof(exporter.shm_name), "%s%d", STATS_EXPORT_SHM_NAME_PREFIX, (int)getpid());
+        const int shm_fd = shm_open(exporter.shm_name, O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644);
+        if (shm_fd == SHM_OPEN_FAILURE)
+                LOG_ERROR_RETURN(MMAP_FAILURE, "Statistics exporter failed; shm_open(%s) set errno(%d):%s.", exporter.shm_name, errno, strerror(errno));
+        stats_export_t *segment = MMAP_FAILURE;
+        if (ftruncate(shm_fd, sizeof(stats_export_t)) == 0)
+                segment = mmap(_address, sizeof(stats_export_t), PROT_READ | PROT_WRITE, MAP_SHARED | (_address != NULL ? MAP_FIXED : 0), shm_fd, 0);
+        close(shm_fd); /* Mapping outlives it. */
+        if (segment == MMAP_FAILURE)
+        {
+                LOG_ERROR("Statistics exporter failed mapping %s; errno(%d):%s.", exporter.shm_name, errno, strerror(errno));
+                shm_unlink(exporter.shm_name);
+        }
+        return segment;
+}
+
+/* Called holding exporter's lock. */
+static status_t initialize_segment(void)
+{
+        stats_export_t *const segment = map_segment(NULL);
+        if (segment == MMAP_FAILURE)
+                return FAILURE;
+        segment->version = STATS_EXPORT_VERSION;
+        segment->pid = getpid();
+        segment->slot_count = STATS_EXPORT_SLOTS;
+        for (size_t i = 0; i < STATS_EXPORT_SLOTS; i++)
+                exporter.free_slots[i] = STATS_EXPORT_SLOTS - 1 - i; /* Lowest slots are handed out first. */
+        exporter.free_slot_count = STATS_EXPORT_SLOTS;
+        atomic_thread_fence(memory_order_release);
+        segment->magic = STATS_EXPORT_MAGIC; /* Readers trust the rest, once magic is there. */
+        exporter.segment = segment;
+        LOG_INFO_RETURN(SUCCESS, "Statistics exported to shared memory %s.", exporter.shm_name);
+}
+
+status_t stats_export_start(void)
+{
+        pthread_mutex_lock(&exporter.lock);
+        if (exporter.started)
+        {
+                pthread_mutex_unlock(&exporter.lock);
+                return SUCCESS;
+        }
+        const status_t initialize_ret_val = initialize_segment();
+        if (initialize_ret_val == SUCCESS)
+        {
+                exporter.started = true;
+                pthread_atfork(lock_exporter, unlock_exporter, fork_segment_in_child);
+        }
+        pthread_mutex_unlock(&exporter.lock);
+        return initialize_ret_val;
+}
+
+void stats_export_acquire_slot(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL, _socket->stats_export_slot == NULL);
+        pthread_mutex_lock(&exporter.lock);
+        if (!exporter.started || (exporter.segment == NULL && initialize_segment() == FAILURE))
+        {
+                pthread_mutex_unlock(&exporter.lock);
+                return;
+        }
+        stats_export_write_begin(&exporter.segment->sequence);
+        exporter.segment->totals.connections_opened++;
+        if (exporter.free_slot_count == 0)
+                exporter.segment->totals.connections_unexported++;
+        stats_export_write_end(&exporter.segment->sequence);
+        if (exporter.free_slot_count == 0)
+        {
+                pthread_mutex_unlock(&exporter.lock);
+                LOG_WARNING("Every statistics slot is taken; Connection is not exported.");
+                return;
+        }
+        stats_export_slot_t *const slot = &exporter.segment->slots[exporter.free_slots[--exporter.free_slot_count]];
+        pthread_mutex_unlock(&exporter.lock);
+
+        struct sockaddr_in local_address = {0};
+        socklen_t local_address_len = sizeof(local_address);
+        getsockname(_socket->sd, (struct sockaddr *)&local_address, &local_address_len);
+        stats_export_write_begin(&slot->sequence);
+        slot->in_use = true;
+        slot->local_address = local_address;
+        memcpy(&slot->peer_address, _socket->peer_address, sizeof(slot->peer_address));
+        stats_export_write_end(&slot->sequence);
+        _socket->stats_export_slot = slot;
+        stats_export_publish(_socket, get_monotonic_time_usec());
+}
+
+void stats_export_release_slot(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL);
+        stats_export_slot_t *const slot = _socket->stats_export_slot;
+        if (slot == NULL)
+                return;
+        microtcp_info_t info;
+        get_socket_info(_socket, &info);
+        stats_export_write_begin(&slot->sequence);
+        slot->in_use = false;
+        stats_export_write_end(&slot->sequence);
+        _socket->stats_export_slot = NULL;
+
+        pthread_mutex_lock(&exporter.lock);
+        stats_export_write_begin(&exporter.segment->sequence);
+        exporter.segment->totals.connections_closed++;
+        add_to_totals(&exporter.segment->totals, &info);
+        stats_export_write_end(&exporter.segment->sequence);
+        exporter.free_slots[exporter.free_slot_count++] = (uint16_t)(slot - exporter.segment->slots);
+        pthread_mutex_unlock(&exporter.lock);
+}
+
+void stats_export_publish(microtcp_sock_t *const _socket, const time_t _now_usec)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->stats_export_slot != NULL);
+        stats_export_slot_t *const slot = _socket->stats_export_slot;
+        microtcp_info_t info; /* Gathered first; Slot stays odd for a single copy only. */
+        get_socket_info(_socket, &info);
+        stats_export_write_begin(&slot->sequence);
+        slot->published_usec = _now_usec;
+        slot->info = info;
+        stats_export_write_end(&slot->sequence);
+        _socket->stats_export_due_usec = _now_usec + STATS_EXPORT_INTERVAL_USEC;
+}
+
+static void add_to_totals(stats_export_totals_t *const _totals, const microtcp_info_t *const _info)
+{
+        _totals->packets_sent += _info->packets_sent;
+        _totals->packets_lost += _info->packets_lost;
+        _totals->packets_received += _info->packets_received;
+        _totals->bytes_sent += _info->bytes_sent;
+        _totals->bytes_lost += _info->bytes_lost;
+        _totals->bytes_received += _info->bytes_received;
+        _totals->timeouts += _info->stats.timeouts;
+        _totals->timeout_retransmits += _info->stats.timeout_retransmits;
+        _totals->fast_retransmits += _info->stats.fast_retransmits;
+        _totals->duplicate_acks += _info->stats.duplicate_acks;
+}
+
+static void lock_exporter(void)
+{
+        pthread_mutex_lock(&exporter.lock);
+}
+
+static void unlock_exporter(void)
+{
+        pthread_mutex_unlock(&exporter.lock);
+}
+
+/**
+ * Child would share parent's segment (and the slots parent hands out). Unless it inherited connections, it maps its own
+ * segment with its first one. Otherwise it gets a copy of parent's, mapped at the same address, so inherited slots stay
+ * valid; Writes that fork interrupted never end, so they are ended here.
+ */
+static void fork_segment_in_child(void)
+{
+        if (exporter.segment != NULL && exporter.free_slot_count == STATS_EXPORT_SLOTS)
+        {
+                munmap(exporter.segment, sizeof(*exporter.segment));
+                exporter.segment = NULL;
+        }
+        stats_export_t *snapshot = exporter.segment != NULL ? MALLOC_LOG(snapshot, sizeof(*snapshot)) : NULL;
+        if (snapshot != NULL)
+        {
+                memcpy(snapshot, exporter.segment, sizeof(*snapshot));
+                if (map_segment(exporter.segment) != MMAP_FAILURE)
+                {
+                        memcpy(exporter.segment, snapshot, sizeof(*snapshot));
+                        exporter.segment->pid = getpid();
+                        for (size_t i = 0; i < STATS_EXPORT_SLOTS; i++)
+                                if (atomic_load_explicit(&exporter.segment->slots[i].sequence, memory_order_relaxed) & 1)
+                                        stats_export_write_end(&exporter.segment->slots[i].sequence);
+                }
+                FREE_NULLIFY_LOG(snapshot);
+        }
+        pthread_mutex_unlock(&exporter.lock);
+}
+
+/* Lets deployed binaries export, without code changes. */
+__attribute__((constructor(STATS_EXPORT_CONSTRUCTOR_PRIORITY))) static void start_exporter_on_request(void)
+{
+        if (getenv(STATS_EXPORT_ENVIRONMENT_VARIABLE) != NULL)
+                stats_export_start();
+}
+
+/* Segment's name goes with the process; Mapping stays, threads still running may publish until they exit. */
+__attribute__((destructor(STATS_EXPORT_DESTRUCTOR_PRIORITY))) static void unlink_exported_segment(void)
+{
+        pthread_mutex_lock(&exporter.lock);
+        if (exporter.segment != NULL)
+                shm_unlink(exporter.shm_name);
+        pthread_mutex_unlock(&exporter.lock);
+}
@@ -0,0 +1,107 @@
+#include "core/syn_cookie.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/random.h>
+#include "logging/microtcp_logger.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+
+#define COOKIE_COUNTER_SHIFT 24
+#define COOKIE_HASH_MASK ((UINT32_C(1) << COOKIE_COUNTER_SHIFT) - 1)
+#define COOKIE_COUNTER_MASK UINT32_C(0xFF)
+#define USEC_PER_SEC 1000000
+
+static uint64_t secret_key[2]; /* SipHash's 128-bit key. */
+static pthread_once_t secret_key_once = PTHREAD_ONCE_INIT;
+static status_t secret_key_status = FAILURE;
+
+static uint32_t get_counter(void);
+static uint32_t compute_cookie(const struct sockaddr *_peer, uint32_t _peer_isn, uint32_t _counter);
+
+static void generate_secret_key(void)
+{
+        ssize_t getrandom_ret_val;
+        do
+                getrandom_ret_val = getrandom(secret_key, sizeof(secret_key), 0);
+        while (getrandom_ret_val == -1 && errno == EINTR);
+        if (getrandom_ret_val == sizeof(secret_key))
+                secret_key_status = SUCCESS;
+        else
+                LOG_ERROR("SYN cookie key generation failed; %s() -> ERRNO %d: %s", STRINGIFY(getrandom), errno, strerror(errno));
+}
+
+status_t syn_cookie_initialize(void)
+{
+        pthread_once(&secret_key_once, generate_secret_key);
+        return secret_key_status;
+}
+
+uint32_t syn_cookie_generate(const struct sockaddr *const _peer, const uint32_t _peer_isn)
+{
+        DEBUG_SMART_ASSERT(_peer != NULL, secret_key_status == SUCCESS);
+        return compute_cookie(_peer, _peer_isn, get_counter());
+}
+
+_Bool syn_cookie_validate(const struct sockaddr *const _peer, const uint32_t _peer_isn, const uint32_t _cookie)
+{
+        DEBUG_SMART_ASSERT(_peer != NULL, secret_key_status == SUCCESS);
+        const uint32_t counter = get_counter();
+        const uint32_t cookie_counter = _cookie >> COOKIE_COUNTER_SHIFT;
+        if (cookie_counter != counter && cookie_counter != ((counter - 1) & COOKIE_COUNTER_MASK))
+                return false; /* Expired (or forged). */
+        return compute_cookie(_peer, _peer_isn, cookie_counter) == _cookie;
+}
+
+static uint32_t get_counter(void)
+{
+        return (uint32_t)(get_monotonic_time_usec() / (SYN_COOKIE_TICK_SEC * (time_t)USEC_PER_SEC)) & COOKIE_COUNTER_MASK;
+}
+
+static uint32_t compute_cookie(const struct sockaddr *const _peer, const uint32_t _peer_isn, const uint32_t _counter)
+{
+        const struct sockaddr_in *const peer = (const struct sockaddr_in *)_peer;
+        const uint64_t words[2] = {((uint64_t)peer->sin_addr.s_addr << 16) | peer->sin_port,
+                                   ((uint64_t)_counter << 32) | _peer_isn};
+        const uint32_t hash = (uint32_t)syn_cookie_siphash_2_4(secret_key, words, ARRAY_SIZE(words)) & COOKIE_HASH_MASK;
+        return (_counter << COOKIE_COUNTER_SHIFT) | hash;
+}
+
+#define ROTL64(_x, _b) (((_x) << (_b)) | ((_x) >> (64 - (_b))))
+#define SIPROUND(_v0, _v1, _v2, _v3)                                                          \
+        do                                                                                    \
+        {                                                                                     \
+                _v0 += _v1, _v1 = ROTL64(_v1, 13), _v1 ^= _v0, _v0 = ROTL64(_v0, 32); \
+                _v2 += _v3, _v3 = ROTL64(_v3, 16), _v3 ^= _v2;                        \
+                _v0 += _v3, _v3 = ROTL64(_v3, 21), _v3 ^= _v0;                        \
+                _v2 += _v1, _v1 = ROTL64(_v1, 17), _v1 ^= _v2, _v2 = ROTL64(_v2, 32); \
+        } while (0)
+
+/* SipHash-2-4 (Aumasson & Bernstein) over whole 64-bit words; Inputs here are fixed length, so no tail bytes. */
+uint64_t syn_cookie_siphash_2_4(const uint64_t _key[2], const uint64_t *const _words, const size_t _words_count)
+{
+        uint64_t v0 = _key[0] ^ UINT64_C(0x736f6d6570736575);
+        uint64_t v1 = _key[1] ^ UINT64_C(0x646f72616e646f6d);
+        uint64_t v2 = _key[0] ^ UINT64_C(0x6c7967656e657261);
+        uint64_t v3 = _key[1] ^ UINT64_C(0x7465646279746573);
+        for (size_t i = 0; i < _words_count; i++)
+        {
+                v3 ^= _words[i];
+                SIPROUND(v0, v1, v2, v3);
+                SIPROUND(v0, v1, v2, v3);
+                v0 ^= _words[i];
+        }
+        const uint64_t length_word = (uint64_t)(_words_count * sizeof(uint64_t)) << 56;
+        v3 ^= length_word;
+        SIPROUND(v0, v1, v2, v3);
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= length_word;
+        v2 ^= 0xFF;
+        for (int i = 0; i < 4; i++)
+                SIPROUND(v0, v1, v2, v3);
+        return v0 ^ v1 ^ v2 ^ v3;
+}
@@ -0,0 +1,317 @@
+#include "core/time_wait_table.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "allocator/allocator_macros.h"
+#include "core/connection_table.h"
+#include "core/listener.h"
+#include "core/segment_processing.h"
+#include "core/timer_wheel.h"
+#include "crc32.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp.h"
+#include "microtcp_defines.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "settings/microtcp_settings.h"
+#include "smart_assert.h"
+#include "status.h"
+
+#define POLL_INFINITE_TIMEOUT (-1)
+#define EVENTFD_FAILURE (-1)
+#define SENDTO_ERROR (-1)
+#define USEC_PER_MSEC 1000
+#define WAKEUP_DESCRIPTOR_INDEX 0
+#define LINGERING_PUMP_DELAY_MSEC 1 /* Application's waiters get the first turn at a readable descriptor. */
+
+struct time_wait_entry
+{
+        struct sockaddr peer;
+        uint32_t seq_number;                  /* Past our FIN; Peer's FIN|ACK acknowledges it. */
+        uint32_t ack_number;                  /* Past peer's FIN. */
+        int sd;                               /* Listener's descriptor. */
+        listener_t *listener;                 /* A reference, keeping `sd` open. */
+        connection_entry_t *connection_entry; /* Still in listener's table. */
+        wheel_timer_t expiry_timer;
+};
+
+/* Listener some entries linger through; Table's thread watches its descriptor. */
+typedef struct lingering_listener
+{
+        listener_t *listener; /* Entries' references keep it alive. */
+        int sd;
+        size_t entries;
+        struct lingering_listener *next;
+} lingering_listener_t;
+
+/* Table's thread polls a copy of the descriptors (and their listeners); Hand-overs change the table meanwhile. */
+typedef struct
+{
+        struct pollfd *descriptors; /* Wakeup eventfd first, then listeners' descriptors. */
+        listener_t **listeners;     /* Parallel to `descriptors`, past the wakeup eventfd. */
+        size_t count;
+        size_t capacity;
+} watch_set_t;
+
+static struct
+{
+        pthread_mutex_t lock; /* Guards everything below; Entries are only freed by table's thread. */
+        _Bool started;
+        timer_wheel_t *timers;
+        int wakeup_eventfd; /* Hand-overs wake table's thread, to recalculate its wait. */
+        size_t size;
+        lingering_listener_t *listeners;
+        size_t listeners_count;
+} table = {.lock = PTHREAD_MUTEX_INITIALIZER, .wakeup_eventfd = EVENTFD_FAILURE};
+
+static status_t start_table(void);
+static void *run_time_wait_table(void *_unused);
+static void forget_entry(time_wait_entry_t *_entry);
+static status_t watch_listener(listener_t *_listener, int _sd);
+static void unwatch_listener(const listener_t *_listener);
+static void fill_watch_set(watch_set_t *_watch_set);
+static void pump_lingering_descriptors(const watch_set_t *_watch_set);
+static void send_ack(const time_wait_entry_t *_entry, int _sd);
+
+status_t time_wait_table_add(microtcp_sock_t *const _socket)
+{
+        SMART_ASSERT(_socket != NULL, _socket->peer_address != NULL, _socket->listener != NULL);
+        time_wait_entry_t *entry = CALLOC_LOG(entry, sizeof(time_wait_entry_t));
+        if (entry == NULL)
+                return FAILURE;
+        memcpy(&entry->peer, _socket->peer_address, sizeof(entry->peer));
+        entry->seq_number = _socket->seq_number;
+        entry->ack_number = _socket->ack_number;
+        tw_timer_init(&entry->expiry_timer, entry);
+
+        pthread_mutex_lock(&table.lock);
+        if (!table.started && start_table() == FAILURE)
+                goto failure_cleanup;
+        entry->sd = _socket->sd;
+        if (watch_listener(_socket->listener, entry->sd) == FAILURE)
+                goto failure_cleanup;
+        if ((entry->connection_entry = listener_linger(_socket, entry)) == NULL)
+        {
+                unwatch_listener(_socket->listener);
+                goto failure_cleanup;
+        }
+        entry->listener = listener_retain(_socket->listener);
+        tw_arm(table.timers, &entry->expiry_timer, get_monotonic_time_usec() + timeval_to_usec(get_shutdown_time_wait_period()));
+        const size_t lingering_connections = ++table.size;
+        const uint64_t wakeup = 1; /* Table's thread recalculates its wait. */
+        if (write(table.wakeup_eventfd, &wakeup, sizeof(wakeup)) == -1)
+                LOG_WARNING("TIME_WAIT table's wakeup failed; write() on eventfd set errno(%d):%s.", errno, strerror(errno));
+        pthread_mutex_unlock(&table.lock);
+        LOG_INFO_RETURN(SUCCESS, "Connection handed over to TIME_WAIT table; %zu lingering.", lingering_connections);
+
+failure_cleanup:
+        pthread_mutex_unlock(&table.lock);
+        FREE_NULLIFY_LOG(entry);
+        LOG_ERROR_RETURN(FAILURE, "Failed to hand connection over to TIME_WAIT table.");
+}
+
+void time_wait_answer_datagram(const time_wait_entry_t *const _entry, const int _sd, void *const _bytestream, const ssize_t _bytestream_length)
+{
+        DEBUG_SMART_ASSERT(_entry != NULL, _bytestream != NULL);
+        if (_bytestream_length != (ssize_t)MICROTCP_HEADER_SIZE || !is_valid_microtcp_bytestream(_bytestream, _bytestream_length))
+                return;
+        const microtcp_header_t *const header = _bytestream;
+        if ((header->control & (FIN_BIT | ACK_BIT)) != (FIN_BIT | ACK_BIT) || header->ack_number != _entry->seq_number)
+                return;
+        LOG_INFO("TIME_WAIT table heard a retransmitted `FIN|ACK`; Peer missed our `ACK`.");
+        send_ack(_entry, _sd);
+}
+
+size_t time_wait_table_size(void)
+{
+        pthread_mutex_lock(&table.lock);
+        const size_t size = table.size;
+        pthread_mutex_unlock(&table.lock);
+        return size;
+}
+
+/* Called locked, by the first hand-over. Table's thread runs detached, for the rest of the process. */
+static status_t start_table(void)
+{
+        pthread_t thread;
+        if ((table.timers = tw_create()) == NULL)
+                goto failure_cleanup;
+        if ((table.wakeup_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == EVENTFD_FAILURE)
+        {
+                LOG_ERROR("TIME_WAIT table's eventfd could not be created; errno(%d):%s.", errno, strerror(errno));
+                goto failure_cleanup;
+        }
+        const int pthread_create_ret_val = pthread_create(&thread, NULL, run_time_wait_table, NULL);
+        if (pthread_create_ret_val != 0)
+        {
+                LOG_ERROR("Starting TIME_WAIT table failed; pthread_create() returned (%d):%s.", pthread_create_ret_val, strerror(pthread_create_ret_val));
+                goto failure_cleanup;
+        }
+        pthread_detach(thread);
+        table.started = true;
+        LOG_INFO_RETURN(SUCCESS, "TIME_WAIT table started.");
+
+failure_cleanup:
+        if (table.wakeup_eventfd != EVENTFD_FAILURE)
+                close(table.wakeup_eventfd);
+        table.wakeup_eventfd = EVENTFD_FAILURE;
+        tw_destroy(&table.timers);
+        return FAILURE;
+}
+
+/* Called locked. */
+static int get_wait_msec(void)
+{
+        const time_t next_expiry_usec = tw_next_expiry_usec(table.timers);
+        if (next_expiry_usec == TIMER_WHEEL_NO_EXPIRY)
+                return POLL_INFINITE_TIMEOUT;
+        const time_t wait_usec = MAX(next_expiry_usec - get_monotonic_time_usec(), 0);
+        return (int)MIN((wait_usec + USEC_PER_MSEC - 1) / USEC_PER_MSEC, (time_t)INT32_MAX);
+}
+
+/**
+ * Besides expiring entries, watches lingering connections' descriptors: Peer's retransmitted FIN|ACK must be answered
+ * even if the application stopped waiting on the listener (e.g. it only accepts, now and then). Readable ones are pumped
+ * by the thread, unless a waiter pumps them already (see listener_route()).
+ */
+static void *run_time_wait_table(void *const _unused)
+{
+        (void)_unused;
+        watch_set_t watch_set = {0};
+        pthread_mutex_lock(&table.lock);
+        while (true)
+        {
+                wheel_timer_t *expired_timer;
+                while ((expired_timer = tw_pop_expired(table.timers, get_monotonic_time_usec())) != NULL)
+                        forget_entry(expired_timer->owner);
+                const int wait_msec = get_wait_msec();
+                fill_watch_set(&watch_set); /* Only this thread forgets entries; Listeners outlive the copy. */
+                pthread_mutex_unlock(&table.lock);
+                const int ready_descriptors = poll(watch_set.descriptors, watch_set.count, wait_msec);
+                uint64_t wakeups;
+                if (ready_descriptors > 0 && (watch_set.descriptors[WAKEUP_DESCRIPTOR_INDEX].revents & POLLIN) &&
+                    read(table.wakeup_eventfd, &wakeups, sizeof(wakeups)) == -1 && errno != EAGAIN)
+                        LOG_WARNING("TIME_WAIT table's eventfd read failed; errno(%d):%s.", errno, strerror(errno));
+                if (ready_descriptors > 0)
+                        pump_lingering_descriptors(&watch_set);
+                pthread_mutex_lock(&table.lock);
+        }
+        return NULL;
+}
+
+/* Called unlocked; Waiters that pumped meanwhile leave nothing to route. */
+static void pump_lingering_descriptors(const watch_set_t *const _watch_set)
+{
+        _Bool delayed = false;
+        for (size_t i = WAKEUP_DESCRIPTOR_INDEX + 1; i < _watch_set->count; i++)
+        {
+                if (_watch_set->descriptors[i].revents == 0)
+                        continue;
+                if (!delayed)
+                        poll(NULL, 0, LINGERING_PUMP_DELAY_MSEC);
+                delayed = true;
+                if (listener_route(_watch_set->listeners[i - 1]) == FAILURE)
+                        LOG_WARNING("TIME_WAIT table failed pumping a lingering connection's descriptor.");
+        }
+}
+
+/* Called locked; On allocation failure, descriptors that don't fit go unwatched (until a later call), as before this table's thread pumped. */
+static void fill_watch_set(watch_set_t *const _watch_set)
+{
+        const size_t count = table.listeners_count + 1;
+        struct pollfd *descriptors = NULL;
+        listener_t **listeners = NULL;
+        if (count > _watch_set->capacity && MALLOC_LOG(descriptors, count * sizeof(struct pollfd)) != NULL &&
+            MALLOC_LOG(listeners, count * sizeof(listener_t *)) == NULL)
+                FREE_NULLIFY_LOG(descriptors);
+        if (listeners != NULL)
+        {
+                if (_watch_set->capacity > 0)
+                {
+                        FREE_NULLIFY_LOG(_watch_set->descriptors);
+                        FREE_NULLIFY_LOG(_watch_set->listeners);
+                }
+                _watch_set->descriptors = descriptors;
+                _watch_set->listeners = listeners;
+                _watch_set->capacity = count;
+        }
+        _watch_set->count = 0;
+        if (_watch_set->capacity == 0)
+                return;
+        _watch_set->descriptors[WAKEUP_DESCRIPTOR_INDEX] = (struct pollfd){.fd = table.wakeup_eventfd, .events = POLLIN};
+        _watch_set->count = WAKEUP_DESCRIPTOR_INDEX + 1;
+        for (lingering_listener_t *watched = table.listeners; watched != NULL && _watch_set->count < _watch_set->capacity; watched = watched->next)
+        {
+                _watch_set->descriptors[_watch_set->count] = (struct pollfd){.fd = watched->sd, .events = POLLIN};
+                _watch_set->listeners[_watch_set->count - 1] = watched->listener;
+                _watch_set->count++;
+        }
+}
+
+/* Called locked; Listeners are few, a list will do. */
+static status_t watch_listener(listener_t *const _listener, const int _sd)
+{
+        for (lingering_listener_t *watched = table.listeners; watched != NULL; watched = watched->next)
+        {
+                if (watched->listener != _listener)
+                        continue;
+                watched->entries++;
+                return SUCCESS;
+        }
+        lingering_listener_t *watched = CALLOC_LOG(watched, sizeof(lingering_listener_t));
+        if (watched == NULL)
+                return FAILURE;
+        watched->listener = _listener;
+        watched->sd = _sd;
+        watched->entries = 1;
+        watched->next = table.listeners;
+        table.listeners = watched;
+        table.listeners_count++;
+        return SUCCESS;
+}
+
+/* Called locked. */
+static void unwatch_listener(const listener_t *const _listener)
+{
+        for (lingering_listener_t **watched_address = &table.listeners; *watched_address != NULL; watched_address = &(*watched_address)->next)
+        {
+                lingering_listener_t *watched = *watched_address;
+                if (watched->listener != _listener)
+                        continue;
+                if (--watched->entries > 0)
+                        return;
+                *watched_address = watched->next;
+                table.listeners_count--;
+                FREE_NULLIFY_LOG(watched);
+                return;
+        }
+}
+
+/* Called locked; TIME_WAIT is over. */
+static void forget_entry(time_wait_entry_t *_entry)
+{
+        listener_forget(_entry->listener, &_entry->connection_entry);
+        unwatch_listener(_entry->listener);
+        if (listener_release(&_entry->listener)) /* Listening socket and its other connections are gone. */
+                close(_entry->sd);
+        table.size--;
+        FREE_NULLIFY_LOG(_entry);
+}
+
+static void send_ack(const time_wait_entry_t *const _entry, const int _sd)
+{
+        microtcp_header_t header;
+        memset(&header, 0, sizeof(header)); /* Padding too; Checksum covers it. */
+        header.seq_number = _entry->seq_number;
+        header.ack_number = _entry->ack_number;
+        header.control = ACK_BIT;
+        header.checksum = crc32((const uint8_t *)&header, MICROTCP_HEADER_SIZE);
+        if (sendto(_sd, &header, MICROTCP_HEADER_SIZE, 0, &_entry->peer, sizeof(_entry->peer)) == SENDTO_ERROR)
+                LOG_WARNING("TIME_WAIT table failed re-sending `ACK`; sendto() set errno(%d):%s.", errno, strerror(errno));
+}
@@ -0,0 +1,217 @@
+#include "core/timer_wheel.h"
+#include <stddef.h>
+#include <stdint.h>
+#include "allocator/allocator_macros.h"
+#include "microtcp_helper_functions.h"
+#include "microtcp_helper_macros.h"
+#include "smart_assert.h"
+#include "status.h"
+
+#define SLOT_BITS 6
+#define SLOTS_PER_LEVEL (1 << SLOT_BITS) /* One bit each, in level's `occupied` bitmap. */
+#define SLOT_MASK (SLOTS_PER_LEVEL - 1)
+#define EXPIRED_LEVEL TIMER_WHEEL_LEVELS
+#define WHEEL_REACH_TICKS ((uint64_t)1 << (SLOT_BITS * TIMER_WHEEL_LEVELS)) /* ~28 minutes, with 100μsec ticks. */
+#define NO_TICK UINT64_MAX
+
+struct timer_wheel
+{
+        time_t origin_usec;    /* Monotonic; Tick 0. */
+        uint64_t current_tick; /* Ticks up to it are processed. */
+        wheel_timer_t *slots[TIMER_WHEEL_LEVELS][SLOTS_PER_LEVEL];
+        uint64_t occupied[TIMER_WHEEL_LEVELS];
+        wheel_timer_t *expired; /* Expired, not yet popped. */
+        size_t armed_timers;
+};
+
+static void place_timer(timer_wheel_t *_tw, wheel_timer_t *_timer);
+static void unlink_timer(timer_wheel_t *_tw, wheel_timer_t *_timer);
+static void advance(timer_wheel_t *_tw, uint64_t _target_tick);
+static uint64_t get_next_event_tick(const timer_wheel_t *_tw);
+
+timer_wheel_t *tw_create(void)
+{
+        timer_wheel_t *tw = CALLOC_LOG(tw, sizeof(timer_wheel_t));
+        if (tw == NULL)
+                return NULL;
+        tw->origin_usec = get_monotonic_time_usec();
+        return tw;
+}
+
+/* We request a double pointer, in order to NULLIFY user's wheel pointer. Timers still armed are disarmed (not freed; They are their embedders'). */
+status_t tw_destroy(timer_wheel_t **const _tw_address)
+{
+        SMART_ASSERT(_tw_address != NULL);
+
+#define TW (*_tw_address)
+        if (TW == NULL)
+                return SUCCESS;
+        while (TW->expired != NULL)
+                unlink_timer(TW, TW->expired);
+        for (size_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+                for (size_t slot = 0; slot < SLOTS_PER_LEVEL; slot++)
+                        while (TW->slots[level][slot] != NULL)
+                                unlink_timer(TW, TW->slots[level][slot]);
+        FREE_NULLIFY_LOG(TW);
+        return SUCCESS;
+#undef TW
+}
+
+void tw_timer_init(wheel_timer_t *const _timer, void *const _owner)
+{
+        DEBUG_SMART_ASSERT(_timer != NULL);
+        *_timer = (wheel_timer_t){.owner = _owner};
+}
+
+void tw_arm(timer_wheel_t *const _tw, wheel_timer_t *const _timer, const time_t _expiry_usec)
+{
+        DEBUG_SMART_ASSERT(_tw != NULL, _timer != NULL);
+        if (tw_is_armed(_timer))
+                unlink_timer(_tw, _timer);
+        else
+                _tw->armed_timers++;
+        _timer->expiry_usec = _expiry_usec;
+        _timer->expiry_tick = _expiry_usec <= _tw->origin_usec ? 0 : (uint64_t)(_expiry_usec - _tw->origin_usec + TIMER_WHEEL_TICK_USEC - 1) / TIMER_WHEEL_TICK_USEC;
+        place_timer(_tw, _timer);
+}
+
+void tw_cancel(timer_wheel_t *const _tw, wheel_timer_t *const _timer)
+{
+        DEBUG_SMART_ASSERT(_tw != NULL, _timer != NULL);
+        if (!tw_is_armed(_timer))
+                return;
+        unlink_timer(_tw, _timer);
+        _tw->armed_timers--;
+}
+
+wheel_timer_t *tw_pop_expired(timer_wheel_t *const _tw, const time_t _now_usec)
+{
+        DEBUG_SMART_ASSERT(_tw != NULL);
+        if (_now_usec > _tw->origin_usec)
+                advance(_tw, (uint64_t)(_now_usec - _tw->origin_usec) / TIMER_WHEEL_TICK_USEC);
+        wheel_timer_t *const timer = _tw->expired;
+        if (timer != NULL)
+                tw_cancel(_tw, timer);
+        return timer;
+}
+
+time_t tw_next_expiry_usec(const timer_wheel_t *const _tw)
+{
+        DEBUG_SMART_ASSERT(_tw != NULL);
+        if (_tw->expired != NULL)
+                return _tw->origin_usec + (time_t)_tw->current_tick * TIMER_WHEEL_TICK_USEC;
+        const uint64_t next_event_tick = get_next_event_tick(_tw);
+        return next_event_tick == NO_TICK ? TIMER_WHEEL_NO_EXPIRY : _tw->origin_usec + (time_t)next_event_tick * TIMER_WHEEL_TICK_USEC;
+}
+
+size_t tw_armed_timers(const timer_wheel_t *const _tw)
+{
+        DEBUG_SMART_ASSERT(_tw != NULL);
+        return _tw->armed_timers;
+}
+
+static void link_timer(wheel_timer_t **const _head, wheel_timer_t *const _timer)
+{
+        _timer->next = *_head;
+        if (*_head != NULL)
+                (*_head)->previous_next = &_timer->next;
+        *_head = _timer;
+        _timer->previous_next = _head;
+}
+
+static void unlink_timer(timer_wheel_t *const _tw, wheel_timer_t *const _timer)
+{
+        *_timer->previous_next = _timer->next;
+        if (_timer->next != NULL)
+                _timer->next->previous_next = _timer->previous_next;
+        _timer->next = NULL;
+        _timer->previous_next = NULL;
+        if (_timer->level != EXPIRED_LEVEL && _tw->slots[_timer->level][_timer->slot] == NULL)
+                _tw->occupied[_timer->level] &= ~((uint64_t)1 << _timer->slot);
+}
+
+/**
+ * @brief Level is the lowest one whose turn covers the time left; Slot is picked by expiry's own bits at that level, so
+ * a slot holds a single block of ticks (the next turn's, if level's current block is past). Time left beyond the top
+ * level's turn parks the timer at the farthest tick it reaches.
+ */
+static void place_timer(timer_wheel_t *const _tw, wheel_timer_t *const _timer)
+{
+        if (_timer->expiry_tick <= _tw->current_tick)
+        {
+                _timer->level = EXPIRED_LEVEL;
+                link_timer(&_tw->expired, _timer);
+                return;
+        }
+        const uint64_t ticks_left = MIN(_timer->expiry_tick - _tw->current_tick, WHEEL_REACH_TICKS - 1);
+        const uint64_t tick = _tw->current_tick + ticks_left;
+        uint8_t level = 0;
+        while (ticks_left >= (uint64_t)1 << (SLOT_BITS * (level + 1)))
+                level++;
+        _timer->level = level;
+        _timer->slot = (tick >> (SLOT_BITS * level)) & SLOT_MASK;
+        link_timer(&_tw->slots[level][_timer->slot], _timer);
+        _tw->occupied[level] |= (uint64_t)1 << _timer->slot;
+}
+
+/* Slot's timers are due within the level below's turn; They are placed again, one level (or more) lower. */
+static void cascade(timer_wheel_t *const _tw, const size_t _level, const size_t _slot)
+{
+        wheel_timer_t *timer = _tw->slots[_level][_slot];
+        _tw->slots[_level][_slot] = NULL;
+        _tw->occupied[_level] &= ~((uint64_t)1 << _slot);
+        while (timer != NULL)
+        {
+                wheel_timer_t *const next = timer->next;
+                place_timer(_tw, timer);
+                timer = next;
+        }
+}
+
+static void process_tick(timer_wheel_t *const _tw, const uint64_t _tick)
+{
+        _tw->current_tick = _tick;
+        for (size_t level = 1; level < TIMER_WHEEL_LEVELS; level++) /* A level's slot is entered, once levels below it turned over. */
+        {
+                if ((_tick & (((uint64_t)1 << (SLOT_BITS * level)) - 1)) != 0)
+                        break;
+                cascade(_tw, level, (_tick >> (SLOT_BITS * level)) & SLOT_MASK);
+        }
+        cascade(_tw, 0, _tick & SLOT_MASK); /* Lowest level's slot holds this tick's timers; They expire. */
+}
+
+/* Only ticks where a timer expires or cascades are processed; Ticks in between are skipped. */
+static void advance(timer_wheel_t *const _tw, const uint64_t _target_tick)
+{
+        while (_tw->current_tick < _target_tick)
+        {
+                const uint64_t next_event_tick = get_next_event_tick(_tw);
+                if (next_event_tick > _target_tick)
+                {
+                        _tw->current_tick = _target_tick;
+                        return;
+                }
+                process_tick(_tw, next_event_tick);
+        }
+}
+
+static __always_inline uint64_t rotate_right(const uint64_t _bits, const unsigned _count)
+{
+        return _count == 0 ? _bits : (_bits >> _count) | (_bits << (64 - _count));
+}
+
+/* @returns the first tick past the current one, where an occupied slot is entered (its timers expire or cascade); NO_TICK if none is. */
+static uint64_t get_next_event_tick(const timer_wheel_t *const _tw)
+{
+        uint64_t next_event_tick = NO_TICK;
+        for (size_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+        {
+                if (_tw->occupied[level] == 0)
+                        continue;
+                const unsigned shift = SLOT_BITS * level;
+                const uint64_t current_block = _tw->current_tick >> shift;
+                const uint64_t blocks_ahead = (uint64_t)__builtin_ctzll(rotate_right(_tw->occupied[level], (current_block + 1) & SLOT_MASK)) + 1;
+                next_event_tick = MIN(next_event_tick, (current_block + blocks_ahead) << shift);
+        }
+        return next_event_tick;
+}
@@ -1,8 +1,14 @@
 #include <stddef.h>          // for size_t
 #include <sys/socket.h>      // for socklen_t, sockaddr
 #include <sys/types.h>       // for ssize_t
+#include "core/connection_table.h"
+#include "core/datagram_batch.h"
+#include "core/listen_queue.h"
+#include "core/listener.h"
+#include "core/misc.h"
 #include "core/segment_io.h" // for RECV_SEGMENT_ERROR, RECV_SE...
 #include "core/segment_processing.h"
+#include "core/syn_cookie.h"
 #include "core/socket_stats_updater.h"   // for update_socket_received_coun...
 #include "fsm/microtcp_fsm.h"            // for microtcp_accept_fsm
 #include "fsm_common.h"                  // for SENT_SYN_SEQUENCE_NUMBER_IN...
@@ -11,6 +17,7 @@
 #include "microtcp.h"                    // for microtcp_sock_t, LISTEN
 #include "microtcp_core_macros.h"        // for RETURN_ERROR_IF_MICROTCP_SO...
 #include "microtcp_defines.h"            // for MICROTCP_ACCEPT_FAILURE
+#include "microtcp_helper_functions.h"   // for get_monotonic_time_usec
 #include "microtcp_helper_macros.h"      // for STRINGIFY
 #include "settings/microtcp_settings.h"  // for get_accept_synack_retries
 
@@ -35,8 +42,23 @@ typedef struct
         ssize_t synack_retries_counter;
 } fsm_context_t;
 
+/* Listener mode: Handshakes of every peer progress at once, through listener's listen queue (see core/listen_queue.h);
+ * Accept returns the oldest connection they established. */
+typedef enum
+{
+        BACKLOG_LISTEN_SUBSTATE = LISTEN, /* Initial substate. FSM entry point. */
+        BACKLOG_SEGMENT_RECEIVED_SUBSTATE,
+        BACKLOG_CONNECTION_READY_SUBSTATE,
+        BACKLOG_CONNECTION_ESTABLISHED_SUBSTATE = ESTABLISHED, /* Terminal substate (success). FSM exit point. */
+        BACKLOG_EXIT_FAILURE_SUBSTATE = -1,                    /* Terminal substate (failure). FSM exit point. */
+} accept_backlog_fsm_substates_t;
+
 /* ----------------------------------------- LOCAL HELPER FUNCTIONS ----------------------------------------- */
 static const char *convert_substate_to_string(accept_fsm_substates_t _substate);
+static const char *convert_backlog_substate_to_string(accept_backlog_fsm_substates_t _substate);
+static int microtcp_accept_backlog_fsm(microtcp_sock_t *_socket, struct sockaddr *_address, socklen_t _address_len, listen_queue_t *_lq);
+static status_t send_syn_cookie_synack(microtcp_sock_t *_socket, const struct sockaddr *_address, socklen_t _address_len);
+static _Bool acks_syn_cookie(const struct sockaddr *_peer, const microtcp_header_t *_header);
 
 static accept_fsm_substates_t execute_listen_substate(microtcp_sock_t *_socket, struct sockaddr *const _address,
                                                       socklen_t _address_len, fsm_context_t *_context)
@@ -65,6 +87,36 @@ static accept_fsm_substates_t execute_listen_substate(microtcp_sock_t *_socket,
         }
 }
 
+/**
+ * @brief SYN cookies (see MICROTCP_SO_SYN_COOKIES): SYNs are answered and forgotten; Accept commits to no peer, until
+ * one returns a valid cookie. No SYN|ACK retries either; A peer whose SYN|ACK was lost, retries its SYN.
+ */
+static accept_fsm_substates_t execute_syn_cookie_listen_substate(microtcp_sock_t *_socket, struct sockaddr *const _address,
+                                                                 socklen_t _address_len, fsm_context_t *_context)
+{
+        _context->recv_syn_ret_val = receive_handshake_segment(_socket, _address, _address_len, true);
+        switch (_context->recv_syn_ret_val)
+        {
+        case RECV_SEGMENT_FATAL_ERROR:
+                return EXIT_FAILURE_SUBSTATE;
+        case RECV_SEGMENT_TIMEOUT:
+        case RECV_SEGMENT_ERROR:
+                return LISTEN_SUBSTATE;
+        default:
+                break;
+        }
+
+        const microtcp_header_t *const header = &_socket->segment_receive_buffer->header;
+        if (header->control == SYN_BIT && header->data_len == 0)
+                return send_syn_cookie_synack(_socket, _address, _address_len) == SUCCESS ? LISTEN_SUBSTATE : EXIT_FAILURE_SUBSTATE;
+        if (!acks_syn_cookie(_address, header))
+                return LISTEN_SUBSTATE; /* Stale, forged, or not a handshake's; Dropped. */
+        _socket->seq_number = header->ack_number;
+        _socket->ack_number = header->seq_number;
+        _socket->peer_win_size = header->window;
+        return ACK_RECEIVED_SUBSTATE;
+}
+
 static accept_fsm_substates_t execute_syn_received_substate(microtcp_sock_t *_socket, struct sockaddr *const _address,
                                                             socklen_t _address_len, fsm_context_t *_context)
 {
@@ -132,6 +184,13 @@ int microtcp_accept_fsm(microtcp_sock_t *_socket, struct sockaddr *const _addres
         RETURN_ERROR_IF_SOCKET_ADDRESS_LENGTH_INVALID(MICROTCP_ACCEPT_FAILURE, _address_len, sizeof(*_address));
         /* No argument validation needed. FSMs are called from their
          * respective functions which already vildated their input arguments. */
+        if (_socket->listener != NULL)
+        {
+                listen_queue_t *const lq = listener_lock_listen_queue(_socket->listener);
+                const int accept_ret_val = microtcp_accept_backlog_fsm(_socket, _address, _address_len, lq);
+                listener_unlock_listen_queue(_socket->listener);
+                return accept_ret_val;
+        }
         fsm_context_t context = {.synack_retries_counter = get_accept_synack_retries()};
 
         accept_fsm_substates_t current_substate = LISTEN_SUBSTATE;
@@ -141,7 +200,8 @@ int microtcp_accept_fsm(microtcp_sock_t *_socket, struct sockaddr *const _addres
                 switch (current_substate)
                 {
                 case LISTEN_SUBSTATE:
-                        current_substate = execute_listen_substate(_socket, _address, _address_len, &context);
+                        current_substate = _socket->syn_cookies ? execute_syn_cookie_listen_substate(_socket, _address, _address_len, &context)
+                                                                : execute_listen_substate(_socket, _address, _address_len, &context);
                         break;
                 case SYN_RECEIVED_SUBSTATE:
                         current_substate = execute_syn_received_substate(_socket, _address, _address_len, &context);
@@ -163,7 +223,235 @@ int microtcp_accept_fsm(microtcp_sock_t *_socket, struct sockaddr *const _addres
         }
 }
 
+/* Cookie is our ISN; The SYN is forgotten once SYN|ACK leaves. */
+static status_t send_syn_cookie_synack(microtcp_sock_t *_socket, const struct sockaddr *const _address, const socklen_t _address_len)
+{
+        if (RARE_CASE(syn_cookie_initialize() == FAILURE)) /* Enabling the option generated the key; No cookie goes out without it. */
+                LOG_ERROR_RETURN(FAILURE, "SYN cookie could not be generated; Secret key missing.");
+        const microtcp_header_t *const header = &_socket->segment_receive_buffer->header;
+        _socket->seq_number = syn_cookie_generate(_address, header->seq_number);
+        _socket->ack_number = header->seq_number + SYN_SEQ_NUMBER_INCREMENT;
+        LOG_FSM_ACCEPT("SYN answered with cookie %u.", _socket->seq_number);
+        return send_synack_control_segment(_socket, _address, _address_len) == SEND_SEGMENT_FATAL_ERROR ? FAILURE : SUCCESS;
+}
+
+/* Handshake's ACK carries peer's ISN + 1 and our cookie + 1; So does its first data segment, if that ACK was lost. */
+static _Bool acks_syn_cookie(const struct sockaddr *const _peer, const microtcp_header_t *const _header)
+{
+        return (_header->control & ACK_BIT) && !(_header->control & (SYN_BIT | FIN_BIT | RST_BIT)) &&
+               syn_cookie_validate(_peer, _header->seq_number - SYN_SEQ_NUMBER_INCREMENT, _header->ack_number - SYN_SEQ_NUMBER_INCREMENT);
+}
+
+/* ------------------------------------------- LISTENER MODE (BACKLOG) ------------------------------------------- */
+/* Accepting socket sends every SYN|ACK, on behalf of the connection; Its own sequence numbers are not in use yet. */
+static status_t send_pending_synack(microtcp_sock_t *_socket, pending_connection_t *_connection)
+{
+        _socket->seq_number = _connection->seq_number;
+        _socket->ack_number = _connection->ack_number;
+        if (send_synack_control_segment(_socket, &_connection->peer, sizeof(_connection->peer)) == SEND_SEGMENT_FATAL_ERROR)
+                return FAILURE;
+        _connection->synack_deadline_usec = get_monotonic_time_usec() + _connection->synack_rto_usec; /* Lost sends are retried then too. */
+        return SUCCESS;
+}
+
+/* Each half-open connection has its own SYN|ACK timer, backed off as RTO is (see rto_backoff()). */
+static status_t expire_synack_timers(microtcp_sock_t *_socket, listen_queue_t *_lq)
+{
+        const time_t now_usec = get_monotonic_time_usec();
+        const time_t max_rto_usec = timeval_to_usec(get_microtcp_max_rto());
+        size_t i = 0;
+        while (i < lq_size(_lq))
+        {
+                pending_connection_t *const connection = lq_get(_lq, i);
+                if (connection->entry != NULL || connection->synack_deadline_usec > now_usec)
+                {
+                        i++;
+                        continue;
+                }
+                update_socket_lost_counters(_socket, MICROTCP_HEADER_SIZE);
+                if (connection->synack_retries == 0)
+                {
+                        LOG_FSM_ACCEPT("Synack retries exhausted; Half-open connection dropped.");
+                        lq_remove(_lq, connection); /* Last connection takes its index. */
+                        continue;
+                }
+                connection->synack_retries--;
+                connection->synack_rto_usec = MAX(connection->synack_rto_usec, MIN(2 * connection->synack_rto_usec, max_rto_usec));
+                if (send_pending_synack(_socket, connection) == FAILURE)
+                        return FAILURE;
+                i++;
+        }
+        return SUCCESS;
+}
+
+/* Waits for segments no longer than the next SYN|ACK timer. */
+static time_t get_backlog_wait_usec(const microtcp_sock_t *_socket, listen_queue_t *_lq)
+{
+        const time_t next_deadline_usec = lq_next_synack_deadline(_lq);
+        if (next_deadline_usec == -1)
+                return _socket->rto_usec;
+        return MIN(_socket->rto_usec, MAX(next_deadline_usec - get_monotonic_time_usec(), 0));
+}
+
+static accept_backlog_fsm_substates_t execute_backlog_listen_substate(microtcp_sock_t *_socket, struct sockaddr *const _address,
+                                                                      socklen_t _address_len, listen_queue_t *_lq)
+{
+        if (lq_oldest_established(_lq) != NULL)
+                return BACKLOG_CONNECTION_READY_SUBSTATE;
+        if (expire_synack_timers(_socket, _lq) == FAILURE)
+                return BACKLOG_EXIT_FAILURE_SUBSTATE;
+        if (db_pending_slots(_socket->receive_batch) == 0)
+        {
+                const ssize_t receive_ret_val = listener_receive(_socket, get_backlog_wait_usec(_socket, _lq));
+                if (receive_ret_val == RECV_SEGMENT_FATAL_ERROR)
+                        return BACKLOG_EXIT_FAILURE_SUBSTATE;
+                if (receive_ret_val == RECV_SEGMENT_TIMEOUT)
+                        return BACKLOG_LISTEN_SUBSTATE;
+        }
+        switch (receive_handshake_segment(_socket, _address, _address_len, false))
+        {
+        case RECV_SEGMENT_FATAL_ERROR:
+                return BACKLOG_EXIT_FAILURE_SUBSTATE;
+        case RECV_SEGMENT_TIMEOUT:
+        case RECV_SEGMENT_ERROR: /* Corrupted; Its sender retransmits. */
+                return BACKLOG_LISTEN_SUBSTATE;
+        default:
+                return BACKLOG_SEGMENT_RECEIVED_SUBSTATE;
+        }
+}
+
+/**
+ * @brief Matches the received segment against the listen queue: A new peer's SYN opens a half-open connection (dropped
+ * if backlog is full; Peer retries), a duplicate SYN gets SYN|ACK again, and the ACK of our SYN|ACK establishes it.
+ * Anything else is noise. Data piggybacked on that ACK is dropped with it; Peer retransmits it.
+ */
+static accept_backlog_fsm_substates_t execute_backlog_segment_received_substate(microtcp_sock_t *_socket, struct sockaddr *const _address,
+                                                                                socklen_t _address_len, listen_queue_t *_lq)
+{
+        const microtcp_header_t *const header = &_socket->segment_receive_buffer->header;
+        pending_connection_t *connection = lq_find(_lq, _address);
+        if (connection != NULL && connection->entry != NULL) /* Stale; Routed before its connection was established. */
+                return BACKLOG_LISTEN_SUBSTATE;
+
+        if (header->control & RST_BIT)
+        {
+                if (connection != NULL)
+                        lq_remove(_lq, connection);
+                LOG_FSM_ACCEPT("Handshake failed, received RST");
+                return BACKLOG_LISTEN_SUBSTATE;
+        }
+
+        if (header->control == SYN_BIT && header->data_len == 0)
+        {
+                if (connection == NULL && _socket->syn_cookies)
+                        return send_syn_cookie_synack(_socket, _address, _address_len) == SUCCESS ? BACKLOG_LISTEN_SUBSTATE
+                                                                                                   : BACKLOG_EXIT_FAILURE_SUBSTATE;
+                if (connection == NULL && (connection = lq_add(_lq, _address)) == NULL)
+                        LOG_WARNING_RETURN(BACKLOG_LISTEN_SUBSTATE, "Accept's backlog is full (%zu connections); SYN dropped.", lq_size(_lq));
+                if (connection->synack_rto_usec == 0) /* New one. */
+                {
+                        generate_initial_sequence_number(_socket);
+                        connection->seq_number = _socket->seq_number;
+                        connection->ack_number = header->seq_number + SYN_SEQ_NUMBER_INCREMENT;
+                        connection->synack_retries = get_accept_synack_retries();
+                        connection->synack_rto_usec = timeval_to_usec(get_microtcp_ack_timeout());
+                }
+                return send_pending_synack(_socket, connection) == SUCCESS ? BACKLOG_LISTEN_SUBSTATE : BACKLOG_EXIT_FAILURE_SUBSTATE;
+        }
+
+        if (connection == NULL && _socket->syn_cookies && acks_syn_cookie(_address, header))
+        {
+                /* Peer's first state on our side; Backlog's capacity still bounds what accept has not taken yet. */
+                if ((connection = lq_add(_lq, _address)) == NULL)
+                        LOG_WARNING_RETURN(BACKLOG_LISTEN_SUBSTATE, "Accept's backlog is full (%zu connections); Cookie's ACK dropped.", lq_size(_lq));
+                connection->seq_number = header->ack_number - SYN_SEQ_NUMBER_INCREMENT;
+                connection->ack_number = header->seq_number;
+        }
+        const _Bool acks_synack = (header->control & ACK_BIT) && !(header->control & (SYN_BIT | FIN_BIT)) &&
+                                  connection != NULL && header->ack_number == connection->seq_number + SYN_SEQ_NUMBER_INCREMENT;
+        if (!acks_synack)
+                return BACKLOG_LISTEN_SUBSTATE;
+
+        connection_entry_t *entry = ce_create();
+        if (entry == NULL)
+        {
+                lq_remove(_lq, connection);
+                LOG_ERROR_RETURN(BACKLOG_LISTEN_SUBSTATE, "Failed to allocate established connection's entry; Connection dropped.");
+        }
+        memcpy(&entry->peer, &connection->peer, sizeof(entry->peer));
+        if (listener_attach(_socket, entry) == FAILURE)
+        {
+                ce_destroy(&entry);
+                lq_remove(_lq, connection);
+                return BACKLOG_LISTEN_SUBSTATE;
+        }
+        connection->entry = entry;
+        connection->peer_win_size = header->window;
+        connection->established_time_usec = get_monotonic_time_usec();
+        LOG_FSM_ACCEPT("Handshake completed; Connection queued for accept (%zu in backlog).", lq_size(_lq));
+        return BACKLOG_LISTEN_SUBSTATE;
+}
+
+/* Accepting socket becomes the oldest established connection; Peer's datagrams already wait in its entry's inbox. */
+static accept_backlog_fsm_substates_t execute_backlog_connection_ready_substate(microtcp_sock_t *_socket, struct sockaddr *const _address,
+                                                                                socklen_t _address_len, listen_queue_t *_lq)
+{
+        pending_connection_t *const connection = lq_oldest_established(_lq);
+        DEBUG_SMART_ASSERT(connection != NULL, db_pending_slots(_socket->receive_batch) == 0);
+        memcpy(_address, &connection->peer, _address_len);
+        _socket->seq_number = connection->seq_number + SYN_SEQ_NUMBER_INCREMENT;
+        _socket->ack_number = connection->ack_number;
+        _socket->peer_win_size = connection->peer_win_size;
+        _socket->connection_entry = connection->entry;
+        _socket->peer_address = _address;
+        _socket->state = ESTABLISHED;
+        lq_remove(_lq, connection);
+        return BACKLOG_CONNECTION_ESTABLISHED_SUBSTATE;
+}
+
+/* Called with listener's listen queue locked. */
+static int microtcp_accept_backlog_fsm(microtcp_sock_t *_socket, struct sockaddr *const _address, socklen_t _address_len, listen_queue_t *_lq)
+{
+        accept_backlog_fsm_substates_t current_substate = BACKLOG_LISTEN_SUBSTATE;
+        while (true)
+        {
+                LOG_FSM_ACCEPT("Entering %s", convert_backlog_substate_to_string(current_substate));
+                switch (current_substate)
+                {
+                case BACKLOG_LISTEN_SUBSTATE:
+                        current_substate = execute_backlog_listen_substate(_socket, _address, _address_len, _lq);
+                        break;
+                case BACKLOG_SEGMENT_RECEIVED_SUBSTATE:
+                        current_substate = execute_backlog_segment_received_substate(_socket, _address, _address_len, _lq);
+                        break;
+                case BACKLOG_CONNECTION_READY_SUBSTATE:
+                        current_substate = execute_backlog_connection_ready_substate(_socket, _address, _address_len, _lq);
+                        break;
+                case BACKLOG_CONNECTION_ESTABLISHED_SUBSTATE:
+                        return MICROTCP_ACCEPT_SUCCESS;
+                case BACKLOG_EXIT_FAILURE_SUBSTATE:
+                        return MICROTCP_ACCEPT_FAILURE;
+                default:
+                        FSM_DEFAULT_CASE_HANDLER(convert_backlog_substate_to_string, current_substate, BACKLOG_EXIT_FAILURE_SUBSTATE);
+                        break;
+                }
+        }
+}
+
 // clang-format off
+static const char *convert_backlog_substate_to_string(accept_backlog_fsm_substates_t _substate)
+{
+        switch (_substate)
+        {
+        case BACKLOG_LISTEN_SUBSTATE:                   return STRINGIFY(BACKLOG_LISTEN_SUBSTATE);
+        case BACKLOG_SEGMENT_RECEIVED_SUBSTATE:         return STRINGIFY(BACKLOG_SEGMENT_RECEIVED_SUBSTATE);
+        case BACKLOG_CONNECTION_READY_SUBSTATE:         return STRINGIFY(BACKLOG_CONNECTION_READY_SUBSTATE);
+        case BACKLOG_CONNECTION_ESTABLISHED_SUBSTATE:   return STRINGIFY(BACKLOG_CONNECTION_ESTABLISHED_SUBSTATE);
+        case BACKLOG_EXIT_FAILURE_SUBSTATE:             return STRINGIFY(BACKLOG_EXIT_FAILURE_SUBSTATE);
+        default:                                        return "??ACCEPT_BACKLOG_SUBSTATE??";
+        }
+}
+
 static const char *convert_substate_to_string(accept_fsm_substates_t _substate)
 {
         switch (_substate)
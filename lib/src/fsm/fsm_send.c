@@ -2,27 +2,28 @@
 #include "microtcp.h"
 #include <limits.h>
 #include <unistd.h>
+#include "allocator/allocator_macros.h"
+#include "congestion_control/congestion_control.h"
 #include "core/misc.h"
+#include "core/pacing.h"
 #include "core/segment_processing.h"
 #include "core/socket_stats_updater.h"
 #include "core/send_queue.h"
+#include "core/send_ring_buffer.h"
 #include "core/segment_io.h"
+#include "core/rto_estimator.h"
+#include "core/sack.h"
 #include "settings/microtcp_settings.h"
 #include "logging/microtcp_logger.h"
 #include "microtcp_defines.h"
 #include "smart_assert.h"
 #include "microtcp_core_macros.h"
+#include "fsm/microtcp_fsm.h"
 #include "fsm_common.h"
 #include "logging/microtcp_fsm_logger.h"
 
 #define DUPLICATE_ACK_COUNT_FOR_FAST_RETRANSMIT 3
 
-typedef enum
-{
-        ALGORITHM_SLOW_START,
-        ALGORITHM_CONGESTION_AVOIDANCE
-} send_algorithm_t;
-
 typedef enum
 {
         SEND_DATA_ROUND_SUBSTATE, /* Entry point. */
@@ -34,25 +35,48 @@ typedef enum
         EXIT_SUCCESS_SUBSTATE,
         EXIT_STALLED_SUBSTATE,
         EXIT_FAILURE_SUBSTATE,
+        WOULD_BLOCK_SUBSTATE, /* Buffered send mode: Nothing to do, until ACKs arrive. */
         CONTINUE_SUBSTATE,
 } send_fsm_substates_t;
 
-typedef struct
+/* In buffered send mode, context lives as long as the connection (see `send_fsm_context_t`). */
+struct send_fsm_context
 {
-        const uint8_t *buffer;
-        size_t remaining;
+        const uint8_t *buffer; /* First unacknowledged byte in user's buffer; Unused in buffered send mode (bytes are in `send_ring`). */
+        size_t remaining;      /* Bytes not acknowledged yet. */
+        uint32_t round_unsent; /* Bytes of the current round, that pacing still holds back. */
         uint8_t duplicate_ack_count;
         struct timeval last_ack_timeval;
-        send_algorithm_t current_send_algorithm;
-} fsm_context_t;
+        struct timeval last_transmission_timeval;
+        _Bool fast_recovery;       /* NewReno (RFC 6582); Until every segment in flight on entry is acknowledged. */
+        uint32_t recovery_point;   /* Fast recovery ends once ACK number reaches it; Sequence number following the last segment sent before it. */
+        size_t recovery_inflation; /* Bytes fast recovery adds to congestion control's window; Segments that left the network. */
+        uint32_t high_sacked;        /* SACK: Sequence number following the highest byte peer reported holding; Segments below it and not SACKed are lost. */
+        uint32_t high_retransmitted; /* SACK (RFC 6675's HighRxt): Sequence number following the last hole retransmitted in this recovery. */
+        _Bool block; /* Wait for ACKs; If not set, FSM yields with WOULD_BLOCK_SUBSTATE instead. */
+        _Bool until_free_space; /* Buffered send mode: Blocking FSM yields as soon as ACKs free space in the send ring. */
+};
+typedef struct send_fsm_context fsm_context_t;
 
 static const char *convert_substate_to_string(send_fsm_substates_t _substate);
+static __always_inline send_fsm_substates_t retransmit_segment(microtcp_sock_t *_socket, send_queue_node_t *_node);
+static __always_inline send_fsm_substates_t retransmit_front_segment(microtcp_sock_t *_socket);
+static __always_inline send_fsm_substates_t retransmit_next_hole(microtcp_sock_t *_socket, fsm_context_t *_context);
+static __always_inline void process_sack_blocks(microtcp_sock_t *_socket, fsm_context_t *_context);
 static __always_inline send_fsm_substates_t respond_to_triple_dup_ack(microtcp_sock_t *_socket, fsm_context_t *_context);
+static __always_inline send_fsm_substates_t handle_recovery_ack(microtcp_sock_t *_socket, fsm_context_t *_context, size_t _acked_bytes);
+static __always_inline void release_recovery_data(microtcp_sock_t *_socket, fsm_context_t *_context);
 static __always_inline void respond_to_timeout(microtcp_sock_t *_socket, fsm_context_t *_context);
-static __always_inline void handle_cwnd_increment(microtcp_sock_t *_socket, fsm_context_t *_context, size_t _acked_segments);
+static __always_inline size_t get_send_window(const microtcp_sock_t *_socket, const fsm_context_t *_context);
 static __always_inline void handle_seq_number_increment(microtcp_sock_t *_socket, uint32_t _received_ack_number, size_t _acked_segments);
 static __always_inline void handle_peer_win_size(microtcp_sock_t *_socket);
 static __always_inline uint32_t get_most_recent_ack(uint32_t _ack1, uint32_t _ack2);
+static __always_inline const uint8_t *get_unacked_bytes(const microtcp_sock_t *_socket, const fsm_context_t *_context, size_t _offset, size_t *_contiguous);
+static __always_inline void release_acked_bytes(microtcp_sock_t *_socket, fsm_context_t *_context, size_t _acked_bytes);
+static __always_inline _Bool is_retransmission_timer_expired(const microtcp_sock_t *_socket, const fsm_context_t *_context);
+static __always_inline send_fsm_substates_t store_peer_data(microtcp_sock_t *_socket);
+static __always_inline send_fsm_substates_t transmit_round_segments(microtcp_sock_t *_socket, fsm_context_t *_context);
+static __always_inline void wait_for_pacing(const microtcp_sock_t *_socket);
 
 static __always_inline ssize_t error_tolerant_send_data(microtcp_sock_t *_socket, const void *const _buffer, size_t _segment_size, uint32_t _seq_number)
 {
@@ -67,44 +91,121 @@ static __always_inline ssize_t error_tolerant_send_data(microtcp_sock_t *_socket
         }
 }
 
-/* FAST_RETRANSMIT: response to 3 dup ACK. */
+static __always_inline send_fsm_substates_t retransmit_segment(microtcp_sock_t *const _socket, send_queue_node_t *const _node)
+{
+        _node->retransmitted = true;
+        _socket->stats.fast_retransmits++;
+        const ssize_t send_data_ret_val = error_tolerant_send_data(_socket, _node->buffer, _node->segment_size, _node->seq_number);
+        if (RARE_CASE(send_data_ret_val == SEND_SEGMENT_FATAL_ERROR))
+                return EXIT_FAILURE_SUBSTATE;
+        return CONTINUE_SUBSTATE;
+}
+
+static __always_inline send_fsm_substates_t retransmit_front_segment(microtcp_sock_t *const _socket)
+{
+        return retransmit_segment(_socket, sq_front(_socket->send_queue));
+}
+
+/**
+ * @brief SACK loss recovery (RFC 6675, simplified): Retransmits the first segment, past `high_retransmitted`, that is deemed lost;
+ * Not SACKed, and below `high_sacked` (front segment always is, NewReno's assumption). One per call; Each (dup or partial) ACK
+ * means a segment left the network, so one more may enter it.
+ */
+static __always_inline send_fsm_substates_t retransmit_next_hole(microtcp_sock_t *const _socket, fsm_context_t *const _context)
+{
+        send_queue_node_t *node;
+        for (size_t i = sq_find_index(_socket->send_queue, _context->high_retransmitted); (node = sq_get(_socket->send_queue, i)) != NULL; i++)
+        {
+                if (node->sacked)
+                        continue;
+                if (i != 0 && (int32_t)(_context->high_sacked - node->seq_number) <= 0) /* Nothing SACKed past it; Not known lost. */
+                        break;
+                _context->high_retransmitted = node->seq_number + node->segment_size;
+                return retransmit_segment(_socket, node);
+        }
+        return CONTINUE_SUBSTATE;
+}
+
+/* Every ACK, duplicate or not, may carry SACK blocks; They are applied before ACK number is. */
+static __always_inline void process_sack_blocks(microtcp_sock_t *const _socket, fsm_context_t *const _context)
+{
+        const uint32_t front_seq_number = sq_front(_socket->send_queue)->seq_number;
+        if ((int32_t)(_context->high_sacked - front_seq_number) < 0) /* Left behind by cumulative ACKs. */
+                _context->high_sacked = front_seq_number;
+        rrb_block_t blocks[SACK_MAX_BLOCKS];
+        const size_t block_count = sack_decode(&_socket->segment_receive_buffer->header, blocks);
+        for (size_t i = 0; i < block_count; i++)
+        {
+                if (sq_mark_sacked(_socket->send_queue, blocks[i].seq_number, blocks[i].length) == 0)
+                        continue;
+                _context->high_sacked = get_most_recent_ack(_context->high_sacked, blocks[i].seq_number + blocks[i].length);
+        }
+}
+
+/* FAST_RETRANSMIT: response to 3 dup ACK; Congestion control reduces its window (e.g. Reno halves it), and FSM enters fast recovery. */
 static __always_inline send_fsm_substates_t respond_to_triple_dup_ack(microtcp_sock_t *const _socket, fsm_context_t *const _context)
 {
         LOG_WARNING("SendFSM received 3-duplicate ACKs!");
-        const send_queue_node_t *retransmission_node = sq_front(_socket->send_queue);
-        const ssize_t send_data_ret_val = error_tolerant_send_data(_socket, retransmission_node->buffer, retransmission_node->segment_size, retransmission_node->seq_number);
-        if (RARE_CASE(send_data_ret_val == SEND_SEGMENT_FATAL_ERROR))
+        _context->high_retransmitted = sq_front(_socket->send_queue)->seq_number;
+        if (RARE_CASE(retransmit_next_hole(_socket, _context) == EXIT_FAILURE_SUBSTATE))
                 return EXIT_FAILURE_SUBSTATE;
 
-        _socket->ssthresh = MAX(MICROTCP_MSS, _socket->cwnd / 2);
-        _socket->cwnd = MICROTCP_MSS;
+        const size_t bytes_in_flight = sq_stored_bytes(_socket->send_queue);
+        cc_on_loss(_socket->congestion_control, _socket, bytes_in_flight);
+        _context->round_unsent = 0; /* Round was sized by the window loss just shrunk. */
+        _context->recovery_inflation = DUPLICATE_ACK_COUNT_FOR_FAST_RETRANSMIT * MICROTCP_MSS; /* Dup ACKs are segments that left the network. */
+        _context->recovery_point = _socket->seq_number + bytes_in_flight;
         _context->duplicate_ack_count = 0;
-        _context->current_send_algorithm = ALGORITHM_CONGESTION_AVOIDANCE;
+        _context->fast_recovery = true;
+        release_recovery_data(_socket, _context);
+        return CONTINUE_SUBSTATE;
+}
+
+/**
+ * @brief NewReno: A partial ACK (below `recovery_point`) uncovers the next hole, which is retransmitted at once,
+ * instead of waiting for 3 more dup ACKs (or a timeout); Full ACK deflates window back to congestion control's and ends fast recovery.
+ */
+static __always_inline send_fsm_substates_t handle_recovery_ack(microtcp_sock_t *const _socket, fsm_context_t *const _context, const size_t _acked_bytes)
+{
+        if ((int32_t)(_context->recovery_point - _socket->seq_number) > 0) /* Partial ACK. */
+        {
+                _context->recovery_inflation = (_context->recovery_inflation > _acked_bytes ? _context->recovery_inflation - _acked_bytes : 0) + MICROTCP_MSS; /* Partial deflation. */
+                release_recovery_data(_socket, _context);
+                return _socket->sack ? retransmit_next_hole(_socket, _context) : retransmit_front_segment(_socket);
+        }
+        _context->round_unsent = 0; /* Next round is sized by the deflated window. */
+        _context->recovery_inflation = 0;
+        _context->fast_recovery = false;
         return CONTINUE_SUBSTATE;
 }
 
+/**
+ * @brief Fast recovery keeps the ACK clock running (RFC 6582); Unsent bytes, that the inflated window leaves room for, join the current round.
+ * Rounds otherwise start only once Send-Queue drains, which recovery's outstanding hole prevents.
+ */
+static __always_inline void release_recovery_data(microtcp_sock_t *const _socket, fsm_context_t *const _context)
+{
+        const size_t bytes_in_flight = sq_stored_bytes(_socket->send_queue);
+        const size_t window = MIN(get_send_window(_socket, _context), (size_t)_socket->segment_receive_buffer->header.window);
+        DEBUG_SMART_ASSERT(_context->remaining >= bytes_in_flight);
+        _context->round_unsent = window > bytes_in_flight ? MIN(window - bytes_in_flight, _context->remaining - bytes_in_flight) : 0;
+}
+
 static __always_inline void respond_to_timeout(microtcp_sock_t *const _socket, fsm_context_t *const _context)
 {
         LOG_WARNING("SendFSM response timed-out!");
-        _socket->ssthresh = MAX(_socket->cwnd / 2, MICROTCP_MSS);
-        _socket->cwnd = MICROTCP_MSS;
+        _socket->stats.timeouts++;
+        rto_backoff(_socket);
+        cc_on_timeout(_socket->congestion_control, _socket, sq_stored_bytes(_socket->send_queue));
+        _context->round_unsent = 0;
         _context->duplicate_ack_count = 0;
-        _context->current_send_algorithm = ALGORITHM_SLOW_START;
+        _context->recovery_inflation = 0;
+        _context->fast_recovery = false;
 }
 
-static __always_inline void handle_cwnd_increment(microtcp_sock_t *const _socket, fsm_context_t *const _context, const size_t _acked_segments)
+static __always_inline size_t get_send_window(const microtcp_sock_t *const _socket, const fsm_context_t *const _context)
 {
-        DEBUG_SMART_ASSERT(_context->current_send_algorithm == ALGORITHM_SLOW_START ||
-                           _context->current_send_algorithm == ALGORITHM_CONGESTION_AVOIDANCE);
-        if (_context->current_send_algorithm == ALGORITHM_SLOW_START)
-        {
-                _socket->cwnd += _acked_segments * MICROTCP_MSS;
-                if (_socket->cwnd > _socket->ssthresh)
-                        _context->current_send_algorithm = ALGORITHM_CONGESTION_AVOIDANCE;
-        }
-        else if (_context->current_send_algorithm == ALGORITHM_CONGESTION_AVOIDANCE)
-                for (size_t i = 0; i < _acked_segments; i++)
-                        _socket->cwnd += MAX((MICROTCP_MSS * MICROTCP_MSS) / _socket->cwnd, 1); /* If CWND > MSS^2, increament by 1 byte (tahoe). */
+        return cc_cwnd(_socket->congestion_control, _socket) + _context->recovery_inflation;
 }
 
 static __always_inline void handle_seq_number_increment(microtcp_sock_t *const _socket, const uint32_t _received_ack_number, const size_t _acked_segments)
@@ -115,7 +216,9 @@ static __always_inline void handle_seq_number_increment(microtcp_sock_t *const _
 
 static __always_inline void handle_peer_win_size(microtcp_sock_t *const _socket)
 {
-        _socket->peer_win_size = _socket->segment_receive_buffer->header.window - sq_stored_bytes(_socket->send_queue);
+        const size_t advertised_window = _socket->segment_receive_buffer->header.window;
+        const size_t bytes_in_flight = sq_stored_bytes(_socket->send_queue);
+        _socket->peer_win_size = advertised_window > bytes_in_flight ? advertised_window - bytes_in_flight : 0;
 }
 
 static __always_inline uint32_t get_most_recent_ack(const uint32_t _ack1, const uint32_t _ack2)
@@ -123,14 +226,126 @@ static __always_inline uint32_t get_most_recent_ack(const uint32_t _ack1, const
         return (int32_t)(_ack1 - _ack2) > 0 ? _ack1 : _ack2;
 }
 
+/**
+ * @brief Points to the unacknowledged byte `_offset` bytes after the first one; In user's buffer, or in socket's send ring.
+ * @param _contiguous is set to how many bytes, up to the last unacknowledged one, are contiguous in memory.
+ */
+static __always_inline const uint8_t *get_unacked_bytes(const microtcp_sock_t *const _socket, const fsm_context_t *const _context,
+                                                        const size_t _offset, size_t *const _contiguous)
+{
+        if (_socket->send_ring != NULL)
+                return srb_peek(_socket->send_ring, _offset, _contiguous);
+        *_contiguous = _context->remaining - _offset;
+        return _context->buffer + _offset;
+}
+
+static __always_inline void release_acked_bytes(microtcp_sock_t *const _socket, fsm_context_t *const _context, const size_t _acked_bytes)
+{
+        _context->remaining -= _acked_bytes;
+        if (_socket->send_ring != NULL)
+                srb_release(_socket->send_ring, _acked_bytes);
+        else
+                _context->buffer += _acked_bytes;
+}
+
+/* Non-blocking receptions can't rely on socket's timeout; Timer runs from the last transmission or ACK, whichever is latest. */
+static __always_inline _Bool is_retransmission_timer_expired(const microtcp_sock_t *const _socket, const fsm_context_t *const _context)
+{
+        return elapsed_time_usec(_context->last_ack_timeval) > _socket->rto_usec &&
+               elapsed_time_usec(_context->last_transmission_timeval) > _socket->rto_usec;
+}
+
+/**
+ * @brief Buffered send mode: Peer's data may arrive while we wait for ACKs; It is stored in RRB, for microtcp_recv() to pop.
+ * Segments RRB rejects are ACKed too; A retransmitted one means peer missed our last ACK, and both sides could end up waiting on each other.
+ */
+static __always_inline send_fsm_substates_t store_peer_data(microtcp_sock_t *const _socket)
+{
+        receive_ring_buffer_t *const bytestream_rrb = _socket->bytestream_rrb;
+        if (rrb_append(bytestream_rrb, _socket->segment_receive_buffer) > 0)
+        {
+                _socket->ack_number = rrb_last_consumed_seq_number(bytestream_rrb) + rrb_consumable_bytes(bytestream_rrb) + 1;
+                _socket->curr_win_size = rrb_size(bytestream_rrb) - rrb_consumable_bytes(bytestream_rrb);
+        }
+        if (send_ack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address)) == SEND_SEGMENT_FATAL_ERROR)
+                return EXIT_FAILURE_SUBSTATE;
+        return CONTINUE_SUBSTATE;
+}
+
+/**
+ * @brief Transmits round's unsent bytes, as many as pacing allows; They follow the ones in flight, and leave with as few sendmmsg() calls as possible.
+ * Nothing in flight, means nothing would clock the rest out; So the first segment always leaves, taking pacing into debt if need be.
+ */
+static __always_inline send_fsm_substates_t transmit_round_segments(microtcp_sock_t *const _socket, fsm_context_t *const _context)
+{
+        const size_t first_new_index = sq_stored_segments(_socket->send_queue);
+        const size_t allowance = first_new_index == 0 ? MAX(pacing_allowance(_socket), MICROTCP_MSS) : pacing_allowance(_socket);
+        size_t total_data_bytes_sent = 0;
+        while (_context->round_unsent > 0 && total_data_bytes_sent < allowance && !sq_is_full(_socket->send_queue))
+        {
+                const size_t unacked_offset = sq_stored_bytes(_socket->send_queue);
+                size_t contiguous_bytes = 0; /* Segments of a send ring are cut on its wrap-around. */
+                const uint8_t *const payload = get_unacked_bytes(_socket, _context, unacked_offset, &contiguous_bytes);
+                const size_t payload_size = MIN(MIN(_context->round_unsent, MICROTCP_MSS), contiguous_bytes);
+                const uint32_t segment_seq_number = _socket->seq_number + unacked_offset;
+
+                const ssize_t segment_bytes_queued = queue_data_segment(_socket, payload, payload_size, segment_seq_number);
+                if (RARE_CASE(segment_bytes_queued == SEND_SEGMENT_FATAL_ERROR))
+                        return EXIT_FAILURE_SUBSTATE;
+
+                DEBUG_SMART_ASSERT((size_t)segment_bytes_queued == payload_size + MICROTCP_HEADER_SIZE);
+
+                sq_enqueue(_socket->send_queue, segment_seq_number, payload_size, payload);
+                _context->round_unsent -= payload_size;
+                total_data_bytes_sent += payload_size;
+        }
+        if (total_data_bytes_sent == 0)
+                return CONTINUE_SUBSTATE;
+        if (RARE_CASE(flush_data_segments(_socket) == SEND_SEGMENT_FATAL_ERROR))
+                return EXIT_FAILURE_SUBSTATE;
+        pacing_consume(_socket, total_data_bytes_sent);
+        _context->last_transmission_timeval = get_current_timeval();
+        const time_t transmission_time_usec = get_monotonic_time_usec(); /* RTT samples start once segments are on the wire. */
+        const uint64_t delivered = cc_delivered(_socket->congestion_control);
+        for (size_t i = first_new_index; i < sq_stored_segments(_socket->send_queue); i++)
+        {
+                send_queue_node_t *const node = sq_get(_socket->send_queue, i);
+                node->transmission_time_usec = transmission_time_usec;
+                node->delivered_at_send = delivered;
+        }
+        return CONTINUE_SUBSTATE;
+}
+
+#define NSEC_PER_USEC (1000)
+#define USEC_PER_SEC (1000000)
+static __always_inline void wait_for_pacing(const microtcp_sock_t *const _socket)
+{
+        const time_t sleep_usec = pacing_delay_usec(_socket);
+        if (sleep_usec == 0)
+                return;
+        const struct timespec nanosleep_interval = {.tv_sec = sleep_usec / USEC_PER_SEC, .tv_nsec = (sleep_usec % USEC_PER_SEC) * NSEC_PER_USEC};
+        clock_nanosleep(CLOCK_MONOTONIC, 0, &nanosleep_interval, NULL);
+}
+#undef USEC_PER_SEC
+#undef NSEC_PER_USEC
+
 static __always_inline send_fsm_substates_t handle_ack_reception(microtcp_sock_t *_socket, fsm_context_t *_context)
 {
         const uint32_t received_ack_number = _socket->segment_receive_buffer->header.ack_number;
         const microtcp_segment_t *control_segment = _socket->segment_receive_buffer;
         DEBUG_SMART_ASSERT(sq_front(_socket->send_queue) != NULL);
+        if (_socket->sack)
+                process_sack_blocks(_socket, _context);
 
         if (sq_front(_socket->send_queue)->seq_number == received_ack_number) /* check for DUPLICATE ACK */
         {
+                _socket->stats.duplicate_acks++;
+                if (_context->fast_recovery)
+                {
+                        _context->recovery_inflation += MICROTCP_MSS; /* Another segment left the network. */
+                        release_recovery_data(_socket, _context);
+                        return _socket->sack ? retransmit_next_hole(_socket, _context) : CONTINUE_SUBSTATE;
+                }
                 if (++_context->duplicate_ack_count == DUPLICATE_ACK_COUNT_FOR_FAST_RETRANSMIT)
                         if (respond_to_triple_dup_ack(_socket, _context) == EXIT_FAILURE_SUBSTATE)
                                 return EXIT_FAILURE_SUBSTATE;
@@ -139,43 +354,56 @@ static __always_inline send_fsm_substates_t handle_ack_reception(microtcp_sock_t
         _context->duplicate_ack_count = 0;
         _socket->ack_number = get_most_recent_ack(_socket->ack_number, control_segment->header.seq_number);
         const size_t pre_dequeue_bytes = sq_stored_bytes(_socket->send_queue);
-        const size_t acked_segments = sq_dequeue(_socket->send_queue, received_ack_number);
+        send_queue_node_t last_acked_node;
+        const size_t acked_segments = sq_dequeue(_socket->send_queue, received_ack_number, &last_acked_node);
         const size_t post_dequeue_bytes = sq_stored_bytes(_socket->send_queue);
-        _context->remaining -= (pre_dequeue_bytes - post_dequeue_bytes);
-        _context->buffer += (pre_dequeue_bytes - post_dequeue_bytes);
+        const size_t acked_bytes = pre_dequeue_bytes - post_dequeue_bytes;
+        release_acked_bytes(_socket, _context, acked_bytes);
+        handle_seq_number_increment(_socket, received_ack_number, acked_segments);
         if (COMMON_CASE(acked_segments))
+        {
                 _context->last_ack_timeval = get_current_timeval();
-        handle_seq_number_increment(_socket, received_ack_number, acked_segments);
-        handle_cwnd_increment(_socket, _context, acked_segments);
+                const time_t now_usec = get_monotonic_time_usec();
+                const time_t rtt_usec = COMMON_CASE(!last_acked_node.retransmitted) ? MAX(now_usec - last_acked_node.transmission_time_usec, 1) : 0; /* Karn's rule. */
+                if (COMMON_CASE(rtt_usec != 0))
+                {
+                        rto_sample(_socket, rtt_usec);
+                        update_socket_rtt_histogram(_socket, rtt_usec);
+                }
+                if (RARE_CASE(_context->fast_recovery) && handle_recovery_ack(_socket, _context, acked_bytes) == EXIT_FAILURE_SUBSTATE)
+                        return EXIT_FAILURE_SUBSTATE;
+                const cc_ack_sample_t ack_sample = {.acked_bytes = acked_bytes,
+                                                    .acked_segments = acked_segments,
+                                                    .bytes_in_flight = post_dequeue_bytes,
+                                                    .rtt_usec = rtt_usec,
+                                                    .now_usec = now_usec,
+                                                    .delivered_at_send = last_acked_node.delivered_at_send,
+                                                    .in_recovery = _context->fast_recovery};
+                cc_on_ack(_socket->congestion_control, _socket, &ack_sample);
+        }
         handle_peer_win_size(_socket);
-        if (RARE_CASE(_socket->segment_receive_buffer->header.window == 0)) /* IMPOSSIBLE_CASE ACTUALLY... (in single thread setup). */
+        if (RARE_CASE(_socket->segment_receive_buffer->header.window == 0)) /* Peer's application fell behind (e.g. busy, while its engine thread ACKs). */
+        {
+                _context->round_unsent = 0;
                 return PEER_WINDOW_ZERO_SUBSTATE;
+        }
         return CONTINUE_SUBSTATE;
 }
 
 static inline send_fsm_substates_t execute_send_data_round_substate(microtcp_sock_t *const _socket, fsm_context_t *const _context)
 {
         DEBUG_SMART_ASSERT(_socket != NULL, _context != NULL);
-        DEBUG_SMART_ASSERT(_socket->state == ESTABLISHED, _context->buffer != NULL, sq_is_empty(_socket->send_queue));
+        DEBUG_SMART_ASSERT(_socket->state == ESTABLISHED, sq_is_empty(_socket->send_queue));
         if (_context->remaining == 0)
                 return EXIT_SUCCESS_SUBSTATE; /* EXIT point. */
+        if (RARE_CASE(_socket->peer_win_size == 0))
+                return PEER_WINDOW_ZERO_SUBSTATE;
 
-        uint32_t bytes_to_send = MIN(MIN(_socket->cwnd, _socket->peer_win_size), _context->remaining);
-        uint32_t total_data_bytes_sent = 0;
-        while (total_data_bytes_sent != bytes_to_send)
-        {
-                const size_t payload_size = MIN(bytes_to_send - total_data_bytes_sent, MICROTCP_MSS);
-                const uint32_t segment_seq_number = _socket->seq_number + total_data_bytes_sent;
-
-                const ssize_t segment_bytes_sent = error_tolerant_send_data(_socket, _context->buffer + total_data_bytes_sent, payload_size, segment_seq_number);
-                if (RARE_CASE(segment_bytes_sent == SEND_SEGMENT_FATAL_ERROR))
-                        return EXIT_FAILURE_SUBSTATE; /* EXIT point. */
-
-                DEBUG_SMART_ASSERT((size_t)segment_bytes_sent == payload_size + MICROTCP_HEADER_SIZE);
-
-                sq_enqueue(_socket->send_queue, segment_seq_number, payload_size, _context->buffer + total_data_bytes_sent);
-                total_data_bytes_sent += (segment_bytes_sent - MICROTCP_HEADER_SIZE);
-        }
+        /* Round is also bounded by Send-Queue's slots (peer's window may only grow past it, if peer misbehaves). */
+        const size_t send_queue_limit = sq_capacity(_socket->send_queue) * MICROTCP_MSS;
+        _context->round_unsent = MIN(MIN(MIN(get_send_window(_socket, _context), _socket->peer_win_size), _context->remaining), send_queue_limit);
+        if (RARE_CASE(transmit_round_segments(_socket, _context) == EXIT_FAILURE_SUBSTATE))
+                return EXIT_FAILURE_SUBSTATE; /* EXIT point. */
         return RECV_ACK_ROUND_SUBSTATE;
 }
 
@@ -185,7 +413,10 @@ static inline send_fsm_substates_t receive_and_process_ack(microtcp_sock_t *cons
         switch (recv_ack_ret_val)
         {
         case RECV_SEGMENT_ERROR:
+                break;
         case RECV_SEGMENT_CARRIES_DATA:
+                if (_socket->send_ring != NULL)
+                        return store_peer_data(_socket);
                 break;
         case RECV_SEGMENT_TIMEOUT:
                 if (_block == true) /* If in block, timeout timer expired. */
@@ -193,7 +424,7 @@ static inline send_fsm_substates_t receive_and_process_ack(microtcp_sock_t *cons
                         respond_to_timeout(_socket, _context);
                         return RETRANSMISSIONS_SUBSTATE;
                 }
-                break;
+                return WOULD_BLOCK_SUBSTATE;
         case RECV_SEGMENT_FINACK_UNEXPECTED:
                 return FINACK_RECEPTION_SUBSTATE;
         case RECV_SEGMENT_RST_RECEIVED:
@@ -209,13 +440,29 @@ static inline send_fsm_substates_t receive_and_process_ack(microtcp_sock_t *cons
 static inline send_fsm_substates_t execute_recv_ack_round_substate(microtcp_sock_t *_socket, fsm_context_t *_context)
 {
         DEBUG_SMART_ASSERT(_socket != NULL, _context != NULL);
-        DEBUG_SMART_ASSERT(_socket->state == ESTABLISHED, _context->buffer != NULL);
+        DEBUG_SMART_ASSERT(_socket->state == ESTABLISHED);
 
         while (!sq_is_empty(_socket->send_queue))
         {
-                const send_fsm_substates_t next_substate = receive_and_process_ack(_socket, _context, true);
+                /* Round's unsent bytes leave as pacing allows; Meanwhile ACKs are polled, not waited for. */
+                if (_context->round_unsent > 0 && transmit_round_segments(_socket, _context) == EXIT_FAILURE_SUBSTATE)
+                        return EXIT_FAILURE_SUBSTATE;
+                const _Bool paced = _context->round_unsent > 0;
+                const send_fsm_substates_t next_substate = receive_and_process_ack(_socket, _context, _context->block && !paced);
+                if (next_substate == WOULD_BLOCK_SUBSTATE && is_retransmission_timer_expired(_socket, _context))
+                {
+                        respond_to_timeout(_socket, _context);
+                        return RETRANSMISSIONS_SUBSTATE;
+                }
+                if (next_substate == WOULD_BLOCK_SUBSTATE && _context->block) /* Only a paced round gets here. */
+                {
+                        wait_for_pacing(_socket);
+                        continue;
+                }
                 if (next_substate != CONTINUE_SUBSTATE)
                         return next_substate;
+                if (RARE_CASE(_context->until_free_space) && srb_free_space(_socket->send_ring) > 0)
+                        return WOULD_BLOCK_SUBSTATE; /* Round resumes on the next call. */
         }
         return SEND_DATA_ROUND_SUBSTATE;
 }
@@ -223,11 +470,19 @@ static inline send_fsm_substates_t execute_recv_ack_round_substate(microtcp_sock
 static inline send_fsm_substates_t execute_retransmissions_substate(microtcp_sock_t *const _socket, fsm_context_t *const _context)
 {
         uint32_t bytes_resent = 0;
-        send_queue_node_t *curr_node = sq_front(_socket->send_queue);
-        while (curr_node != NULL)
+        size_t curr_index = 0;
+        send_queue_node_t *curr_node;
+        while ((curr_node = sq_get(_socket->send_queue, curr_index)) != NULL)
         {
-                if (bytes_resent + curr_node->segment_size > _socket->cwnd) /* Hit transmission limit. */
+                if (curr_node->sacked) /* Peer holds it already. */
+                {
+                        curr_index++;
+                        continue;
+                }
+                if (bytes_resent + curr_node->segment_size > get_send_window(_socket, _context)) /* Hit transmission limit. */
                         break;
+                curr_node->retransmitted = true;
+                _socket->stats.timeout_retransmits++;
                 update_socket_lost_counters(_socket, curr_node->segment_size + MICROTCP_HEADER_SIZE);
                 ssize_t send_dat_ret_val = error_tolerant_send_data(_socket, curr_node->buffer, curr_node->segment_size, curr_node->seq_number);
                 if (RARE_CASE(send_dat_ret_val == SEND_SEGMENT_FATAL_ERROR))
@@ -235,13 +490,14 @@ static inline send_fsm_substates_t execute_retransmissions_substate(microtcp_soc
 
                 const size_t stored_segments_pre_ack = sq_stored_segments(_socket->send_queue);
                 const send_fsm_substates_t next_substate = receive_and_process_ack(_socket, _context, false);
-                if (next_substate != CONTINUE_SUBSTATE)
+                if (next_substate != CONTINUE_SUBSTATE && next_substate != WOULD_BLOCK_SUBSTATE)
                         return next_substate;
                 if (stored_segments_pre_ack == sq_stored_segments(_socket->send_queue)) /* No ACK, or ACK didn't match. SEND-NEXT */
-                        curr_node = curr_node->next;
+                        curr_index++;
                 else
-                        curr_node = sq_front(_socket->send_queue); /* ACK, match segment in send_queue. FAST-FORWARD. */
+                        curr_index = 0; /* ACK, match segment in send_queue. FAST-FORWARD. */
         }
+        _context->last_transmission_timeval = get_current_timeval();
         return RECV_ACK_ROUND_SUBSTATE; /* We performed the interleaved (with ack reception) retransmissions. Now listen for ACKs */
 }
 
@@ -278,44 +534,84 @@ static __always_inline ssize_t execute_rst_reception_substate(microtcp_sock_t *c
         return (ssize_t)(_bytes_sent > 0 ? _bytes_sent : MICROTCP_SEND_FAILURE);
 }
 
+/* Peer's window reopened (ACK to a window probe, or any ACK while it was closed). */
+static __always_inline send_fsm_substates_t handle_window_update(microtcp_sock_t *const _socket, fsm_context_t *const _context)
+{
+        _context->last_ack_timeval = get_current_timeval(); /* Peer is alive; Closed window is not a stall. */
+        if (sq_is_empty(_socket->send_queue))
+                _socket->peer_win_size = _socket->segment_receive_buffer->header.window;
+        else
+        {
+                const send_fsm_substates_t next_substate = handle_ack_reception(_socket, _context);
+                if (next_substate != CONTINUE_SUBSTATE)
+                        return next_substate;
+        }
+        return _socket->segment_receive_buffer->header.window == 0 ? PEER_WINDOW_ZERO_SUBSTATE : RECV_ACK_ROUND_SUBSTATE;
+}
+
 #define NSEC_PER_USEC (1000)
+#define USEC_PER_SEC (1000000)
+/**
+ * @brief Probes peer's closed window with a WIN|ACK, once per RTO.
+ * Blocking FSM sleeps until the next probe is due; Non-blocking one yields instead, and probe's reply is processed
+ * as any other ACK, by microtcp_send_fsm_process_ack().
+ */
 static __always_inline send_fsm_substates_t execute_peer_window_zero_substate(microtcp_sock_t *_socket, fsm_context_t *_context)
 {
-        while (true)
+        const time_t elapsed_usec = elapsed_time_usec(_context->last_transmission_timeval);
+        if (elapsed_usec < _socket->rto_usec)
         {
-                const struct timeval microtcp_timeout = get_microtcp_ack_timeout();
-                const struct timespec nanosleep_interval = {.tv_sec = microtcp_timeout.tv_sec, .tv_nsec = microtcp_timeout.tv_usec * NSEC_PER_USEC};
+                if (!_context->block)
+                        return WOULD_BLOCK_SUBSTATE;
+                const time_t sleep_usec = _socket->rto_usec - elapsed_usec;
+                const struct timespec nanosleep_interval = {.tv_sec = sleep_usec / USEC_PER_SEC, .tv_nsec = (sleep_usec % USEC_PER_SEC) * NSEC_PER_USEC};
                 clock_nanosleep(CLOCK_MONOTONIC, 0, &nanosleep_interval, NULL);
-                send_winack_control_segment(_socket);
-                ssize_t recv_ack_ret_val = receive_ack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address), _socket->seq_number + 1);
-                switch (recv_ack_ret_val)
-                {
-                case RECV_SEGMENT_FATAL_ERROR:
+        }
+        if (send_winack_control_segment(_socket) == SEND_SEGMENT_FATAL_ERROR)
+                return EXIT_FAILURE_SUBSTATE;
+        _context->last_transmission_timeval = get_current_timeval();
+        if (!_context->block)
+                return WOULD_BLOCK_SUBSTATE;
+
+        /* Peer ACKs whatever it received so far; That is not necessarily our `seq_number`, if segments were in flight. */
+        switch (receive_data_ack_segment(_socket, true))
+        {
+        case RECV_SEGMENT_FATAL_ERROR:
+                return EXIT_FAILURE_SUBSTATE;
+        case RECV_SEGMENT_FINACK_UNEXPECTED:
+                return FINACK_RECEPTION_SUBSTATE;
+        case RECV_SEGMENT_RST_RECEIVED:
+                return RST_RECEPTION_SUBSTATE;
+        case RECV_SEGMENT_CARRIES_DATA:
+                if (_socket->send_ring != NULL && store_peer_data(_socket) == EXIT_FAILURE_SUBSTATE)
                         return EXIT_FAILURE_SUBSTATE;
-                case RECV_SEGMENT_FINACK_UNEXPECTED:
-                        return FINACK_RECEPTION_SUBSTATE;
-                case RECV_SEGMENT_RST_RECEIVED:
-                        return RST_RECEPTION_SUBSTATE;
-                case RECV_SEGMENT_TIMEOUT:
-                        return PEER_WINDOW_ZERO_SUBSTATE;
-                case RECV_SEGMENT_ERROR:
-                        return PEER_WINDOW_ZERO_SUBSTATE;
-                default:
-                        if (_socket->peer_win_size != 0)
-                                return SEND_DATA_ROUND_SUBSTATE;
-                        return PEER_WINDOW_ZERO_SUBSTATE;
-                        _context->last_ack_timeval = get_current_timeval();
-                }
+                return PEER_WINDOW_ZERO_SUBSTATE;
+        case RECV_SEGMENT_TIMEOUT:
+        case RECV_SEGMENT_ERROR:
+                return PEER_WINDOW_ZERO_SUBSTATE;
+        default:
+                return handle_window_update(_socket, _context);
         }
 }
+#undef USEC_PER_SEC
 #undef NSEC_PER_USEC
 
+/**
+ * Buffered send mode: microtcp_send() already reported the stored bytes as sent, and they can no longer be delivered;
+ * Connection is aborted (peer gets an RST), so following calls fail, instead of silently skipping them.
+ */
 static __always_inline ssize_t execute_exit_stalled_substate(microtcp_sock_t *const _socket, const size_t _bytes_sent)
 {
         DEBUG_SMART_ASSERT(_bytes_sent < SSIZE_MAX);
         sq_flush(_socket->send_queue);
+        if (_socket->send_ring != NULL)
+        {
+                send_rstack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address));
+                _socket->state = RESET;
+                LOG_ERROR_RETURN((ssize_t)_bytes_sent, "Send FSM stalled, couldn't receive valid ACKs; %zu buffered bytes undelivered, socket enters %s state.",
+                                 srb_stored_bytes(_socket->send_ring), get_microtcp_state_to_string(_socket->state));
+        }
         LOG_ERROR_RETURN((ssize_t)_bytes_sent, "Send FSM stalled, couldn't receive valid ACKs, socket's->send_queue flushed.");
-        return (ssize_t)_bytes_sent;
 }
 
 static __always_inline _Bool is_send_fsm_stalled(const struct timeval _last_ack_timeval, const time_t _stall_time_threshhold)
@@ -329,11 +625,15 @@ ssize_t microtcp_send_fsm(microtcp_sock_t *const _socket, const void *const _buf
         fsm_context_t context = {.buffer = _buffer,
                                  .remaining = _length,
                                  .last_ack_timeval = get_current_timeval(),
+                                 .last_transmission_timeval = get_current_timeval(),
                                  .duplicate_ack_count = 0,
-                                 .current_send_algorithm = ALGORITHM_SLOW_START};
+                                 .fast_recovery = false,
+                                 .recovery_inflation = 0,
+                                 .block = true};
         const time_t invalid_response_time_limit_usec = timeval_to_usec(get_microtcp_stall_time_limit());
 
         send_fsm_substates_t current_substate = SEND_DATA_ROUND_SUBSTATE;
+        time_t substate_entered_usec = get_monotonic_time_usec();
         while (true)
         {
                 if (is_send_fsm_stalled(context.last_ack_timeval, invalid_response_time_limit_usec))
@@ -343,15 +643,19 @@ ssize_t microtcp_send_fsm(microtcp_sock_t *const _socket, const void *const _buf
                 {
                 case SEND_DATA_ROUND_SUBSTATE:
                         current_substate = execute_send_data_round_substate(_socket, &context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_DATA_ROUND, substate_entered_usec);
                         continue;
                 case RECV_ACK_ROUND_SUBSTATE:
                         current_substate = execute_recv_ack_round_substate(_socket, &context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_ACK_ROUND, substate_entered_usec);
                         continue;
                 case RETRANSMISSIONS_SUBSTATE:
                         current_substate = execute_retransmissions_substate(_socket, &context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_RETRANSMISSIONS, substate_entered_usec);
                         continue;
                 case PEER_WINDOW_ZERO_SUBSTATE:
                         current_substate = execute_peer_window_zero_substate(_socket, &context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_PEER_WINDOW_ZERO, substate_entered_usec);
                         continue;
                 case CONTINUE_SUBSTATE:
                         LOG_ERROR("Logic error occured, CONTINUE_SUBSTATE is not meant to be returned in FSM substate runner. ");
@@ -367,6 +671,91 @@ ssize_t microtcp_send_fsm(microtcp_sock_t *const _socket, const void *const _buf
                         return execute_exit_stalled_substate(_socket, _length - context.remaining);
                 case EXIT_SUCCESS_SUBSTATE:
                         return execute_exit_success_substate(_length - context.remaining);
+                case WOULD_BLOCK_SUBSTATE: /* Only non-blocking (buffered) FSM yields. */
+                default:
+                        FSM_DEFAULT_CASE_HANDLER(convert_substate_to_string, current_substate, EXIT_FAILURE_SUBSTATE);
+                        continue;
+                }
+        }
+}
+
+send_fsm_context_t *create_send_fsm_context(void)
+{
+        send_fsm_context_t *context = CALLOC_LOG(context, sizeof(send_fsm_context_t));
+        if (context == NULL)
+                return NULL;
+        context->last_ack_timeval = get_current_timeval();
+        context->last_transmission_timeval = get_current_timeval();
+        return context;
+}
+
+/**
+ * @brief Buffered send mode: Runs send FSM over the bytes of socket's send ring.
+ * @param _block if set, FSM waits for ACKs; Otherwise it yields, as soon as it would wait for them.
+ * @param _until_free_space if set (along with `_block`), FSM returns once the send ring has free space; Otherwise once every stored byte is acknowledged.
+ * @returns FAILURE if the connection broke (socket's state tells how), SUCCESS otherwise.
+ */
+static status_t run_send_fsm_progress(microtcp_sock_t *const _socket, const _Bool _block, const _Bool _until_free_space)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(FAILURE, _socket, ESTABLISHED);
+        DEBUG_SMART_ASSERT(_socket->send_ring != NULL, _socket->send_context != NULL);
+        fsm_context_t *const context = _socket->send_context;
+        context->remaining = srb_stored_bytes(_socket->send_ring);
+        context->block = _block;
+        context->until_free_space = _block && _until_free_space;
+        if (context->remaining == 0)
+                return SUCCESS;
+        if (sq_is_empty(_socket->send_queue)) /* Nothing was in flight; Stall timer starts now. */
+                context->last_ack_timeval = get_current_timeval();
+        const time_t invalid_response_time_limit_usec = timeval_to_usec(get_microtcp_stall_time_limit());
+
+        /* Rounds still waiting for ACKs are resumed. */
+        send_fsm_substates_t current_substate = sq_is_empty(_socket->send_queue) ? SEND_DATA_ROUND_SUBSTATE : RECV_ACK_ROUND_SUBSTATE;
+        time_t substate_entered_usec = get_monotonic_time_usec();
+        while (true)
+        {
+                if (RARE_CASE(context->until_free_space) && srb_free_space(_socket->send_ring) > 0)
+                        return SUCCESS;
+                if (is_send_fsm_stalled(context->last_ack_timeval, invalid_response_time_limit_usec))
+                        current_substate = EXIT_STALLED_SUBSTATE;
+                LOG_FSM_SEND("Entering %s", convert_substate_to_string(current_substate));
+                switch (current_substate)
+                {
+                case SEND_DATA_ROUND_SUBSTATE:
+                        current_substate = execute_send_data_round_substate(_socket, context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_DATA_ROUND, substate_entered_usec);
+                        continue;
+                case RECV_ACK_ROUND_SUBSTATE:
+                        current_substate = execute_recv_ack_round_substate(_socket, context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_ACK_ROUND, substate_entered_usec);
+                        continue;
+                case RETRANSMISSIONS_SUBSTATE:
+                        current_substate = execute_retransmissions_substate(_socket, context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_RETRANSMISSIONS, substate_entered_usec);
+                        continue;
+                case PEER_WINDOW_ZERO_SUBSTATE:
+                        current_substate = execute_peer_window_zero_substate(_socket, context);
+                        substate_entered_usec = update_socket_send_fsm_time(_socket, MICROTCP_SEND_FSM_PEER_WINDOW_ZERO, substate_entered_usec);
+                        continue;
+                case CONTINUE_SUBSTATE:
+                        LOG_ERROR("Logic error occured, CONTINUE_SUBSTATE is not meant to be returned in FSM substate runner. ");
+                        current_substate = EXIT_FAILURE_SUBSTATE;
+                        continue;
+                case WOULD_BLOCK_SUBSTATE:
+                case EXIT_SUCCESS_SUBSTATE:
+                        return SUCCESS;
+                case FINACK_RECEPTION_SUBSTATE:
+                        execute_finack_reception_substate(_socket, 0);
+                        return FAILURE;
+                case RST_RECEPTION_SUBSTATE:
+                        execute_rst_reception_substate(_socket, 0);
+                        return FAILURE;
+                case EXIT_FAILURE_SUBSTATE:
+                        execute_exit_failure_substate(_socket, 0);
+                        return FAILURE;
+                case EXIT_STALLED_SUBSTATE:
+                        execute_exit_stalled_substate(_socket, 0);
+                        return FAILURE;
                 default:
                         FSM_DEFAULT_CASE_HANDLER(convert_substate_to_string, current_substate, EXIT_FAILURE_SUBSTATE);
                         continue;
@@ -374,6 +763,80 @@ ssize_t microtcp_send_fsm(microtcp_sock_t *const _socket, const void *const _buf
         }
 }
 
+/* Buffered send mode: With `_block` set, runs until every stored byte is acknowledged (see run_send_fsm_progress()). */
+status_t microtcp_send_fsm_progress(microtcp_sock_t *const _socket, const _Bool _block)
+{
+        return run_send_fsm_progress(_socket, _block, false);
+}
+
+/* Buffered send mode: @returns μsec until pacing lets the current round's next segment out; -1 if it holds none back. */
+time_t microtcp_send_fsm_pacing_delay_usec(const microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->send_context != NULL);
+        return _socket->send_context->round_unsent > 0 ? pacing_delay_usec(_socket) : -1;
+}
+
+/**
+ * @brief Buffered send mode: @returns μsec until the retransmission timer expires (see is_retransmission_timer_expired());
+ * With nothing in flight, until peer's closed window is due for a probe. -1 if no byte is stored.
+ */
+time_t microtcp_send_fsm_retransmission_delay_usec(const microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->send_ring != NULL, _socket->send_context != NULL);
+        if (srb_stored_bytes(_socket->send_ring) == 0)
+                return -1;
+        const fsm_context_t *const context = _socket->send_context;
+        time_t elapsed_usec = elapsed_time_usec(context->last_transmission_timeval);
+        if (!sq_is_empty(_socket->send_queue))
+                elapsed_usec = MIN(elapsed_usec, elapsed_time_usec(context->last_ack_timeval));
+        return MAX(_socket->rto_usec - elapsed_usec + 1, 0); /* Expires once RTO is exceeded. */
+}
+
+/**
+ * @brief Buffered send mode: Processes the ACK held in socket's `segment_receive_buffer` (received by microtcp_recv()),
+ * then lets send FSM transmit whatever that ACK allows.
+ */
+status_t microtcp_send_fsm_process_ack(microtcp_sock_t *const _socket)
+{
+        DEBUG_SMART_ASSERT(_socket != NULL, _socket->send_ring != NULL, _socket->send_context != NULL);
+        fsm_context_t *const context = _socket->send_context;
+        context->remaining = srb_stored_bytes(_socket->send_ring);
+        if (sq_is_empty(_socket->send_queue)) /* Nothing in flight; Old ACK, or reply to a window probe. */
+                _socket->peer_win_size = _socket->segment_receive_buffer->header.window;
+        else if (handle_ack_reception(_socket, context) == EXIT_FAILURE_SUBSTATE)
+                return FAILURE;
+        return microtcp_send_fsm_progress(_socket, false);
+}
+
+/**
+ * @brief Buffered send mode: Copies `_buffer` into socket's send ring, and returns as soon as it is stored.
+ * Only a full send ring blocks (unless MSG_DONTWAIT is set); Until enough bytes are acknowledged to fit the rest.
+ */
+ssize_t microtcp_send_buffered_fsm(microtcp_sock_t *const _socket, const void *const _buffer, const size_t _length, const int _flags)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SEND_FAILURE, _socket, ESTABLISHED);
+        DEBUG_SMART_ASSERT(_socket->send_ring != NULL, _socket->send_context != NULL);
+        const _Bool block = !(_flags & MSG_DONTWAIT);
+        size_t bytes_queued = 0;
+        while (true)
+        {
+                bytes_queued += srb_push(_socket->send_ring, (const uint8_t *)_buffer + bytes_queued, _length - bytes_queued);
+
+                const _Bool wait_for_space = block && bytes_queued != _length;
+                if (run_send_fsm_progress(_socket, wait_for_space, true) == FAILURE)
+                        return (ssize_t)(bytes_queued > 0 ? bytes_queued : MICROTCP_SEND_FAILURE);
+                if (!wait_for_space)
+                        break;
+        }
+        if (bytes_queued == 0)
+        {
+                errno = EAGAIN;
+                return MICROTCP_SEND_FAILURE;
+        }
+        DEBUG_SMART_ASSERT(bytes_queued < SSIZE_MAX);
+        return (ssize_t)bytes_queued;
+}
+
 // clang-format off
 static const char *convert_substate_to_string(const send_fsm_substates_t _substate)
 {
@@ -387,6 +850,7 @@ static const char *convert_substate_to_string(const send_fsm_substates_t _substa
         case EXIT_SUCCESS_SUBSTATE:     return STRINGIFY(EXIT_SUCCESS_SUBSTATE);
         case EXIT_STALLED_SUBSTATE:     return STRINGIFY(EXIT_STALLED_SUBSTATE);
         case EXIT_FAILURE_SUBSTATE:     return STRINGIFY(EXIT_FAILURE_SUBSTATE);
+        case WOULD_BLOCK_SUBSTATE:      return STRINGIFY(WOULD_BLOCK_SUBSTATE);
         case CONTINUE_SUBSTATE:         return STRINGIFY(CONTINUE_SUBSTATE);
         default:                        return "??CONNECT_SUBSTATE??";
         }
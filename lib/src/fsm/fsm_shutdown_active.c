@@ -6,8 +6,10 @@
 #include "core/segment_io.h"
 #include "core/misc.h"
 #include "core/resource_allocation.h"
+#include "core/rto_estimator.h"
 #include "core/socket_stats_updater.h"
 #include "core/segment_processing.h"
+#include "core/time_wait_table.h"
 #include "fsm_common.h"
 #include "logging/microtcp_fsm_logger.h"
 #include "logging/microtcp_logger.h"
@@ -52,7 +54,6 @@ typedef struct
 
         ssize_t finack_retries_counter;
         struct timeval finack_wait_time_timer;
-        struct timeval recvfrom_timeout;
         shutdown_active_fsm_errno_t errno;
 } fsm_context_t;
 
@@ -111,6 +112,8 @@ static shutdown_active_fsm_substates_t execute_fin_wait_1_substate(microtcp_sock
         case RECV_SEGMENT_TIMEOUT:
                 update_socket_lost_counters(_socket, _context->send_finack_ret_val);
                 RETURN_EXIT_FAILURE_SUBSTATE_IF_FINACK_RETRIES_EXHAUSTED(_context);
+                if (_context->recv_ack_ret_val == RECV_SEGMENT_TIMEOUT) /* FIN|ACK retransmissions back off, like data ones. */
+                        rto_backoff(_socket);
                 return CONNECTION_ESTABLISHED_SUBSTATE;
         case RECV_SEGMENT_RST_RECEIVED:
                 _context->errno = RST_EXPECTED_ACK;
@@ -173,6 +176,8 @@ static shutdown_active_fsm_substates_t execute_fin_double_substate(microtcp_sock
         case RECV_SEGMENT_TIMEOUT:
                 update_socket_lost_counters(_socket, _context->send_finack_ret_val);
                 RETURN_EXIT_FAILURE_SUBSTATE_IF_FINACK_RETRIES_EXHAUSTED(_context);
+                if (_context->recv_ack_ret_val == RECV_SEGMENT_TIMEOUT) /* FIN|ACK retransmissions back off, like data ones. */
+                        rto_backoff(_socket);
                 TRY_SEND_CTRL_SEG_OR_RETURN_SUBSTATE(_socket, _address, _address_len, _context, finack);
                 return FIN_DOUBLE_SUBSTATE;
         case RECV_SEGMENT_RST_RECEIVED:
@@ -203,7 +208,7 @@ static shutdown_active_fsm_substates_t execute_fin_wait_2_recv_substate(microtcp
         case RECV_SEGMENT_TIMEOUT:
                 if (timeval_to_usec(_context->finack_wait_time_timer) > 0) /* Retry receiving FIN|ACK until the timeout expires. */
                 {
-                        subtract_timeval(&(_context->finack_wait_time_timer), _context->recvfrom_timeout);
+                        subtract_timeval(&(_context->finack_wait_time_timer), usec_to_timeval(_socket->rto_usec)); /* Socket's timeout is its RTO. */
                         return FIN_WAIT_2_RECV_SUBSTATE;
                 }
                 send_rstack_control_segment(_socket, _address, _address_len); /* Final attempt to notify peer for closure. */
@@ -240,6 +245,12 @@ static shutdown_active_fsm_substates_t execute_fin_wait_2_send_substate(microtcp
 static shutdown_active_fsm_substates_t execute_time_wait_substate(microtcp_sock_t *const _socket, struct sockaddr *const _address,
                                                                   socklen_t _address_len, fsm_context_t *_context)
 {
+        if (_socket->async_time_wait && _socket->listener != NULL) /* Only listener mode enables it; Checked again, as disabling that leaves no listener. */
+        {
+                if (time_wait_table_add(_socket) == SUCCESS)
+                        return CLOSED_1_SUBSTATE;
+                LOG_WARNING("Asynchronous TIME_WAIT failed; Waiting it out.");
+        }
         time_t timewait_period_us = timeval_to_usec(get_shutdown_time_wait_period());
         struct timeval starting_time;
         gettimeofday(&starting_time, NULL);
@@ -288,7 +299,6 @@ int microtcp_shutdown_active_fsm(microtcp_sock_t *const _socket, struct sockaddr
         /* Initialize FSM's context. */
         fsm_context_t context = {.finack_retries_counter = get_shutdown_finack_retries(),
                                  .finack_wait_time_timer = get_shutdown_time_wait_period(),
-                                 .recvfrom_timeout = get_socket_recvfrom_timeout(_socket),
                                  .errno = NO_ERROR};
 
         /* If we are in shutdown_active()'s FSM, that means that host (local) called shutdown not peer. */
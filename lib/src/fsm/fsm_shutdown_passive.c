@@ -4,6 +4,7 @@
 #include "core/segment_io.h"
 #include "core/misc.h"
 #include "core/resource_allocation.h"
+#include "core/rto_estimator.h"
 #include "core/socket_stats_updater.h"
 #include "fsm/microtcp_fsm.h"
 #include "fsm_common.h"
@@ -41,7 +42,6 @@ typedef struct
         size_t recv_ack_ret_val;
 
         struct timeval last_ack_wait_time_timer;
-        struct timeval recvfrom_timeout;
         shutdown_fsm_errno_t errno;
 } fsm_context_t;
 
@@ -101,7 +101,9 @@ static shutdown_passive_fsm_substates_t execute_last_ack_substate(microtcp_sock_
         case RECV_SEGMENT_TIMEOUT:
                 if (timeval_to_usec(_context->last_ack_wait_time_timer) > 0) /* Retry receiving LAST ACK until the timeout expires. */
                 {
-                        subtract_timeval(&(_context->last_ack_wait_time_timer), _context->recvfrom_timeout);
+                        subtract_timeval(&(_context->last_ack_wait_time_timer), usec_to_timeval(_socket->rto_usec)); /* Socket's timeout is its RTO. */
+                        if (_context->recv_ack_ret_val == RECV_SEGMENT_TIMEOUT) /* FIN|ACK is resent; Its retransmissions back off. */
+                                rto_backoff(_socket);
                         return CLOSE_WAIT_SUBTATE;
                 }
                 send_rstack_control_segment(_socket, _address, _address_len); /* Final attempt to notify peer for closure. */
@@ -130,7 +132,6 @@ int microtcp_shutdown_passive_fsm(microtcp_sock_t *const _socket, struct sockadd
 
         /* Initialize FSM's context. */
         fsm_context_t context = {.last_ack_wait_time_timer = get_shutdown_time_wait_period(),
-                                 .recvfrom_timeout = get_socket_recvfrom_timeout(_socket),
                                  .errno = NO_ERROR};
 
         /* If we are in shutdown()'s passive FSM, that means that microtcp intercepted a FIN-ACK packet. */
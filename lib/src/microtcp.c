@@ -1,10 +1,17 @@
 #include "microtcp.h"
 #include <errno.h>     // for errno
 #include <string.h>    // for strerror
+#include "core/connection_table.h"
+#include "core/listener.h"
 #include "core/misc.h" // for generate_initial_sequence_nu...
 #include "core/microtcp_recv_impl.h"
+#include "core/poller.h"
+#include "core/protocol_engine.h"
 #include "core/resource_allocation.h"
 #include "core/segment_io.h"
+#include "core/socket_options.h"
+#include "core/socket_stats_updater.h"
+#include "core/stats_export.h"
 #include "fsm/microtcp_fsm.h"           // for microtcp_accept_fsm, microtc...
 #include "logging/microtcp_logger.h"    // for LOG_ERROR_RETURN, LOG_INFO_R...
 #include "microtcp_core_macros.h"       // for RETURN_ERROR_IF_MICROTCP_SOC...
@@ -70,6 +77,8 @@ int microtcp_connect(microtcp_sock_t *_socket, const struct sockaddr *const _add
         RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_CONNECT_FAILURE, _socket, CLOSED);
         RETURN_ERROR_IF_SOCKADDR_INVALID(MICROTCP_CONNECT_FAILURE, _address);
         RETURN_ERROR_IF_SOCKET_ADDRESS_LENGTH_INVALID(MICROTCP_CONNECT_FAILURE, _address_len, sizeof(*_address));
+        if (_socket->listener != NULL)
+                LOG_ERROR_RETURN(MICROTCP_CONNECT_FAILURE, "Connect operation is not allowed on a listener, or its connections.");
 
         /* Initialize socket handshake required resources for connection.*/
         generate_initial_sequence_number(_socket);
@@ -82,6 +91,9 @@ int microtcp_connect(microtcp_sock_t *_socket, const struct sockaddr *const _add
         if (allocate_post_handshake_buffers(_socket) == FAILURE)
                 goto connect_failure_cleanup;
 
+        if (_socket->engine != NULL && pe_start(_socket->engine) == FAILURE)
+                goto connect_failure_cleanup;
+
         LOG_INFO_RETURN(MICROTCP_CONNECT_SUCCESS, "Connect operation succeeded; Post handshake buffer allocate.");
 
 connect_failure_cleanup:
@@ -96,6 +108,8 @@ int microtcp_accept(microtcp_sock_t *_socket, struct sockaddr *_address, socklen
         RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_CONNECT_FAILURE, _socket, LISTEN);
         RETURN_ERROR_IF_SOCKADDR_INVALID(MICROTCP_CONNECT_FAILURE, _address);
         RETURN_ERROR_IF_SOCKET_ADDRESS_LENGTH_INVALID(MICROTCP_CONNECT_FAILURE, _address_len, sizeof(*_address));
+        if (_socket->listener != NULL)
+                LOG_ERROR_RETURN(MICROTCP_ACCEPT_FAILURE, "Socket is a listener; Its connections are accepted with %s().", STRINGIFY(microtcp_accept_connection));
 
         /* Initialize socket's resources required for 3-way handshake. */
         generate_initial_sequence_number(_socket);
@@ -109,6 +123,9 @@ int microtcp_accept(microtcp_sock_t *_socket, struct sockaddr *_address, socklen
         if (allocate_post_handshake_buffers(_socket) == FAILURE)
                 goto accept_failure_cleanup;
 
+        if (_socket->engine != NULL && pe_start(_socket->engine) == FAILURE)
+                goto accept_failure_cleanup;
+
         LOG_INFO_RETURN(MICROTCP_ACCEPT_SUCCESS, "Accept operation succeeded; Post handshake buffer allocated.");
 
 accept_failure_cleanup:
@@ -116,14 +133,55 @@ accept_failure_cleanup:
         LOG_ERROR_RETURN(MICROTCP_ACCEPT_FAILURE, "Accept operation failed.");
 }
 
+/* Part of the extended API(). */
+microtcp_sock_t microtcp_accept_connection(microtcp_sock_t *const _listener, struct sockaddr *const _address, const socklen_t _address_len)
+{
+        microtcp_sock_t connection = initialize_microtcp_socket();
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(connection, _listener, LISTEN);
+        if (_listener->listener == NULL || _listener->connection_entry != NULL)
+                LOG_ERROR_RETURN(connection, "Socket is not a listener; Enable %s first.", STRINGIFY(MICROTCP_SO_LISTENER));
+
+        /* Connection shares listener's descriptor, and inherits its per socket options. */
+        connection.sd = _listener->sd;
+        connection.state = LISTEN;
+        connection.send_buffer_size = _listener->send_buffer_size;
+        connection.congestion_control_ops = _listener->congestion_control_ops;
+        connection.sack = _listener->sack;
+        connection.pacing = _listener->pacing;
+        connection.syn_cookies = _listener->syn_cookies;
+        connection.async_time_wait = _listener->async_time_wait;
+        DEBUG_SMART_ASSERT(!_listener->engine_thread); /* Listeners reject engine thread mode; Their connections run on caller's thread. */
+        connection.listener = listener_retain(_listener->listener);
+
+        /* Accept's state machine takes the oldest connection of listener's backlog; Its entry comes along. */
+        generate_initial_sequence_number(&connection);
+        if (allocate_pre_handshake_buffers(&connection) == FAILURE ||
+            microtcp_accept_fsm(&connection, _address, _address_len) == MICROTCP_ACCEPT_FAILURE ||
+            allocate_post_handshake_buffers(&connection) == FAILURE)
+        {
+                microtcp_close(&connection);
+                LOG_ERROR_RETURN(connection, "Accept connection operation failed.");
+        }
+        LOG_INFO_RETURN(connection, "Accept connection operation succeeded.");
+}
+
 int microtcp_shutdown(microtcp_sock_t *_socket, int _how)
 {
+        RETURN_ERROR_IF_MICROTCP_SOCKET_NULL(MICROTCP_SHUTDOWN_FAILURE, _socket);
+        /* Engine thread mode: Application thread takes the connection back; Then shutdown proceeds as in buffered send mode. */
+        if (_socket->engine != NULL)
+                pe_stop(_socket->engine);
+
         /* Validate input parameters. */
         RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_CONNECT_FAILURE, _socket, ESTABLISHED | CLOSING_BY_PEER);
 
         struct sockaddr *address = _socket->peer_address;
         socklen_t address_len = sizeof(*(_socket->peer_address));
 
+        /* Buffered send mode: Data still in send buffer goes out (and gets acknowledged) before FIN. */
+        if (_socket->state == ESTABLISHED && _socket->send_ring != NULL && microtcp_send_fsm_progress(_socket, true) == FAILURE)
+                LOG_WARNING("Send buffer could not be flushed, before shutdown; Socket state = %s.", get_microtcp_state_to_string(_socket->state));
+
         switch (_socket->state)
         {
         case ESTABLISHED:
@@ -144,21 +202,45 @@ int microtcp_shutdown(microtcp_sock_t *_socket, int _how)
 
 ssize_t microtcp_send(microtcp_sock_t *_socket, const void *_buffer, size_t _length, int _flags)
 {
-        DEBUG_SMART_ASSERT(_socket != NULL, _buffer != NULL);
-        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SEND_FAILURE, _socket, ESTABLISHED);
+        DEBUG_SMART_ASSERT(_buffer != NULL);
+        RETURN_ERROR_IF_MICROTCP_SOCKET_NULL(MICROTCP_SEND_FAILURE, _socket);
         if (_length == 0)
                 LOG_WARNING_RETURN(0, "%s() was asked to send 0 bytes.", __func__);
-        return microtcp_send_fsm(_socket, _buffer, _length);
+        const time_t start_usec = get_monotonic_time_usec();
+        ssize_t send_ret_val;
+        if (_socket->engine != NULL) /* Socket's state belongs to engine's thread; Engine validates it (and publishes its statistics). */
+                send_ret_val = pe_send(_socket->engine, _buffer, _length, _flags);
+        else
+        {
+                RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SEND_FAILURE, _socket, ESTABLISHED);
+                send_ret_val = _socket->send_ring != NULL ? microtcp_send_buffered_fsm(_socket, _buffer, _length, _flags)
+                                                          : microtcp_send_fsm(_socket, _buffer, _length);
+        }
+        const time_t end_usec = get_monotonic_time_usec();
+        update_socket_send_latency_histogram(_socket, end_usec - start_usec);
+        if (_socket->engine == NULL)
+                stats_export_publish_if_due(_socket, end_usec);
+        if (_socket->poller_registration != NULL) /* Segments may be in flight now; Poller arms their retransmission timer. */
+                poller_touch(_socket);
+        return send_ret_val;
 }
 
 ssize_t microtcp_recv(microtcp_sock_t *const _socket, void *const _buffer, const size_t _length, const int _flags)
 {
         DEBUG_SMART_ASSERT(_buffer != NULL, _length > 0);
-        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_CONNECT_FAILURE, _socket, ESTABLISHED);
+        RETURN_ERROR_IF_MICROTCP_SOCKET_NULL(MICROTCP_RECV_FAILURE, _socket);
         if (!ARE_VALID_MICROTCP_RECV_FLAGS(_flags))
                 return MICROTCP_RECV_FAILURE;
+        if (_socket->engine != NULL) /* Socket's state belongs to engine's thread; Engine validates it. */
+                return pe_recv(_socket->engine, _buffer, _length, _flags);
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_CONNECT_FAILURE, _socket, ESTABLISHED);
 
-        return microtcp_recv_impl(_socket, _buffer, _length, _flags);
+        const ssize_t recv_ret_val = microtcp_recv_impl(_socket, _buffer, _length, _flags);
+        if (_socket->stats_export_slot != NULL)
+                stats_export_publish_if_due(_socket, get_monotonic_time_usec());
+        if (_socket->poller_registration != NULL) /* Buffered send may have progressed on the ACKs it processed. */
+                poller_touch(_socket);
+        return recv_ret_val;
 }
 
 /* Part of the extended API(). */
@@ -168,17 +250,110 @@ ssize_t microtcp_recv_timed(microtcp_sock_t *const _socket, void *const _buffer,
         _Static_assert(MICROTCP_RECV_TIMEOUT == 0, "DEFAULT value altered");
         _Static_assert(MICROTCP_RECV_FAILURE == -1, "DEFAULT value altered");
         DEBUG_SMART_ASSERT(_buffer != NULL, _length > 0);
-        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_CONNECT_FAILURE, _socket, ESTABLISHED);
-        return microtcp_recv_timed_impl(_socket, _buffer, _length, _max_idle_time);
+        RETURN_ERROR_IF_MICROTCP_SOCKET_NULL(MICROTCP_RECV_FAILURE, _socket);
+        if (_socket->engine == NULL)
+                RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_CONNECT_FAILURE, _socket, ESTABLISHED);
+        const ssize_t recv_ret_val = microtcp_recv_timed_impl(_socket, _buffer, _length, _max_idle_time);
+        if (_socket->poller_registration != NULL)
+                poller_touch(_socket);
+        return recv_ret_val;
 }
 
+/* Part of the extended API(). */
+int microtcp_setsockopt(microtcp_sock_t *const _socket, const microtcp_sockopt_t _option, const void *const _value, const socklen_t _value_len)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, ~INVALID);
+        return set_microtcp_socket_option(_socket, _option, _value, _value_len);
+}
+
+/* Part of the extended API(). */
+int microtcp_getsockopt(microtcp_sock_t *const _socket, const microtcp_sockopt_t _option, void *const _value, socklen_t *const _value_len)
+{
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_SOCKOPT_FAILURE, _socket, ~INVALID);
+        return get_microtcp_socket_option(_socket, _option, _value, _value_len);
+}
+
+/* Part of the extended API(). */
+int microtcp_get_info(const microtcp_sock_t *const _socket, microtcp_info_t *const _info)
+{
+        if (_socket == NULL || _info == NULL)
+                LOG_ERROR_RETURN(MICROTCP_GET_INFO_FAILURE, "%s() got a NULL argument; (socket = %p, info = %p).", __func__, (const void *)_socket, (void *)_info);
+        if (_socket->engine != NULL) /* Engine's thread may be updating the connection. */
+                pe_get_info(_socket->engine, _info);
+        else
+                get_socket_info(_socket, _info);
+        return MICROTCP_GET_INFO_SUCCESS;
+}
+
+/* Part of the extended API(). */
+int microtcp_stats_export_start(void)
+{
+        return stats_export_start() == SUCCESS ? MICROTCP_STATS_EXPORT_SUCCESS : MICROTCP_STATS_EXPORT_FAILURE;
+}
 
 void microtcp_close(microtcp_sock_t *_socket)
 {
         SMART_ASSERT(_socket != NULL);
+        if (_socket->engine != NULL)
+                pe_stop(_socket->engine);
         if (_socket->state == ESTABLISHED)
                 send_rstack_control_segment(_socket, _socket->peer_address, sizeof(*_socket->peer_address));
         _socket->state = INVALID;
         cleanup_microtcp_socket(_socket);
         LOG_INFO("MicroTCP socket closed successfully.");
 }
+
+/* Part of the extended API(). */
+microtcp_poller_t *microtcp_poller_create(void)
+{
+        microtcp_poller_t *poller = poller_create();
+        if (poller == NULL)
+                LOG_ERROR_RETURN(NULL, "Poller creation failed.");
+        LOG_INFO_RETURN(poller, "Poller created.");
+}
+
+/* Part of the extended API(). */
+void microtcp_poller_destroy(microtcp_poller_t **const _poller_address)
+{
+        SMART_ASSERT(_poller_address != NULL);
+        poller_destroy(_poller_address);
+}
+
+/* Part of the extended API(). */
+int microtcp_poller_add(microtcp_poller_t *const _poller, microtcp_sock_t *const _socket, const uint32_t _events, void *const _user_data)
+{
+        if (_poller == NULL)
+                LOG_ERROR_RETURN(MICROTCP_POLLER_FAILURE, "Poller is NULL.");
+        RETURN_ERROR_IF_MICROTCP_SOCKET_INVALID(MICROTCP_POLLER_FAILURE, _socket, ~INVALID);
+        return poller_add(_poller, _socket, _events, _user_data) == SUCCESS ? MICROTCP_POLLER_SUCCESS : MICROTCP_POLLER_FAILURE;
+}
+
+/* Part of the extended API(). Sockets may be removed in any state; Closed ones too. */
+int microtcp_poller_remove(microtcp_poller_t *const _poller, microtcp_sock_t *const _socket)
+{
+        if (_poller == NULL || _socket == NULL)
+                LOG_ERROR_RETURN(MICROTCP_POLLER_FAILURE, "Poller and socket must not be NULL.");
+        return poller_remove(_poller, _socket) == SUCCESS ? MICROTCP_POLLER_SUCCESS : MICROTCP_POLLER_FAILURE;
+}
+
+/* Part of the extended API(). */
+int microtcp_poll(microtcp_poller_t *const _poller, microtcp_poll_event_t *const _events, const size_t _max_events, const int _timeout_msec)
+{
+        if (_poller == NULL || _events == NULL || _max_events == 0)
+                LOG_ERROR_RETURN(MICROTCP_POLL_FAILURE, "Invalid arguments; (poller = %p, events = %p, max_events = %zu).", _poller, _events, _max_events);
+        return poller_wait(_poller, _events, _max_events, _timeout_msec);
+}
+
+/* Part of the extended API(). */
+int microtcp_poller_fd(const microtcp_poller_t *const _poller)
+{
+        SMART_ASSERT(_poller != NULL);
+        return poller_fd(_poller);
+}
+
+/* Part of the extended API(). */
+int microtcp_poller_timeout(const microtcp_poller_t *const _poller)
+{
+        SMART_ASSERT(_poller != NULL);
+        return poller_timeout_msec(_poller);
+}
@@ -197,6 +197,13 @@ struct timeval get_current_timeval(void)
         return tv;
 }
 
+time_t get_monotonic_time_usec(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec * USEC_PER_SEC) + (ts.tv_nsec / (NSEC_PER_SEC / USEC_PER_SEC));
+}
+
 size_t get_transferred_bytes_per_sec(const struct timeval _start_time, const size_t _transferred_bytes)
 {
         const double elapsed_seconds = elapsed_time_usec(_start_time) / (double)USEC_PER_SEC;
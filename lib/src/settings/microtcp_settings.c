@@ -6,17 +6,25 @@
 #include "microtcp_helper_macros.h"
 #include "microtcp_helper_functions.h"
 #include "microtcp_settings_common.h"
+#include "congestion_control/congestion_control.h"
 
 /* ----------------------------------------- MicroTCP general configuration variables ----------------------------------------- */
 static size_t microtcp_bytestream_rrb_size = MICROTCP_RECVBUF_LEN;
+static _Bool microtcp_bytestream_rrb_double_mapped = DEFAULT_MICROTCP_BYTESTREAM_RRB_DOUBLE_MAPPED;
 static struct timeval microtcp_ack_timeout = DEFAULT_MICROTCP_ACK_TIMEOUT;
+static struct timeval microtcp_min_rto = DEFAULT_MICROTCP_MIN_RTO;
+static struct timeval microtcp_max_rto = DEFAULT_MICROTCP_MAX_RTO;
 static struct timeval microtcp_stall_time_limit = DEFAULT_MICROTCP_STALL_TIME_LIMIT;
+static const char *microtcp_congestion_control = DEFAULT_MICROTCP_CONGESTION_CONTROL;
+static struct timeval microtcp_delayed_ack_timeout = DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT;
+static size_t microtcp_delayed_ack_segments = DEFAULT_MICROTCP_DELAYED_ACK_SEGMENTS;
 
 /* ----------------------------------------- Connect()'s FSM configuration variables ------------------------------------------ */
 static size_t connect_rst_retries = DEFAULT_CONNECT_RST_RETRIES; /* Default. Can be changed from following "API". */
 
 /* ------------------------------------------ Accept()'s FSM configuration variables ------------------------------------------ */
 static size_t accept_synack_retries = LINUX_DEFAULT_ACCEPT_TIMEOUTS; /* Default. Can be changed from following "API". */
+static size_t accept_backlog = DEFAULT_ACCEPT_BACKLOG;
 
 /* ----------------------------------------- Shutdown()'s FSM configuration variables ----------------------------------------- */
 static struct timeval shutdown_time_wait_period = {.tv_sec = DEFAULT_SHUTDOWN_TIME_WAIT_SEC, .tv_usec = DEFAULT_SHUTDOWN_TIME_WAIT_USEC};
@@ -42,6 +50,17 @@ void set_microtcp_bytestream_rrb_size(size_t _bytstream_rrb_size)
         microtcp_bytestream_rrb_size = _bytstream_rrb_size;
 }
 
+_Bool get_microtcp_bytestream_rrb_double_mapped(void)
+{
+        return microtcp_bytestream_rrb_double_mapped;
+}
+
+void set_microtcp_bytestream_rrb_double_mapped(const _Bool _double_mapped)
+{
+        LOG_INFO("Setting `microtcp_bytestream_rrb_double_mapped` to %s.", _double_mapped ? "true" : "false");
+        microtcp_bytestream_rrb_double_mapped = _double_mapped;
+}
+
 struct timeval get_microtcp_ack_timeout(void)
 {
         return microtcp_ack_timeout;
@@ -62,6 +81,93 @@ void set_microtcp_ack_timeout(struct timeval _ack_timeout_tv)
         microtcp_ack_timeout = _ack_timeout_tv;
 }
 
+struct timeval get_microtcp_min_rto(void)
+{
+        return microtcp_min_rto;
+}
+
+void set_microtcp_min_rto(struct timeval _min_rto_tv)
+{
+        SMART_ASSERT(_min_rto_tv.tv_sec >= 0, _min_rto_tv.tv_usec >= 0);
+        normalize_timeval(&_min_rto_tv);
+        if (timeval_to_usec(_min_rto_tv) == 0 || timeval_to_usec(_min_rto_tv) > timeval_to_usec(get_microtcp_max_rto()))
+        {
+                LOG_ERROR("MicroTCP's minimum RTO must be positive, and not greater than maximum RTO. Minimum RTO remains unchanged.");
+                return;
+        }
+        microtcp_min_rto = _min_rto_tv;
+        LOG_INFO("Setting `microtcp_min_rto` value to [%ld sec, %ld μsec].", _min_rto_tv.tv_sec, _min_rto_tv.tv_usec);
+}
+
+struct timeval get_microtcp_max_rto(void)
+{
+        return microtcp_max_rto;
+}
+
+void set_microtcp_max_rto(struct timeval _max_rto_tv)
+{
+        SMART_ASSERT(_max_rto_tv.tv_sec >= 0, _max_rto_tv.tv_usec >= 0);
+        normalize_timeval(&_max_rto_tv);
+        if (timeval_to_usec(_max_rto_tv) < timeval_to_usec(get_microtcp_min_rto()))
+        {
+                LOG_ERROR("MicroTCP's maximum RTO must not be less than minimum RTO. Maximum RTO remains unchanged.");
+                return;
+        }
+        microtcp_max_rto = _max_rto_tv;
+        LOG_INFO("Setting `microtcp_max_rto` value to [%ld sec, %ld μsec].", _max_rto_tv.tv_sec, _max_rto_tv.tv_usec);
+}
+
+const char *get_microtcp_congestion_control(void)
+{
+        return microtcp_congestion_control;
+}
+
+void set_microtcp_congestion_control(const char *const _name)
+{
+        const congestion_control_ops_t *const ops = cc_find(_name);
+        if (ops == NULL)
+        {
+                LOG_ERROR("Unknown congestion control module `%s`. MicroTCP's congestion control remains `%s`.", _name, microtcp_congestion_control);
+                return;
+        }
+        microtcp_congestion_control = ops->name;
+        LOG_INFO("Setting `microtcp_congestion_control` to `%s`.", microtcp_congestion_control);
+}
+
+struct timeval get_microtcp_delayed_ack_timeout(void)
+{
+        return microtcp_delayed_ack_timeout;
+}
+
+void set_microtcp_delayed_ack_timeout(struct timeval _delayed_ack_timeout_tv)
+{
+        SMART_ASSERT(_delayed_ack_timeout_tv.tv_sec >= 0, _delayed_ack_timeout_tv.tv_usec >= 0);
+        normalize_timeval(&_delayed_ack_timeout_tv);
+        if (timeval_to_usec(_delayed_ack_timeout_tv) >= timeval_to_usec(get_microtcp_min_rto()))
+                LOG_WARNING("Setting `microtcp_delayed_ack_timeout` to [%ld sec, %ld μsec]; Not below minimum RTO, peer may time out on delayed ACKs.",
+                            _delayed_ack_timeout_tv.tv_sec, _delayed_ack_timeout_tv.tv_usec);
+        else
+                LOG_INFO("Setting `microtcp_delayed_ack_timeout` to [%ld sec, %ld μsec].",
+                         _delayed_ack_timeout_tv.tv_sec, _delayed_ack_timeout_tv.tv_usec);
+        microtcp_delayed_ack_timeout = _delayed_ack_timeout_tv;
+}
+
+size_t get_microtcp_delayed_ack_segments(void)
+{
+        return microtcp_delayed_ack_segments;
+}
+
+void set_microtcp_delayed_ack_segments(const size_t _segments_count)
+{
+        if (_segments_count == 0)
+        {
+                LOG_ERROR("MicroTCP's delayed ACKs must cover at least 1 segment. Delayed ACK segments remain %zu.", microtcp_delayed_ack_segments);
+                return;
+        }
+        microtcp_delayed_ack_segments = _segments_count;
+        LOG_INFO("Setting `microtcp_delayed_ack_segments` to %zu.", microtcp_delayed_ack_segments);
+}
+
 void set_microtcp_stall_time_limit(const struct timeval _time_limit)
 {
         if (timeval_to_usec(_time_limit) <= timeval_to_usec(get_microtcp_ack_timeout()))
@@ -100,6 +206,22 @@ void set_accept_synack_retries(size_t _retries_count)
         accept_synack_retries = _retries_count;
 }
 
+size_t get_accept_backlog(void)
+{
+        return accept_backlog;
+}
+
+void set_accept_backlog(const size_t _backlog)
+{
+        if (_backlog == 0)
+        {
+                LOG_ERROR("Accept's backlog must hold at least 1 connection. Accept backlog remains %zu.", accept_backlog);
+                return;
+        }
+        accept_backlog = _backlog;
+        LOG_INFO("Setting `accept_backlog` to %zu.", accept_backlog);
+}
+
 /* ----------------------------------------- Shutdown()'s FSM configurators ----------------------------------------- */
 size_t get_shutdown_finack_retries(void)
 {
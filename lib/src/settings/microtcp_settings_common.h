@@ -4,11 +4,33 @@
 #include <sys/time.h>
 #include "microtcp.h"
 
+#define DEFAULT_MICROTCP_BYTESTREAM_RRB_DOUBLE_MAPPED 0 /* RRB is a plain buffer; Appends/Pops split on wrap-around. */
+
 #define DEFAULT_MICROTCP_ACK_TIMEOUT_SEC 0
 #define DEFAULT_MICROTCP_ACK_TIMEOUT_USEC MICROTCP_ACK_TIMEOUT_US
 #define DEFAULT_MICROTCP_ACK_TIMEOUT ((struct timeval){.tv_sec = DEFAULT_MICROTCP_ACK_TIMEOUT_SEC, \
                                                        .tv_usec = DEFAULT_MICROTCP_ACK_TIMEOUT_USEC})
 
+/* Bounds of the adaptive retransmission timeout (RFC 6298); ACK timeout above is only its initial value. */
+#define DEFAULT_MICROTCP_MIN_RTO_SEC 0
+#define DEFAULT_MICROTCP_MIN_RTO_USEC 1000
+#define DEFAULT_MICROTCP_MIN_RTO ((struct timeval){.tv_sec = DEFAULT_MICROTCP_MIN_RTO_SEC, \
+                                                   .tv_usec = DEFAULT_MICROTCP_MIN_RTO_USEC})
+#define DEFAULT_MICROTCP_MAX_RTO_SEC 2
+#define DEFAULT_MICROTCP_MAX_RTO_USEC 0
+#define DEFAULT_MICROTCP_MAX_RTO ((struct timeval){.tv_sec = DEFAULT_MICROTCP_MAX_RTO_SEC, \
+                                                   .tv_usec = DEFAULT_MICROTCP_MAX_RTO_USEC})
+
+#define DEFAULT_MICROTCP_CONGESTION_CONTROL "reno"
+
+/* RFC 5681: ACK at least every second full segment; RFC 1122 caps the delay at 500ms, Linux starts from 40ms.
+ * Ours is far shorter: Senders hold their next round back until the last one is ACKed, and RTO goes down to a millisecond. */
+#define DEFAULT_MICROTCP_DELAYED_ACK_SEGMENTS 2
+#define DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT_SEC 0
+#define DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT_USEC 500
+#define DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT ((struct timeval){.tv_sec = DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT_SEC, \
+                                                               .tv_usec = DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT_USEC})
+
 #define DEFAULT_MICROTCP_STALL_TIME_LIMIT_SEC 10
 #define DEFAULT_MICROTCP_STALL_TIME_LIMIT_USEC 0
 #define DEFAULT_MICROTCP_STALL_TIME_LIMIT ((struct timeval){.tv_sec = DEFAULT_MICROTCP_STALL_TIME_LIMIT_SEC, \
@@ -16,6 +38,7 @@
 
 #define DEFAULT_CONNECT_RST_RETRIES 3
 #define LINUX_DEFAULT_ACCEPT_TIMEOUTS 5
+#define DEFAULT_ACCEPT_BACKLOG 128 /* Linux's SOMAXCONN, up to 5.4. */
 #define MICROTCP_MSL_SECONDS 10 /* Maximum Segment Lifetime. Used for transitioning from TIME_WAIT -> CLOSED */
 #define DEFAULT_SHUTDOWN_TIME_WAIT_SEC (2 * MICROTCP_MSL_SECONDS)
 #define DEFAULT_SHUTDOWN_TIME_WAIT_USEC 0
@@ -11,6 +11,7 @@
 #include "settings/microtcp_settings.h"
 #include "smart_assert.h"
 #include "microtcp_prompt_util.h"
+#include "congestion_control/congestion_control.h"
 
 void prompt_set_microtcp_rrb_length(void)
 {
@@ -26,9 +27,22 @@ void prompt_set_microtcp_rrb_length(void)
         set_microtcp_bytestream_rrb_size(rrb_size);
 }
 
+void prompt_set_microtcp_rrb_double_mapped(void)
+{
+        const char *prompt = "Map MicroTCP's Receive-Ring-Buffer twice back-to-back, avoiding wrap-around splits (1: yes, 0: no, default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_BYTESTREAM_RRB_DOUBLE_MAPPED) "): ";
+        long double_mapped = -1;
+        do
+        {
+                PROMPT_WITH_READLINE(prompt, "%ld", &double_mapped);
+                if (double_mapped != 0 && double_mapped != 1)
+                        clear_line();
+        } while (double_mapped != 0 && double_mapped != 1);
+        set_microtcp_bytestream_rrb_double_mapped(double_mapped);
+}
+
 void prompt_set_microtcp_ack_timeout(void)
 {
-        const char *prompt = "Specify MicroTCP's ACK timeout interval, (default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_ACK_TIMEOUT_SEC) " seconds " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_ACK_TIMEOUT_USEC) " microseconds): ";
+        const char *prompt = "Specify MicroTCP's initial ACK timeout interval, (default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_ACK_TIMEOUT_SEC) " seconds " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_ACK_TIMEOUT_USEC) " microseconds): ";
         struct timeval ack_timeout_interval = {0};
         do
         {
@@ -39,6 +53,72 @@ void prompt_set_microtcp_ack_timeout(void)
         set_microtcp_ack_timeout(ack_timeout_interval);
 }
 
+void prompt_set_microtcp_min_rto(void)
+{
+        const char *prompt = "Specify MicroTCP's minimum retransmission timeout, (default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_MIN_RTO_SEC) " seconds " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_MIN_RTO_USEC) " microseconds): ";
+        struct timeval min_rto = {0};
+        do
+        {
+                PROMPT_WITH_READLINE(prompt, "%ld%ld", &min_rto.tv_sec, &min_rto.tv_usec);
+                if (min_rto.tv_sec < 0 || min_rto.tv_usec < 0)
+                        clear_line();
+        } while (min_rto.tv_sec < 0 || min_rto.tv_usec < 0);
+        set_microtcp_min_rto(min_rto);
+}
+
+void prompt_set_microtcp_max_rto(void)
+{
+        const char *prompt = "Specify MicroTCP's maximum retransmission timeout, (default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_MAX_RTO_SEC) " seconds " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_MAX_RTO_USEC) " microseconds): ";
+        struct timeval max_rto = {0};
+        do
+        {
+                PROMPT_WITH_READLINE(prompt, "%ld%ld", &max_rto.tv_sec, &max_rto.tv_usec);
+                if (max_rto.tv_sec < 0 || max_rto.tv_usec < 0)
+                        clear_line();
+        } while (max_rto.tv_sec < 0 || max_rto.tv_usec < 0);
+        set_microtcp_max_rto(max_rto);
+}
+
+void prompt_set_microtcp_congestion_control(void)
+{
+        const char *prompt = "Specify MicroTCP's congestion control (reno, cubic or bbr, default: " DEFAULT_MICROTCP_CONGESTION_CONTROL "): ";
+        char name[CC_NAME_MAX_LENGTH + 1] = {0}; /* Scanned up to CC_NAME_MAX_LENGTH chars; Names that long are unknown anyway. */
+        while (1)
+        {
+                PROMPT_WITH_READLINE(prompt, "%" STRINGIFY_EXPANDED(CC_NAME_MAX_LENGTH) "s", name);
+                if (cc_find(name) != NULL)
+                        break;
+                clear_line();
+        }
+        set_microtcp_congestion_control(name);
+}
+
+void prompt_set_microtcp_delayed_ack_timeout(void)
+{
+        const char *prompt = "Specify MicroTCP's delayed ACK timeout, 0 disables delaying, (default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT_SEC) " seconds " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_DELAYED_ACK_TIMEOUT_USEC) " microseconds): ";
+        struct timeval delayed_ack_timeout = {0};
+        do
+        {
+                PROMPT_WITH_READLINE(prompt, "%ld%ld", &delayed_ack_timeout.tv_sec, &delayed_ack_timeout.tv_usec);
+                if (delayed_ack_timeout.tv_sec < 0 || delayed_ack_timeout.tv_usec < 0)
+                        clear_line();
+        } while (delayed_ack_timeout.tv_sec < 0 || delayed_ack_timeout.tv_usec < 0);
+        set_microtcp_delayed_ack_timeout(delayed_ack_timeout);
+}
+
+void prompt_set_microtcp_delayed_ack_segments(void)
+{
+        const char *prompt = "Specify how many full segments MicroTCP ACKs at once, 1 disables delaying (Default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_DELAYED_ACK_SEGMENTS) "): ";
+        long segments = 0;
+        do
+        {
+                PROMPT_WITH_READLINE(prompt, "%ld", &segments);
+                if (segments < 1)
+                        clear_line();
+        } while (segments < 1);
+        set_microtcp_delayed_ack_segments(segments);
+}
+
 void prompt_set_microtcp_stall_time_limit(void)
 {
         const char *prompt = "Specify MicroTCP's stall time limit, (default: " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_STALL_TIME_LIMIT_SEC) " seconds " STRINGIFY_EXPANDED(DEFAULT_MICROTCP_STALL_TIME_LIMIT_USEC) " microseconds): ";
@@ -78,6 +158,19 @@ void prompt_set_accept_retries(void)
         set_accept_synack_retries(retries);
 }
 
+void prompt_set_accept_backlog(void)
+{
+        const char *prompt = "Specify the maximum connections a listener holds, handshaking or waiting to be accepted (Default: " STRINGIFY_EXPANDED(DEFAULT_ACCEPT_BACKLOG) "): ";
+        long backlog = 0;
+        do
+        {
+                PROMPT_WITH_READLINE(prompt, "%ld", &backlog);
+                if (backlog < 1)
+                        clear_line();
+        } while (backlog < 1);
+        set_accept_backlog(backlog);
+}
+
 void prompt_set_shutdown_retries(void)
 {
         const char *prompt = "Specify the maximum FIN|ACK retries during shutdown (Default: " STRINGIFY_EXPANDED(TCP_RETRIES2) "): ";
@@ -107,10 +200,17 @@ void prompt_set_shutdown_time_wait_period(void)
 void configure_microtcp_settings(void)
 {
         prompt_set_microtcp_rrb_length();
+        prompt_set_microtcp_rrb_double_mapped();
         prompt_set_microtcp_ack_timeout();
+        prompt_set_microtcp_max_rto(); /* Max goes first; Min is validated against it. */
+        prompt_set_microtcp_min_rto();
+        prompt_set_microtcp_congestion_control();
+        prompt_set_microtcp_delayed_ack_timeout();
+        prompt_set_microtcp_delayed_ack_segments();
         prompt_set_microtcp_stall_time_limit();
         prompt_set_connect_retries();
         prompt_set_accept_retries();
+        prompt_set_accept_backlog();
         prompt_set_shutdown_retries();
         prompt_set_shutdown_time_wait_period();
 }
@@ -0,0 +1,30 @@
+#ifndef UNIT_CHECK_H
+#define UNIT_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Focused checks of library's internal modules; A check executable exits with EXIT_FAILURE, if any of its checks failed. */
+static size_t failed_checks = 0;
+
+#define CHECK(_condition)                                                                                                 \
+        do                                                                                                                \
+        {                                                                                                                 \
+                if (!(_condition))                                                                                        \
+                {                                                                                                         \
+                        fprintf(stderr, "%s:%d: %s(): CHECK(%s) failed.\n", __FILE__, __LINE__, __func__, #_condition); \
+                        failed_checks++;                                                                                  \
+                }                                                                                                         \
+        } while (0)
+
+#define RUN_CHECK(_check_function)                                                                                       \
+        do                                                                                                                \
+        {                                                                                                                 \
+                const size_t failed_checks_before = failed_checks;                                                        \
+                _check_function();                                                                                        \
+                printf("%s: %s\n", #_check_function, failed_checks == failed_checks_before ? "OK" : "FAILED");           \
+        } while (0)
+
+#define UNIT_CHECK_EXIT_STATUS() (failed_checks == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
+
+#endif /* UNIT_CHECK_H */
@@ -72,6 +72,7 @@ enum io_type
         IO_WRITE
 };
 static inline void prompt_to_configure_microtcp(void);
+static void enable_socket_options(microtcp_sock_t *_utcp_socket, const microtcp_sockopt_t *_options, size_t _options_count);
 static status_t miniredis_terminate_connection(microtcp_sock_t *_utcp_socket);
 static void set_max_response_idle_time(size_t _max_idle_time_multiplier);
 static void create_directory(const char *_directory_name);
@@ -121,6 +122,15 @@ static inline void prompt_to_configure_microtcp(void)
 #undef DEFAULT_ANSWER
 }
 
+/* Options unavailable in this build (e.g. SACK in OPTIMIZED_MODE) are skipped; Demo runs without them. */
+static void enable_socket_options(microtcp_sock_t *const _utcp_socket, const microtcp_sockopt_t *const _options, const size_t _options_count)
+{
+        const int enable = 1;
+        for (size_t i = 0; i < _options_count; i++)
+                if (microtcp_setsockopt(_utcp_socket, _options[i], &enable, sizeof(enable)) == MICROTCP_SOCKOPT_FAILURE)
+                        LOG_APP_WARNING("Socket option %d could not be enabled; Demo runs without it.", _options[i]);
+}
+
 static status_t miniredis_terminate_connection(microtcp_sock_t *const _utcp_socket)
 {
         const _Bool shutdown_succeeded = microtcp_shutdown(_utcp_socket, SHUT_RDWR) == MICROTCP_SHUTDOWN_SUCCESS;
@@ -52,6 +52,8 @@ static status_t miniredis_establish_connection(microtcp_sock_t *const _utcp_sock
         (*_utcp_socket) = microtcp_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
         if (_utcp_socket->state == INVALID)
                 return FAILURE;
+        const microtcp_sockopt_t options[] = {MICROTCP_SO_SACK, MICROTCP_SO_PACING, MICROTCP_SO_ENGINE_THREAD};
+        enable_socket_options(_utcp_socket, options, ARRAY_SIZE(options));
         if (microtcp_connect(_utcp_socket, (struct sockaddr *)_server_address, sizeof(*_server_address)) == MICROTCP_ACCEPT_FAILURE)
                 return FAILURE;
         LOG_APP_INFO_RETURN(SUCCESS, "MiniRedis Client-side connected to server.");
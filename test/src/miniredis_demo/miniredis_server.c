@@ -88,6 +88,8 @@ static status_t miniredis_establish_connection(microtcp_sock_t *const _utcp_sock
         (*_utcp_socket) = microtcp_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
         if (_utcp_socket->state == INVALID)
                 return FAILURE;
+        const microtcp_sockopt_t options[] = {MICROTCP_SO_SACK, MICROTCP_SO_PACING};
+        enable_socket_options(_utcp_socket, options, ARRAY_SIZE(options));
         if (microtcp_bind(_utcp_socket, (struct sockaddr *)_server_address, sizeof(*_server_address)) == MICROTCP_BIND_FAILURE)
                 return FAILURE;
         if (microtcp_accept(_utcp_socket, (struct sockaddr *)_client_address, sizeof(*_client_address)) == MICROTCP_ACCEPT_FAILURE)
@@ -0,0 +1,106 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "crc32.h"
+#include "unit_checks/unit_check.h"
+
+#define BUFFER_SIZE 8192
+#define MAX_ALIGNMENT_OFFSET 16
+#define RANDOM_ROUNDS 4000
+#define RANDOM_SEED 0x5eed
+
+static uint8_t buffer[BUFFER_SIZE + MAX_ALIGNMENT_OFFSET];
+static uint8_t copy_buffer[BUFFER_SIZE + MAX_ALIGNMENT_OFFSET];
+
+/* Reference: Bit by bit, straight from the (reflected) polynomial; Shares nothing with the engines. */
+static uint32_t reference_crc32(uint32_t _crc, const uint8_t *_data, size_t _length)
+{
+        while (_length--)
+        {
+                _crc ^= *_data++;
+                for (int bit = 0; bit < 8; bit++)
+                        _crc = (_crc >> 1) ^ (0xEDB88320U & (0U - (_crc & 1)));
+        }
+        return _crc;
+}
+
+static uint32_t random_u32(void)
+{
+        return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+/* Lengths around the PCLMUL kernel's thresholds (64 byte minimum, 16 byte chunks), and slice-by-8's 8 byte steps. */
+static size_t random_length(void)
+{
+        switch (rand() % 3)
+        {
+        case 0:
+                return (size_t)(rand() % 160);
+        case 1:
+                return (size_t)(64 * (1 + rand() % 16) + rand() % 3 - 1);
+        default:
+                return (size_t)(rand() % (BUFFER_SIZE + 1));
+        }
+}
+
+/* Standard check value of CRC-32/ISO-HDLC. */
+static void check_known_value(void)
+{
+        const uint8_t message[] = "123456789";
+        CHECK(crc32(message, sizeof(message) - 1) == 0xCBF43926U);
+        CHECK(update_crc32_slice_by_8(0xffffffff, message, sizeof(message) - 1) == reference_crc32(0xffffffff, message, sizeof(message) - 1));
+}
+
+/* Every engine matches the reference, over random lengths, alignments and seeds. */
+static void check_engines_match_reference(void)
+{
+#if defined(__x86_64__)
+        const _Bool pclmul_in_use = strcmp(crc32_engine_name(), "pclmul") == 0;
+#endif /* __x86_64__ */
+        for (size_t round = 0; round < RANDOM_ROUNDS; round++)
+        {
+                const size_t offset = (size_t)(rand() % MAX_ALIGNMENT_OFFSET);
+                const size_t length = random_length();
+                const uint32_t seed = (round % 2) ? random_u32() : 0xffffffff;
+                const uint8_t *const data = buffer + offset;
+                const uint32_t expected = reference_crc32(seed, data, length);
+
+                CHECK(update_crc32_slice_by_8(seed, data, length) == expected);
+                CHECK(update_crc32(seed, data, length) == expected);
+#if defined(__x86_64__)
+                if (pclmul_in_use)
+                        CHECK(update_crc32_pclmul(seed, data, length) == expected);
+#endif /* __x86_64__ */
+        }
+}
+
+/* Progressive calculation over split buffers, and copy-and-checksum, yield the single pass result. */
+static void check_progressive_and_copy(void)
+{
+        for (size_t round = 0; round < RANDOM_ROUNDS / 4; round++)
+        {
+                const size_t length = random_length();
+                const size_t split = length == 0 ? 0 : (size_t)rand() % length;
+                const size_t source_offset = (size_t)(rand() % MAX_ALIGNMENT_OFFSET);
+                const size_t destination_offset = (size_t)(rand() % MAX_ALIGNMENT_OFFSET);
+                const uint8_t *const data = buffer + source_offset;
+                const uint32_t expected = reference_crc32(0xffffffff, data, length);
+
+                CHECK(update_crc32(update_crc32(0xffffffff, data, split), data + split, length - split) == expected);
+                memset(copy_buffer, 0, sizeof(copy_buffer));
+                CHECK(update_crc32_copy(0xffffffff, copy_buffer + destination_offset, data, length) == expected);
+                CHECK(memcmp(copy_buffer + destination_offset, data, length) == 0);
+        }
+}
+
+int main(void)
+{
+        srand(RANDOM_SEED);
+        for (size_t i = 0; i < sizeof(buffer); i++)
+                buffer[i] = (uint8_t)rand();
+        fprintf(stderr, "CRC-32 engine in use: %s\n", crc32_engine_name());
+        RUN_CHECK(check_known_value);
+        RUN_CHECK(check_engines_match_reference);
+        RUN_CHECK(check_progressive_and_copy);
+        return UNIT_CHECK_EXIT_STATUS();
+}
@@ -0,0 +1,109 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <string.h>
+#include "core/listen_queue.h"
+#include "unit_checks/unit_check.h"
+
+#define BACKLOG 4
+
+static struct sockaddr make_peer(const uint16_t _port)
+{
+        struct sockaddr peer;
+        struct sockaddr_in *const peer_in = (struct sockaddr_in *)&peer;
+        memset(&peer, 0, sizeof(peer));
+        peer_in->sin_family = AF_INET;
+        peer_in->sin_port = htons(_port);
+        peer_in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return peer;
+}
+
+static uint16_t peer_port(const pending_connection_t *const _connection)
+{
+        return ntohs(((const struct sockaddr_in *)&_connection->peer)->sin_port);
+}
+
+/* Half-open and established connections alike count against the backlog; Removal frees a place. */
+static void check_backlog_capacity(void)
+{
+        listen_queue_t *lq = lq_create(BACKLOG);
+        CHECK(lq != NULL && lq_size(lq) == 0);
+        for (uint16_t port = 1; port <= BACKLOG; port++)
+        {
+                const struct sockaddr peer = make_peer(port);
+                pending_connection_t *const connection = lq_add(lq, &peer);
+                CHECK(connection != NULL && connection->entry == NULL && peer_port(connection) == port);
+        }
+        const struct sockaddr overflow_peer = make_peer(BACKLOG + 1);
+        CHECK(lq_add(lq, &overflow_peer) == NULL);
+        CHECK(lq_size(lq) == BACKLOG);
+
+        const struct sockaddr second_peer = make_peer(2);
+        lq_remove(lq, lq_find(lq, &second_peer));
+        CHECK(lq_size(lq) == BACKLOG - 1 && lq_find(lq, &second_peer) == NULL);
+        CHECK(lq_add(lq, &overflow_peer) != NULL);
+        lq_destroy(&lq);
+        CHECK(lq == NULL);
+}
+
+/* Removal moves the last connection in place of the removed one; Every other peer is still found. */
+static void check_find_after_removal(void)
+{
+        listen_queue_t *lq = lq_create(BACKLOG);
+        for (uint16_t port = 1; port <= BACKLOG; port++)
+        {
+                const struct sockaddr peer = make_peer(port);
+                lq_add(lq, &peer)->seq_number = port * 1000;
+        }
+        lq_remove(lq, lq_get(lq, 0));
+        CHECK(peer_port(lq_get(lq, 0)) == BACKLOG); /* Last one moved to the front. */
+        for (uint16_t port = 2; port <= BACKLOG; port++)
+        {
+                const struct sockaddr peer = make_peer(port);
+                const pending_connection_t *const connection = lq_find(lq, &peer);
+                CHECK(connection != NULL && connection->seq_number == port * 1000u);
+        }
+        const struct sockaddr other_address = {.sa_family = AF_INET}; /* 0.0.0.0, port 0. */
+        CHECK(lq_find(lq, &other_address) == NULL);
+        lq_destroy(&lq);
+}
+
+/* Accept takes the oldest established connection; SYN|ACK retransmissions are due by the earliest half-open deadline. */
+static void check_oldest_established_and_deadline(void)
+{
+        listen_queue_t *lq = lq_create(BACKLOG);
+        connection_entry_t *const fake_entry = (connection_entry_t *)&lq; /* Never dereferenced; Marks a connection established. */
+        CHECK(lq_oldest_established(lq) == NULL && lq_next_synack_deadline(lq) == -1);
+
+        const struct sockaddr peers[BACKLOG] = {make_peer(1), make_peer(2), make_peer(3), make_peer(4)};
+        pending_connection_t *connections[BACKLOG];
+        for (size_t i = 0; i < BACKLOG; i++)
+                connections[i] = lq_add(lq, &peers[i]);
+        connections[0]->synack_deadline_usec = 700;
+        connections[1]->synack_deadline_usec = 300;
+        connections[2]->synack_deadline_usec = 500;
+        connections[3]->synack_deadline_usec = 100;
+        CHECK(lq_next_synack_deadline(lq) == 100);
+        CHECK(lq_oldest_established(lq) == NULL);
+
+        connections[3]->entry = fake_entry; /* Established ones have no SYN|ACK deadline. */
+        connections[3]->established_time_usec = 9000;
+        connections[1]->entry = fake_entry;
+        connections[1]->established_time_usec = 4000;
+        CHECK(lq_next_synack_deadline(lq) == 500);
+        CHECK(lq_oldest_established(lq) == lq_find(lq, &peers[1]));
+
+        lq_remove(lq, lq_find(lq, &peers[1])); /* Accepted. */
+        CHECK(peer_port(lq_oldest_established(lq)) == 4);
+        lq_remove(lq, lq_find(lq, &peers[3]));
+        CHECK(lq_oldest_established(lq) == NULL);
+        lq_destroy(&lq);
+}
+
+int main(void)
+{
+        RUN_CHECK(check_backlog_capacity);
+        RUN_CHECK(check_find_after_removal);
+        RUN_CHECK(check_oldest_established_and_deadline);
+        return UNIT_CHECK_EXIT_STATUS();
+}
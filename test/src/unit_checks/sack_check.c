@@ -0,0 +1,137 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "microtcp.h"
+#include "core/receive_ring_buffer.h"
+#include "core/sack.h"
+#include "core/segment_processing.h"
+#include "core/send_queue.h"
+#include "crc32.h"
+#include "unit_checks/unit_check.h"
+
+#define RRB_SIZE 16384
+#define INITIAL_SEQ_NUMBER 1000 /* RRB expects the byte following it first. */
+
+static uint8_t payload[MICROTCP_MSS];
+
+/* Appends a checksummed segment of `_length` bytes, starting at `_seq_number`, to `_rrb`. */
+static uint32_t append_segment(receive_ring_buffer_t *const _rrb, const uint32_t _seq_number, const uint32_t _length)
+{
+        microtcp_segment_t segment = {.header = {.seq_number = _seq_number, .data_len = _length}, .raw_payload_bytes = payload};
+        segment.header.checksum = update_crc32(begin_microtcp_checksum(&segment.header), payload, _length) ^ 0xffffffff;
+        return rrb_append(_rrb, &segment);
+}
+
+/* Only segments lying entirely within a SACK block are marked. */
+static void check_mark_sacked(void)
+{
+        send_queue_t *sq = sq_create(8 * MICROTCP_MSS);
+        const uint32_t first_seq_number = UINT32_MAX - MICROTCP_MSS; /* Block straddles the wrap-around. */
+        uint32_t seq_number = first_seq_number;
+        for (size_t i = 0; i < 4; i++, seq_number += MICROTCP_MSS)
+                sq_enqueue(sq, seq_number, MICROTCP_MSS, payload);
+
+        CHECK(sq_mark_sacked(sq, sq_get(sq, 1)->seq_number, 2 * MICROTCP_MSS) == 2);
+        CHECK(!sq_get(sq, 0)->sacked && sq_get(sq, 1)->sacked && sq_get(sq, 2)->sacked && !sq_get(sq, 3)->sacked);
+        CHECK(sq_mark_sacked(sq, sq_get(sq, 3)->seq_number + 1, MICROTCP_MSS - 1) == 0); /* Part of a segment. */
+        CHECK(!sq_get(sq, 3)->sacked);
+        sq_flush(sq);
+        sq_destroy(&sq);
+}
+
+#if SACK_SUPPORTED
+
+/* Blocks past a gap are reported relative to ACK number, and decode back to the same sequence space. */
+static void check_round_trip(void)
+{
+        receive_ring_buffer_t *rrb = rrb_create(RRB_SIZE, INITIAL_SEQ_NUMBER, false);
+        CHECK(rrb != NULL);
+        const uint32_t ack_number = INITIAL_SEQ_NUMBER + 1 + 100; /* First 100 bytes arrived in order. */
+        CHECK(append_segment(rrb, INITIAL_SEQ_NUMBER + 1, 100) == 100);
+        CHECK(append_segment(rrb, ack_number + 200, 300) == 300);
+        CHECK(append_segment(rrb, ack_number + 1000, 50) == 50);
+        CHECK(append_segment(rrb, ack_number + 1050, 50) == 50); /* Adjacent; Same block. */
+
+        microtcp_header_t header = {.ack_number = ack_number};
+        sack_encode(&header, rrb);
+        rrb_block_t blocks[SACK_MAX_BLOCKS];
+        CHECK(sack_decode(&header, blocks) == 2);
+        CHECK(blocks[0].seq_number == ack_number + 200 && blocks[0].length == 300);
+        CHECK(blocks[1].seq_number == ack_number + 1000 && blocks[1].length == 100);
+        CHECK(header.future_use2 == 0);
+        rrb_destroy(&rrb);
+}
+
+/* At most SACK_MAX_BLOCKS are carried; The lowest ones. */
+static void check_block_limit(void)
+{
+        receive_ring_buffer_t *rrb = rrb_create(RRB_SIZE, INITIAL_SEQ_NUMBER, false);
+        const uint32_t ack_number = INITIAL_SEQ_NUMBER + 1;
+        for (uint32_t i = 1; i <= SACK_MAX_BLOCKS + 2; i++)
+                CHECK(append_segment(rrb, ack_number + i * 100, 10) == 10);
+
+        microtcp_header_t header = {.ack_number = ack_number};
+        sack_encode(&header, rrb);
+        rrb_block_t blocks[SACK_MAX_BLOCKS];
+        CHECK(sack_decode(&header, blocks) == SACK_MAX_BLOCKS);
+        for (uint32_t i = 0; i < SACK_MAX_BLOCKS; i++)
+                CHECK(blocks[i].seq_number == ack_number + (i + 1) * 100 && blocks[i].length == 10);
+        rrb_destroy(&rrb);
+}
+
+/* Nothing out-of-order, nothing carried; A peer without SACK leaves the words zeroed, which decodes to no blocks. */
+static void check_no_blocks(void)
+{
+        receive_ring_buffer_t *rrb = rrb_create(RRB_SIZE, INITIAL_SEQ_NUMBER, false);
+        CHECK(append_segment(rrb, INITIAL_SEQ_NUMBER + 1, 500) == 500);
+        microtcp_header_t header = {.ack_number = INITIAL_SEQ_NUMBER + 501, .future_use0 = 0xDEAD, .future_use1 = 0xBEEF};
+        sack_encode(&header, rrb);
+        CHECK(header.future_use0 == 0 && header.future_use1 == 0 && header.future_use2 == 0);
+        rrb_block_t blocks[SACK_MAX_BLOCKS];
+        CHECK(sack_decode(&header, blocks) == 0);
+        rrb_destroy(&rrb);
+}
+
+/* Decoding stops at the first empty word (zero length); Later words are ignored. */
+static void check_decode_stops_at_empty_word(void)
+{
+        const uint32_t ack_number = UINT32_MAX - 10; /* Blocks wrap past the sequence space's end. */
+        microtcp_header_t header = {.ack_number = ack_number,
+                                    .future_use0 = (20u << 16) | 30u,
+                                    .future_use1 = 40u << 16,
+                                    .future_use2 = (80u << 16) | 5u};
+        rrb_block_t blocks[SACK_MAX_BLOCKS];
+        CHECK(sack_decode(&header, blocks) == 1);
+        CHECK(blocks[0].seq_number == (uint32_t)(ack_number + 20) && blocks[0].length == 30);
+}
+
+#else /* SACK_SUPPORTED */
+
+/* OPTIMIZED_MODE's header has no spare words; SACK encodes and decodes nothing. */
+static void check_unsupported(void)
+{
+        receive_ring_buffer_t *rrb = rrb_create(RRB_SIZE, INITIAL_SEQ_NUMBER, false);
+        CHECK(append_segment(rrb, INITIAL_SEQ_NUMBER + 101, 100) == 100);
+        microtcp_header_t header = {.ack_number = INITIAL_SEQ_NUMBER + 1};
+        sack_encode(&header, rrb);
+        rrb_block_t blocks[SACK_MAX_BLOCKS];
+        CHECK(sack_decode(&header, blocks) == 0);
+        rrb_destroy(&rrb);
+}
+
+#endif /* SACK_SUPPORTED */
+
+int main(void)
+{
+        memset(payload, 'S', sizeof(payload));
+        RUN_CHECK(check_mark_sacked);
+#if SACK_SUPPORTED
+        RUN_CHECK(check_round_trip);
+        RUN_CHECK(check_block_limit);
+        RUN_CHECK(check_no_blocks);
+        RUN_CHECK(check_decode_stops_at_empty_word);
+#else
+        RUN_CHECK(check_unsupported);
+#endif /* SACK_SUPPORTED */
+        return UNIT_CHECK_EXIT_STATUS();
+}
@@ -0,0 +1,118 @@
+#include <stdint.h>
+#include "core/send_queue.h"
+#include "microtcp.h"
+#include "unit_checks/unit_check.h"
+
+static const uint8_t payload[MICROTCP_MSS]; /* Segments only point to it. */
+
+/* Enqueues consecutive segments, from `_seq_number` on; @returns the sequence number following the last one. */
+static uint32_t enqueue_segments(send_queue_t *const _sq, uint32_t _seq_number, const uint32_t *const _segment_sizes, const size_t _count)
+{
+        for (size_t i = 0; i < _count; i++)
+        {
+                sq_enqueue(_sq, _seq_number, _segment_sizes[i], payload);
+                _seq_number += _segment_sizes[i];
+        }
+        return _seq_number;
+}
+
+/* MSS sized segments; Their slot is computed, not searched for. */
+static void check_full_segments(void)
+{
+        send_queue_t *sq = sq_create(8 * MICROTCP_MSS);
+        CHECK(sq != NULL && sq_capacity(sq) == 8);
+        const uint32_t sizes[] = {MICROTCP_MSS, MICROTCP_MSS, MICROTCP_MSS, MICROTCP_MSS};
+        const uint32_t first_seq_number = 1000;
+        enqueue_segments(sq, first_seq_number, sizes, 4);
+        CHECK(sq_stored_segments(sq) == 4 && sq_stored_bytes(sq) == 4 * MICROTCP_MSS);
+
+        send_queue_node_t last_acked_node;
+        CHECK(sq_dequeue(sq, first_seq_number + 2 * MICROTCP_MSS, &last_acked_node) == 2);
+        CHECK(last_acked_node.seq_number == first_seq_number + MICROTCP_MSS);
+        CHECK(sq_front(sq)->seq_number == first_seq_number + 2 * MICROTCP_MSS);
+        CHECK(sq_stored_segments(sq) == 2 && sq_stored_bytes(sq) == 2 * MICROTCP_MSS);
+        sq_flush(sq);
+        sq_destroy(&sq);
+        CHECK(sq == NULL);
+}
+
+/* ACK numbers that end no stored segment dequeue nothing. */
+static void check_unmatched_acks(void)
+{
+        send_queue_t *sq = sq_create(8 * MICROTCP_MSS);
+        const uint32_t sizes[] = {MICROTCP_MSS, MICROTCP_MSS, MICROTCP_MSS};
+        const uint32_t first_seq_number = 5000;
+        const uint32_t next_seq_number = enqueue_segments(sq, first_seq_number, sizes, 3);
+
+        CHECK(sq_dequeue(sq, first_seq_number, NULL) == 0);                       /* Duplicate ACK. */
+        CHECK(sq_dequeue(sq, first_seq_number - 1, NULL) == 0);                   /* Old ACK. */
+        CHECK(sq_dequeue(sq, first_seq_number + MICROTCP_MSS / 2, NULL) == 0);    /* Mid segment. */
+        CHECK(sq_dequeue(sq, next_seq_number + 1, NULL) == 0);                    /* Past the last segment. */
+        CHECK(sq_stored_segments(sq) == 3 && sq_stored_bytes(sq) == 3 * MICROTCP_MSS);
+        CHECK(sq_dequeue(sq, next_seq_number, NULL) == 3);
+        CHECK(sq_is_empty(sq));
+        sq_destroy(&sq);
+}
+
+/* Short segments (e.g. cut on a send ring's wrap-around) make the computed slot miss; Binary search finds it. */
+static void check_short_segments(void)
+{
+        send_queue_t *sq = sq_create(8 * MICROTCP_MSS);
+        const uint32_t sizes[] = {100, MICROTCP_MSS, 37, MICROTCP_MSS, 1, MICROTCP_MSS, 500};
+        const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+        uint32_t segment_ends[sizeof(sizes) / sizeof(sizes[0])];
+        const uint32_t first_seq_number = 70000;
+        uint32_t seq_number = first_seq_number;
+        for (size_t i = 0; i < count; i++)
+                segment_ends[i] = (seq_number += sizes[i]);
+        enqueue_segments(sq, first_seq_number, sizes, count);
+
+        CHECK(sq_find_index(sq, first_seq_number) == 0);
+        CHECK(sq_find_index(sq, segment_ends[2]) == 3);
+        CHECK(sq_find_index(sq, segment_ends[4] - 1) == 4);
+        CHECK(sq_find_index(sq, segment_ends[count - 1]) == count);
+
+        send_queue_node_t last_acked_node;
+        CHECK(sq_dequeue(sq, segment_ends[3], &last_acked_node) == 4);
+        CHECK(last_acked_node.segment_size == sizes[3]);
+        CHECK(sq_front(sq)->seq_number == segment_ends[3]);
+        CHECK(sq_dequeue(sq, segment_ends[4] + 1, NULL) == 0); /* Inside the next segment. */
+        CHECK(sq_dequeue(sq, segment_ends[5], NULL) == 2);
+        CHECK(sq_dequeue(sq, segment_ends[6], NULL) == 1);
+        CHECK(sq_is_empty(sq) && sq_stored_bytes(sq) == 0);
+        sq_destroy(&sq);
+}
+
+/* Sequence numbers wrap past UINT32_MAX, and slots past the array's end; Neither shows. */
+static void check_wrap_around(void)
+{
+        send_queue_t *sq = sq_create(4 * MICROTCP_MSS);
+        CHECK(sq_capacity(sq) == 4);
+        const uint32_t sizes[] = {MICROTCP_MSS, 200, MICROTCP_MSS};
+        uint32_t seq_number = UINT32_MAX - 3 * MICROTCP_MSS;
+        for (size_t round = 0; round < 10; round++) /* Front walks around the slots, a few times. */
+        {
+                const uint32_t second_seq_number = seq_number + sizes[0]; /* Sums are kept 32-bit wide, as sequence numbers. */
+                const uint32_t third_seq_number = second_seq_number + sizes[1];
+                seq_number = enqueue_segments(sq, seq_number, sizes, 3);
+                CHECK(!sq_is_full(sq));
+                CHECK(sq_get(sq, 1)->seq_number == second_seq_number);
+                CHECK(sq_get(sq, 3) == NULL);
+                CHECK(sq_find_index(sq, third_seq_number) == 2);
+                CHECK(sq_dequeue(sq, third_seq_number, NULL) == 2);
+                CHECK(sq_front(sq)->seq_number == third_seq_number);
+                CHECK(sq_dequeue(sq, seq_number, NULL) == 1);
+                CHECK(sq_is_empty(sq));
+        }
+        CHECK(seq_number < UINT32_MAX - 3 * MICROTCP_MSS); /* Sequence space wrapped. */
+        sq_destroy(&sq);
+}
+
+int main(void)
+{
+        RUN_CHECK(check_full_segments);
+        RUN_CHECK(check_unmatched_acks);
+        RUN_CHECK(check_short_segments);
+        RUN_CHECK(check_wrap_around);
+        return UNIT_CHECK_EXIT_STATUS();
+}
@@ -0,0 +1,75 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <string.h>
+#include "core/syn_cookie.h"
+#include "unit_checks/unit_check.h"
+
+#define COOKIE_COUNTER_SHIFT 24
+#define COOKIE_HASH_MASK ((UINT32_C(1) << COOKIE_COUNTER_SHIFT) - 1)
+
+static struct sockaddr make_peer(const char *const _ipv4, const uint16_t _port)
+{
+        struct sockaddr peer;
+        struct sockaddr_in *const peer_in = (struct sockaddr_in *)&peer;
+        memset(&peer, 0, sizeof(peer));
+        peer_in->sin_family = AF_INET;
+        peer_in->sin_port = htons(_port);
+        inet_pton(AF_INET, _ipv4, &peer_in->sin_addr);
+        return peer;
+}
+
+/* Reference vectors (SipHash paper's key 00 01 .. 0f, messages 00 01 .. of 0, 8, 16 and 24 bytes). */
+static void check_siphash_vectors(void)
+{
+        const uint64_t key[2] = {UINT64_C(0x0706050403020100), UINT64_C(0x0f0e0d0c0b0a0908)};
+        const uint64_t message[3] = {UINT64_C(0x0706050403020100), UINT64_C(0x0f0e0d0c0b0a0908), UINT64_C(0x1716151413121110)};
+        CHECK(syn_cookie_siphash_2_4(key, message, 0) == UINT64_C(0x726fdb47dd0e0e31));
+        CHECK(syn_cookie_siphash_2_4(key, message, 1) == UINT64_C(0x93f5f5799a932462));
+        CHECK(syn_cookie_siphash_2_4(key, message, 2) == UINT64_C(0x3f2acc7f57c29bdb));
+        CHECK(syn_cookie_siphash_2_4(key, message, 3) == UINT64_C(0xb8ad50c6f649af94));
+}
+
+/* A cookie validates for the peer (address, port) and ISN it was generated for; Only for them. */
+static void check_peer_binding(void)
+{
+        const struct sockaddr peer = make_peer("10.0.0.1", 40000);
+        const struct sockaddr other_port = make_peer("10.0.0.1", 40001);
+        const struct sockaddr other_address = make_peer("10.0.0.2", 40000);
+        const uint32_t peer_isn = 123456789;
+        const uint32_t cookie = syn_cookie_generate(&peer, peer_isn);
+
+        CHECK(syn_cookie_validate(&peer, peer_isn, cookie));
+        CHECK(!syn_cookie_validate(&peer, peer_isn + 1, cookie));
+        CHECK(!syn_cookie_validate(&other_port, peer_isn, cookie));
+        CHECK(!syn_cookie_validate(&other_address, peer_isn, cookie));
+        CHECK(!syn_cookie_validate(&peer, peer_isn, cookie ^ 1)); /* Forged hash. */
+}
+
+/* Cookies of the current and previous ticks are accepted; Older (or future) counters are rejected, hash notwithstanding. */
+static void check_expiry(void)
+{
+        const struct sockaddr peer = make_peer("192.168.1.7", 5000);
+        const uint32_t peer_isn = 42;
+        const uint32_t cookie = syn_cookie_generate(&peer, peer_isn);
+        const uint32_t counter = cookie >> COOKIE_COUNTER_SHIFT;
+        const uint32_t hash = cookie & COOKIE_HASH_MASK;
+        const uint32_t expired = (((counter - 2) & 0xFF) << COOKIE_COUNTER_SHIFT) | hash;
+        const uint32_t future = (((counter + 1) & 0xFF) << COOKIE_COUNTER_SHIFT) | hash;
+        const uint32_t previous = (((counter - 1) & 0xFF) << COOKIE_COUNTER_SHIFT) | hash; /* Counter is hashed too; Relabeling it fails. */
+
+        CHECK(syn_cookie_validate(&peer, peer_isn, cookie));
+        CHECK(!syn_cookie_validate(&peer, peer_isn, expired));
+        CHECK(!syn_cookie_validate(&peer, peer_isn, future));
+        CHECK(!syn_cookie_validate(&peer, peer_isn, previous));
+}
+
+int main(void)
+{
+        if (syn_cookie_initialize() == FAILURE)
+                return EXIT_FAILURE;
+        RUN_CHECK(check_siphash_vectors);
+        RUN_CHECK(check_peer_binding);
+        RUN_CHECK(check_expiry);
+        return UNIT_CHECK_EXIT_STATUS();
+}
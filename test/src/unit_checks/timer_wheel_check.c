@@ -0,0 +1,126 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include "core/timer_wheel.h"
+#include "microtcp_helper_functions.h"
+#include "unit_checks/unit_check.h"
+
+#define TICKS_PER_LEVEL_1_SLOT 64ULL
+#define TICKS_PER_LEVEL_2_SLOT (64ULL * 64)
+#define TICKS_PER_LEVEL_3_SLOT (64ULL * 64 * 64)
+#define WHEEL_REACH_TICKS (64ULL * 64 * 64 * 64)
+#define MAX_WAKEUPS 100000
+
+typedef struct
+{
+        wheel_timer_t timer;
+        _Bool expired;
+} timed_event_t;
+
+/**
+ * @brief Drives the wheel as its owners do: Waits (virtually) until tw_next_expiry_usec(), then pops the expired timers.
+ * Each timer must expire at its expiry or within the tick after it; Never early, never missed.
+ */
+static void run_wheel(timer_wheel_t *const _tw)
+{
+        size_t wakeups = 0;
+        while (tw_armed_timers(_tw) > 0 && wakeups++ < MAX_WAKEUPS)
+        {
+                const time_t now_usec = tw_next_expiry_usec(_tw);
+                CHECK(now_usec != TIMER_WHEEL_NO_EXPIRY);
+                wheel_timer_t *timer;
+                while ((timer = tw_pop_expired(_tw, now_usec)) != NULL)
+                {
+                        timed_event_t *const event = timer->owner;
+                        CHECK(!event->expired);
+                        CHECK(now_usec >= timer->expiry_usec);
+                        CHECK(now_usec < timer->expiry_usec + TIMER_WHEEL_TICK_USEC);
+                        CHECK(!tw_is_armed(timer));
+                        event->expired = true;
+                }
+        }
+        CHECK(wakeups < MAX_WAKEUPS);
+}
+
+/* Timers of every level (and one past the wheels' reach) cascade down to the lowest level, and expire on time. */
+static void check_cascade_across_levels(void)
+{
+        const time_t origin_usec = get_monotonic_time_usec();
+        timer_wheel_t *tw = tw_create();
+        CHECK(tw != NULL);
+        const uint64_t distances_ticks[] = {1,
+                                            63,
+                                            TICKS_PER_LEVEL_1_SLOT,
+                                            TICKS_PER_LEVEL_1_SLOT * 5 + 17,
+                                            TICKS_PER_LEVEL_2_SLOT - 1,
+                                            TICKS_PER_LEVEL_2_SLOT * 3 + 100,
+                                            TICKS_PER_LEVEL_3_SLOT * 2 + TICKS_PER_LEVEL_2_SLOT + 5,
+                                            WHEEL_REACH_TICKS - 1,
+                                            WHEEL_REACH_TICKS * 2 + 12345}; /* Parked, then re-armed. */
+        const size_t count = sizeof(distances_ticks) / sizeof(distances_ticks[0]);
+        timed_event_t events[sizeof(distances_ticks) / sizeof(distances_ticks[0])];
+        for (size_t i = 0; i < count; i++)
+        {
+                events[i].expired = false;
+                tw_timer_init(&events[i].timer, &events[i]);
+                tw_arm(tw, &events[i].timer, origin_usec + (time_t)distances_ticks[i] * TIMER_WHEEL_TICK_USEC + 37); /* Off tick. */
+                CHECK(tw_is_armed(&events[i].timer));
+        }
+        CHECK(tw_armed_timers(tw) == count);
+        CHECK(tw_next_expiry_usec(tw) <= events[0].timer.expiry_usec + TIMER_WHEEL_TICK_USEC);
+
+        run_wheel(tw);
+        for (size_t i = 0; i < count; i++)
+                CHECK(events[i].expired);
+        CHECK(tw_armed_timers(tw) == 0 && tw_next_expiry_usec(tw) == TIMER_WHEEL_NO_EXPIRY);
+        tw_destroy(&tw);
+        CHECK(tw == NULL);
+}
+
+/* Popping ahead of a timer's expiry returns nothing; Past expiries expire at once. */
+static void check_no_early_expiry(void)
+{
+        const time_t origin_usec = get_monotonic_time_usec();
+        timer_wheel_t *tw = tw_create();
+        timed_event_t late = {.expired = false};
+        timed_event_t past = {.expired = false};
+        tw_timer_init(&late.timer, &late);
+        tw_timer_init(&past.timer, &past);
+        const time_t late_expiry_usec = origin_usec + (time_t)TICKS_PER_LEVEL_2_SLOT * 7 * TIMER_WHEEL_TICK_USEC;
+        tw_arm(tw, &late.timer, late_expiry_usec);
+        CHECK(tw_pop_expired(tw, late_expiry_usec - 1) == NULL);
+        tw_arm(tw, &past.timer, origin_usec - 1);
+        CHECK(tw_pop_expired(tw, late_expiry_usec - 1) == &past.timer);
+        CHECK(tw_pop_expired(tw, late_expiry_usec + TIMER_WHEEL_TICK_USEC) == &late.timer);
+        CHECK(tw_pop_expired(tw, late_expiry_usec + TIMER_WHEEL_TICK_USEC) == NULL);
+        tw_destroy(&tw);
+}
+
+/* Canceled timers never expire; Re-arming moves a timer, counted once. */
+static void check_cancel_and_rearm(void)
+{
+        const time_t origin_usec = get_monotonic_time_usec();
+        timer_wheel_t *tw = tw_create();
+        timed_event_t canceled = {.expired = false};
+        timed_event_t moved = {.expired = false};
+        tw_timer_init(&canceled.timer, &canceled);
+        tw_timer_init(&moved.timer, &moved);
+        tw_arm(tw, &canceled.timer, origin_usec + (time_t)TICKS_PER_LEVEL_1_SLOT * 3 * TIMER_WHEEL_TICK_USEC);
+        tw_arm(tw, &moved.timer, origin_usec + (time_t)TICKS_PER_LEVEL_3_SLOT * TIMER_WHEEL_TICK_USEC);
+        tw_arm(tw, &moved.timer, origin_usec + (time_t)TICKS_PER_LEVEL_1_SLOT * 2 * TIMER_WHEEL_TICK_USEC);
+        CHECK(tw_armed_timers(tw) == 2);
+        tw_cancel(tw, &canceled.timer);
+        tw_cancel(tw, &canceled.timer); /* Harmless. */
+        CHECK(tw_armed_timers(tw) == 1 && !tw_is_armed(&canceled.timer));
+
+        run_wheel(tw);
+        CHECK(moved.expired && !canceled.expired);
+        tw_destroy(&tw);
+}
+
+int main(void)
+{
+        RUN_CHECK(check_cascade_across_levels);
+        RUN_CHECK(check_no_early_expiry);
+        RUN_CHECK(check_cancel_and_rearm);
+        return UNIT_CHECK_EXIT_STATUS();
+}
@@ -0,0 +1,265 @@
+/**
+ * microtcp_log_decode: Renders binary logs (see logging/microtcp_binary_logger.h), one line per record, in the order
+ * the logger's thread wrote them (timestamp order, per drain).
+ *
+ * Usage: microtcp_log_decode [binary_log...]
+ *      binary_log: Files written by processes running with MICROTCP_BINARY_LOG set; Standard input, if none is given.
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "logging/microtcp_binary_logger.h"
+#include "logging/microtcp_fsm_logger.h"
+#include "logging/microtcp_logger.h"
+
+#define RENDER_BUFFER_SIZE 4096
+#define MAX_PAYLOAD_SIZE (1 << 16)
+#define SITE_TABLE_INITIAL_CAPACITY 256
+#define NSEC_PER_SEC INT64_C(1000000000)
+
+typedef struct
+{
+        uint64_t id;
+        binary_log_site_t site;
+} decoded_site_t;
+
+static struct
+{
+        decoded_site_t *entries; /* Open addressing, by id; Id 0 marks a free entry (no site lives at address 0). */
+        size_t capacity;
+        size_t count;
+} sites;
+
+static int decode_file(const char *_path, FILE *_file);
+static int read_site(FILE *_file);
+static int read_event(FILE *_file);
+static int read_drops(FILE *_file);
+static char *read_string(FILE *_file);
+static decoded_site_t *find_site(uint64_t _id, _Bool _insert);
+static const char *get_tag_string(const binary_log_site_t *_site);
+
+int main(int _argc, char **_argv)
+{
+        if (_argc < 2)
+                return decode_file("<stdin>", stdin) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        int exit_status = EXIT_SUCCESS;
+        for (int i = 1; i < _argc; i++)
+        {
+                FILE *const file = fopen(_argv[i], "rb");
+                if (file == NULL)
+                {
+                        perror(_argv[i]);
+                        exit_status = EXIT_FAILURE;
+                        continue;
+                }
+                if (decode_file(_argv[i], file) != 0)
+                        exit_status = EXIT_FAILURE;
+                fclose(file);
+        }
+        return exit_status;
+}
+
+#define READ_FIELD(_file, _field) (fread(&(_field), sizeof(_field), 1, (_file)) == 1)
+
+static int decode_file(const char *const _path, FILE *const _file)
+{
+        char magic[sizeof(BINARY_LOG_FILE_MAGIC) - 1];
+        uint32_t version, reserved;
+        if (fread(magic, sizeof(magic), 1, _file) != 1 || memcmp(magic, BINARY_LOG_FILE_MAGIC, sizeof(magic)) != 0 ||
+            !READ_FIELD(_file, version) || !READ_FIELD(_file, reserved))
+        {
+                fprintf(stderr, "%s: Not a binary log.\n", _path);
+                return -1;
+        }
+        if (version != BINARY_LOG_FILE_VERSION)
+        {
+                fprintf(stderr, "%s: Binary log's version is %" PRIu32 "; Decoder reads version %d.\n", _path, version, BINARY_LOG_FILE_VERSION);
+                return -1;
+        }
+        sites.count = 0; /* Sites' ids are addresses, valid within their file only. */
+        if (sites.entries != NULL)
+                memset(sites.entries, 0, sites.capacity * sizeof(*sites.entries));
+
+        uint32_t kind;
+        while (READ_FIELD(_file, kind))
+        {
+                int read_ret_val;
+                switch (kind)
+                {
+                case BINARY_LOG_FILE_SITE:
+                        read_ret_val = read_site(_file);
+                        break;
+                case BINARY_LOG_FILE_EVENT:
+                        read_ret_val = read_event(_file);
+                        break;
+                case BINARY_LOG_FILE_DROPS:
+                        read_ret_val = read_drops(_file);
+                        break;
+                default:
+                        read_ret_val = -1;
+                        break;
+                }
+                if (read_ret_val != 0)
+                {
+                        fprintf(stderr, "%s: Truncated, or corrupted, at byte %ld.\n", _path, ftell(_file));
+                        return -1;
+                }
+        }
+        return 0;
+}
+
+static int read_site(FILE *const _file)
+{
+        uint64_t id;
+        int32_t tag, line;
+        binary_log_site_t site = {0};
+        if (!READ_FIELD(_file, id) || !READ_FIELD(_file, tag) || !READ_FIELD(_file, site.origin) || !READ_FIELD(_file, site.arg_count) ||
+            site.arg_count > BINARY_LOG_MAX_ARGS || fread(site.arg_types, 1, site.arg_count, _file) != site.arg_count || !READ_FIELD(_file, line))
+                return -1;
+        site.tag = tag;
+        site.line = line;
+        if ((site.project_name = read_string(_file)) == NULL || (site.file = read_string(_file)) == NULL ||
+            (site.func = read_string(_file)) == NULL || (site.format = read_string(_file)) == NULL)
+                return -1;
+        decoded_site_t *const entry = find_site(id, true);
+        if (entry == NULL)
+                return -1;
+        entry->site = site; /* Strings of a redefined site leak; Decoder exits soon. */
+        return 0;
+}
+
+static int read_event(FILE *const _file)
+{
+        static uint8_t payload[MAX_PAYLOAD_SIZE];
+        uint64_t site_id;
+        int64_t timestamp_nsec;
+        int32_t thread_id;
+        uint32_t payload_size;
+        if (!READ_FIELD(_file, site_id) || !READ_FIELD(_file, timestamp_nsec) || !READ_FIELD(_file, thread_id) ||
+            !READ_FIELD(_file, payload_size) || payload_size > sizeof(payload) || fread(payload, 1, payload_size, _file) != payload_size)
+                return -1;
+        const decoded_site_t *const entry = find_site(site_id, false);
+        if (entry == NULL)
+                return -1;
+
+        char message[RENDER_BUFFER_SIZE];
+        binary_log_render(&entry->site, payload, payload_size, message, sizeof(message));
+        const time_t seconds = timestamp_nsec / NSEC_PER_SEC;
+        struct tm calendar_time;
+        char time_string[32];
+        strftime(time_string, sizeof(time_string), "%F %T", localtime_r(&seconds, &calendar_time));
+        if (entry->site.origin == BINARY_LOG_ORIGIN_FSM)
+        {
+                printf("[%s.%09" PRId64 "][%" PRId32 "][%s]: %s\n", time_string, timestamp_nsec % NSEC_PER_SEC, thread_id,
+                       get_tag_string(&entry->site), message);
+                return 0;
+        }
+        const char *const file_name = strrchr(entry->site.file, '/') != NULL ? strrchr(entry->site.file, '/') + 1 : entry->site.file;
+        printf("[%s.%09" PRId64 "][%" PRId32 "][%s %s][%s:%d][%s()] %s\n", time_string, timestamp_nsec % NSEC_PER_SEC, thread_id,
+               entry->site.project_name, get_tag_string(&entry->site), file_name, entry->site.line, entry->site.func, message);
+        return 0;
+}
+
+static int read_drops(FILE *const _file)
+{
+        int32_t thread_id;
+        uint64_t dropped;
+        if (!READ_FIELD(_file, thread_id) || !READ_FIELD(_file, dropped))
+                return -1;
+        printf("[%" PRId32 "] %" PRIu64 " records dropped; Thread's ring was full.\n", thread_id, dropped);
+        return 0;
+}
+
+static char *read_string(FILE *const _file)
+{
+        uint32_t length;
+        if (!READ_FIELD(_file, length) || length > MAX_PAYLOAD_SIZE)
+                return NULL;
+        char *const string = malloc(length + 1);
+        if (string == NULL || fread(string, 1, length, _file) != length)
+        {
+                free(string);
+                return NULL;
+        }
+        string[length] = '\0';
+        return string;
+}
+
+static decoded_site_t *find_site(const uint64_t _id, const _Bool _insert)
+{
+        if (_id == 0)
+                return NULL;
+        if (_insert && 2 * (sites.count + 1) > sites.capacity) /* Keep load under 1/2. */
+        {
+                const size_t capacity = sites.capacity == 0 ? SITE_TABLE_INITIAL_CAPACITY : 2 * sites.capacity;
+                decoded_site_t *const entries = calloc(capacity, sizeof(*entries));
+                if (entries == NULL)
+                        return NULL;
+                for (size_t i = 0; i < sites.capacity; i++)
+                {
+                        if (sites.entries[i].id == 0)
+                                continue;
+                        size_t slot = (sites.entries[i].id >> 4) & (capacity - 1);
+                        while (entries[slot].id != 0)
+                                slot = (slot + 1) & (capacity - 1);
+                        entries[slot] = sites.entries[i];
+                }
+                free(sites.entries);
+                sites.entries = entries;
+                sites.capacity = capacity;
+        }
+        if (sites.capacity == 0)
+                return NULL;
+        size_t slot = (_id >> 4) & (sites.capacity - 1);
+        while (sites.entries[slot].id != 0)
+        {
+                if (sites.entries[slot].id == _id)
+                        return &sites.entries[slot];
+                slot = (slot + 1) & (sites.capacity - 1);
+        }
+        if (!_insert)
+                return NULL;
+        sites.entries[slot].id = _id;
+        sites.count++;
+        return &sites.entries[slot];
+}
+
+static const char *get_tag_string(const binary_log_site_t *const _site)
+{
+        if (_site->origin == BINARY_LOG_ORIGIN_FSM)
+        {
+                switch (_site->tag)
+                {
+                case FSM_CONNECT:
+                        return "FSM_CONNECT";
+                case FSM_ACCEPT:
+                        return "FSM_ACCEPT";
+                case FSM_SHUTDOWN:
+                        return "FSM_SHUTDOWN";
+                case FSM_RECV:
+                        return "FSM_RECV";
+                case FSM_SEND:
+                        return "FSM_SEND";
+                default:
+                        return "??FSM??";
+                }
+        }
+        switch (_site->tag)
+        {
+        case LOG_INFO:
+        case LOG_INFO_APP:
+                return "INFO";
+        case LOG_WARNING:
+        case LOG_WARNING_APP:
+                return "WARNING";
+        case LOG_ERROR:
+        case LOG_ERROR_APP:
+                return "ERROR";
+        default:
+                return "??LOG??";
+        }
+}
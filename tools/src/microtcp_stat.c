@@ -0,0 +1,245 @@
+/**
+ * microtcp_stat: Live view of microTCP connections, in the fashion of `ss -ti`.
+ * Attaches read-only to the shared memory segments of exporting processes (see core/stats_export.h); Exporting is
+ * started by microtcp_stats_export_start(), or by running the process with MICROTCP_STATS_EXPORT set.
+ *
+ * Usage: microtcp_stat [-i interval_msec] [-n count] [pid...]
+ *      -i: Refreshes the view every `interval_msec`, until interrupted (or `count` views are printed).
+ *      -n: Number of views to print.
+ *      pid: Exporting processes to watch; All of them, if none is given.
+ */
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/stats_export.h"
+#include "microtcp.h"
+#include "microtcp_helper_macros.h"
+
+#define SHM_DIRECTORY "/dev/shm"
+#define MAX_WATCHED_PROCESSES 64
+#define SHM_NAME_CAPACITY 64
+#define USEC_PER_MSEC 1000
+
+static const char *get_state_to_string(microtcp_state_t _state);
+static size_t find_exporting_processes(pid_t *_pids, size_t _max_pids);
+static const stats_export_t *attach(pid_t _pid);
+static void print_process(const stats_export_t *_segment);
+static void print_connection(const stats_export_slot_t *_slot, stats_export_totals_t *_live_totals);
+static void print_totals(const char *_label, const stats_export_totals_t *_totals);
+
+int main(int _argc, char **_argv)
+{
+        long interval_msec = 0;
+        long count = 1;
+        _Bool count_given = false;
+        int option;
+        while ((option = getopt(_argc, _argv, "i:n:h")) != -1)
+        {
+                switch (option)
+                {
+                case 'i':
+                        interval_msec = strtol(optarg, NULL, 10);
+                        break;
+                case 'n':
+                        count = strtol(optarg, NULL, 10);
+                        count_given = true;
+                        break;
+                default:
+                        fprintf(stderr, "Usage: %s [-i interval_msec] [-n count] [pid...]\n", _argv[0]);
+                        return option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+                }
+        }
+        if (interval_msec < 0 || count < 1)
+        {
+                fprintf(stderr, "%s: Interval must be positive, and count at least 1.\n", _argv[0]);
+                return EXIT_FAILURE;
+        }
+        if (interval_msec > 0 && !count_given)
+                count = -1; /* Until interrupted. */
+
+        pid_t pids[MAX_WATCHED_PROCESSES];
+        size_t pid_count = 0;
+        for (int i = optind; i < _argc && pid_count < MAX_WATCHED_PROCESSES; i++)
+                pids[pid_count++] = (pid_t)strtol(_argv[i], NULL, 10);
+        const _Bool scan = pid_count == 0; /* Processes come and go; Rescanned each view. */
+
+        for (long view = 0; count < 0 || view < count; view++)
+        {
+                if (view > 0)
+                        usleep((useconds_t)(interval_msec * USEC_PER_MSEC));
+                if (interval_msec > 0)
+                        CLEAR_SCREEN();
+                if (scan)
+                        pid_count = find_exporting_processes(pids, MAX_WATCHED_PROCESSES);
+                if (pid_count == 0)
+                        printf("No exporting microTCP process found (see %s).\n", STATS_EXPORT_ENVIRONMENT_VARIABLE);
+                for (size_t i = 0; i < pid_count; i++)
+                {
+                        const stats_export_t *const segment = attach(pids[i]);
+                        if (segment == NULL)
+                                continue;
+                        print_process(segment);
+                        munmap((void *)segment, sizeof(*segment));
+                }
+                fflush(stdout);
+        }
+        return EXIT_SUCCESS;
+}
+
+static const char *get_state_to_string(const microtcp_state_t _state)
+{
+        switch (_state)
+        {
+        case RESET:
+                return "RESET";
+        case INVALID:
+                return "INVALID";
+        case CLOSED:
+                return "CLOSED";
+        case LISTEN:
+                return "LISTEN";
+        case ESTABLISHED:
+                return "ESTAB";
+        case CLOSING_BY_PEER:
+                return "CLOSE-WAIT";
+        case CLOSING_BY_HOST:
+                return "FIN-WAIT";
+        default:
+                return "UNKNOWN";
+        }
+}
+
+static size_t find_exporting_processes(pid_t *const _pids, const size_t _max_pids)
+{
+        const char *const prefix = STATS_EXPORT_SHM_NAME_PREFIX + 1; /* Entries are named without the leading '/'. */
+        DIR *const directory = opendir(SHM_DIRECTORY);
+        if (directory == NULL)
+                return 0;
+        size_t pid_count = 0;
+        struct dirent *entry;
+        while ((entry = readdir(directory)) != NULL && pid_count < _max_pids)
+                if (strncmp(entry->d_name, prefix, strlen(prefix)) == 0)
+                        _pids[pid_count++] = (pid_t)strtol(entry->d_name + strlen(prefix), NULL, 10);
+        closedir(directory);
+        return pid_count;
+}
+
+static const stats_export_t *attach(const pid_t _pid)
+{
+        char shm_name[SHM_NAME_CAPACITY];
+        snprintf(shm_name, sizeof(shm_name), "%s%d", STATS_EXPORT_SHM_NAME_PREFIX, (int)_pid);
+        const int shm_fd = shm_open(shm_name, O_RDONLY, 0);
+        if (shm_fd == -1)
+        {
+                fprintf(stderr, "pid %d: Not exporting; shm_open(%s) set errno(%d):%s.\n", (int)_pid, shm_name, errno, strerror(errno));
+                return NULL;
+        }
+        struct stat shm_stat;
+        const stats_export_t *segment = MAP_FAILED;
+        if (fstat(shm_fd, &shm_stat) == 0 && (size_t)shm_stat.st_size >= sizeof(*segment))
+                segment = mmap(NULL, sizeof(*segment), PROT_READ, MAP_SHARED, shm_fd, 0);
+        close(shm_fd);
+        if (segment == MAP_FAILED)
+        {
+                fprintf(stderr, "pid %d: Segment %s is not mappable, or too small.\n", (int)_pid, shm_name);
+                return NULL;
+        }
+        const uint32_t magic = __atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE); /* Exporter sets it last. */
+        if (magic != STATS_EXPORT_MAGIC || segment->version != STATS_EXPORT_VERSION || segment->slot_count > STATS_EXPORT_SLOTS)
+        {
+                fprintf(stderr, "pid %d: Segment %s is not initialized yet, or of another version.\n", (int)_pid, shm_name);
+                munmap((void *)segment, sizeof(*segment));
+                return NULL;
+        }
+        return segment;
+}
+
+static void print_process(const stats_export_t *const _segment)
+{
+        stats_export_totals_t closed_totals;
+        uint32_t sequence;
+        do
+        {
+                sequence = stats_export_read_begin(&_segment->sequence);
+                closed_totals = _segment->totals;
+        } while (stats_export_read_retry(&_segment->sequence, sequence));
+
+        const _Bool alive = kill(_segment->pid, 0) == 0 || errno == EPERM;
+        printf("pid %d%s: %" PRIu64 " opened, %" PRIu64 " closed, %" PRIu64 " unexported connections\n",
+               (int)_segment->pid, alive ? "" : " (exited)", closed_totals.connections_opened,
+               closed_totals.connections_closed, closed_totals.connections_unexported);
+        printf("%-10s %-21s %-21s\n", "State", "Local Address:Port", "Peer Address:Port");
+        stats_export_totals_t live_totals = {0};
+        for (uint32_t i = 0; i < _segment->slot_count; i++)
+                print_connection(&_segment->slots[i], &live_totals);
+        print_totals("live", &live_totals);
+        print_totals("closed", &closed_totals);
+        putchar('\n');
+}
+
+static void print_connection(const stats_export_slot_t *const _slot, stats_export_totals_t *const _live_totals)
+{
+        stats_export_slot_t slot;
+        uint32_t sequence;
+        do
+        {
+                sequence = stats_export_read_begin(&_slot->sequence);
+                if (!_slot->in_use)
+                        return;
+                memcpy(&slot, _slot, sizeof(slot));
+        } while (stats_export_read_retry(&_slot->sequence, sequence));
+
+        const microtcp_info_t *const info = &slot.info;
+        char local_ip[INET_ADDRSTRLEN], peer_ip[INET_ADDRSTRLEN];
+        char local[INET_ADDRSTRLEN + 8], peer[INET_ADDRSTRLEN + 8];
+        inet_ntop(AF_INET, &slot.local_address.sin_addr, local_ip, sizeof(local_ip));
+        inet_ntop(AF_INET, &slot.peer_address.sin_addr, peer_ip, sizeof(peer_ip));
+        snprintf(local, sizeof(local), "%s:%u", local_ip, ntohs(slot.local_address.sin_port));
+        snprintf(peer, sizeof(peer), "%s:%u", peer_ip, ntohs(slot.peer_address.sin_port));
+        printf("%-10s %-21s %-21s\n", get_state_to_string(info->state), local, peer);
+        printf("\t rtt:%.3f/%.3f rto:%.3f cwnd:%zu", (double)info->srtt_usec / USEC_PER_MSEC,
+               (double)info->rttvar_usec / USEC_PER_MSEC, (double)info->rto_usec / USEC_PER_MSEC, info->cwnd);
+        if (info->ssthresh != SIZE_MAX) /* Slow start's initial threshold is unbounded; `ss` omits it too. */
+                printf(" ssthresh:%zu", info->ssthresh);
+        printf(" peer_win:%zu inflight:%zu ooo:%zu\n", info->peer_win_size, info->bytes_in_flight, info->out_of_order_bytes);
+        printf("\t sent:%" PRIu64 "/%" PRIu64 "B lost:%" PRIu64 "/%" PRIu64 "B rcvd:%" PRIu64 "/%" PRIu64 "B"
+               " retrans:%" PRIu64 "/%" PRIu64 " timeouts:%" PRIu64 " dupacks:%" PRIu64 "\n",
+               info->packets_sent, info->bytes_sent, info->packets_lost, info->bytes_lost, info->packets_received, info->bytes_received,
+               info->stats.timeout_retransmits, info->stats.fast_retransmits, info->stats.timeouts, info->stats.duplicate_acks);
+        printf("\t send_fsm_ms data:%.1f ack:%.1f retrans:%.1f zero_win:%.1f\n",
+               (double)info->stats.send_fsm_usec[MICROTCP_SEND_FSM_DATA_ROUND] / USEC_PER_MSEC,
+               (double)info->stats.send_fsm_usec[MICROTCP_SEND_FSM_ACK_ROUND] / USEC_PER_MSEC,
+               (double)info->stats.send_fsm_usec[MICROTCP_SEND_FSM_RETRANSMISSIONS] / USEC_PER_MSEC,
+               (double)info->stats.send_fsm_usec[MICROTCP_SEND_FSM_PEER_WINDOW_ZERO] / USEC_PER_MSEC);
+
+        _live_totals->packets_sent += info->packets_sent;
+        _live_totals->packets_lost += info->packets_lost;
+        _live_totals->packets_received += info->packets_received;
+        _live_totals->bytes_sent += info->bytes_sent;
+        _live_totals->bytes_lost += info->bytes_lost;
+        _live_totals->bytes_received += info->bytes_received;
+        _live_totals->timeouts += info->stats.timeouts;
+        _live_totals->timeout_retransmits += info->stats.timeout_retransmits;
+        _live_totals->fast_retransmits += info->stats.fast_retransmits;
+        _live_totals->duplicate_acks += info->stats.duplicate_acks;
+}
+
+static void print_totals(const char *const _label, const stats_export_totals_t *const _totals)
+{
+        printf("Total (%s): sent:%" PRIu64 "/%" PRIu64 "B lost:%" PRIu64 "/%" PRIu64 "B rcvd:%" PRIu64 "/%" PRIu64 "B"
+               " retrans:%" PRIu64 "/%" PRIu64 " timeouts:%" PRIu64 " dupacks:%" PRIu64 "\n",
+               _label, _totals->packets_sent, _totals->bytes_sent, _totals->packets_lost, _totals->bytes_lost,
+               _totals->packets_received, _totals->bytes_received, _totals->timeout_retransmits, _totals->fast_retransmits,
+               _totals->timeouts, _totals->duplicate_acks);
+}
@@ -0,0 +1,164 @@
+#ifndef MICROTCP_BINARY_LOGGER_H
+#define MICROTCP_BINARY_LOGGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "logging/microtcp_logger.h"
+
+/**
+ * @brief Asynchronous binary logger (see BINARY_LOG_MODE): LOG_*() calls only record their call site and raw arguments,
+ * in a lock-free ring of their thread; No formatting, no locks, no I/O on the calling thread.
+ * A background thread drains the rings, every BINARY_LOG_DRAIN_INTERVAL_USEC, in timestamp order. It formats records
+ * to the log stream; Or, if MICROTCP_BINARY_LOG names a path prefix, persists them to `<prefix>.<pid>`, for
+ * `microtcp_log_decode` to render offline.
+ * Records that find their ring full are dropped (and counted), instead of blocking the thread.
+ */
+
+#define BINARY_LOG_ENVIRONMENT_VARIABLE "MICROTCP_BINARY_LOG"
+#define BINARY_LOG_RING_SIZE (1 << 16)	      /* Per thread; Power of 2. */
+#define BINARY_LOG_DRAIN_INTERVAL_USEC 2000
+#define BINARY_LOG_MAX_ARGS 16
+#define BINARY_LOG_MAX_STRING_LENGTH 255      /* Longer string arguments are truncated. */
+#define BINARY_LOG_NULL_STRING UINT64_MAX     /* String argument's length, when it is NULL. */
+
+/* Persisted file's layout: Header, then records, each starting with its `binary_log_file_record_kind`. Native byte order. */
+#define BINARY_LOG_FILE_MAGIC "mTCPBLOG"
+#define BINARY_LOG_FILE_VERSION 1
+enum binary_log_file_record_kind
+{
+	BINARY_LOG_FILE_SITE = 1, /* uint64 id, int32 tag, uint8 origin, uint8 arg_count, uint8 arg_types[arg_count], int32 line,
+				   * then project, file, func and format; Each a uint32 length and its bytes. Precedes site's events. */
+	BINARY_LOG_FILE_EVENT,	  /* uint64 site id, int64 timestamp_nsec, int32 thread_id, uint32 payload_size, payload. */
+	BINARY_LOG_FILE_DROPS,	  /* int32 thread_id, uint64 records dropped since the previous report. */
+};
+
+enum binary_log_arg_type
+{
+	BINARY_LOG_ARG_END, /* Terminates `arg_types`. */
+	BINARY_LOG_ARG_SIGNED,
+	BINARY_LOG_ARG_UNSIGNED,
+	BINARY_LOG_ARG_DOUBLE,
+	BINARY_LOG_ARG_STRING, /* Copied; Its slot holds the length, bytes follow the slots (NUL terminated, 8-byte aligned). */
+	BINARY_LOG_ARG_POINTER,
+};
+
+enum binary_log_origin
+{
+	BINARY_LOG_ORIGIN_MESSAGE, /* LOG_*(); `tag` is an `enum log_tag`. */
+	BINARY_LOG_ORIGIN_FSM,	   /* LOG_FSM_*(); `tag` is an `enum fsm_log_tag`. */
+};
+
+/* Everything a LOG_*() call knows at compile time; One static instance per call site, its address is site's id. */
+typedef struct
+{
+	int tag;
+	uint8_t origin;
+	uint8_t arg_count;
+	uint8_t arg_types[BINARY_LOG_MAX_ARGS + 1];
+	int line;
+	const char *project_name;
+	const char *file;
+	const char *func;
+	const char *format;
+} binary_log_site_t;
+
+typedef union
+{
+	int64_t signed_value;
+	uint64_t unsigned_value;
+	double double_value;
+	const char *string;
+	const void *pointer;
+} binary_log_arg_t;
+
+/* Records a call; Hot path. */
+void binary_log_write(const binary_log_site_t *_site, const binary_log_arg_t *_args);
+
+/* Drains every ring, and stops the background thread; Called by logger's destructor. Records logged afterwards are dropped. */
+void binary_log_stop(void);
+
+/**
+ * @brief Renders a record's message, as printf() would have; Shared with the offline decoder.
+ * @returns message's length; Truncated to `_buffer_size` - 1.
+ */
+size_t binary_log_render(const binary_log_site_t *_site, const void *_payload, size_t _payload_size, char *_buffer, size_t _buffer_size);
+
+/* Argument encoding; _Generic picks, per argument, a type known at compile time and an encoder. */
+static inline binary_log_arg_t binary_log_encode_signed(const int64_t _value) { return (binary_log_arg_t){.signed_value = _value}; }
+static inline binary_log_arg_t binary_log_encode_unsigned(const uint64_t _value) { return (binary_log_arg_t){.unsigned_value = _value}; }
+static inline binary_log_arg_t binary_log_encode_double(const double _value) { return (binary_log_arg_t){.double_value = _value}; }
+static inline binary_log_arg_t binary_log_encode_string(const char *const _value) { return (binary_log_arg_t){.string = _value}; }
+static inline binary_log_arg_t binary_log_encode_pointer(const void *const _value) { return (binary_log_arg_t){.pointer = _value}; }
+
+// clang-format off
+#define BINARY_LOG_ARG_TYPE(_arg) _Generic((_arg),						\
+	_Bool: BINARY_LOG_ARG_UNSIGNED, char: BINARY_LOG_ARG_SIGNED,				\
+	signed char: BINARY_LOG_ARG_SIGNED, unsigned char: BINARY_LOG_ARG_UNSIGNED,		\
+	short: BINARY_LOG_ARG_SIGNED, unsigned short: BINARY_LOG_ARG_UNSIGNED,			\
+	int: BINARY_LOG_ARG_SIGNED, unsigned int: BINARY_LOG_ARG_UNSIGNED,			\
+	long: BINARY_LOG_ARG_SIGNED, unsigned long: BINARY_LOG_ARG_UNSIGNED,			\
+	long long: BINARY_LOG_ARG_SIGNED, unsigned long long: BINARY_LOG_ARG_UNSIGNED,		\
+	float: BINARY_LOG_ARG_DOUBLE, double: BINARY_LOG_ARG_DOUBLE, long double: BINARY_LOG_ARG_DOUBLE, \
+	char *: BINARY_LOG_ARG_STRING, const char *: BINARY_LOG_ARG_STRING,			\
+	default: BINARY_LOG_ARG_POINTER),
+
+#define BINARY_LOG_ARG_VALUE(_arg) _Generic((_arg),						\
+	_Bool: binary_log_encode_unsigned, char: binary_log_encode_signed,			\
+	signed char: binary_log_encode_signed, unsigned char: binary_log_encode_unsigned,	\
+	short: binary_log_encode_signed, unsigned short: binary_log_encode_unsigned,		\
+	int: binary_log_encode_signed, unsigned int: binary_log_encode_unsigned,		\
+	long: binary_log_encode_signed, unsigned long: binary_log_encode_unsigned,		\
+	long long: binary_log_encode_signed, unsigned long long: binary_log_encode_unsigned,	\
+	float: binary_log_encode_double, double: binary_log_encode_double, long double: binary_log_encode_double, \
+	char *: binary_log_encode_string, const char *: binary_log_encode_string,		\
+	default: binary_log_encode_pointer)(_arg),
+
+/* Argument counting and mapping, up to BINARY_LOG_MAX_ARGS; Each mapped argument ends with a comma. */
+#define BINARY_LOG_COUNT_ARGS(...) BINARY_LOG_COUNT_ARGS_(_, ##__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define BINARY_LOG_COUNT_ARGS_(_, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _count, ...) _count
+#define BINARY_LOG_CONCATENATE(_a, _b) BINARY_LOG_CONCATENATE_(_a, _b)
+#define BINARY_LOG_CONCATENATE_(_a, _b) _a##_b
+#define BINARY_LOG_MAP(_macro, ...) BINARY_LOG_CONCATENATE(BINARY_LOG_MAP_, BINARY_LOG_COUNT_ARGS(__VA_ARGS__))(_macro, ##__VA_ARGS__)
+#define BINARY_LOG_MAP_0(_macro)
+#define BINARY_LOG_MAP_1(_macro, _arg) _macro(_arg)
+#define BINARY_LOG_MAP_2(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_1(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_3(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_2(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_4(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_3(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_5(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_4(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_6(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_5(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_7(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_6(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_8(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_7(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_9(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_8(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_10(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_9(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_11(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_10(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_12(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_11(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_13(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_12(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_14(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_13(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_15(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_14(_macro, __VA_ARGS__)
+#define BINARY_LOG_MAP_16(_macro, _arg, ...) _macro(_arg) BINARY_LOG_MAP_15(_macro, __VA_ARGS__)
+// clang-format on
+
+/**
+ * @brief Records a LOG_*() call. Site is built at compile time (`_format_message` must be a literal); At run time,
+ * only the arguments are evaluated and copied.
+ */
+#define BINARY_LOG_RECORD(_origin, _log_tag, _project_name, _format_message, ...) __extension__({                                      \
+	static const binary_log_site_t binary_log_site = {.tag = (_log_tag),                                                         \
+							  .origin = (_origin),                                                       \
+							  .arg_count = BINARY_LOG_COUNT_ARGS(__VA_ARGS__),                           \
+							  .arg_types = {BINARY_LOG_MAP(BINARY_LOG_ARG_TYPE, ##__VA_ARGS__) BINARY_LOG_ARG_END}, \
+							  .line = __LINE__,                                                          \
+							  .project_name = (_project_name),                                           \
+							  .file = __FILE__,                                                          \
+							  .func = __func__,                                                          \
+							  .format = (_format_message)};                                              \
+	const binary_log_arg_t binary_log_args[] = {BINARY_LOG_MAP(BINARY_LOG_ARG_VALUE, ##__VA_ARGS__){0}};                       \
+	binary_log_write(&binary_log_site, binary_log_args);                                                                        \
+})
+
+#define BINARY_LOG_MESSAGE(_log_tag, _project_name, _format_message, ...) \
+	BINARY_LOG_RECORD(BINARY_LOG_ORIGIN_MESSAGE, _log_tag, _project_name, _format_message, ##__VA_ARGS__)
+#define BINARY_LOG_FSM_MESSAGE(_fsm_log_tag, _format_message, ...) \
+	BINARY_LOG_RECORD(BINARY_LOG_ORIGIN_FSM, _fsm_log_tag, TRANSPORT_PROTOCOL_NAME, _format_message, ##__VA_ARGS__)
+
+#endif /* MICROTCP_BINARY_LOGGER_H */
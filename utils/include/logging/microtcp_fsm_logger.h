@@ -12,15 +12,22 @@ enum fsm_log_tag
 
 void log_fsm_message_thread_safe(enum fsm_log_tag _fsm_log_tag, const char *_format_message, ...);
 
+#ifndef BINARY_LOG_MODE
+#define LOG_FSM_MESSAGE(_fsm_log_tag, _format_message, ...) log_fsm_message_thread_safe(_fsm_log_tag, _format_message, ##__VA_ARGS__)
+#else /* ifdef BINARY_LOG_MODE */
+#include "logging/microtcp_binary_logger.h"
+#define LOG_FSM_MESSAGE(_fsm_log_tag, _format_message, ...) BINARY_LOG_FSM_MESSAGE(_fsm_log_tag, _format_message, ##__VA_ARGS__)
+#endif /* BINARY_LOG_MODE */
+
 /* In MicroTCP these are not performance critical, thus are always visible. (Expect is logging is completely disabled (through MicroTCP's settings). */
-#define LOG_FSM_CONNECT(_format_message, ...) log_fsm_message_thread_safe(FSM_CONNECT, _format_message, ##__VA_ARGS__)
-#define LOG_FSM_ACCEPT(_format_message, ...) log_fsm_message_thread_safe(FSM_ACCEPT, _format_message, ##__VA_ARGS__)
-#define LOG_FSM_SHUTDOWN(_format_message, ...) log_fsm_message_thread_safe(FSM_SHUTDOWN, _format_message, ##__VA_ARGS__)
+#define LOG_FSM_CONNECT(_format_message, ...) LOG_FSM_MESSAGE(FSM_CONNECT, _format_message, ##__VA_ARGS__)
+#define LOG_FSM_ACCEPT(_format_message, ...) LOG_FSM_MESSAGE(FSM_ACCEPT, _format_message, ##__VA_ARGS__)
+#define LOG_FSM_SHUTDOWN(_format_message, ...) LOG_FSM_MESSAGE(FSM_SHUTDOWN, _format_message, ##__VA_ARGS__)
 
 /* Enable logging for RECV and SEND FSM only in VERBOSE_MODE for performance reasons */
 #ifdef VERBOSE_MODE
-#define LOG_FSM_RECV(_format_message, ...) log_fsm_message_thread_safe(FSM_RECV, _format_message, ##__VA_ARGS__)
-#define LOG_FSM_SEND(_format_message, ...) log_fsm_message_thread_safe(FSM_SEND, _format_message, ##__VA_ARGS__)
+#define LOG_FSM_RECV(_format_message, ...) LOG_FSM_MESSAGE(FSM_RECV, _format_message, ##__VA_ARGS__)
+#define LOG_FSM_SEND(_format_message, ...) LOG_FSM_MESSAGE(FSM_SEND, _format_message, ##__VA_ARGS__)
 #else /* ifndef VERBOSE_MODE */
 #define LOG_FSM_RECV(_format_message, ...)
 #define LOG_FSM_SEND(_format_message, ...)
@@ -91,10 +91,17 @@ void log_message_non_thread_safe(enum log_tag _log_tag, const char *_project_nam
  *
  * @note This macro ensures thread safety, making it suitable for multi-threaded environments.
  */
+#ifndef BINARY_LOG_MODE
 #define LOG_MESSAGE(_log_tag, _format_message, ...) \
 	log_message_thread_safe(_log_tag, TRANSPORT_PROTOCOL_NAME, __FILENAME__, __LINE__, __func__, _format_message, ##__VA_ARGS__)
 #define LOG_APP_MESSAGE(_log_tag, _format_message, ...) \
 	log_message_thread_safe(_log_tag, APPLICATION_NAME, __FILENAME__, __LINE__, __func__, _format_message, ##__VA_ARGS__)
+#else /* ifdef BINARY_LOG_MODE */
+/* Calling thread only records the call (see logging/microtcp_binary_logger.h); Logger's thread formats it. */
+#include "logging/microtcp_binary_logger.h"
+#define LOG_MESSAGE(_log_tag, _format_message, ...) BINARY_LOG_MESSAGE(_log_tag, TRANSPORT_PROTOCOL_NAME, _format_message, ##__VA_ARGS__)
+#define LOG_APP_MESSAGE(_log_tag, _format_message, ...) BINARY_LOG_MESSAGE(_log_tag, APPLICATION_NAME, _format_message, ##__VA_ARGS__)
+#endif /* BINARY_LOG_MODE */
 
 #if defined(DEBUG_MODE) || defined(VERBOSE_MODE)
 /**
@@ -0,0 +1,209 @@
+#include "crc32.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CRC32_PCLMUL_SUPPORTED
+#endif /* __x86_64__ */
+
+#define CRC32_REFLECTED_POLYNOMIAL 0xEDB88320U /* Bit-reflected 0x104C11DB7. */
+#define CRC32_SLICES 8
+
+/* PCLMUL kernel folds 64 byte blocks, then 16 byte blocks; Shorter inputs (and tails) are left to slice-by-8. */
+#define CRC32_PCLMUL_MINIMUM_LENGTH 64
+#define CRC32_PCLMUL_CHUNK_MASK 15
+
+/* Copy-and-checksum works on chunks small enough to still be in L1, when CRC re-reads them from destination. */
+#define CRC32_COPY_CHUNK_SIZE 512
+
+typedef uint32_t (*crc32_engine_t)(uint32_t _crc, const uint8_t *_data, size_t _length);
+
+/* crc32_lut[0] is the classic bytewise table; crc32_lut[k] advances a byte through k extra zero bytes. */
+static uint32_t crc32_lut[CRC32_SLICES][256];
+static crc32_engine_t crc32_engine = update_crc32_slice_by_8;
+static const char *crc32_engine_label = "slice-by-8";
+
+/* Runs before main() (and before any socket exists), so the engine is never switched under a caller's feet. */
+__attribute__((constructor)) static void initialize_crc32_engine(void)
+{
+        for (uint32_t i = 0; i < 256; i++)
+        {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++)
+                        crc = (crc >> 1) ^ (CRC32_REFLECTED_POLYNOMIAL & (0U - (crc & 1)));
+                crc32_lut[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++)
+                for (int slice = 1; slice < CRC32_SLICES; slice++)
+                        crc32_lut[slice][i] = (crc32_lut[slice - 1][i] >> 8) ^ crc32_lut[0][crc32_lut[slice - 1][i] & 0xFF];
+
+#ifdef CRC32_PCLMUL_SUPPORTED
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+        {
+                crc32_engine = update_crc32_pclmul;
+                crc32_engine_label = "pclmul";
+        }
+#endif /* CRC32_PCLMUL_SUPPORTED */
+}
+
+uint32_t update_crc32(const uint32_t _crc, const uint8_t *const _data, const size_t _length)
+{
+        return crc32_engine(_crc, _data, _length);
+}
+
+uint32_t update_crc32_copy(uint32_t _crc, uint8_t *_dst, const uint8_t *_src, size_t _length)
+{
+        while (_length > 0)
+        {
+                const size_t chunk_size = _length < CRC32_COPY_CHUNK_SIZE ? _length : CRC32_COPY_CHUNK_SIZE;
+                memcpy(_dst, _src, chunk_size);
+                _crc = crc32_engine(_crc, _dst, chunk_size);
+                _dst += chunk_size;
+                _src += chunk_size;
+                _length -= chunk_size;
+        }
+        return _crc;
+}
+
+const char *crc32_engine_name(void)
+{
+        return crc32_engine_label;
+}
+
+static uint32_t crc32_bytewise(uint32_t _crc, const uint8_t *_data, size_t _length)
+{
+        while (_length--)
+                _crc = (_crc >> 8) ^ crc32_lut[0][(_crc ^ *_data++) & 0xFF];
+        return _crc;
+}
+
+uint32_t update_crc32_slice_by_8(uint32_t _crc, const uint8_t *_data, size_t _length)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        while (_length >= 8)
+        {
+                uint32_t low_word;
+                uint32_t high_word;
+                memcpy(&low_word, _data, sizeof(low_word)); /* memcpy() avoids unaligned access UB; Compiles to a plain load. */
+                memcpy(&high_word, _data + 4, sizeof(high_word));
+                low_word ^= _crc;
+                _crc = crc32_lut[7][low_word & 0xFF] ^
+                       crc32_lut[6][(low_word >> 8) & 0xFF] ^
+                       crc32_lut[5][(low_word >> 16) & 0xFF] ^
+                       crc32_lut[4][low_word >> 24] ^
+                       crc32_lut[3][high_word & 0xFF] ^
+                       crc32_lut[2][(high_word >> 8) & 0xFF] ^
+                       crc32_lut[1][(high_word >> 16) & 0xFF] ^
+                       crc32_lut[0][high_word >> 24];
+                _data += 8;
+                _length -= 8;
+        }
+#endif /* __BYTE_ORDER__ */
+        return crc32_bytewise(_crc, _data, _length);
+}
+
+#ifdef CRC32_PCLMUL_SUPPORTED
+/**
+ * @brief Folds `_length` bytes (at least 64, multiple of 16) with carry-less multiplications, then Barrett reduces to 32 bits.
+ * Constants are the bit-reflected k1..k5 and μ/P(x) of Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ".
+ */
+__attribute__((target("pclmul,sse4.1"))) static uint32_t crc32_pclmul_fold(const uint8_t *_data, size_t _length, const uint32_t _crc)
+{
+        static const uint64_t __attribute__((aligned(16))) k1k2[] = {0x0154442bd4, 0x01c6e41596};
+        static const uint64_t __attribute__((aligned(16))) k3k4[] = {0x01751997d0, 0x00ccaa009e};
+        static const uint64_t __attribute__((aligned(16))) k5k0[] = {0x0163cd6124, 0x0000000000};
+        static const uint64_t __attribute__((aligned(16))) poly[] = {0x01db710641, 0x01f7011641};
+
+        __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+        x1 = _mm_loadu_si128((const __m128i *)(_data + 0x00));
+        x2 = _mm_loadu_si128((const __m128i *)(_data + 0x10));
+        x3 = _mm_loadu_si128((const __m128i *)(_data + 0x20));
+        x4 = _mm_loadu_si128((const __m128i *)(_data + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(_crc));
+        x0 = _mm_load_si128((const __m128i *)k1k2);
+        _data += 64;
+        _length -= 64;
+
+        /* Fold 4 x 128 bits in parallel. */
+        while (_length >= 64)
+        {
+                x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+                x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+                x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+                x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+                x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+                x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+                x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+                x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+                y5 = _mm_loadu_si128((const __m128i *)(_data + 0x00));
+                y6 = _mm_loadu_si128((const __m128i *)(_data + 0x10));
+                y7 = _mm_loadu_si128((const __m128i *)(_data + 0x20));
+                y8 = _mm_loadu_si128((const __m128i *)(_data + 0x30));
+                x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+                x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+                x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+                x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+                _data += 64;
+                _length -= 64;
+        }
+
+        /* Fold the 4 lanes into a single 128 bit one. */
+        x0 = _mm_load_si128((const __m128i *)k3k4);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+        /* Fold remaining 16 byte blocks. */
+        while (_length >= 16)
+        {
+                x2 = _mm_loadu_si128((const __m128i *)_data);
+                x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+                x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+                x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+                _data += 16;
+                _length -= 16;
+        }
+
+        /* Fold 128 bits to 64 bits. */
+        x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+        x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+        x1 = _mm_srli_si128(x1, 8);
+        x1 = _mm_xor_si128(x1, x2);
+        x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, x3);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        /* Barrett reduce to 32 bits. */
+        x0 = _mm_load_si128((const __m128i *)poly);
+        x2 = _mm_and_si128(x1, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+        x2 = _mm_and_si128(x2, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+        return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+uint32_t update_crc32_pclmul(uint32_t _crc, const uint8_t *_data, size_t _length)
+{
+        if (_length >= CRC32_PCLMUL_MINIMUM_LENGTH)
+        {
+                const size_t folded_length = _length & ~(size_t)CRC32_PCLMUL_CHUNK_MASK;
+                _crc = crc32_pclmul_fold(_data, folded_length, _crc);
+                _data += folded_length;
+                _length -= folded_length;
+        }
+        return update_crc32_slice_by_8(_crc, _data, _length);
+}
+#endif /* CRC32_PCLMUL_SUPPORTED */
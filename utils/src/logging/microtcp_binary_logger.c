@@ -0,0 +1,594 @@
+#include "logging/microtcp_binary_logger.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "allocator/allocator_macros.h"
+#include "logging/logger_options.h"
+#include "logging/microtcp_fsm_logger.h"
+#include "logging/microtcp_logger.h"
+#include "microtcp_helper_macros.h"
+
+#define BINARY_LOG_TAG "BINARY LOGGER"
+#define CACHE_LINE_SIZE 64
+#define RING_MASK (BINARY_LOG_RING_SIZE - 1)
+#define ALIGN_TO(_bytes, _alignment) (((_bytes) + (_alignment) - 1) & ~((size_t)(_alignment) - 1))
+#define ALIGN_TO_SLOT(_bytes) ALIGN_TO(_bytes, sizeof(uint64_t))
+#define RECORD_ALIGNMENT 32 /* Exceeds record's header; A filler always fits in what is left before ring's end. */
+#define RENDER_BUFFER_SIZE 4096
+#define SITE_SET_INITIAL_CAPACITY 256
+#define NSEC_PER_SEC 1000000000LL
+#define NSEC_PER_USEC 1000
+
+/* Ring's records; RECORD_ALIGNMENT aligned, never split by ring's end. */
+typedef struct
+{
+	uint32_t size;	       /* Record's bytes, padding up to the next record included. */
+	uint32_t payload_size; /* Argument slots, then string arguments' bytes. */
+	const binary_log_site_t *site; /* NULL: Filler, up to ring's end. */
+	int64_t timestamp_nsec;	       /* CLOCK_REALTIME. */
+} record_header_t;
+
+/* Single producer (its thread), single consumer (logger's thread); Positions count bytes, and never wrap. */
+typedef struct ring
+{
+	_Alignas(CACHE_LINE_SIZE) _Atomic uint64_t tail; /* Producer's. */
+	_Atomic uint64_t dropped;			 /* Records that found the ring full. */
+	_Alignas(CACHE_LINE_SIZE) _Atomic uint64_t head; /* Consumer's. */
+	uint64_t reported_drops;
+	_Atomic _Bool orphaned; /* Its thread exited; Freed once drained. */
+	pid_t thread_id;
+	struct ring *next;
+	_Alignas(CACHE_LINE_SIZE) uint8_t bytes[BINARY_LOG_RING_SIZE];
+} ring_t;
+
+static struct
+{
+	pthread_mutex_t lock; /* Guards rings' list, and consumer's start and stop. */
+	ring_t *rings;
+	pthread_key_t thread_exit_key;
+	_Bool thread_exit_key_created;
+	_Atomic _Bool running;
+	_Atomic _Bool stop_requested;
+	_Atomic _Bool stopped; /* For good; Process exits. Later records are dropped, as nothing drains rings any more. */
+	pthread_t thread;
+
+	/* Consumer's own; Persisting output, and the sites already written to it. */
+	FILE *output;
+	const binary_log_site_t **written_sites;
+	size_t written_sites_capacity;
+	size_t written_sites_count;
+} logger = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static __thread ring_t *thread_ring;
+
+static ring_t *create_thread_ring(void);
+static void start_consumer(void);
+static void *run_consumer(void *_unused);
+static void drain_rings(void);
+static void emit_record(const ring_t *_ring, const record_header_t *_record);
+static void emit_drops(ring_t *_ring);
+static void open_output(void);
+static _Bool write_site_once(const binary_log_site_t *_site);
+static void write_string(const char *_string);
+static void orphan_thread_ring(void *_ring);
+static void lock_logger(void);
+static void unlock_logger(void);
+static void reset_in_child(void);
+
+static __always_inline _Bool is_site_enabled(const binary_log_site_t *const _site)
+{
+	if (!logger_is_enabled())
+		return false;
+	if (_site->origin == BINARY_LOG_ORIGIN_FSM)
+		return true;
+	switch (_site->tag)
+	{
+	case LOG_INFO:
+		return logger_is_info_enabled();
+	case LOG_WARNING:
+		return logger_is_warning_enabled();
+	case LOG_ERROR:
+		return logger_is_error_enabled();
+	default:
+		return true;
+	}
+}
+
+void binary_log_write(const binary_log_site_t *const _site, const binary_log_arg_t *const _args)
+{
+	if (!is_site_enabled(_site) || atomic_load_explicit(&logger.stopped, memory_order_relaxed))
+		return;
+	ring_t *const ring = thread_ring != NULL ? thread_ring : create_thread_ring();
+	if (ring == NULL)
+		return;
+	if (!atomic_load_explicit(&logger.running, memory_order_relaxed)) /* First record of the process (or of a forked child). */
+		start_consumer();
+
+	uint64_t string_lengths[BINARY_LOG_MAX_ARGS];
+	size_t payload_size = _site->arg_count * sizeof(uint64_t);
+	for (size_t i = 0; i < _site->arg_count; i++)
+	{
+		if (_site->arg_types[i] != BINARY_LOG_ARG_STRING)
+			continue;
+		string_lengths[i] = _args[i].string == NULL ? BINARY_LOG_NULL_STRING : strnlen(_args[i].string, BINARY_LOG_MAX_STRING_LENGTH);
+		if (_args[i].string != NULL)
+			payload_size += ALIGN_TO_SLOT(string_lengths[i] + 1);
+	}
+	const uint32_t record_size = ALIGN_TO(sizeof(record_header_t) + payload_size, RECORD_ALIGNMENT);
+
+	/* Reserve; A record that would cross ring's end, is preceded by a filler. */
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	const uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	const size_t contiguous_bytes = BINARY_LOG_RING_SIZE - (tail & RING_MASK);
+	const size_t filler_size = record_size > contiguous_bytes ? contiguous_bytes : 0;
+	if (BINARY_LOG_RING_SIZE - (tail - head) < filler_size + record_size)
+	{
+		atomic_store_explicit(&ring->dropped, atomic_load_explicit(&ring->dropped, memory_order_relaxed) + 1, memory_order_relaxed);
+		return;
+	}
+	if (filler_size > 0)
+	{
+		*(record_header_t *)&ring->bytes[tail & RING_MASK] = (record_header_t){.size = filler_size, .site = NULL};
+		tail += filler_size;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	uint8_t *const record = &ring->bytes[tail & RING_MASK];
+	*(record_header_t *)record = (record_header_t){.size = record_size,
+						       .payload_size = payload_size,
+						       .site = _site,
+						       .timestamp_nsec = now.tv_sec * NSEC_PER_SEC + now.tv_nsec};
+	uint64_t *const slots = (uint64_t *)(record + sizeof(record_header_t));
+	uint8_t *strings = (uint8_t *)(slots + _site->arg_count);
+	for (size_t i = 0; i < _site->arg_count; i++)
+	{
+		if (_site->arg_types[i] != BINARY_LOG_ARG_STRING)
+		{
+			slots[i] = _args[i].unsigned_value;
+			continue;
+		}
+		slots[i] = string_lengths[i];
+		if (_args[i].string == NULL)
+			continue;
+		memcpy(strings, _args[i].string, string_lengths[i]);
+		strings[string_lengths[i]] = '\0';
+		strings += ALIGN_TO_SLOT(string_lengths[i] + 1);
+	}
+	atomic_store_explicit(&ring->tail, tail + record_size, memory_order_release);
+}
+
+void binary_log_stop(void)
+{
+	pthread_mutex_lock(&logger.lock);
+	atomic_store_explicit(&logger.stopped, true, memory_order_relaxed);
+	if (atomic_load_explicit(&logger.running, memory_order_relaxed))
+	{
+		atomic_store_explicit(&logger.stop_requested, true, memory_order_relaxed);
+		pthread_mutex_unlock(&logger.lock); /* Consumer takes it, draining. */
+		pthread_join(logger.thread, NULL);
+		pthread_mutex_lock(&logger.lock);
+		atomic_store_explicit(&logger.running, false, memory_order_relaxed);
+	}
+	if (logger.output != NULL)
+	{
+		fclose(logger.output);
+		logger.output = NULL;
+	}
+	pthread_mutex_unlock(&logger.lock);
+}
+
+static ring_t *create_thread_ring(void)
+{
+	ring_t *ring = MALLOC_LOG(ring, sizeof(ring_t));
+	if (ring == NULL)
+		return NULL;
+	atomic_init(&ring->tail, 0);
+	atomic_init(&ring->dropped, 0);
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->orphaned, false);
+	ring->reported_drops = 0;
+	ring->thread_id = (pid_t)syscall(SYS_gettid);
+
+	pthread_mutex_lock(&logger.lock);
+	if (!logger.thread_exit_key_created)
+		logger.thread_exit_key_created = pthread_key_create(&logger.thread_exit_key, orphan_thread_ring) == 0;
+	if (logger.thread_exit_key_created)
+		pthread_setspecific(logger.thread_exit_key, ring);
+	ring->next = logger.rings;
+	logger.rings = ring;
+	pthread_mutex_unlock(&logger.lock);
+	return thread_ring = ring;
+}
+
+static void start_consumer(void)
+{
+	static _Bool fork_handlers_registered = false;
+	pthread_mutex_lock(&logger.lock);
+	if (!atomic_load_explicit(&logger.running, memory_order_relaxed) && !atomic_load_explicit(&logger.stopped, memory_order_relaxed))
+	{
+		open_output();
+		atomic_store_explicit(&logger.stop_requested, false, memory_order_relaxed);
+		if (pthread_create(&logger.thread, NULL, run_consumer, NULL) == 0)
+			atomic_store_explicit(&logger.running, true, memory_order_relaxed);
+		else
+			LOG_MESSAGE_NON_THREAD_SAFE(LOG_ERROR, BINARY_LOG_TAG, "Binary logger's thread failed to start; Records stay in their rings.");
+		if (!fork_handlers_registered)
+			fork_handlers_registered = pthread_atfork(lock_logger, unlock_logger, reset_in_child) == 0;
+	}
+	pthread_mutex_unlock(&logger.lock);
+}
+
+static void *run_consumer(void *const _unused)
+{
+	(void)_unused;
+	const struct timespec drain_interval = {.tv_sec = 0, .tv_nsec = BINARY_LOG_DRAIN_INTERVAL_USEC * NSEC_PER_USEC};
+	while (!atomic_load_explicit(&logger.stop_requested, memory_order_relaxed))
+	{
+		drain_rings();
+		nanosleep(&drain_interval, NULL);
+	}
+	drain_rings(); /* Records of the last interval. */
+	return NULL;
+}
+
+/* Merges rings' records by timestamp; Up to where each producer was, when the pass started. */
+static void drain_rings(void)
+{
+	pthread_mutex_lock(&logger.lock);
+	for (;;)
+	{
+		ring_t *oldest_ring = NULL;
+		const record_header_t *oldest_record = NULL;
+		for (ring_t *ring = logger.rings; ring != NULL; ring = ring->next)
+		{
+			const uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+			uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+			const record_header_t *record = NULL;
+			while (head != tail && (record = (const record_header_t *)&ring->bytes[head & RING_MASK])->site == NULL)
+				head += record->size; /* Filler. */
+			atomic_store_explicit(&ring->head, head, memory_order_release);
+			if (head != tail && (oldest_record == NULL || record->timestamp_nsec < oldest_record->timestamp_nsec))
+			{
+				oldest_ring = ring;
+				oldest_record = record;
+			}
+		}
+		if (oldest_ring == NULL)
+			break;
+		emit_record(oldest_ring, oldest_record);
+		atomic_store_explicit(&oldest_ring->head, atomic_load_explicit(&oldest_ring->head, memory_order_relaxed) + oldest_record->size,
+				      memory_order_release);
+	}
+	for (ring_t **ring_address = &logger.rings; *ring_address != NULL;)
+	{
+		ring_t *ring = *ring_address;
+		emit_drops(ring);
+		if (atomic_load_explicit(&ring->orphaned, memory_order_acquire) &&
+		    atomic_load_explicit(&ring->head, memory_order_relaxed) == atomic_load_explicit(&ring->tail, memory_order_acquire))
+		{
+			*ring_address = ring->next;
+			FREE_NULLIFY_LOG(ring);
+			continue;
+		}
+		ring_address = &ring->next;
+	}
+	if (logger.output != NULL)
+		fflush(logger.output);
+	pthread_mutex_unlock(&logger.lock);
+}
+
+static void emit_record(const ring_t *const _ring, const record_header_t *const _record)
+{
+	const binary_log_site_t *const site = _record->site;
+	const void *const payload = _record + 1;
+	if (logger.output != NULL)
+	{
+		if (!write_site_once(site))
+			return;
+		const uint32_t kind = BINARY_LOG_FILE_EVENT;
+		const uint64_t site_id = (uintptr_t)site;
+		const int32_t thread_id = _ring->thread_id;
+		fwrite(&kind, sizeof(kind), 1, logger.output);
+		fwrite(&site_id, sizeof(site_id), 1, logger.output);
+		fwrite(&_record->timestamp_nsec, sizeof(_record->timestamp_nsec), 1, logger.output);
+		fwrite(&thread_id, sizeof(thread_id), 1, logger.output);
+		fwrite(&_record->payload_size, sizeof(_record->payload_size), 1, logger.output);
+		fwrite(payload, _record->payload_size, 1, logger.output);
+		return;
+	}
+	char message[RENDER_BUFFER_SIZE];
+	binary_log_render(site, payload, _record->payload_size, message, sizeof(message));
+	if (site->origin == BINARY_LOG_ORIGIN_FSM)
+	{
+		log_fsm_message_thread_safe((enum fsm_log_tag)site->tag, "%s", message);
+		return;
+	}
+	const char *const file_name = strrchr(site->file, '/') != NULL ? strrchr(site->file, '/') + 1 : site->file;
+	log_message_thread_safe((enum log_tag)site->tag, site->project_name, file_name, site->line, site->func, "%s", message);
+}
+
+static void emit_drops(ring_t *const _ring)
+{
+	const uint64_t dropped = atomic_load_explicit(&_ring->dropped, memory_order_relaxed);
+	if (COMMON_CASE(dropped == _ring->reported_drops))
+		return;
+	const uint64_t new_drops = dropped - _ring->reported_drops;
+	_ring->reported_drops = dropped;
+	if (logger.output == NULL)
+	{
+		log_message_thread_safe(LOG_WARNING, BINARY_LOG_TAG, __FILENAME__, __LINE__, __func__,
+					"Thread %d dropped %lu log records; Its ring was full.", (int)_ring->thread_id, (unsigned long)new_drops);
+		return;
+	}
+	const uint32_t kind = BINARY_LOG_FILE_DROPS;
+	const int32_t thread_id = _ring->thread_id;
+	fwrite(&kind, sizeof(kind), 1, logger.output);
+	fwrite(&thread_id, sizeof(thread_id), 1, logger.output);
+	fwrite(&new_drops, sizeof(new_drops), 1, logger.output);
+}
+
+/* Persisting output, if requested; Named after the process, so forked children write files of their own. */
+static void open_output(void)
+{
+	const char *const path_prefix = getenv(BINARY_LOG_ENVIRONMENT_VARIABLE);
+	if (path_prefix == NULL || logger.output != NULL)
+		return;
+	char path[FILENAME_MAX];
+	snprintf(path, sizeof(path), "%s.%d", path_prefix, (int)getpid());
+	if ((logger.output = fopen(path, "wbe")) == NULL)
+	{
+		LOG_MESSAGE_NON_THREAD_SAFE(LOG_ERROR, BINARY_LOG_TAG, "Binary log %s could not be opened; Records are formatted instead.", path);
+		return;
+	}
+	const uint32_t version = BINARY_LOG_FILE_VERSION;
+	const uint32_t reserved = 0;
+	fwrite(BINARY_LOG_FILE_MAGIC, strlen(BINARY_LOG_FILE_MAGIC), 1, logger.output);
+	fwrite(&version, sizeof(version), 1, logger.output);
+	fwrite(&reserved, sizeof(reserved), 1, logger.output);
+	logger.written_sites_count = 0;
+}
+
+/* Sites are written to the output once, before their first record; Set of sites' addresses, open addressing. */
+static _Bool write_site_once(const binary_log_site_t *const _site)
+{
+	if (2 * (logger.written_sites_count + 1) > logger.written_sites_capacity) /* Keep load under 1/2. */
+	{
+		const size_t capacity = logger.written_sites_capacity == 0 ? SITE_SET_INITIAL_CAPACITY : 2 * logger.written_sites_capacity;
+		const binary_log_site_t **sites = CALLOC_LOG(sites, capacity * sizeof(*sites));
+		if (sites == NULL)
+			return false;
+		for (size_t i = 0; i < logger.written_sites_capacity; i++)
+		{
+			if (logger.written_sites[i] == NULL)
+				continue;
+			size_t slot = ((uintptr_t)logger.written_sites[i] >> 4) & (capacity - 1);
+			while (sites[slot] != NULL)
+				slot = (slot + 1) & (capacity - 1);
+			sites[slot] = logger.written_sites[i];
+		}
+		if (logger.written_sites != NULL)
+			FREE_NULLIFY_LOG(logger.written_sites);
+		logger.written_sites = sites;
+		logger.written_sites_capacity = capacity;
+	}
+	size_t slot = ((uintptr_t)_site >> 4) & (logger.written_sites_capacity - 1);
+	while (logger.written_sites[slot] != NULL)
+	{
+		if (logger.written_sites[slot] == _site)
+			return true;
+		slot = (slot + 1) & (logger.written_sites_capacity - 1);
+	}
+	logger.written_sites[slot] = _site;
+	logger.written_sites_count++;
+
+	const uint32_t kind = BINARY_LOG_FILE_SITE;
+	const uint64_t site_id = (uintptr_t)_site;
+	const int32_t tag = _site->tag;
+	const int32_t line = _site->line;
+	fwrite(&kind, sizeof(kind), 1, logger.output);
+	fwrite(&site_id, sizeof(site_id), 1, logger.output);
+	fwrite(&tag, sizeof(tag), 1, logger.output);
+	fwrite(&_site->origin, sizeof(_site->origin), 1, logger.output);
+	fwrite(&_site->arg_count, sizeof(_site->arg_count), 1, logger.output);
+	fwrite(_site->arg_types, sizeof(_site->arg_types[0]), _site->arg_count, logger.output);
+	fwrite(&line, sizeof(line), 1, logger.output);
+	write_string(_site->project_name);
+	write_string(_site->file);
+	write_string(_site->func);
+	write_string(_site->format);
+	return true;
+}
+
+static void write_string(const char *const _string)
+{
+	const uint32_t length = strlen(_string);
+	fwrite(&length, sizeof(length), 1, logger.output);
+	fwrite(_string, length, 1, logger.output);
+}
+
+/* Thread exit; Its ring is drained, then freed, by the consumer. Records of thread's later destructors go to a new ring. */
+static void orphan_thread_ring(void *const _ring)
+{
+	ring_t *const ring = _ring;
+	thread_ring = NULL;
+	atomic_store_explicit(&ring->orphaned, true, memory_order_release);
+}
+
+static void lock_logger(void)
+{
+	pthread_mutex_lock(&logger.lock);
+}
+
+static void unlock_logger(void)
+{
+	pthread_mutex_unlock(&logger.lock);
+}
+
+/**
+ * Consumer thread does not survive fork(); Child starts its own with its first record. Pending records are parent's
+ * (parent outputs them), and rings of other threads have no thread any more.
+ */
+static void reset_in_child(void)
+{
+	atomic_store_explicit(&logger.running, false, memory_order_relaxed);
+	for (ring_t *ring = logger.rings; ring != NULL; ring = ring->next)
+	{
+		atomic_store_explicit(&ring->head, atomic_load_explicit(&ring->tail, memory_order_relaxed), memory_order_relaxed);
+		ring->reported_drops = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+		if (ring != thread_ring)
+			atomic_store_explicit(&ring->orphaned, true, memory_order_relaxed);
+	}
+	if (thread_ring != NULL)
+		thread_ring->thread_id = (pid_t)syscall(SYS_gettid);
+	if (logger.output != NULL) /* Parent's file; Its buffered bytes are parent's to write. */
+	{
+		close(fileno(logger.output));
+		logger.output = NULL;
+	}
+	pthread_mutex_unlock(&logger.lock);
+}
+
+/* ---------------------------------------------- RENDERING ---------------------------------------------- */
+typedef struct
+{
+	char *buffer;
+	size_t size;
+	size_t length; /* Of the whole message; Beyond `size` when truncated. */
+} render_output_t;
+
+static void render_append(render_output_t *const _output, const char *const _format, ...) __attribute__((format(printf, 2, 3)));
+
+static void render_append(render_output_t *const _output, const char *const _format, ...)
+{
+	va_list args;
+	va_start(args, _format);
+	const size_t offset = MIN(_output->length, _output->size);
+	const int appended = vsnprintf(_output->buffer + offset, _output->size - offset, _format, args);
+	va_end(args);
+	if (appended > 0)
+		_output->length += appended;
+}
+
+size_t binary_log_render(const binary_log_site_t *const _site, const void *const _payload, const size_t _payload_size,
+			 char *const _buffer, const size_t _buffer_size)
+{
+	render_output_t output = {.buffer = _buffer, .size = _buffer_size, .length = 0};
+	if (_buffer_size > 0)
+		_buffer[0] = '\0';
+	const uint64_t *const slots = _payload;
+	const size_t slots_size = _site->arg_count * sizeof(uint64_t);
+	if (_payload_size < slots_size)
+		return 0;
+	const char *strings = (const char *)_payload + slots_size;
+	const char *const payload_end = (const char *)_payload + _payload_size;
+	size_t next_arg = 0;
+
+	for (const char *c = _site->format; *c != '\0'; c++)
+	{
+		if (*c != '%')
+		{
+			const size_t literal_length = strcspn(c, "%");
+			render_append(&output, "%.*s", (int)literal_length, c);
+			c += literal_length - 1;
+			continue;
+		}
+		if (c[1] == '%')
+		{
+			render_append(&output, "%%");
+			c++;
+			continue;
+		}
+		/* Conversion specification; Rebuilt with the length modifier of the recorded (widened) argument. */
+		char spec[32] = "%";
+		size_t spec_length = 1;
+		for (c++; *c != '\0' && strchr("-+ #0'123456789.*", *c) != NULL && spec_length < sizeof(spec) - 4; c++)
+		{
+			if (*c != '*')
+			{
+				spec[spec_length++] = *c;
+				continue;
+			}
+			const long long field = next_arg < _site->arg_count ? (long long)slots[next_arg++] : 0; /* Width or precision argument. */
+			spec_length += snprintf(spec + spec_length, sizeof(spec) - spec_length - 4, "%d", (int)field);
+		}
+		while (*c != '\0' && strchr("hlLqjzt", *c) != NULL)
+			c++;
+		if (*c == '\0')
+			break;
+		if (next_arg >= _site->arg_count)
+		{
+			render_append(&output, "(?)");
+			continue;
+		}
+		const uint8_t type = _site->arg_types[next_arg];
+		const uint64_t slot = slots[next_arg++];
+		const char *string = "(null)";
+		if (type == BINARY_LOG_ARG_STRING && slot != BINARY_LOG_NULL_STRING)
+		{
+			if (slot >= (uint64_t)(payload_end - strings))
+				break; /* Malformed payload. */
+			string = strings;
+			strings += ALIGN_TO_SLOT(slot + 1);
+		}
+		double double_value;
+		memcpy(&double_value, &slot, sizeof(double_value));
+		const long long signed_value = type == BINARY_LOG_ARG_DOUBLE ? (long long)double_value : (long long)slot;
+		const unsigned long long unsigned_value = type == BINARY_LOG_ARG_DOUBLE ? (unsigned long long)double_value : slot;
+		if (type != BINARY_LOG_ARG_DOUBLE)
+			double_value = type == BINARY_LOG_ARG_SIGNED ? (double)signed_value : (double)unsigned_value;
+
+		switch (*c)
+		{
+		case 'd':
+		case 'i':
+			memcpy(spec + spec_length, "lld", 4);
+			render_append(&output, spec, signed_value);
+			break;
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+			memcpy(spec + spec_length, "ll", 2);
+			spec[spec_length + 2] = *c;
+			spec[spec_length + 3] = '\0';
+			render_append(&output, spec, unsigned_value);
+			break;
+		case 'c':
+			memcpy(spec + spec_length, "c", 2);
+			render_append(&output, spec, (int)signed_value);
+			break;
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			spec[spec_length] = *c;
+			spec[spec_length + 1] = '\0';
+			render_append(&output, spec, double_value);
+			break;
+		case 's':
+			memcpy(spec + spec_length, "s", 2);
+			render_append(&output, spec, type == BINARY_LOG_ARG_STRING ? string : "(?)");
+			break;
+		case 'p':
+			memcpy(spec + spec_length, "p", 2);
+			render_append(&output, spec, (void *)(uintptr_t)slot);
+			break;
+		default: /* Unknown conversion (or %n); Printed as written. */
+			render_append(&output, "%s%c", spec, *c);
+			break;
+		}
+	}
+	return output.length < _buffer_size ? output.length : (_buffer_size > 0 ? _buffer_size - 1 : 0); /* What fit. */
+}
@@ -10,6 +10,7 @@
 #include "allocator/allocator_macros.h"
 #include "cli_color.h"
 #include "logging/logger_options.h"
+#include "logging/microtcp_binary_logger.h"
 #include "microtcp_defines.h"
 #include "microtcp_logging_colors.h"
 
@@ -88,6 +89,7 @@ static void logger_constructor(void)
 static void logger_destructor(void)
 {
 #define PTHREAD_MUTEX_DESTROY_SUCCESS 0 /* Specified in man pages. */
+	binary_log_stop(); /* Its thread formats through the mutex. */
 	if (mutex_logger != NULL && pthread_mutex_destroy(mutex_logger) == PTHREAD_MUTEX_DESTROY_SUCCESS)
 	{
 		free(mutex_logger);